@@ -1007,7 +1007,8 @@ int main(int argc, char **argv) {
             sp<IMemory> mem =
                     retriever->getFrameAtTime(-1,
                             MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC,
-                            retrieverPixelFormat, false /*metaOnly*/);
+                            retrieverPixelFormat, false /*metaOnly*/,
+                            0 /*dstWidth*/, 0 /*dstHeight*/);
 
             if (mem != NULL) {
                 failed = false;
@@ -27,6 +27,7 @@
 #include <C2PlatformSupport.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 
 #include "C2SoftAvcDec.h"
 
@@ -342,6 +343,7 @@ C2SoftAvcDec::C2SoftAvcDec(
       mIntf(intfImpl),
       mDecHandle(nullptr),
       mOutBufferFlush(nullptr),
+      mNumCores(0),
       mIvColorFormat(IV_YUV_420P),
       mOutputDelay(kDefaultOutputDelay),
       mWidth(320),
@@ -514,7 +516,10 @@ void C2SoftAvcDec::getVersion() {
 
 status_t C2SoftAvcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    if (mNumCores == 0) {
+        mNumCores = SimpleC2TaskPool::Get().acquireThreads(
+                MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -665,6 +670,11 @@ status_t C2SoftAvcDec::resetDecoder() {
         return UNKNOWN_ERROR;
     }
     mStride = 0;
+    // the share of threads of this session may have changed since it started
+    if (mNumCores > 0) {
+        mNumCores = SimpleC2TaskPool::Get().rebalanceThreads(
+                mNumCores, MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     (void) setNumCores();
     mSignalledError = false;
     mHeaderDecoded = false;
@@ -681,6 +691,8 @@ void C2SoftAvcDec::resetPlugin() {
 }
 
 status_t C2SoftAvcDec::deleteDecoder() {
+    SimpleC2TaskPool::Get().releaseThreads(mNumCores);
+    mNumCores = 0;
     if (mDecHandle) {
         ivdext_delete_ip_t s_delete_ip = {};
         ivdext_delete_op_t s_delete_op = {};
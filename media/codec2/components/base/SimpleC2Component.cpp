@@ -26,12 +26,18 @@
 #include <inttypes.h>
 #include <libyuv.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
 #include <Codec2BufferUtils.h>
 #include <Codec2CommonUtils.h>
 #include <SimpleC2Component.h>
+#include <SimpleC2TaskPool.h>
+
+#include "SimpleC2ConverterKernels.h"
 
 namespace android {
 
@@ -46,6 +52,40 @@ namespace android {
 constexpr uint8_t kNeutralUVBitDepth8 = 128;
 constexpr uint16_t kNeutralUVBitDepth10 = 512;
 
+namespace {
+
+CONV_ISA_T GetBestConverterIsa() {
+    for (CONV_ISA_T isa : { CONV_ISA_AVX2, CONV_ISA_SSE4_1, CONV_ISA_NEON }) {
+        if (GetSimpleC2ConverterKernels(isa) != nullptr) {
+            return isa;
+        }
+    }
+    return CONV_ISA_SCALAR;
+}
+
+std::atomic<CONV_ISA_T> &ConverterIsa() {
+    static std::atomic<CONV_ISA_T> sIsa(GetBestConverterIsa());
+    return sIsa;
+}
+
+const SimpleC2ConverterKernels &GetConverterKernels() {
+    return *GetSimpleC2ConverterKernels(ConverterIsa().load(std::memory_order_relaxed));
+}
+
+}  // namespace
+
+bool setConverterIsa(CONV_ISA_T isa) {
+    if (GetSimpleC2ConverterKernels(isa) == nullptr) {
+        return false;
+    }
+    ConverterIsa() = isa;
+    return true;
+}
+
+CONV_ISA_T getConverterIsa() {
+    return ConverterIsa();
+}
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
@@ -84,6 +124,7 @@ void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, con
 void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
                                  const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
                                  size_t srcVStride, size_t dstStride, size_t width, size_t height) {
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
     // Converting two lines at a time, slightly faster
     for (size_t y = 0; y < height; y += 2) {
         uint32_t *dstTop = (uint32_t *)dst;
@@ -94,7 +135,13 @@ void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint
         uint16_t *vSrc = (uint16_t *)srcV;
 
         uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
-        size_t x = 0;
+        size_t x = kernels.y410(dstTop, dstBot, ySrcTop, ySrcBot, uSrc, vSrc, width);
+        dstTop += x;
+        dstBot += x;
+        ySrcTop += x;
+        ySrcBot += x;
+        uSrc += x / 2;
+        vSrc += x / 2;
         for (; x < width - 3; x += 4) {
             u01 = *((uint32_t *)uSrc);
             uSrc += 2;
@@ -263,6 +310,9 @@ void convertYUV420Planar16ToRGBA1010102(
     int32_t _neg_g_v = -coeffs._g_v;
     int32_t _r_v = coeffs._r_v;
     int32_t _c16 = coeffs._c16;
+    const int32_t kernelCoeffs[6] = {
+        coeffs._y, coeffs._r_v, coeffs._g_u, coeffs._g_v, coeffs._b_u, coeffs._c16 };
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
 
     // Converting two lines at a time, slightly faster
     for (size_t y = 0; y < height; y += 2) {
@@ -273,7 +323,15 @@ void convertYUV420Planar16ToRGBA1010102(
         uint16_t *uSrc = (uint16_t *)srcU;
         uint16_t *vSrc = (uint16_t *)srcV;
 
-        for (size_t x = 0; x < width; x += 2) {
+        size_t x = kernels.rgba1010102(
+                dstTop, dstBot, ySrcTop, ySrcBot, uSrc, vSrc, width, kernelCoeffs);
+        dstTop += x;
+        dstBot += x;
+        ySrcTop += x;
+        ySrcBot += x;
+        uSrc += x / 2;
+        vSrc += x / 2;
+        for (; x < width; x += 2) {
             int32_t u, v, y00, y01, y10, y11;
             u = *uSrc - 512;
             uSrc += 1;
@@ -345,13 +403,31 @@ void convertYUV420Planar16ToY410OrRGBA1010102(
         size_t srcYStride, size_t srcUStride,
         size_t srcVStride, size_t dstStride, size_t width, size_t height,
         std::shared_ptr<const C2ColorAspectsStruct> aspects) {
-    if (isAtLeastT()) {
-        convertYUV420Planar16ToRGBA1010102(dst, srcY, srcU, srcV, srcYStride, srcUStride,
-                                           srcVStride, dstStride, width, height, aspects);
-    } else {
-        convertYUV420Planar16ToY410(dst, srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                                    dstStride, width, height);
-    }
+    // Converts bands of rows on the shared task pool; must be even for the chroma rows.
+    constexpr size_t kBandHeight = 64;
+    const bool rgba = isAtLeastT();
+    if (rgba) {
+        // deduce missing aspects from the frame size, not the band size
+        aspects = std::make_shared<const C2ColorAspectsStruct>(
+                FillMissingColorAspects(aspects, width, height));
+    }
+    SimpleC2TaskPool::Get().parallelFor(
+            (height + kBandHeight - 1) / kBandHeight,
+            [=, &aspects](size_t band) {
+                const size_t row = band * kBandHeight;
+                const size_t rows = std::min(height - row, kBandHeight);
+                if (rgba) {
+                    convertYUV420Planar16ToRGBA1010102(
+                            dst + dstStride * row, srcY + srcYStride * row,
+                            srcU + srcUStride * (row / 2), srcV + srcVStride * (row / 2),
+                            srcYStride, srcUStride, srcVStride, dstStride, width, rows, aspects);
+                } else {
+                    convertYUV420Planar16ToY410(
+                            dst + dstStride * row, srcY + srcYStride * row,
+                            srcU + srcUStride * (row / 2), srcV + srcVStride * (row / 2),
+                            srcYStride, srcUStride, srcVStride, dstStride, width, rows);
+                }
+            });
 }
 
 void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint16_t *srcY,
@@ -359,8 +435,9 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
+        for (size_t x = kernels.narrow10To8(dstY, srcY, width); x < width; ++x) {
             dstY[x] = (uint8_t)(srcY[x] >> 2);
         }
         srcY += srcYStride;
@@ -379,7 +456,9 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+        size_t x = kernels.narrow10To8(dstU, srcU, (width + 1) / 2);
+        kernels.narrow10To8(dstV, srcV, (width + 1) / 2);
+        for (; x < (width + 1) / 2; ++x) {
             dstU[x] = (uint8_t)(srcU[x] >> 2);
             dstV[x] = (uint8_t)(srcV[x] >> 2);
         }
@@ -395,8 +474,9 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
+        for (size_t x = kernels.shiftLeft6(dstY, srcY, width); x < width; ++x) {
             dstY[x] = srcY[x] << 6;
         }
         srcY += srcYStride;
@@ -416,7 +496,8 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+        for (size_t x = kernels.interleaveUV(dstUV, srcU, srcV, (width + 1) / 2);
+                x < (width + 1) / 2; ++x) {
             dstUV[2 * x] = srcU[x] << 6;
             dstUV[2 * x + 1] = srcV[x] << 6;
         }
@@ -431,8 +512,9 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
                                  size_t srcYStride, size_t srcUVStride, size_t dstYStride,
                                  size_t dstUStride, size_t dstVStride, size_t width,
                                  size_t height, bool isMonochrome) {
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
+        for (size_t x = kernels.shiftRight6(dstY, srcY, width); x < width; ++x) {
             dstY[x] = srcY[x] >> 6;
         }
         srcY += srcYStride;
@@ -453,7 +535,8 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+        for (size_t x = kernels.deinterleaveUV(dstU, dstV, srcUV, (width + 1) / 2);
+                x < (width + 1) / 2; ++x) {
             dstU[x] = srcUV[2 * x] >> 6;
             dstV[x] = srcUV[2 * x + 1] >> 6;
         }
@@ -489,9 +572,14 @@ void convertRGBA1010102ToYUV420Planar16(uint16_t* dstY, uint16_t* dstU, uint16_t
     const int16_t(*weights)[3] = (colorMatrix == C2Color::MATRIX_BT709)
                                          ? bt709Matrix_10bit[colorRange - 1]
                                          : bt2020Matrix_10bit[colorRange - 1];
+    const int32_t levels[3] = { zeroLvl, maxLvlLuma, maxLvlChroma };
+    const SimpleC2ConverterKernels &kernels = GetConverterKernels();
 
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
+        for (size_t x = kernels.rgba1010102ToYuv(dstY, y % 2 == 0 ? dstU : nullptr,
+                                                 y % 2 == 0 ? dstV : nullptr, srcRGBA, width,
+                                                 weights, levels);
+                x < width; ++x) {
             b = (srcRGBA[x]  >> 20) & 0x3FF;
             g = (srcRGBA[x]  >> 10) & 0x3FF;
             r = srcRGBA[x] & 0x3FF;
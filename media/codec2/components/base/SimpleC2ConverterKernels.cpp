@@ -0,0 +1,739 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SimpleC2ConverterKernels.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON 1
+#include <arm_neon.h>
+#else
+#define USE_NEON 0
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_SSE_AVX 1
+#include <immintrin.h>
+#define TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define USE_SSE_AVX 0
+#endif
+
+namespace android {
+
+namespace {
+
+// The scalar code masks the first of each pair of samples to 10 bits only, so the kernels mask
+// alternate lanes the same way.
+constexpr uint32_t kEvenMask = 0x3FF;
+constexpr uint32_t kOddMask = 0xFFFF;
+constexpr uint32_t kAlpha = 3u << 30;
+
+size_t y410Scalar(uint32_t *, uint32_t *, const uint16_t *, const uint16_t *, const uint16_t *,
+                  const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t rgba1010102Scalar(uint32_t *, uint32_t *, const uint16_t *, const uint16_t *,
+                         const uint16_t *, const uint16_t *, size_t, const int32_t[6]) {
+    return 0;
+}
+
+size_t shiftScalar(uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t narrow10To8Scalar(uint8_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t interleaveUVScalar(uint16_t *, const uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t deinterleaveUVScalar(uint16_t *, uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t rgba1010102ToYuvScalar(uint16_t *, uint16_t *, uint16_t *, const uint32_t *, size_t,
+                              const int16_t[3][3], const int32_t[3]) {
+    return 0;
+}
+
+const SimpleC2ConverterKernels kScalarKernels = {
+    y410Scalar,
+    rgba1010102Scalar,
+    shiftScalar,
+    shiftScalar,
+    narrow10To8Scalar,
+    interleaveUVScalar,
+    deinterleaveUVScalar,
+    rgba1010102ToYuvScalar,
+};
+
+#if USE_NEON
+
+size_t y410Neon(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                size_t width) {
+    static const uint32_t kMasks[4] = { kEvenMask, kOddMask, kEvenMask, kOddMask };
+    const uint32x4_t mask = vld1q_u32(kMasks);
+    const uint32x4_t alpha = vdupq_n_u32(kAlpha);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint32x4_t u = vandq_u32(vmovl_u16(vld1_u16(srcU + x / 2)), mask);
+        const uint32x4_t v = vandq_u32(vmovl_u16(vld1_u16(srcV + x / 2)), mask);
+        const uint32x4_t uv1 = vorrq_u32(vorrq_u32(u, vshlq_n_u32(v, 20)), alpha);
+        const uint32x4x2_t uv = vzipq_u32(uv1, uv1);
+
+        uint16x8_t y = vld1q_u16(srcYTop + x);
+        vst1q_u32(dstTop + x, vorrq_u32(
+                vshlq_n_u32(vandq_u32(vmovl_u16(vget_low_u16(y)), mask), 10), uv.val[0]));
+        vst1q_u32(dstTop + x + 4, vorrq_u32(
+                vshlq_n_u32(vandq_u32(vmovl_u16(vget_high_u16(y)), mask), 10), uv.val[1]));
+        y = vld1q_u16(srcYBot + x);
+        vst1q_u32(dstBot + x, vorrq_u32(
+                vshlq_n_u32(vandq_u32(vmovl_u16(vget_low_u16(y)), mask), 10), uv.val[0]));
+        vst1q_u32(dstBot + x + 4, vorrq_u32(
+                vshlq_n_u32(vandq_u32(vmovl_u16(vget_high_u16(y)), mask), 10), uv.val[1]));
+    }
+    return x;
+}
+
+inline uint32x4_t packRgbaNeon(int32x4_t yMult, int32x4_t ub, int32x4_t uvg, int32x4_t vr) {
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(1023);
+    const int32x4_t b = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, ub), 10), zero), max);
+    const int32x4_t g = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, uvg), 10), zero), max);
+    const int32x4_t r = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, vr), 10), zero), max);
+    return vorrq_u32(vorrq_u32(vdupq_n_u32(kAlpha), vshlq_n_u32(vreinterpretq_u32_s32(b), 20)),
+                     vorrq_u32(vshlq_n_u32(vreinterpretq_u32_s32(g), 10),
+                               vreinterpretq_u32_s32(r)));
+}
+
+size_t rgba1010102Neon(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                       const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                       size_t width, const int32_t coeffs[6]) {
+    const int32_t _y = coeffs[0], _r_v = coeffs[1], _g_u = coeffs[2], _g_v = coeffs[3],
+            _b_u = coeffs[4], _c16 = coeffs[5];
+    const int32x4_t c512 = vdupq_n_s32(512);
+    const int32x4_t c16 = vdupq_n_s32(_c16);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const int32x4_t u = vsubq_s32(
+                vreinterpretq_s32_u32(vmovl_u16(vld1_u16(srcU + x / 2))), c512);
+        const int32x4_t v = vsubq_s32(
+                vreinterpretq_s32_u32(vmovl_u16(vld1_u16(srcV + x / 2))), c512);
+        const int32x4_t ub1 = vmulq_n_s32(u, _b_u);
+        const int32x4_t uvg1 = vaddq_s32(vmulq_n_s32(v, -_g_v), vmulq_n_s32(u, -_g_u));
+        const int32x4_t vr1 = vmulq_n_s32(v, _r_v);
+        const int32x4x2_t ub = vzipq_s32(ub1, ub1);
+        const int32x4x2_t uvg = vzipq_s32(uvg1, uvg1);
+        const int32x4x2_t vr = vzipq_s32(vr1, vr1);
+
+        const uint16_t *srcY[2] = { srcYTop + x, srcYBot + x };
+        uint32_t *dst[2] = { dstTop + x, dstBot + x };
+        for (size_t row = 0; row < 2; ++row) {
+            const uint16x8_t y = vld1q_u16(srcY[row]);
+            const int32x4_t y0 = vsubq_s32(
+                    vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(y))), c16);
+            const int32x4_t y1 = vsubq_s32(
+                    vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(y))), c16);
+            vst1q_u32(dst[row], packRgbaNeon(
+                    vmlaq_n_s32(c512, y0, _y), ub.val[0], uvg.val[0], vr.val[0]));
+            vst1q_u32(dst[row] + 4, packRgbaNeon(
+                    vmlaq_n_s32(c512, y1, _y), ub.val[1], uvg.val[1], vr.val[1]));
+        }
+    }
+    return x;
+}
+
+size_t shiftLeft6Neon(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        vst1q_u16(dst + x, vshlq_n_u16(vld1q_u16(src + x), 6));
+    }
+    return x;
+}
+
+size_t shiftRight6Neon(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        vst1q_u16(dst + x, vshrq_n_u16(vld1q_u16(src + x), 6));
+    }
+    return x;
+}
+
+size_t narrow10To8Neon(uint8_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        vst1q_u8(dst + x, vcombine_u8(vshrn_n_u16(vld1q_u16(src + x), 2),
+                                      vshrn_n_u16(vld1q_u16(src + x + 8), 2)));
+    }
+    return x;
+}
+
+size_t interleaveUVNeon(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                        size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint16x8x2_t uv;
+        uv.val[0] = vshlq_n_u16(vld1q_u16(srcU + x), 6);
+        uv.val[1] = vshlq_n_u16(vld1q_u16(srcV + x), 6);
+        vst2q_u16(dstUV + 2 * x, uv);
+    }
+    return x;
+}
+
+size_t deinterleaveUVNeon(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                          size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint16x8x2_t uv = vld2q_u16(srcUV + 2 * x);
+        vst1q_u16(dstU + x, vshrq_n_u16(uv.val[0], 6));
+        vst1q_u16(dstV + x, vshrq_n_u16(uv.val[1], 6));
+    }
+    return x;
+}
+
+inline uint16x4_t rgbToComponentNeon(int32x4_t r, int32x4_t g, int32x4_t b,
+                                     const int16_t weights[3], int32_t offset,
+                                     int32_t min, int32_t max) {
+    int32x4_t c = vmlaq_n_s32(vmlaq_n_s32(vmlaq_n_s32(vdupq_n_s32(512), r, weights[0]),
+                                          g, weights[1]), b, weights[2]);
+    c = vaddq_s32(vshrq_n_s32(c, 10), vdupq_n_s32(offset));
+    c = vminq_s32(vmaxq_s32(c, vdupq_n_s32(min)), vdupq_n_s32(max));
+    return vmovn_u32(vreinterpretq_u32_s32(c));
+}
+
+size_t rgba1010102ToYuvNeon(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                            const uint32_t *src, size_t width, const int16_t weights[3][3],
+                            const int32_t levels[3]) {
+    const uint32x4_t mask = vdupq_n_u32(0x3FF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint32x4_t p0 = vld1q_u32(src + x);
+        const uint32x4_t p1 = vld1q_u32(src + x + 4);
+        const uint32x4_t p[2] = { p0, p1 };
+        uint16x4_t y[2];
+        for (size_t i = 0; i < 2; ++i) {
+            const int32x4_t r = vreinterpretq_s32_u32(vandq_u32(p[i], mask));
+            const int32x4_t g = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(p[i], 10), mask));
+            const int32x4_t b = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(p[i], 20), mask));
+            y[i] = rgbToComponentNeon(r, g, b, weights[0], levels[0], levels[0], levels[1]);
+        }
+        vst1q_u16(dstY + x, vcombine_u16(y[0], y[1]));
+
+        if (dstU != nullptr) {
+            const uint32x4_t e = vuzpq_u32(p0, p1).val[0];
+            const int32x4_t r = vreinterpretq_s32_u32(vandq_u32(e, mask));
+            const int32x4_t g = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(e, 10), mask));
+            const int32x4_t b = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(e, 20), mask));
+            vst1_u16(dstU + x / 2,
+                     rgbToComponentNeon(r, g, b, weights[1], 512, levels[0], levels[2]));
+            vst1_u16(dstV + x / 2,
+                     rgbToComponentNeon(r, g, b, weights[2], 512, levels[0], levels[2]));
+        }
+    }
+    return x;
+}
+
+const SimpleC2ConverterKernels kNeonKernels = {
+    y410Neon,
+    rgba1010102Neon,
+    shiftLeft6Neon,
+    shiftRight6Neon,
+    narrow10To8Neon,
+    interleaveUVNeon,
+    deinterleaveUVNeon,
+    rgba1010102ToYuvNeon,
+};
+
+#endif  // USE_NEON
+
+#if USE_SSE_AVX
+
+TARGET_SSE4_1
+size_t y410Sse41(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                 const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                 size_t width) {
+    const __m128i mask = _mm_setr_epi32(kEvenMask, kOddMask, kEvenMask, kOddMask);
+    const __m128i alpha = _mm_set1_epi32(kAlpha);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_and_si128(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcU + x / 2))), mask);
+        const __m128i v = _mm_and_si128(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcV + x / 2))), mask);
+        const __m128i uv = _mm_or_si128(_mm_or_si128(u, _mm_slli_epi32(v, 20)), alpha);
+        const __m128i uv0 = _mm_unpacklo_epi32(uv, uv);
+        const __m128i uv1 = _mm_unpackhi_epi32(uv, uv);
+
+        const uint16_t *srcY[2] = { srcYTop + x, srcYBot + x };
+        uint32_t *dst[2] = { dstTop + x, dstBot + x };
+        for (size_t row = 0; row < 2; ++row) {
+            const __m128i y = _mm_loadu_si128((const __m128i *)srcY[row]);
+            const __m128i y0 = _mm_and_si128(_mm_cvtepu16_epi32(y), mask);
+            const __m128i y1 = _mm_and_si128(_mm_cvtepu16_epi32(_mm_srli_si128(y, 8)), mask);
+            _mm_storeu_si128((__m128i *)dst[row], _mm_or_si128(_mm_slli_epi32(y0, 10), uv0));
+            _mm_storeu_si128((__m128i *)(dst[row] + 4),
+                             _mm_or_si128(_mm_slli_epi32(y1, 10), uv1));
+        }
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+inline __m128i packRgbaSse41(__m128i yMult, __m128i ub, __m128i uvg, __m128i vr) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi32(1023);
+    // an arithmetic shift rounds down where the scalar division rounds towards zero, which
+    // only differs for negative values, which are clipped to 0 either way
+    const __m128i b = _mm_min_epi32(_mm_max_epi32(
+            _mm_srai_epi32(_mm_add_epi32(yMult, ub), 10), zero), max);
+    const __m128i g = _mm_min_epi32(_mm_max_epi32(
+            _mm_srai_epi32(_mm_add_epi32(yMult, uvg), 10), zero), max);
+    const __m128i r = _mm_min_epi32(_mm_max_epi32(
+            _mm_srai_epi32(_mm_add_epi32(yMult, vr), 10), zero), max);
+    return _mm_or_si128(_mm_or_si128(_mm_set1_epi32(kAlpha), _mm_slli_epi32(b, 20)),
+                        _mm_or_si128(_mm_slli_epi32(g, 10), r));
+}
+
+TARGET_SSE4_1
+size_t rgba1010102Sse41(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                        const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                        size_t width, const int32_t coeffs[6]) {
+    const __m128i _y = _mm_set1_epi32(coeffs[0]);
+    const __m128i _r_v = _mm_set1_epi32(coeffs[1]);
+    const __m128i _neg_g_u = _mm_set1_epi32(-coeffs[2]);
+    const __m128i _neg_g_v = _mm_set1_epi32(-coeffs[3]);
+    const __m128i _b_u = _mm_set1_epi32(coeffs[4]);
+    const __m128i _c16 = _mm_set1_epi32(coeffs[5]);
+    const __m128i c512 = _mm_set1_epi32(512);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcU + x / 2))), c512);
+        const __m128i v = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcV + x / 2))), c512);
+        const __m128i ub = _mm_mullo_epi32(u, _b_u);
+        const __m128i uvg = _mm_add_epi32(_mm_mullo_epi32(v, _neg_g_v),
+                                          _mm_mullo_epi32(u, _neg_g_u));
+        const __m128i vr = _mm_mullo_epi32(v, _r_v);
+        const __m128i ub0 = _mm_unpacklo_epi32(ub, ub), ub1 = _mm_unpackhi_epi32(ub, ub);
+        const __m128i uvg0 = _mm_unpacklo_epi32(uvg, uvg), uvg1 = _mm_unpackhi_epi32(uvg, uvg);
+        const __m128i vr0 = _mm_unpacklo_epi32(vr, vr), vr1 = _mm_unpackhi_epi32(vr, vr);
+
+        const uint16_t *srcY[2] = { srcYTop + x, srcYBot + x };
+        uint32_t *dst[2] = { dstTop + x, dstBot + x };
+        for (size_t row = 0; row < 2; ++row) {
+            const __m128i y = _mm_loadu_si128((const __m128i *)srcY[row]);
+            const __m128i y0 = _mm_sub_epi32(_mm_cvtepu16_epi32(y), _c16);
+            const __m128i y1 = _mm_sub_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(y, 8)), _c16);
+            _mm_storeu_si128((__m128i *)dst[row], packRgbaSse41(
+                    _mm_add_epi32(_mm_mullo_epi32(y0, _y), c512), ub0, uvg0, vr0));
+            _mm_storeu_si128((__m128i *)(dst[row] + 4), packRgbaSse41(
+                    _mm_add_epi32(_mm_mullo_epi32(y1, _y), c512), ub1, uvg1, vr1));
+        }
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+size_t shiftLeft6Sse41(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(src + x)), 6));
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+size_t shiftRight6Sse41(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x)), 6));
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+size_t narrow10To8Sse41(uint8_t *dst, const uint16_t *src, size_t width) {
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i a = _mm_and_si128(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x)), 2), mask);
+        const __m128i b = _mm_and_si128(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x + 8)), 2), mask);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(a, b));
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+size_t interleaveUVSse41(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                         size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcU + x)), 6);
+        const __m128i v = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcV + x)), 6);
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x), _mm_unpacklo_epi16(u, v));
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x + 8), _mm_unpackhi_epi16(u, v));
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+size_t deinterleaveUVSse41(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                           size_t width) {
+    const __m128i mask = _mm_set1_epi32(0xFFFF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i a = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(srcUV + 2 * x)), 6);
+        const __m128i b = _mm_srli_epi16(
+                _mm_loadu_si128((const __m128i *)(srcUV + 2 * x + 8)), 6);
+        _mm_storeu_si128((__m128i *)(dstU + x),
+                         _mm_packus_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storeu_si128((__m128i *)(dstV + x),
+                         _mm_packus_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16)));
+    }
+    return x;
+}
+
+TARGET_SSE4_1
+inline __m128i rgbToComponentSse41(__m128i r, __m128i g, __m128i b, const int16_t weights[3],
+                                   int32_t offset, int32_t min, int32_t max) {
+    __m128i c = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(r, _mm_set1_epi32(weights[0])),
+                                            _mm_mullo_epi32(g, _mm_set1_epi32(weights[1]))),
+                              _mm_mullo_epi32(b, _mm_set1_epi32(weights[2])));
+    c = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(c, _mm_set1_epi32(512)), 10),
+                      _mm_set1_epi32(offset));
+    return _mm_min_epi32(_mm_max_epi32(c, _mm_set1_epi32(min)), _mm_set1_epi32(max));
+}
+
+TARGET_SSE4_1
+size_t rgba1010102ToYuvSse41(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                             const uint32_t *src, size_t width, const int16_t weights[3][3],
+                             const int32_t levels[3]) {
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i p[2] = {
+            _mm_loadu_si128((const __m128i *)(src + x)),
+            _mm_loadu_si128((const __m128i *)(src + x + 4)),
+        };
+        __m128i y[2];
+        for (size_t i = 0; i < 2; ++i) {
+            const __m128i r = _mm_and_si128(p[i], mask);
+            const __m128i g = _mm_and_si128(_mm_srli_epi32(p[i], 10), mask);
+            const __m128i b = _mm_and_si128(_mm_srli_epi32(p[i], 20), mask);
+            y[i] = rgbToComponentSse41(r, g, b, weights[0], levels[0], levels[0], levels[1]);
+        }
+        _mm_storeu_si128((__m128i *)(dstY + x), _mm_packus_epi32(y[0], y[1]));
+
+        if (dstU != nullptr) {
+            const __m128i e = _mm_castps_si128(_mm_shuffle_ps(
+                    _mm_castsi128_ps(p[0]), _mm_castsi128_ps(p[1]), _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128i r = _mm_and_si128(e, mask);
+            const __m128i g = _mm_and_si128(_mm_srli_epi32(e, 10), mask);
+            const __m128i b = _mm_and_si128(_mm_srli_epi32(e, 20), mask);
+            const __m128i u = rgbToComponentSse41(
+                    r, g, b, weights[1], 512, levels[0], levels[2]);
+            const __m128i v = rgbToComponentSse41(
+                    r, g, b, weights[2], 512, levels[0], levels[2]);
+            _mm_storel_epi64((__m128i *)(dstU + x / 2), _mm_packus_epi32(u, u));
+            _mm_storel_epi64((__m128i *)(dstV + x / 2), _mm_packus_epi32(v, v));
+        }
+    }
+    return x;
+}
+
+const SimpleC2ConverterKernels kSse41Kernels = {
+    y410Sse41,
+    rgba1010102Sse41,
+    shiftLeft6Sse41,
+    shiftRight6Sse41,
+    narrow10To8Sse41,
+    interleaveUVSse41,
+    deinterleaveUVSse41,
+    rgba1010102ToYuvSse41,
+};
+
+// Duplicates each of the 8 lanes of |a| into 16 lanes, returned in |lo| and |hi|.
+TARGET_AVX2
+inline void duplicateLanesAvx2(__m256i a, __m256i *lo, __m256i *hi) {
+    const __m256i a0 = _mm256_unpacklo_epi32(a, a);
+    const __m256i a1 = _mm256_unpackhi_epi32(a, a);
+    *lo = _mm256_permute2x128_si256(a0, a1, 0x20);
+    *hi = _mm256_permute2x128_si256(a0, a1, 0x31);
+}
+
+TARGET_AVX2
+size_t y410Avx2(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                size_t width) {
+    const __m256i mask = _mm256_setr_epi32(kEvenMask, kOddMask, kEvenMask, kOddMask,
+                                           kEvenMask, kOddMask, kEvenMask, kOddMask);
+    const __m256i alpha = _mm256_set1_epi32(kAlpha);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i u = _mm256_and_si256(
+                _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(srcU + x / 2))), mask);
+        const __m256i v = _mm256_and_si256(
+                _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(srcV + x / 2))), mask);
+        __m256i uv0, uv1;
+        duplicateLanesAvx2(
+                _mm256_or_si256(_mm256_or_si256(u, _mm256_slli_epi32(v, 20)), alpha), &uv0, &uv1);
+
+        const uint16_t *srcY[2] = { srcYTop + x, srcYBot + x };
+        uint32_t *dst[2] = { dstTop + x, dstBot + x };
+        for (size_t row = 0; row < 2; ++row) {
+            const __m256i y = _mm256_loadu_si256((const __m256i *)srcY[row]);
+            const __m256i y0 = _mm256_and_si256(
+                    _mm256_cvtepu16_epi32(_mm256_castsi256_si128(y)), mask);
+            const __m256i y1 = _mm256_and_si256(
+                    _mm256_cvtepu16_epi32(_mm256_extracti128_si256(y, 1)), mask);
+            _mm256_storeu_si256((__m256i *)dst[row],
+                                _mm256_or_si256(_mm256_slli_epi32(y0, 10), uv0));
+            _mm256_storeu_si256((__m256i *)(dst[row] + 8),
+                                _mm256_or_si256(_mm256_slli_epi32(y1, 10), uv1));
+        }
+    }
+    return x;
+}
+
+TARGET_AVX2
+inline __m256i packRgbaAvx2(__m256i yMult, __m256i ub, __m256i uvg, __m256i vr) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(1023);
+    const __m256i b = _mm256_min_epi32(_mm256_max_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(yMult, ub), 10), zero), max);
+    const __m256i g = _mm256_min_epi32(_mm256_max_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(yMult, uvg), 10), zero), max);
+    const __m256i r = _mm256_min_epi32(_mm256_max_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(yMult, vr), 10), zero), max);
+    return _mm256_or_si256(
+            _mm256_or_si256(_mm256_set1_epi32(kAlpha), _mm256_slli_epi32(b, 20)),
+            _mm256_or_si256(_mm256_slli_epi32(g, 10), r));
+}
+
+TARGET_AVX2
+size_t rgba1010102Avx2(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                       const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                       size_t width, const int32_t coeffs[6]) {
+    const __m256i _y = _mm256_set1_epi32(coeffs[0]);
+    const __m256i _r_v = _mm256_set1_epi32(coeffs[1]);
+    const __m256i _neg_g_u = _mm256_set1_epi32(-coeffs[2]);
+    const __m256i _neg_g_v = _mm256_set1_epi32(-coeffs[3]);
+    const __m256i _b_u = _mm256_set1_epi32(coeffs[4]);
+    const __m256i _c16 = _mm256_set1_epi32(coeffs[5]);
+    const __m256i c512 = _mm256_set1_epi32(512);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i u = _mm256_sub_epi32(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcU + x / 2))), c512);
+        const __m256i v = _mm256_sub_epi32(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcV + x / 2))), c512);
+        __m256i ub0, ub1, uvg0, uvg1, vr0, vr1;
+        duplicateLanesAvx2(_mm256_mullo_epi32(u, _b_u), &ub0, &ub1);
+        duplicateLanesAvx2(_mm256_add_epi32(_mm256_mullo_epi32(v, _neg_g_v),
+                                            _mm256_mullo_epi32(u, _neg_g_u)), &uvg0, &uvg1);
+        duplicateLanesAvx2(_mm256_mullo_epi32(v, _r_v), &vr0, &vr1);
+
+        const uint16_t *srcY[2] = { srcYTop + x, srcYBot + x };
+        uint32_t *dst[2] = { dstTop + x, dstBot + x };
+        for (size_t row = 0; row < 2; ++row) {
+            const __m256i y = _mm256_loadu_si256((const __m256i *)srcY[row]);
+            const __m256i y0 = _mm256_sub_epi32(
+                    _mm256_cvtepu16_epi32(_mm256_castsi256_si128(y)), _c16);
+            const __m256i y1 = _mm256_sub_epi32(
+                    _mm256_cvtepu16_epi32(_mm256_extracti128_si256(y, 1)), _c16);
+            _mm256_storeu_si256((__m256i *)dst[row], packRgbaAvx2(
+                    _mm256_add_epi32(_mm256_mullo_epi32(y0, _y), c512), ub0, uvg0, vr0));
+            _mm256_storeu_si256((__m256i *)(dst[row] + 8), packRgbaAvx2(
+                    _mm256_add_epi32(_mm256_mullo_epi32(y1, _y), c512), ub1, uvg1, vr1));
+        }
+    }
+    return x;
+}
+
+TARGET_AVX2
+size_t shiftLeft6Avx2(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(src + x)), 6));
+    }
+    return x;
+}
+
+TARGET_AVX2
+size_t shiftRight6Avx2(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + x)), 6));
+    }
+    return x;
+}
+
+TARGET_AVX2
+size_t narrow10To8Avx2(uint8_t *dst, const uint16_t *src, size_t width) {
+    const __m256i mask = _mm256_set1_epi16(0xFF);
+    size_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i a = _mm256_and_si256(
+                _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + x)), 2), mask);
+        const __m256i b = _mm256_and_si256(
+                _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + x + 16)), 2), mask);
+        // packing works within 128-bit lanes
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+    return x;
+}
+
+TARGET_AVX2
+size_t interleaveUVAvx2(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                        size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i u = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(srcU + x)), 6);
+        const __m256i v = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(srcV + x)), 6);
+        const __m256i lo = _mm256_unpacklo_epi16(u, v);
+        const __m256i hi = _mm256_unpackhi_epi16(u, v);
+        _mm256_storeu_si256((__m256i *)(dstUV + 2 * x),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dstUV + 2 * x + 16),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    return x;
+}
+
+TARGET_AVX2
+size_t deinterleaveUVAvx2(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                          size_t width) {
+    const __m256i mask = _mm256_set1_epi32(0xFFFF);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i a = _mm256_srli_epi16(
+                _mm256_loadu_si256((const __m256i *)(srcUV + 2 * x)), 6);
+        const __m256i b = _mm256_srli_epi16(
+                _mm256_loadu_si256((const __m256i *)(srcUV + 2 * x + 16)), 6);
+        _mm256_storeu_si256((__m256i *)(dstU + x), _mm256_permute4x64_epi64(
+                _mm256_packus_epi32(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask)),
+                0xD8));
+        _mm256_storeu_si256((__m256i *)(dstV + x), _mm256_permute4x64_epi64(
+                _mm256_packus_epi32(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16)),
+                0xD8));
+    }
+    return x;
+}
+
+TARGET_AVX2
+inline __m256i rgbToComponentAvx2(__m256i r, __m256i g, __m256i b, const int16_t weights[3],
+                                  int32_t offset, int32_t min, int32_t max) {
+    __m256i c = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(weights[0])),
+                             _mm256_mullo_epi32(g, _mm256_set1_epi32(weights[1]))),
+            _mm256_mullo_epi32(b, _mm256_set1_epi32(weights[2])));
+    c = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c, _mm256_set1_epi32(512)), 10),
+                         _mm256_set1_epi32(offset));
+    return _mm256_min_epi32(_mm256_max_epi32(c, _mm256_set1_epi32(min)),
+                            _mm256_set1_epi32(max));
+}
+
+TARGET_AVX2
+size_t rgba1010102ToYuvAvx2(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                            const uint32_t *src, size_t width, const int16_t weights[3][3],
+                            const int32_t levels[3]) {
+    const __m256i mask = _mm256_set1_epi32(0x3FF);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i p[2] = {
+            _mm256_loadu_si256((const __m256i *)(src + x)),
+            _mm256_loadu_si256((const __m256i *)(src + x + 8)),
+        };
+        __m256i y[2];
+        for (size_t i = 0; i < 2; ++i) {
+            const __m256i r = _mm256_and_si256(p[i], mask);
+            const __m256i g = _mm256_and_si256(_mm256_srli_epi32(p[i], 10), mask);
+            const __m256i b = _mm256_and_si256(_mm256_srli_epi32(p[i], 20), mask);
+            y[i] = rgbToComponentAvx2(r, g, b, weights[0], levels[0], levels[0], levels[1]);
+        }
+        _mm256_storeu_si256((__m256i *)(dstY + x),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi32(y[0], y[1]), 0xD8));
+
+        if (dstU != nullptr) {
+            const __m256i e = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(
+                    _mm256_castsi256_ps(p[0]), _mm256_castsi256_ps(p[1]),
+                    _MM_SHUFFLE(2, 0, 2, 0))), 0xD8);
+            const __m256i r = _mm256_and_si256(e, mask);
+            const __m256i g = _mm256_and_si256(_mm256_srli_epi32(e, 10), mask);
+            const __m256i b = _mm256_and_si256(_mm256_srli_epi32(e, 20), mask);
+            const __m256i u = rgbToComponentAvx2(
+                    r, g, b, weights[1], 512, levels[0], levels[2]);
+            const __m256i v = rgbToComponentAvx2(
+                    r, g, b, weights[2], 512, levels[0], levels[2]);
+            _mm_storeu_si128((__m128i *)(dstU + x / 2), _mm256_castsi256_si128(
+                    _mm256_permute4x64_epi64(_mm256_packus_epi32(u, u), 0x08)));
+            _mm_storeu_si128((__m128i *)(dstV + x / 2), _mm256_castsi256_si128(
+                    _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08)));
+        }
+    }
+    return x;
+}
+
+const SimpleC2ConverterKernels kAvx2Kernels = {
+    y410Avx2,
+    rgba1010102Avx2,
+    shiftLeft6Avx2,
+    shiftRight6Avx2,
+    narrow10To8Avx2,
+    interleaveUVAvx2,
+    deinterleaveUVAvx2,
+    rgba1010102ToYuvAvx2,
+};
+
+#endif  // USE_SSE_AVX
+
+}  // namespace
+
+const SimpleC2ConverterKernels *GetSimpleC2ConverterKernels(CONV_ISA_T isa) {
+    switch (isa) {
+    case CONV_ISA_SCALAR:
+        return &kScalarKernels;
+#if USE_NEON
+    case CONV_ISA_NEON:
+        return &kNeonKernels;
+#endif
+#if USE_SSE_AVX
+    case CONV_ISA_SSE4_1:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1") ? &kSse41Kernels : nullptr;
+    case CONV_ISA_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? &kAvx2Kernels : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+}  // namespace android
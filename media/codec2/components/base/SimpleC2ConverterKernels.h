@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIMPLE_C2_CONVERTER_KERNELS_H_
+#define SIMPLE_C2_CONVERTER_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SimpleC2Component.h>
+
+namespace android {
+
+/**
+ * Vectorized row kernels of the format converters of SimpleC2Component.
+ *
+ * Each kernel converts the leading pixels of a row (or of a pair of rows) in
+ * multiples of its vector width, and returns the number of pixels converted;
+ * the caller converts the rest with the scalar code. The kernels produce the
+ * same output as the scalar code for any input, including samples that do not
+ * fit in 10 bits.
+ */
+struct SimpleC2ConverterKernels {
+    // Y410 of two rows, from 4:2:0 samples.
+    size_t (*y410)(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                   const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                   size_t width);
+    // RGBA1010102 of two rows, from 4:2:0 samples. |coeffs| is
+    // { _y, _r_v, _g_u, _g_v, _b_u, _c16 }.
+    size_t (*rgba1010102)(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                          const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                          size_t width, const int32_t coeffs[6]);
+    // dst[x] = src[x] << 6
+    size_t (*shiftLeft6)(uint16_t *dst, const uint16_t *src, size_t width);
+    // dst[x] = src[x] >> 6
+    size_t (*shiftRight6)(uint16_t *dst, const uint16_t *src, size_t width);
+    // dst[x] = src[x] >> 2, truncated to 8 bits
+    size_t (*narrow10To8)(uint8_t *dst, const uint16_t *src, size_t width);
+    // dstUV[2x] = srcU[x] << 6, dstUV[2x + 1] = srcV[x] << 6
+    size_t (*interleaveUV)(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                           size_t width);
+    // dstU[x] = srcUV[2x] >> 6, dstV[x] = srcUV[2x + 1] >> 6
+    size_t (*deinterleaveUV)(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                             size_t width);
+    // Y of one row of RGBA1010102, and U and V of its even pixels if dstU and dstV are not
+    // null. |weights| is the 3x3 matrix of convertRGBA1010102ToYUV420Planar16() and
+    // |levels| is { zero, max luma, max chroma }.
+    size_t (*rgba1010102ToYuv)(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                               const uint32_t *src, size_t width, const int16_t weights[3][3],
+                               const int32_t levels[3]);
+};
+
+/**
+ * Returns the kernels for |isa|, or nullptr if the CPU does not support it.
+ */
+const SimpleC2ConverterKernels *GetSimpleC2ConverterKernels(CONV_ISA_T isa);
+
+}  // namespace android
+
+#endif  // SIMPLE_C2_CONVERTER_KERNELS_H_
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2TaskPool"
+#include <log/log.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
+#include <cutils/properties.h>
+#include <system/thread_defs.h>
+#include <utils/AndroidThreads.h>
+
+#include <SimpleC2TaskPool.h>
+
+namespace android {
+
+namespace {
+
+constexpr char kPoolThreadsProperty[] = "debug.stagefright.c2.sw.pool.threads";
+constexpr size_t kMaxPoolThreads = 64;
+
+size_t GetPoolSize() {
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int32_t numThreads = property_get_int32(kPoolThreadsProperty, 0);
+    if (numThreads <= 0) {
+        numThreads = numCpus > 0 ? numCpus : 1;
+    }
+    return std::min((size_t)numThreads, kMaxPoolThreads);
+}
+
+}  // namespace
+
+struct SimpleC2TaskPool::Job {
+    explicit Job(const std::function<void(size_t)> &f, size_t count)
+        : fn(f), remaining(count) {}
+
+    const std::function<void(size_t)> &fn;
+    std::atomic<size_t> remaining;
+    // Completing the last task notifies |done| with |lock| held, so that the
+    // job, which lives on the stack of parallelFor(), outlives its tasks.
+    std::mutex lock;
+    std::condition_variable done;
+
+    void run(size_t index) {
+        fn(index);
+        std::lock_guard<std::mutex> l(lock);
+        if (--remaining == 0) {
+            done.notify_all();
+        }
+    }
+};
+
+// static
+SimpleC2TaskPool &SimpleC2TaskPool::Get() {
+    // never destroyed, as the workers run until the process exits
+    static SimpleC2TaskPool *sPool = new SimpleC2TaskPool(GetPoolSize());
+    return *sPool;
+}
+
+SimpleC2TaskPool::SimpleC2TaskPool(size_t numWorkers)
+    : mNumWorkers(std::max(numWorkers, (size_t)1)),
+      mNextQueue(0),
+      mNumQueued(0),
+      mStarted(false),
+      mThreadsInUse(0),
+      mNumSessions(0) {
+    for (size_t i = 0; i < mNumWorkers; ++i) {
+        mQueues.emplace_back(new Queue);
+    }
+}
+
+void SimpleC2TaskPool::start_l() {
+    if (mStarted) {
+        return;
+    }
+    mStarted = true;
+    ALOGV("starting %zu workers", mNumWorkers);
+    for (size_t i = 0; i < mNumWorkers; ++i) {
+        std::thread([this, i] { workerLoop(i); }).detach();
+    }
+}
+
+void SimpleC2TaskPool::workerLoop(size_t id) {
+    char name[16];
+    snprintf(name, sizeof(name), "C2SwPool#%zu", id);
+    pthread_setname_np(pthread_self(), name);
+    androidSetThreadPriority(0, ANDROID_PRIORITY_VIDEO);
+
+    for (;;) {
+        if (runOne(id, true /* ownQueue */)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> l(mLock);
+        mWorkAvailable.wait(l, [this] { return mNumQueued > 0; });
+    }
+}
+
+bool SimpleC2TaskPool::runOne(size_t firstQueue, bool ownQueue) {
+    // A worker takes the newest task of its own queue, and otherwise steals the
+    // oldest task of another.
+    for (size_t i = 0; i < mNumWorkers; ++i) {
+        Queue &queue = *mQueues[(firstQueue + i) % mNumWorkers];
+        Task task;
+        {
+            std::lock_guard<std::mutex> l(queue.lock);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (ownQueue && i == 0) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> l(mLock);
+            --mNumQueued;
+        }
+        task.job->run(task.index);
+        return true;
+    }
+    return false;
+}
+
+void SimpleC2TaskPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+    if (count <= 1 || mNumWorkers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    Job job(fn, count);
+    // Count the tasks before queueing them, as runOne() may take them as soon
+    // as they are queued. Until then, waking workers find nothing to run.
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        start_l();
+        mNumQueued += count - 1;
+    }
+    // The calling thread runs the first task itself.
+    for (size_t i = 1; i < count; ++i) {
+        Queue &queue = *mQueues[mNextQueue++ % mNumWorkers];
+        std::lock_guard<std::mutex> l(queue.lock);
+        queue.tasks.push_back({&job, i});
+    }
+    mWorkAvailable.notify_all();
+
+    job.run(0);
+    size_t nextQueue = 0;
+    while (job.remaining > 0 && runOne(nextQueue++ % mNumWorkers, false /* ownQueue */)) {
+    }
+    std::unique_lock<std::mutex> l(job.lock);
+    job.done.wait(l, [&job] { return job.remaining == 0; });
+}
+
+size_t SimpleC2TaskPool::shareThreads_l(size_t wanted) const {
+    // An equal share of the budget, or the threads the other sessions leave
+    // unused if that is more.
+    size_t share = std::max(mNumWorkers / std::max(mNumSessions, (size_t)1), (size_t)1);
+    size_t available = mNumWorkers > mThreadsInUse ? mNumWorkers - mThreadsInUse : 0;
+    return std::max(std::min(wanted, std::max(share, available)), (size_t)1);
+}
+
+size_t SimpleC2TaskPool::acquireThreads(size_t wanted) {
+    std::lock_guard<std::mutex> l(mLock);
+    ++mNumSessions;
+    size_t count = shareThreads_l(wanted);
+    mThreadsInUse += count;
+    ALOGV("acquired %zu of %zu threads wanted, %zu in use by %zu sessions",
+            count, wanted, mThreadsInUse, mNumSessions);
+    return count;
+}
+
+size_t SimpleC2TaskPool::rebalanceThreads(size_t held, size_t wanted) {
+    std::lock_guard<std::mutex> l(mLock);
+    mThreadsInUse -= std::min(held, mThreadsInUse);
+    size_t count = shareThreads_l(wanted);
+    mThreadsInUse += count;
+    if (count != held) {
+        ALOGV("rebalanced %zu to %zu of %zu threads wanted, %zu in use by %zu sessions",
+                held, count, wanted, mThreadsInUse, mNumSessions);
+    }
+    return count;
+}
+
+void SimpleC2TaskPool::releaseThreads(size_t count) {
+    if (count == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> l(mLock);
+    mThreadsInUse -= std::min(count, mThreadsInUse);
+    mNumSessions -= std::min((size_t)1, mNumSessions);
+}
+
+}  // namespace android
@@ -37,6 +37,21 @@ typedef enum {
     CONV_FORMAT_I444,
 } CONV_FORMAT_T;
 
+typedef enum {
+    CONV_ISA_SCALAR,
+    CONV_ISA_NEON,
+    CONV_ISA_SSE4_1,
+    CONV_ISA_AVX2,
+} CONV_ISA_T;
+
+/**
+ * The converters below use the best instruction set supported by the CPU.
+ * setConverterIsa() restricts them to |isa|, for tests and benchmarks, and
+ * returns false if the CPU does not support it.
+ */
+bool setConverterIsa(CONV_ISA_T isa);
+CONV_ISA_T getConverterIsa();
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIMPLE_C2_TASK_POOL_H_
+#define SIMPLE_C2_TASK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * A process-wide pool of worker threads shared by all software components, so
+ * that concurrent sessions in one process do not each start a thread per core.
+ *
+ * Each worker has its own task deque. A worker runs the tasks of its own deque
+ * and steals from the others when it runs out, and a thread waiting for its
+ * tasks to complete runs queued tasks too, so tasks may submit and wait for
+ * tasks of their own.
+ *
+ * The size of the pool is the concurrency budget of the process: the number of
+ * online CPUs, unless set by the debug.stagefright.c2.sw.pool.threads
+ * property. Codec libraries that run their own threads take their share of the
+ * budget through acquireThreads(), and adjust it through rebalanceThreads()
+ * whenever they can change their number of threads.
+ */
+class SimpleC2TaskPool {
+public:
+    /**
+     * Returns the pool of this process.
+     */
+    static SimpleC2TaskPool &Get();
+
+    /**
+     * Returns the number of worker threads.
+     */
+    size_t size() const { return mNumWorkers; }
+
+    /**
+     * Runs fn(0) to fn(count - 1) on the workers and the calling thread, and
+     * returns when all of them have completed.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    /**
+     * Registers a session, and returns the number of threads, out of |wanted|,
+     * that it may ask its codec library for. Each session is guaranteed an
+     * equal share of the budget, at least 1 thread; it gets more while other
+     * sessions leave threads unused. The result must be returned with
+     * releaseThreads() when the library is closed.
+     */
+    size_t acquireThreads(size_t wanted);
+
+    /**
+     * Returns the number of threads, out of |wanted|, that a session holding
+     * |held| threads may now use, as sessions come and go. The result replaces
+     * |held|.
+     */
+    size_t rebalanceThreads(size_t held, size_t wanted);
+
+    /**
+     * Unregisters a session holding |count| threads. Does nothing if |count|
+     * is 0, so that sessions that never acquired threads can call it.
+     */
+    void releaseThreads(size_t count);
+
+private:
+    struct Job;
+    struct Task {
+        Job *job;
+        size_t index;
+    };
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    const size_t mNumWorkers;
+    std::vector<std::unique_ptr<Queue>> mQueues;  // one per worker
+    std::atomic<size_t> mNextQueue;
+
+    std::mutex mLock;
+    std::condition_variable mWorkAvailable;
+    size_t mNumQueued;  // tasks in all queues
+    bool mStarted;
+    size_t mThreadsInUse;  // by codec libraries
+    size_t mNumSessions;   // codec libraries holding threads
+
+    explicit SimpleC2TaskPool(size_t numWorkers);
+
+    void start_l();
+    size_t shareThreads_l(size_t wanted) const;
+    void workerLoop(size_t id);
+    bool runOne(size_t firstQueue, bool ownQueue);
+
+    SimpleC2TaskPool(const SimpleC2TaskPool &) = delete;
+    SimpleC2TaskPool &operator=(const SimpleC2TaskPool &) = delete;
+};
+
+}  // namespace android
+
+#endif  // SIMPLE_C2_TASK_POOL_H_
@@ -26,6 +26,7 @@
 #include <Codec2CommonUtils.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 #include <log/log.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/MediaDefs.h>
@@ -543,7 +544,11 @@ bool C2SoftDav1dDec::initDecoder() {
     Dav1dSettings lib_settings;
     dav1d_default_settings(&lib_settings);
     int cpu_count = GetCPUCoreCount();
-    lib_settings.n_threads = std::max(cpu_count / 2, 1);  // use up to half the cores by default.
+    if (mNumThreads == 0) {
+        // use up to half the cores by default, within the budget shared with other sessions.
+        mNumThreads = SimpleC2TaskPool::Get().acquireThreads(std::max(cpu_count / 2, 1));
+    }
+    lib_settings.n_threads = mNumThreads;
 
     int32_t numThreads =
             android::base::GetIntProperty(NUM_THREADS_DAV1D_PROPERTY, NUM_THREADS_DAV1D_DEFAULT);
@@ -569,6 +574,8 @@ void C2SoftDav1dDec::destroyDecoder() {
         mOutputBufferIndex = 0;
         mInputBufferIndex = 0;
     }
+    SimpleC2TaskPool::Get().releaseThreads(mNumThreads);
+    mNumThreads = 0;
 #ifdef FILE_DUMP_ENABLE
     mC2SoftDav1dDump.destroyDumping();
 #endif
@@ -58,6 +58,7 @@ struct C2SoftDav1dDec : public SimpleC2Component {
     int mOutputBufferIndex = 0;
 
     Dav1dContext* mDav1dCtx = nullptr;
+    size_t mNumThreads = 0;  // acquired from SimpleC2TaskPool
 
     // configurations used by component in process
     // (TODO: keep this in intf but make them internal only)
@@ -25,6 +25,7 @@
 #include <Codec2CommonUtils.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 #include <libyuv.h>
 #include <log/log.h>
 #include <media/stagefright/foundation/AUtils.h>
@@ -509,7 +510,10 @@ bool C2SoftGav1Dec::initDecoder() {
   }
 
   libgav1::DecoderSettings settings = {};
-  settings.threads = GetCPUCoreCount();
+  if (mNumThreads == 0) {
+    mNumThreads = SimpleC2TaskPool::Get().acquireThreads(GetCPUCoreCount());
+  }
+  settings.threads = mNumThreads;
   int32_t numThreads = android::base::GetIntProperty(kNumThreadsProperty, 0);
   if (numThreads > 0 && numThreads < settings.threads) {
     settings.threads = numThreads;
@@ -525,7 +529,11 @@ bool C2SoftGav1Dec::initDecoder() {
   return true;
 }
 
-void C2SoftGav1Dec::destroyDecoder() { mCodecCtx = nullptr; }
+void C2SoftGav1Dec::destroyDecoder() {
+  mCodecCtx = nullptr;
+  SimpleC2TaskPool::Get().releaseThreads(mNumThreads);
+  mNumThreads = 0;
+}
 
 void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
   uint32_t flags = 0;
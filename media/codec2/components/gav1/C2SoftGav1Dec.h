@@ -52,6 +52,7 @@ struct C2SoftGav1Dec : public SimpleC2Component {
  private:
   std::shared_ptr<IntfImpl> mIntf;
   std::unique_ptr<libgav1::Decoder> mCodecCtx;
+  size_t mNumThreads = 0;  // acquired from SimpleC2TaskPool
 
   // configurations used by component in process
   // (TODO: keep this in intf but make them internal only)
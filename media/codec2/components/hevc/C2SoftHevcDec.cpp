@@ -27,6 +27,7 @@
 #include <C2PlatformSupport.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 
 #include "C2SoftHevcDec.h"
 
@@ -333,6 +334,7 @@ C2SoftHevcDec::C2SoftHevcDec(
         mIntf(intfImpl),
         mDecHandle(nullptr),
         mOutBufferFlush(nullptr),
+        mNumCores(0),
         mIvColorformat(IV_YUV_420P),
         mOutputDelay(kDefaultOutputDelay),
         mWidth(320),
@@ -507,7 +509,10 @@ status_t C2SoftHevcDec::getVersion() {
 
 status_t C2SoftHevcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    if (mNumCores == 0) {
+        mNumCores = SimpleC2TaskPool::Get().acquireThreads(
+                MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -659,6 +664,11 @@ status_t C2SoftHevcDec::resetDecoder() {
         return UNKNOWN_ERROR;
     }
     mStride = 0;
+    // the share of threads of this session may have changed since it started
+    if (mNumCores > 0) {
+        mNumCores = SimpleC2TaskPool::Get().rebalanceThreads(
+                mNumCores, MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     (void) setNumCores();
     mSignalledError = false;
     mHeaderDecoded = false;
@@ -674,6 +684,8 @@ void C2SoftHevcDec::resetPlugin() {
 }
 
 status_t C2SoftHevcDec::deleteDecoder() {
+    SimpleC2TaskPool::Get().releaseThreads(mNumCores);
+    mNumCores = 0;
     if (mDecHandle) {
         ivdext_delete_ip_t s_delete_ip = {};
         ivdext_delete_op_t s_delete_op = {};
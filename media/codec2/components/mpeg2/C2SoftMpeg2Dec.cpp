@@ -27,6 +27,7 @@
 #include <C2PlatformSupport.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 
 #include "C2SoftMpeg2Dec.h"
 #include "impeg2d.h"
@@ -324,6 +325,7 @@ C2SoftMpeg2Dec::C2SoftMpeg2Dec(
         mDecHandle(nullptr),
         mMemRecords(nullptr),
         mOutBufferDrain(nullptr),
+        mNumCores(0),
         mIvColorformat(IV_YUV_420P),
         mWidth(320),
         mHeight(240),
@@ -576,7 +578,10 @@ status_t C2SoftMpeg2Dec::initDecoder() {
 
     if (OK != createDecoder()) return UNKNOWN_ERROR;
 
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    if (mNumCores == 0) {
+        mNumCores = SimpleC2TaskPool::Get().acquireThreads(
+                MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -727,6 +732,11 @@ status_t C2SoftMpeg2Dec::resetDecoder() {
         ALOGE("error in %s: 0x%x", __func__, s_reset_op.u4_error_code);
         return UNKNOWN_ERROR;
     }
+    // the share of threads of this session may have changed since it started
+    if (mNumCores > 0) {
+        mNumCores = SimpleC2TaskPool::Get().rebalanceThreads(
+                mNumCores, MIN(getCpuCoreCount(), MAX_NUM_CORES));
+    }
     (void) setNumCores();
     mStride = 0;
     mSignalledError = false;
@@ -743,6 +753,8 @@ void C2SoftMpeg2Dec::resetPlugin() {
 }
 
 status_t C2SoftMpeg2Dec::deleteDecoder() {
+    SimpleC2TaskPool::Get().releaseThreads(mNumCores);
+    mNumCores = 0;
     if (mMemRecords) {
         iv_mem_rec_t *ps_mem_rec = mMemRecords;
 
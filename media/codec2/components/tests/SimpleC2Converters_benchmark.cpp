@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of the SimpleC2Component format converters on 10-bit
+// 4K frames, for each instruction set supported by the CPU. Throughput counts
+// the bytes read and written. The Y410/RGBA1010102 converter also runs on the
+// SimpleC2TaskPool, so its throughput scales with the number of cores.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <C2Config.h>
+#include <SimpleC2Component.h>
+
+using namespace android;
+
+static constexpr size_t kWidth = 3840;
+static constexpr size_t kHeight = 2160;
+static constexpr size_t kYSize = kWidth * kHeight;
+static constexpr size_t kUVSize = kYSize / 4;
+
+// Returns false, and skips the benchmark, if the instruction set is not supported.
+static bool setIsa(benchmark::State &state) {
+    if (!setConverterIsa((CONV_ISA_T)state.range(0))) {
+        state.SkipWithError("instruction set not supported");
+        return false;
+    }
+    return true;
+}
+
+// 10-bit samples
+static std::vector<uint16_t> makePlane(size_t size) {
+    std::vector<uint16_t> plane(size);
+    for (size_t i = 0; i < size; ++i) {
+        plane[i] = (i * 7) & 0x3FF;
+    }
+    return plane;
+}
+
+static void BM_Y410OrRGBA1010102(benchmark::State &state) {
+    if (!setIsa(state)) {
+        return;
+    }
+    const std::vector<uint16_t> y = makePlane(kYSize);
+    const std::vector<uint16_t> u = makePlane(kUVSize);
+    const std::vector<uint16_t> v = makePlane(kUVSize);
+    std::vector<uint32_t> dst(kYSize);
+    for (auto _ : state) {
+        convertYUV420Planar16ToY410OrRGBA1010102(
+                dst.data(), y.data(), u.data(), v.data(), kWidth, kWidth / 2, kWidth / 2,
+                kWidth, kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * ((kYSize + 2 * kUVSize) * 2 + kYSize * 4));
+}
+
+static void BM_YUV420Planar16ToP010(benchmark::State &state) {
+    if (!setIsa(state)) {
+        return;
+    }
+    const std::vector<uint16_t> y = makePlane(kYSize);
+    const std::vector<uint16_t> u = makePlane(kUVSize);
+    const std::vector<uint16_t> v = makePlane(kUVSize);
+    std::vector<uint16_t> dst(kYSize + 2 * kUVSize);
+    for (auto _ : state) {
+        convertYUV420Planar16ToP010(
+                dst.data(), dst.data() + kYSize, y.data(), u.data(), v.data(), kWidth,
+                kWidth / 2, kWidth / 2, kWidth, kWidth, kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (kYSize + 2 * kUVSize) * 2 * 2);
+}
+
+static void BM_P010ToYUV420Planar16(benchmark::State &state) {
+    if (!setIsa(state)) {
+        return;
+    }
+    const std::vector<uint16_t> src = makePlane(kYSize + 2 * kUVSize);
+    std::vector<uint16_t> dst(kYSize + 2 * kUVSize);
+    for (auto _ : state) {
+        convertP010ToYUV420Planar16(
+                dst.data(), dst.data() + kYSize, dst.data() + kYSize + kUVSize, src.data(),
+                src.data() + kYSize, kWidth, kWidth, kWidth, kWidth / 2, kWidth / 2, kWidth,
+                kHeight);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (kYSize + 2 * kUVSize) * 2 * 2);
+}
+
+static void BM_YUV420Planar16ToYV12(benchmark::State &state) {
+    if (!setIsa(state)) {
+        return;
+    }
+    const std::vector<uint16_t> y = makePlane(kYSize);
+    const std::vector<uint16_t> u = makePlane(kUVSize);
+    const std::vector<uint16_t> v = makePlane(kUVSize);
+    std::vector<uint8_t> dst(kYSize + 2 * kUVSize);
+    for (auto _ : state) {
+        convertYUV420Planar16ToYV12(
+                dst.data(), dst.data() + kYSize, dst.data() + kYSize + kUVSize, y.data(),
+                u.data(), v.data(), kWidth, kWidth / 2, kWidth / 2, kWidth, kWidth / 2, kWidth,
+                kHeight);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (kYSize + 2 * kUVSize) * 3);
+}
+
+static void BM_RGBA1010102ToYUV420Planar16(benchmark::State &state) {
+    if (!setIsa(state)) {
+        return;
+    }
+    std::vector<uint32_t> src(kYSize);
+    for (size_t i = 0; i < kYSize; ++i) {
+        src[i] = 3u << 30 | (i & 0x3FF) << 20 | ((i * 3) & 0x3FF) << 10 | ((i * 5) & 0x3FF);
+    }
+    std::vector<uint16_t> dst(kYSize + 2 * kUVSize);
+    for (auto _ : state) {
+        convertRGBA1010102ToYUV420Planar16(
+                dst.data(), dst.data() + kYSize, dst.data() + kYSize + kUVSize, src.data(),
+                kWidth, kWidth, kHeight, C2Color::MATRIX_BT2020, C2Color::RANGE_LIMITED);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (kYSize * 4 + (kYSize + 2 * kUVSize) * 2));
+}
+
+#define CONVERTER_BENCHMARK(name) \
+    BENCHMARK(name)->DenseRange(CONV_ISA_SCALAR, CONV_ISA_AVX2)->ArgName("isa")
+
+CONVERTER_BENCHMARK(BM_Y410OrRGBA1010102);
+CONVERTER_BENCHMARK(BM_YUV420Planar16ToP010);
+CONVERTER_BENCHMARK(BM_P010ToYUV420Planar16);
+CONVERTER_BENCHMARK(BM_YUV420Planar16ToYV12);
+CONVERTER_BENCHMARK(BM_RGBA1010102ToYUV420Planar16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <C2Config.h>
+#include <SimpleC2Component.h>
+
+namespace android {
+
+// Frame sizes, with widths around the vector widths of the kernels.
+static const struct {
+    size_t width;
+    size_t height;
+} kSizes[] = {
+    {4, 2}, {8, 2}, {14, 4}, {16, 2}, {30, 6}, {32, 4}, {46, 2}, {64, 8}, {130, 4}, {1922, 4},
+};
+
+// Odd sizes, for the converters that support them.
+static const struct {
+    size_t width;
+    size_t height;
+} kOddSizes[] = {
+    {1, 1}, {7, 3}, {17, 5}, {33, 1}, {127, 3},
+};
+
+// Strides are larger than the rows, so that writes past the end of a row are caught.
+static constexpr size_t kPadding = 40;
+
+class SimpleC2ConvertersTest : public ::testing::TestWithParam<CONV_ISA_T> {
+protected:
+    void SetUp() override {
+        mDefaultIsa = getConverterIsa();
+        if (!setConverterIsa(GetParam())) {
+            GTEST_SKIP() << "instruction set not supported";
+        }
+    }
+
+    void TearDown() override {
+        setConverterIsa(mDefaultIsa);
+    }
+
+    // Returns samples of all 16 bits, as the scalar code defines the result of samples that
+    // do not fit in 10 bits too.
+    template <typename T>
+    std::vector<T> randomPlane(size_t size) {
+        std::vector<T> plane(size);
+        for (T &sample : plane) {
+            sample = (T)mRandom();
+        }
+        return plane;
+    }
+
+    // Runs |convert| with the scalar code and with the instruction set under test, and
+    // checks that the outputs, including the padding, are the same.
+    template <typename T>
+    void expectSameAsScalar(size_t size, const std::function<void(T *)> &convert) {
+        std::vector<T> expected(size, 0x5A);
+        std::vector<T> actual(size, 0x5A);
+        ASSERT_TRUE(setConverterIsa(CONV_ISA_SCALAR));
+        convert(expected.data());
+        ASSERT_TRUE(setConverterIsa(GetParam()));
+        convert(actual.data());
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(expected[i], actual[i]) << "at " << i << " of " << size;
+        }
+    }
+
+    CONV_ISA_T mDefaultIsa;
+    std::mt19937 mRandom;
+};
+
+TEST_P(SimpleC2ConvertersTest, Y410OrRGBA1010102) {
+    // Either converts to Y410 or to RGBA1010102, depending on the platform version.
+    const std::shared_ptr<const C2ColorAspectsStruct> aspects[] = {
+        nullptr,
+        std::make_shared<C2ColorAspectsStruct>(
+                C2Color::RANGE_FULL, C2Color::PRIMARIES_BT709, C2Color::TRANSFER_170M,
+                C2Color::MATRIX_BT601),
+        std::make_shared<C2ColorAspectsStruct>(
+                C2Color::RANGE_LIMITED, C2Color::PRIMARIES_BT2020, C2Color::TRANSFER_ST2084,
+                C2Color::MATRIX_BT2020),
+    };
+    for (const auto &size : kSizes) {
+        const size_t yStride = size.width + kPadding;
+        const size_t uvStride = size.width / 2 + kPadding;
+        const std::vector<uint16_t> y = randomPlane<uint16_t>(yStride * size.height);
+        const std::vector<uint16_t> u = randomPlane<uint16_t>(uvStride * size.height / 2);
+        const std::vector<uint16_t> v = randomPlane<uint16_t>(uvStride * size.height / 2);
+        for (const auto &aspect : aspects) {
+            SCOPED_TRACE(testing::Message() << size.width << "x" << size.height);
+            expectSameAsScalar<uint32_t>(yStride * size.height, [&](uint32_t *dst) {
+                convertYUV420Planar16ToY410OrRGBA1010102(
+                        dst, y.data(), u.data(), v.data(), yStride, uvStride, uvStride,
+                        yStride, size.width, size.height, aspect);
+            });
+        }
+    }
+}
+
+TEST_P(SimpleC2ConvertersTest, YUV420Planar16ToP010) {
+    auto test = [this](size_t width, size_t height) {
+        SCOPED_TRACE(testing::Message() << width << "x" << height);
+        const size_t srcStride = width + kPadding;
+        const size_t dstStride = width + 1 + kPadding;
+        const size_t uvHeight = (height + 1) / 2;
+        const std::vector<uint16_t> y = randomPlane<uint16_t>(srcStride * height);
+        const std::vector<uint16_t> u = randomPlane<uint16_t>(srcStride * uvHeight);
+        const std::vector<uint16_t> v = randomPlane<uint16_t>(srcStride * uvHeight);
+        for (bool isMonochrome : {false, true}) {
+            expectSameAsScalar<uint16_t>(dstStride * (height + uvHeight), [&](uint16_t *dst) {
+                convertYUV420Planar16ToP010(
+                        dst, dst + dstStride * height, y.data(), u.data(), v.data(), srcStride,
+                        srcStride, srcStride, dstStride, dstStride, width, height,
+                        isMonochrome);
+            });
+        }
+    };
+    for (const auto &size : kSizes) {
+        test(size.width, size.height);
+    }
+    for (const auto &size : kOddSizes) {
+        test(size.width, size.height);
+    }
+}
+
+TEST_P(SimpleC2ConvertersTest, P010ToYUV420Planar16) {
+    auto test = [this](size_t width, size_t height) {
+        SCOPED_TRACE(testing::Message() << width << "x" << height);
+        const size_t srcStride = width + 1 + kPadding;
+        const size_t dstStride = width + kPadding;
+        const size_t uvHeight = (height + 1) / 2;
+        const std::vector<uint16_t> src = randomPlane<uint16_t>(srcStride * (height + uvHeight));
+        for (bool isMonochrome : {false, true}) {
+            expectSameAsScalar<uint16_t>(dstStride * (height + 2 * uvHeight), [&](uint16_t *dst) {
+                convertP010ToYUV420Planar16(
+                        dst, dst + dstStride * height, dst + dstStride * (height + uvHeight),
+                        src.data(), src.data() + srcStride * height, srcStride, srcStride,
+                        dstStride, dstStride, dstStride, width, height, isMonochrome);
+            });
+        }
+    };
+    for (const auto &size : kSizes) {
+        test(size.width, size.height);
+    }
+    for (const auto &size : kOddSizes) {
+        test(size.width, size.height);
+    }
+}
+
+TEST_P(SimpleC2ConvertersTest, YUV420Planar16ToYV12) {
+    auto test = [this](size_t width, size_t height) {
+        SCOPED_TRACE(testing::Message() << width << "x" << height);
+        const size_t srcStride = width + kPadding;
+        const size_t dstStride = width + kPadding;
+        const size_t uvHeight = (height + 1) / 2;
+        const std::vector<uint16_t> y = randomPlane<uint16_t>(srcStride * height);
+        const std::vector<uint16_t> u = randomPlane<uint16_t>(srcStride * uvHeight);
+        const std::vector<uint16_t> v = randomPlane<uint16_t>(srcStride * uvHeight);
+        for (bool isMonochrome : {false, true}) {
+            expectSameAsScalar<uint8_t>(dstStride * (height + 2 * uvHeight), [&](uint8_t *dst) {
+                convertYUV420Planar16ToYV12(
+                        dst, dst + dstStride * height, dst + dstStride * (height + uvHeight),
+                        y.data(), u.data(), v.data(), srcStride, srcStride, srcStride,
+                        dstStride, dstStride, width, height, isMonochrome);
+            });
+        }
+    };
+    for (const auto &size : kSizes) {
+        test(size.width, size.height);
+    }
+    for (const auto &size : kOddSizes) {
+        test(size.width, size.height);
+    }
+}
+
+TEST_P(SimpleC2ConvertersTest, RGBA1010102ToYUV420Planar16) {
+    auto test = [this](size_t width, size_t height) {
+        SCOPED_TRACE(testing::Message() << width << "x" << height);
+        const size_t srcStride = width + kPadding;
+        const std::vector<uint32_t> src = randomPlane<uint32_t>(srcStride * height);
+        // the converter writes planes of |width| samples, and chroma rows of |width| / 2
+        const size_t ySize = width * height;
+        const size_t uvSize = (width / 2) * ((height + 1) / 2) + 1;
+        for (C2Color::matrix_t matrix : {C2Color::MATRIX_BT709, C2Color::MATRIX_BT2020}) {
+            for (C2Color::range_t range : {C2Color::RANGE_FULL, C2Color::RANGE_LIMITED}) {
+                expectSameAsScalar<uint16_t>(ySize + 2 * uvSize + kPadding, [&](uint16_t *dst) {
+                    convertRGBA1010102ToYUV420Planar16(
+                            dst, dst + ySize, dst + ySize + uvSize, src.data(), srcStride,
+                            width, height, matrix, range);
+                });
+            }
+        }
+    };
+    for (const auto &size : kSizes) {
+        test(size.width, size.height);
+    }
+    for (const auto &size : kOddSizes) {
+        test(size.width, size.height);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Isa, SimpleC2ConvertersTest,
+        ::testing::Values(CONV_ISA_NEON, CONV_ISA_SSE4_1, CONV_ISA_AVX2),
+        [](const ::testing::TestParamInfo<CONV_ISA_T> &info) -> std::string {
+            switch (info.param) {
+            case CONV_ISA_NEON: return "Neon";
+            case CONV_ISA_SSE4_1: return "Sse41";
+            case CONV_ISA_AVX2: return "Avx2";
+            default: return "Scalar";
+            }
+        });
+
+}  // namespace android
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of concurrent sessions, each converting 10-bit
+// 1080p frames to RGBA1010102 as the VP9 and AV1 decoders do, either on
+// converter threads of their own (one per core, per session, as the VP9
+// decoder used to) or on the process-wide SimpleC2TaskPool.
+
+#include <unistd.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <C2Config.h>
+#include <SimpleC2Component.h>
+#include <SimpleC2TaskPool.h>
+
+using namespace android;
+
+static constexpr size_t kWidth = 1920;
+static constexpr size_t kHeight = 1088;
+static constexpr size_t kBandHeight = 64;
+static constexpr size_t kFramesPerSession = 8;
+
+// Converter threads private to a session.
+class PrivateConverter {
+public:
+    explicit PrivateConverter(size_t numThreads) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            mThreads.emplace_back([this] { threadLoop(); });
+        }
+    }
+
+    ~PrivateConverter() {
+        {
+            std::lock_guard<std::mutex> l(mLock);
+            mExit = true;
+        }
+        mCond.notify_all();
+        for (std::thread &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+        std::unique_lock<std::mutex> l(mLock);
+        mFn = &fn;
+        mNext = 0;
+        mCount = count;
+        mPending = count;
+        mCond.notify_all();
+        mDone.wait(l, [this] { return mPending == 0; });
+        mFn = nullptr;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::condition_variable mDone;
+    const std::function<void(size_t)> *mFn = nullptr;
+    size_t mNext = 0;
+    size_t mCount = 0;
+    size_t mPending = 0;
+    bool mExit = false;
+    std::vector<std::thread> mThreads;
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> l(mLock);
+        for (;;) {
+            mCond.wait(l, [this] { return mExit || mNext < mCount; });
+            if (mExit) {
+                return;
+            }
+            const size_t index = mNext++;
+            const std::function<void(size_t)> &fn = *mFn;
+            l.unlock();
+            fn(index);
+            l.lock();
+            if (--mPending == 0) {
+                mDone.notify_all();
+            }
+        }
+    }
+};
+
+struct Session {
+    std::vector<uint16_t> mY;
+    std::vector<uint16_t> mU;
+    std::vector<uint16_t> mV;
+    std::vector<uint32_t> mDst;
+    std::shared_ptr<const C2ColorAspectsStruct> mAspects;
+    std::unique_ptr<PrivateConverter> mConverter;
+
+    explicit Session(size_t privateThreads)
+        : mY(kWidth * kHeight, 300),
+          mU(kWidth * kHeight / 4, 512),
+          mV(kWidth * kHeight / 4, 600),
+          mDst(kWidth * kHeight),
+          mAspects(std::make_shared<C2ColorAspectsStruct>(
+                  C2Color::RANGE_LIMITED, C2Color::PRIMARIES_BT709,
+                  C2Color::TRANSFER_170M, C2Color::MATRIX_BT709)) {
+        if (privateThreads > 0) {
+            mConverter.reset(new PrivateConverter(privateThreads));
+        }
+    }
+
+    void convertBand(size_t band) {
+        const size_t row = band * kBandHeight;
+        convertYUV420Planar16ToY410OrRGBA1010102(
+                mDst.data() + kWidth * row, mY.data() + kWidth * row,
+                mU.data() + kWidth / 2 * (row / 2), mV.data() + kWidth / 2 * (row / 2),
+                kWidth, kWidth / 2, kWidth / 2, kWidth, kWidth,
+                std::min(kBandHeight, kHeight - row), mAspects);
+    }
+
+    void convertFrame() {
+        if (mConverter) {
+            mConverter->parallelFor(kHeight / kBandHeight,
+                                    [this](size_t band) { convertBand(band); });
+        } else {
+            convertYUV420Planar16ToY410OrRGBA1010102(
+                    mDst.data(), mY.data(), mU.data(), mV.data(), kWidth, kWidth / 2,
+                    kWidth / 2, kWidth, kWidth, kHeight, mAspects);
+        }
+        benchmark::ClobberMemory();
+    }
+};
+
+// Arguments: the number of sessions, and whether they use the shared pool.
+static void BM_ConcurrentSessions(benchmark::State &state) {
+    const size_t numSessions = state.range(0);
+    const bool shared = state.range(1) != 0;
+    const size_t numCpus = std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (size_t i = 0; i < numSessions; ++i) {
+        sessions.emplace_back(new Session(shared ? 0 : numCpus));
+    }
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (const std::unique_ptr<Session> &session : sessions) {
+            threads.emplace_back([&session] {
+                for (size_t frame = 0; frame < kFramesPerSession; ++frame) {
+                    session->convertFrame();
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numSessions * kFramesPerSession);
+    state.counters["threads"] = shared ? SimpleC2TaskPool::Get().size()
+                                       : numSessions * numCpus;
+}
+
+BENCHMARK(BM_ConcurrentSessions)
+        ->ArgNames({"sessions", "shared"})
+        ->ArgsProduct({{1, 2, 4, 8}, {0, 1}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <SimpleC2TaskPool.h>
+
+namespace android {
+
+TEST(SimpleC2TaskPoolTest, ParallelForRunsEachIndexOnce) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    ASSERT_GE(pool.size(), 1u);
+    for (size_t count : {0u, 1u, 2u, 7u, 100u, 1000u}) {
+        std::vector<std::atomic<int>> runs(count);
+        pool.parallelFor(count, [&runs](size_t i) { ++runs[i]; });
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(runs[i], 1) << "index " << i << " of " << count;
+        }
+    }
+}
+
+TEST(SimpleC2TaskPoolTest, NestedParallelFor) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    constexpr size_t kOuter = 16;
+    constexpr size_t kInner = 32;
+    std::atomic<size_t> total(0);
+    pool.parallelFor(kOuter, [&pool, &total](size_t) {
+        pool.parallelFor(kInner, [&total](size_t) { ++total; });
+    });
+    EXPECT_EQ(total, kOuter * kInner);
+}
+
+TEST(SimpleC2TaskPoolTest, ConcurrentCallers) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    constexpr size_t kCallers = 8;
+    constexpr size_t kRounds = 200;
+    std::atomic<size_t> total(0);
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < kCallers; ++i) {
+        callers.emplace_back([&pool, &total] {
+            for (size_t round = 0; round < kRounds; ++round) {
+                pool.parallelFor(5, [&total](size_t) { ++total; });
+            }
+        });
+    }
+    for (std::thread &caller : callers) {
+        caller.join();
+    }
+    EXPECT_EQ(total, kCallers * kRounds * 5);
+}
+
+// Workers still looping over the queues take the tasks of the next call as
+// soon as they are queued. The pool library is built with the unsigned integer
+// overflow sanitizer, so a queued task count going below 0 aborts.
+TEST(SimpleC2TaskPoolTest, BackToBackParallelFor) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    constexpr size_t kRounds = 20000;
+    std::atomic<size_t> total(0);
+    size_t expected = 0;
+    for (size_t round = 0; round < kRounds; ++round) {
+        const size_t count = 2 + round % 7;
+        pool.parallelFor(count, [&total](size_t) { ++total; });
+        expected += count;
+    }
+    EXPECT_EQ(total, expected);
+}
+
+TEST(SimpleC2TaskPoolTest, ThreadBudget) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    const size_t first = pool.acquireThreads(pool.size());
+    EXPECT_EQ(first, pool.size());
+    // Once the budget is used up, sessions still get their share.
+    const size_t second = pool.acquireThreads(pool.size());
+    EXPECT_EQ(second, std::max(pool.size() / 2, (size_t)1));
+    pool.releaseThreads(first);
+    const size_t third = pool.acquireThreads(pool.size());
+    EXPECT_EQ(third, std::max(pool.size() - second, (size_t)1));
+    pool.releaseThreads(second);
+    pool.releaseThreads(third);
+    EXPECT_EQ(pool.acquireThreads(1000), pool.size());
+    pool.releaseThreads(pool.size());
+    // Releasing no threads does not unregister a session.
+    pool.releaseThreads(0);
+    EXPECT_EQ(pool.acquireThreads(1), 1u);
+    pool.releaseThreads(1);
+}
+
+TEST(SimpleC2TaskPoolTest, TwoSessionsShareTheBudget) {
+    SimpleC2TaskPool &pool = SimpleC2TaskPool::Get();
+    const size_t half = std::max(pool.size() / 2, (size_t)1);
+
+    // The first session has the pool to itself, until a second one starts.
+    size_t first = pool.acquireThreads(pool.size());
+    EXPECT_EQ(first, pool.size());
+    size_t second = pool.acquireThreads(pool.size());
+    EXPECT_EQ(second, half);
+
+    // Rebalancing brings the first session down to what the second leaves.
+    first = pool.rebalanceThreads(first, pool.size());
+    EXPECT_EQ(first, std::max(pool.size() - second, (size_t)1));
+    EXPECT_GE(first, half);
+    if (pool.size() > 1) {
+        EXPECT_EQ(first + second, pool.size());
+    }
+    EXPECT_EQ(pool.rebalanceThreads(second, pool.size()), second);
+
+    // A session wanting fewer threads leaves the rest to the other.
+    second = pool.rebalanceThreads(second, 1);
+    EXPECT_EQ(second, 1u);
+    first = pool.rebalanceThreads(first, pool.size());
+    EXPECT_EQ(first, std::max(pool.size() - 1, (size_t)1));
+
+    // Once the second session is released, the first gets the whole budget back.
+    pool.releaseThreads(second);
+    first = pool.rebalanceThreads(first, pool.size());
+    EXPECT_EQ(first, pool.size());
+    pool.releaseThreads(first);
+}
+
+}  // namespace android
@@ -27,6 +27,7 @@
 #include <Codec2BufferUtils.h>
 #include <Codec2CommonUtils.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2TaskPool.h>
 
 #include "C2SoftVpxDec.h"
 
@@ -333,34 +334,6 @@ private:
 #endif
 };
 
-C2SoftVpxDec::ConverterThread::ConverterThread(
-        const std::shared_ptr<Mutexed<ConversionQueue>> &queue)
-    : Thread(false), mQueue(queue) {}
-
-bool C2SoftVpxDec::ConverterThread::threadLoop() {
-    Mutexed<ConversionQueue>::Locked queue(*mQueue);
-    if (queue->entries.empty()) {
-        queue.waitForCondition(queue->cond);
-        if (queue->entries.empty()) {
-            return true;
-        }
-    }
-    std::function<void()> convert = queue->entries.front();
-    queue->entries.pop_front();
-    if (!queue->entries.empty()) {
-        queue->cond.signal();
-    }
-    queue.unlock();
-
-    convert();
-
-    queue.lock();
-    if (--queue->numPending == 0u) {
-        queue->cond.broadcast();
-    }
-    return true;
-}
-
 C2SoftVpxDec::C2SoftVpxDec(
         const char *name,
         c2_node_id_t id,
@@ -368,8 +341,7 @@ C2SoftVpxDec::C2SoftVpxDec(
     : SimpleC2Component(std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
       mCodecCtx(nullptr),
-      mCoreCount(1),
-      mQueue(new Mutexed<ConversionQueue>) {
+      mCoreCount(0) {
 }
 
 C2SoftVpxDec::~C2SoftVpxDec() {
@@ -465,7 +437,10 @@ status_t C2SoftVpxDec::initDecoder() {
 
     vpx_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(vpx_codec_dec_cfg_t));
-    cfg.threads = mCoreCount = GetCPUCoreCount();
+    if (mCoreCount == 0) {
+        mCoreCount = SimpleC2TaskPool::Get().acquireThreads(GetCPUCoreCount());
+    }
+    cfg.threads = mCoreCount;
 
     vpx_codec_flags_t flags;
     memset(&flags, 0, sizeof(vpx_codec_flags_t));
@@ -479,18 +454,6 @@ status_t C2SoftVpxDec::initDecoder() {
         return UNKNOWN_ERROR;
     }
 
-    if (mMode == MODE_VP9) {
-        using namespace std::string_literals;
-        for (int i = 0; i < mCoreCount; ++i) {
-            sp<ConverterThread> thread(new ConverterThread(mQueue));
-            mConverterThreads.push_back(thread);
-            if (thread->run(("vp9conv #"s + std::to_string(i)).c_str(),
-                            ANDROID_PRIORITY_AUDIO) != OK) {
-                return UNKNOWN_ERROR;
-            }
-        }
-    }
-
     return OK;
 }
 
@@ -500,21 +463,8 @@ status_t C2SoftVpxDec::destroyDecoder() {
         delete mCodecCtx;
         mCodecCtx = nullptr;
     }
-    bool running = true;
-    for (const sp<ConverterThread> &thread : mConverterThreads) {
-        thread->requestExit();
-    }
-    while (running) {
-        mQueue->lock()->cond.broadcast();
-        running = false;
-        for (const sp<ConverterThread> &thread : mConverterThreads) {
-            if (thread->isRunning()) {
-                running = true;
-                break;
-            }
-        }
-    }
-    mConverterThreads.clear();
+    SimpleC2TaskPool::Get().releaseThreads(mCoreCount);
+    mCoreCount = 0;
 
     return OK;
 }
@@ -811,33 +761,11 @@ status_t C2SoftVpxDec::outputBuffer(
         const uint16_t *srcV = (const uint16_t *)img->planes[VPX_PLANE_V];
 
         if (format == HAL_PIXEL_FORMAT_RGBA_1010102) {
-            Mutexed<ConversionQueue>::Locked queue(*mQueue);
-            size_t i = 0;
-            constexpr size_t kHeight = 64;
-            for (; i < mHeight; i += kHeight) {
-                queue->entries.push_back(
-                        [dstY, srcY, srcU, srcV,
-                         srcYStride, srcUStride, srcVStride, dstYStride,
-                         width = mWidth, height = std::min(mHeight - i, kHeight),
-                         defaultColorAspects] {
-                            convertYUV420Planar16ToY410OrRGBA1010102(
-                                    (uint32_t *)dstY, srcY, srcU, srcV, srcYStride / 2,
-                                    srcUStride / 2, srcVStride / 2, dstYStride / sizeof(uint32_t),
-                                    width, height,
-                                    std::static_pointer_cast<const C2ColorAspectsStruct>(
-                                            defaultColorAspects));
-                        });
-                srcY += srcYStride / 2 * kHeight;
-                srcU += srcUStride / 2 * (kHeight / 2);
-                srcV += srcVStride / 2 * (kHeight / 2);
-                dstY += dstYStride * kHeight;
-            }
-            CHECK_EQ(0u, queue->numPending);
-            queue->numPending = queue->entries.size();
-            while (queue->numPending > 0) {
-                queue->cond.signal();
-                queue.waitForCondition(queue->cond);
-            }
+            convertYUV420Planar16ToY410OrRGBA1010102(
+                    (uint32_t *)dstY, srcY, srcU, srcV, srcYStride / 2,
+                    srcUStride / 2, srcVStride / 2, dstYStride / sizeof(uint32_t),
+                    mWidth, mHeight,
+                    std::static_pointer_cast<const C2ColorAspectsStruct>(defaultColorAspects));
         } else if (format == HAL_PIXEL_FORMAT_YCBCR_P010) {
             convertYUV420Planar16ToP010((uint16_t *)dstY, (uint16_t *)dstU, srcY, srcU, srcV,
                                         srcYStride / 2, srcUStride / 2, srcVStride / 2,
@@ -18,6 +18,7 @@
 #define LOG_TAG "CCodec"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <sstream>
 #include <thread>
 
@@ -87,6 +88,9 @@ typedef CCodecConfig Config;
 
 namespace {
 
+// Maximum number of works handled per kWhatWorkDone message.
+constexpr size_t kMaxWorksPerWorkDoneMessage = 16;
+
 class CCodecWatchdog : public AHandler {
 private:
     enum {
@@ -932,6 +936,10 @@ public:
         mCodec->mCallback->onFirstTunnelFrameReady();
     }
 
+    void onWorksHeld(int64_t timeoutUs) override {
+        (new AMessage(CCodec::kWhatHeldWorksTimeout, mCodec))->post(timeoutUs);
+    }
+
 private:
     CCodec *mCodec;
 };
@@ -2203,12 +2211,21 @@ void CCodec::initiateStop() {
         state->set(STOPPING);
     }
     mChannel->reset();
+    reportFrameLatencies();
     bool pushBlankBuffer = mConfig.lock().get()->mPushBlankBuffersOnStop;
     sp<AMessage> stopMessage(new AMessage(kWhatStop, this));
     stopMessage->setInt32("pushBlankBuffer", pushBlankBuffer);
     stopMessage->post();
 }
 
+void CCodec::reportFrameLatencies() {
+    sp<AMessage> metrics = new AMessage;
+    mChannel->getFrameLatencyMetrics(metrics);
+    if (metrics->countEntries() > 0) {
+        mCallback->onMetricsUpdated(metrics);
+    }
+}
+
 void CCodec::stop(bool pushBlankBuffer) {
     std::shared_ptr<Codec2Client::Component> comp;
     {
@@ -2318,6 +2335,7 @@ void CCodec::initiateRelease(bool sendCallback /* = true */) {
     }
 
     mChannel->reset();
+    reportFrameLatencies();
     bool pushBlankBuffer = mConfig.lock().get()->mPushBlankBuffersOnStop;
     // thiz holds strong ref to this while the thread is running.
     sp<CCodec> thiz(this);
@@ -2793,128 +2811,25 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
         case kWhatWorkDone: {
-            std::unique_ptr<C2Work> work;
+            // Handle the works done so far in one message, but not too many
+            // of them, so that other messages are not held up.
+            std::list<std::unique_ptr<C2Work>> works;
             bool shouldPost = false;
             {
                 Mutexed<std::list<std::unique_ptr<C2Work>>>::Locked queue(mWorkDoneQueue);
                 if (queue->empty()) {
                     break;
                 }
-                work.swap(queue->front());
-                queue->pop_front();
+                auto end = queue->begin();
+                std::advance(end, std::min(queue->size(), kMaxWorksPerWorkDoneMessage));
+                works.splice(works.end(), *queue, queue->begin(), end);
                 shouldPost = !queue->empty();
             }
             if (shouldPost) {
                 (new AMessage(kWhatWorkDone, this))->post();
             }
-
-            // handle configuration changes in work done
-            std::shared_ptr<const C2StreamInitDataInfo::output> initData;
-            sp<AMessage> outputFormat = nullptr;
-            {
-                Mutexed<std::unique_ptr<Config>>::Locked configLocked(mConfig);
-                const std::unique_ptr<Config> &config = *configLocked;
-                Config::Watcher<C2StreamInitDataInfo::output> initDataWatcher =
-                    config->watch<C2StreamInitDataInfo::output>();
-                if (!work->worklets.empty()
-                        && (work->worklets.front()->output.flags
-                                & C2FrameData::FLAG_DISCARD_FRAME) == 0) {
-
-                    // copy buffer info to config
-                    std::vector<std::unique_ptr<C2Param>> updates;
-                    for (const std::unique_ptr<C2Param> &param
-                            : work->worklets.front()->output.configUpdate) {
-                        updates.push_back(C2Param::Copy(*param));
-                    }
-                    unsigned stream = 0;
-                    std::vector<std::shared_ptr<C2Buffer>> &outputBuffers =
-                        work->worklets.front()->output.buffers;
-                    for (const std::shared_ptr<C2Buffer> &buf : outputBuffers) {
-                        for (const std::shared_ptr<const C2Info> &info : buf->info()) {
-                            // move all info into output-stream #0 domain
-                            updates.emplace_back(
-                                    C2Param::CopyAsStream(*info, true /* output */, stream));
-                        }
-
-                        const std::vector<C2ConstGraphicBlock> blocks = buf->data().graphicBlocks();
-                        // for now only do the first block
-                        if (!blocks.empty()) {
-                            // ALOGV("got output buffer with crop %u,%u+%u,%u and size %u,%u",
-                            //      block.crop().left, block.crop().top,
-                            //      block.crop().width, block.crop().height,
-                            //      block.width(), block.height());
-                            const C2ConstGraphicBlock &block = blocks[0];
-                            updates.emplace_back(new C2StreamCropRectInfo::output(
-                                    stream, block.crop()));
-                        }
-                        ++stream;
-                    }
-
-                    sp<AMessage> oldFormat = config->mOutputFormat;
-                    config->updateConfiguration(updates, config->mOutputDomain);
-                    RevertOutputFormatIfNeeded(oldFormat, config->mOutputFormat);
-
-                    // copy standard infos to graphic buffers if not already present (otherwise, we
-                    // may overwrite the actual intermediate value with a final value)
-                    stream = 0;
-                    const static C2Param::Index stdGfxInfos[] = {
-                        C2StreamRotationInfo::output::PARAM_TYPE,
-                        C2StreamColorAspectsInfo::output::PARAM_TYPE,
-                        C2StreamDataSpaceInfo::output::PARAM_TYPE,
-                        C2StreamHdrStaticInfo::output::PARAM_TYPE,
-                        C2StreamHdr10PlusInfo::output::PARAM_TYPE,  // will be deprecated
-                        C2StreamHdrDynamicMetadataInfo::output::PARAM_TYPE,
-                        C2StreamPixelAspectRatioInfo::output::PARAM_TYPE,
-                        C2StreamSurfaceScalingInfo::output::PARAM_TYPE
-                    };
-                    for (const std::shared_ptr<C2Buffer> &buf : outputBuffers) {
-                        if (buf->data().graphicBlocks().size()) {
-                            for (C2Param::Index ix : stdGfxInfos) {
-                                if (!buf->hasInfo(ix)) {
-                                    const C2Param *param =
-                                        config->getConfigParameterValue(ix.withStream(stream));
-                                    if (param) {
-                                        std::shared_ptr<C2Param> info(C2Param::Copy(*param));
-                                        buf->setInfo(std::static_pointer_cast<C2Info>(info));
-                                    }
-                                }
-                            }
-                        }
-                        ++stream;
-                    }
-                }
-                if (config->mInputSurface) {
-                    if (work->worklets.empty()
-                           || !work->worklets.back()
-                           || (work->worklets.back()->output.flags
-                                  & C2FrameData::FLAG_INCOMPLETE) == 0) {
-                        config->mInputSurface->onInputBufferDone(work->input.ordinal.frameIndex);
-                    }
-                }
-                if (initDataWatcher.hasChanged()) {
-                    initData = initDataWatcher.update();
-                    AmendOutputFormatWithCodecSpecificData(
-                            initData->m.value, initData->flexCount(), config->mCodingMediaType,
-                            config->mOutputFormat);
-                }
-                outputFormat = config->mOutputFormat;
-            }
-            mChannel->onWorkDone(
-                    std::move(work), outputFormat, initData ? initData.get() : nullptr);
-            // log metrics to MediaCodec
-            if (mMetrics->countEntries() == 0) {
-                Mutexed<std::unique_ptr<Config>>::Locked configLocked(mConfig);
-                const std::unique_ptr<Config> &config = *configLocked;
-                uint32_t pf = PIXEL_FORMAT_UNKNOWN;
-                if (!config->mInputSurface) {
-                    pf = mChannel->getBuffersPixelFormat(config->mDomain & Config::IS_ENCODER);
-                } else {
-                    pf = config->mInputSurface->getPixelFormat();
-                }
-                if (pf != PIXEL_FORMAT_UNKNOWN) {
-                    mMetrics->setInt64(kCodecPixelFormat, pf);
-                    mCallback->onMetricsUpdated(mMetrics);
-                }
+            for (std::unique_ptr<C2Work> &work : works) {
+                handleWorkDone(std::move(work));
             }
             break;
         }
@@ -2922,6 +2837,10 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
             // watch message already posted; no-op.
             break;
         }
+        case kWhatHeldWorksTimeout: {
+            mChannel->onHeldWorksTimeout();
+            break;
+        }
         default: {
             ALOGE("unrecognized message");
             break;
@@ -2930,6 +2849,117 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
     setDeadline(TimePoint::max(), 0ms, "none");
 }
 
+void CCodec::handleWorkDone(std::unique_ptr<C2Work> work) {
+    // handle configuration changes in work done
+    std::shared_ptr<const C2StreamInitDataInfo::output> initData;
+    sp<AMessage> outputFormat = nullptr;
+    {
+        Mutexed<std::unique_ptr<Config>>::Locked configLocked(mConfig);
+        const std::unique_ptr<Config> &config = *configLocked;
+        Config::Watcher<C2StreamInitDataInfo::output> initDataWatcher =
+            config->watch<C2StreamInitDataInfo::output>();
+        if (!work->worklets.empty()
+                && (work->worklets.front()->output.flags
+                        & C2FrameData::FLAG_DISCARD_FRAME) == 0) {
+
+            // copy buffer info to config
+            std::vector<std::unique_ptr<C2Param>> updates;
+            for (const std::unique_ptr<C2Param> &param
+                    : work->worklets.front()->output.configUpdate) {
+                updates.push_back(C2Param::Copy(*param));
+            }
+            unsigned stream = 0;
+            std::vector<std::shared_ptr<C2Buffer>> &outputBuffers =
+                work->worklets.front()->output.buffers;
+            for (const std::shared_ptr<C2Buffer> &buf : outputBuffers) {
+                for (const std::shared_ptr<const C2Info> &info : buf->info()) {
+                    // move all info into output-stream #0 domain
+                    updates.emplace_back(
+                            C2Param::CopyAsStream(*info, true /* output */, stream));
+                }
+
+                const std::vector<C2ConstGraphicBlock> blocks = buf->data().graphicBlocks();
+                // for now only do the first block
+                if (!blocks.empty()) {
+                    // ALOGV("got output buffer with crop %u,%u+%u,%u and size %u,%u",
+                    //      block.crop().left, block.crop().top,
+                    //      block.crop().width, block.crop().height,
+                    //      block.width(), block.height());
+                    const C2ConstGraphicBlock &block = blocks[0];
+                    updates.emplace_back(new C2StreamCropRectInfo::output(
+                            stream, block.crop()));
+                }
+                ++stream;
+            }
+
+            sp<AMessage> oldFormat = config->mOutputFormat;
+            config->updateConfiguration(updates, config->mOutputDomain);
+            RevertOutputFormatIfNeeded(oldFormat, config->mOutputFormat);
+
+            // copy standard infos to graphic buffers if not already present (otherwise, we
+            // may overwrite the actual intermediate value with a final value)
+            stream = 0;
+            const static C2Param::Index stdGfxInfos[] = {
+                C2StreamRotationInfo::output::PARAM_TYPE,
+                C2StreamColorAspectsInfo::output::PARAM_TYPE,
+                C2StreamDataSpaceInfo::output::PARAM_TYPE,
+                C2StreamHdrStaticInfo::output::PARAM_TYPE,
+                C2StreamHdr10PlusInfo::output::PARAM_TYPE,  // will be deprecated
+                C2StreamHdrDynamicMetadataInfo::output::PARAM_TYPE,
+                C2StreamPixelAspectRatioInfo::output::PARAM_TYPE,
+                C2StreamSurfaceScalingInfo::output::PARAM_TYPE
+            };
+            for (const std::shared_ptr<C2Buffer> &buf : outputBuffers) {
+                if (buf->data().graphicBlocks().size()) {
+                    for (C2Param::Index ix : stdGfxInfos) {
+                        if (!buf->hasInfo(ix)) {
+                            const C2Param *param =
+                                config->getConfigParameterValue(ix.withStream(stream));
+                            if (param) {
+                                std::shared_ptr<C2Param> info(C2Param::Copy(*param));
+                                buf->setInfo(std::static_pointer_cast<C2Info>(info));
+                            }
+                        }
+                    }
+                }
+                ++stream;
+            }
+        }
+        if (config->mInputSurface) {
+            if (work->worklets.empty()
+                   || !work->worklets.back()
+                   || (work->worklets.back()->output.flags
+                          & C2FrameData::FLAG_INCOMPLETE) == 0) {
+                config->mInputSurface->onInputBufferDone(work->input.ordinal.frameIndex);
+            }
+        }
+        if (initDataWatcher.hasChanged()) {
+            initData = initDataWatcher.update();
+            AmendOutputFormatWithCodecSpecificData(
+                    initData->m.value, initData->flexCount(), config->mCodingMediaType,
+                    config->mOutputFormat);
+        }
+        outputFormat = config->mOutputFormat;
+    }
+    mChannel->onWorkDone(
+            std::move(work), outputFormat, initData ? initData.get() : nullptr);
+    // log metrics to MediaCodec
+    if (mMetrics->countEntries() == 0) {
+        Mutexed<std::unique_ptr<Config>>::Locked configLocked(mConfig);
+        const std::unique_ptr<Config> &config = *configLocked;
+        uint32_t pf = PIXEL_FORMAT_UNKNOWN;
+        if (!config->mInputSurface) {
+            pf = mChannel->getBuffersPixelFormat(config->mDomain & Config::IS_ENCODER);
+        } else {
+            pf = config->mInputSurface->getPixelFormat();
+        }
+        if (pf != PIXEL_FORMAT_UNKNOWN) {
+            mMetrics->setInt64(kCodecPixelFormat, pf);
+            mCallback->onMetricsUpdated(mMetrics);
+        }
+    }
+}
+
 void CCodec::setDeadline(
         const TimePoint &now,
         const std::chrono::milliseconds &timeout,
@@ -3020,7 +3050,10 @@ void CCodec::initiateReleaseIfStuck() {
         }
         compName = state->comp->getName();
     }
-    ALOGW("[%s] previous call to %s exceeded timeout", compName.c_str(), name.c_str());
+    std::string latencies;
+    mChannel->dumpPipeline(&latencies);
+    ALOGW("[%s] previous call to %s exceeded timeout; pipeline latencies:\n%s",
+          compName.c_str(), name.c_str(), latencies.c_str());
 
     initiateRelease(false);
     mCallback->onError(UNKNOWN_ERROR, ACTION_CODE_FATAL);
@@ -92,6 +92,9 @@ const static size_t kDequeueTimeoutNs = 0;
 // after app resume to foreground to notify HAL something
 const static uint64_t kPipelinePausedTimeoutMs = 500;
 
+// Work batching is off unless debug.stagefright.ccodec_work_batch_size is set.
+constexpr int32_t kDefaultWorkBatchLatencyUs = 20000;
+
 static bool areRenderMetricsEnabled() {
     std::string v = GetServerConfigurableFlag("media_native", "render_metrics_enabled", "false");
     return v == "true";
@@ -193,7 +196,8 @@ CCodecBufferChannel::CCodecBufferChannel(
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
       mIsHWDecoder(false),
-      mSendEncryptedInfoBuffer(false) {
+      mSendEncryptedInfoBuffer(false),
+      mTrackFrameLatencies(false) {
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers.reset(new DummyInputBuffers(""));
@@ -308,8 +312,9 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
                     return UNKNOWN_ERROR;
                 }
                 bool released = input->buffers->releaseBuffer(buffer, nullptr, true);
-                ALOGV("[%s] queueInputBuffer: buffer copied; %sreleased",
-                      mName, released ? "" : "not ");
+                ALOGV("[%s] queueInputBuffer: buffer copied (%zu copies, %zu bytes so far); "
+                      "%sreleased", mName, input->buffers->numCopies(),
+                      input->buffers->numCopiedBytes(), released ? "" : "not ");
                 buffer = copy;
             } else {
                 ALOGW("[%s] queueInputBuffer: failed to copy a buffer; this may cause input "
@@ -423,24 +428,9 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     if (!items.empty()) {
         ScopedTrace trace(ATRACE_TAG, android::base::StringPrintf(
                 "CCodecBufferChannel::queue(%s@ts=%lld)", mName, (long long)timeUs).c_str());
-        {
-            Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-            PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
-            for (const std::unique_ptr<C2Work> &work : items) {
-                watcher->onWorkQueued(
-                        work->input.ordinal.frameIndex.peeku(),
-                        std::vector(work->input.buffers),
-                        now);
-            }
-        }
-        err = mComponent->queue(&items);
+        err = queueWorks(&items, true /* clientQueued */);
     }
-    if (err != C2_OK) {
-        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-        for (const std::unique_ptr<C2Work> &work : items) {
-            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
-        }
-    } else {
+    if (err == C2_OK) {
         Mutexed<Input>::Locked input(mInput);
         bool released = false;
         if (copy) {
@@ -456,6 +446,77 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     return err;
 }
 
+c2_status_t CCodecBufferChannel::queueWorks(
+        std::list<std::unique_ptr<C2Work>> *items, bool clientQueued) {
+    std::lock_guard<std::mutex> queueLock(mQueueWorksLock);
+    WorkBatcher::Clock::time_point now = WorkBatcher::Clock::now();
+    size_t worksInFlight = mPipelineWatcher.lock()->numWorksInPipeline();
+    if (clientQueued && mTrackFrameLatencies) {
+        Mutexed<FrameLatencyTracker>::Locked tracker(mFrameLatencyTracker);
+        for (const std::unique_ptr<C2Work> &work : *items) {
+            tracker->onEvent(work->input.ordinal.frameIndex.peeku(),
+                             FrameLatencyTracker::INPUT_QUEUED, now);
+        }
+    }
+    WorkBatcher::Clock::time_point deadline = WorkBatcher::Clock::time_point::max();
+    {
+        Mutexed<WorkBatcher>::Locked batcher(mWorkBatcher);
+        if (clientQueued) {
+            bool wasHolding = batcher->numHeldWorks() > 0;
+            batcher->onWorkQueued(items, worksInFlight, now);
+            if (!wasHolding) {
+                deadline = batcher->heldWorksDeadline();
+            }
+        } else {
+            batcher->onWorkDone(items, worksInFlight, now);
+        }
+    }
+    if (deadline != WorkBatcher::Clock::time_point::max()) {
+        // Nothing else may happen in time to release the held works.
+        mCCodecCallback->onWorksHeld(std::max(int64_t(0), int64_t(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                        deadline - now).count())));
+    }
+    if (items->empty()) {
+        return C2_OK;
+    }
+    ALOGV("[%s] queueing %zu works (%zu in flight)", mName, items->size(), worksInFlight);
+    {
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        for (const std::unique_ptr<C2Work> &work : *items) {
+            watcher->onWorkQueued(
+                    work->input.ordinal.frameIndex.peeku(),
+                    std::vector(work->input.buffers),
+                    now);
+        }
+    }
+    if (mTrackFrameLatencies) {
+        Mutexed<FrameLatencyTracker>::Locked tracker(mFrameLatencyTracker);
+        for (const std::unique_ptr<C2Work> &work : *items) {
+            tracker->onEvent(work->input.ordinal.frameIndex.peeku(),
+                             FrameLatencyTracker::COMPONENT_QUEUED, now);
+        }
+    }
+    c2_status_t err = mComponent->queue(items);
+    if (err != C2_OK) {
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        for (const std::unique_ptr<C2Work> &work : *items) {
+            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
+        }
+    }
+    return err;
+}
+
+void CCodecBufferChannel::trackFrame(
+        const sp<MediaCodecBuffer> &buffer, FrameLatencyTracker::Event event) {
+    int64_t frameIndex;
+    if (!mTrackFrameLatencies || !buffer->meta()->findInt64("frameIndex", &frameIndex)) {
+        return;
+    }
+    mFrameLatencyTracker.lock()->onEvent(
+            frameIndex, event, FrameLatencyTracker::Clock::now());
+}
+
 status_t CCodecBufferChannel::setParameters(std::vector<std::unique_ptr<C2Param>> &params) {
     QueueGuard guard(mSync);
     if (!guard.isRunning()) {
@@ -1163,6 +1224,9 @@ status_t CCodecBufferChannel::renderOutputBuffer(
             released = output->buffers->releaseBuffer(buffer, &c2Buffer);
         }
     }
+    if (released) {
+        trackFrame(buffer, FrameLatencyTracker::RENDERED);
+    }
     // NOTE: some apps try to releaseOutputBuffer() with timestamp and/or render
     //       set to true.
     sendOutputBuffers();
@@ -1540,6 +1604,11 @@ status_t CCodecBufferChannel::discardBuffer(const sp<MediaCodecBuffer> &buffer)
         Mutexed<Output>::Locked output(mOutput);
         if (output->buffers && output->buffers->releaseBuffer(buffer, nullptr)) {
             released = true;
+            int64_t frameIndex;
+            if (mTrackFrameLatencies && buffer->meta()->findInt64("frameIndex", &frameIndex)) {
+                mFrameLatencyTracker.lock()->onOutputReleased(
+                        frameIndex, false /* rendered */, FrameLatencyTracker::Clock::now());
+            }
         }
     }
     if (released) {
@@ -1783,7 +1852,12 @@ status_t CCodecBufferChannel::start(
                         numInputSlots, mName));
                 forceArrayMode = true;
             } else {
-                input->buffers.reset(new LinearInputBuffers(mName));
+                std::unique_ptr<LinearInputBuffers> buffers(new LinearInputBuffers(mName));
+                if (android::base::GetBoolProperty(
+                        "debug.stagefright.ccodec_recycle_input_blocks", true)) {
+                    buffers->setRecycleDepth(numInputSlots);
+                }
+                input->buffers = std::move(buffers);
             }
         }
         input->buffers->setFormat(inputFormat);
@@ -2022,6 +2096,25 @@ status_t CCodecBufferChannel::start(
                 .tunneled(mTunneled);
         watcher->flush();
     }
+    {
+        size_t batchSize = 1;
+        if (inputFormat && !mInputSurface && !mTunneled) {
+            batchSize = std::max(1, android::base::GetIntProperty(
+                    "debug.stagefright.ccodec_work_batch_size", 1));
+        }
+        int32_t latencyUs = android::base::GetIntProperty(
+                "debug.stagefright.ccodec_work_batch_latency_us", kDefaultWorkBatchLatencyUs);
+        Mutexed<WorkBatcher>::Locked batcher(mWorkBatcher);
+        batcher->maxBatchSize(batchSize)
+                .maxLatency(std::chrono::microseconds(std::max(0, latencyUs)))
+                .minWorksInFlight(inputDelayValue + pipelineDelayValue + 1);
+        batcher->flush();
+    }
+    mTrackFrameLatencies = android::base::GetBoolProperty(
+            "debug.stagefright.ccodec_frame_latency", false);
+    if (mTrackFrameLatencies) {
+        mFrameLatencyTracker.lock()->start(mName);
+    }
 
     mInputMetEos = false;
     mSync.start();
@@ -2139,6 +2232,11 @@ status_t CCodecBufferChannel::requestInitialInputBuffers(
 
 void CCodecBufferChannel::stop() {
     mSync.stop();
+    // the held works never reached the component
+    mWorkBatcher.lock()->flush();
+    if (mTrackFrameLatencies) {
+        mFrameLatencyTracker.lock()->flush();
+    }
     mFirstValidFrameIndex = mFrameIndex.load(std::memory_order_relaxed);
     mInfoBuffers.clear();
 }
@@ -2167,7 +2265,22 @@ void CCodecBufferChannel::reset() {
     if (mInputSurface != nullptr) {
         mInputSurface.reset();
     }
-    mPipelineWatcher.lock()->flush();
+    {
+        // The pipeline latencies are also in dumpPipeline(); they are logged
+        // here only along with the frame latencies.
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        if (mTrackFrameLatencies) {
+            std::string latencies;
+            watcher->dump(&latencies);
+            ALOGD("[%s] pipeline latencies:\n%s", mName, latencies.c_str());
+        }
+        watcher->flush();
+    }
+    if (mTrackFrameLatencies) {
+        std::string latencies;
+        mFrameLatencyTracker.lock()->dump(&latencies);
+        ALOGD("[%s] frame latencies:\n%s", mName, latencies.c_str());
+    }
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers.reset(new DummyInputBuffers(""));
@@ -2236,6 +2349,9 @@ void CCodecBufferChannel::flush(const std::list<std::unique_ptr<C2Work>> &flushe
         }
     }
     mFlushedConfigs.lock()->swap(configs);
+    if (mTrackFrameLatencies) {
+        mFrameLatencyTracker.lock()->flush();
+    }
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers->flush();
@@ -2254,9 +2370,29 @@ void CCodecBufferChannel::flush(const std::list<std::unique_ptr<C2Work>> &flushe
 void CCodecBufferChannel::onWorkDone(
         std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
         const C2StreamInitDataInfo::output *initData) {
+    if (mTrackFrameLatencies) {
+        mFrameLatencyTracker.lock()->onEvent(
+                work->input.ordinal.frameIndex.peeku(),
+                FrameLatencyTracker::COMPONENT_DONE,
+                FrameLatencyTracker::Clock::now());
+    }
     if (handleWork(std::move(work), outputFormat, initData)) {
         feedInputBufferIfAvailable();
     }
+    queueReleasedWorks();
+}
+
+void CCodecBufferChannel::onHeldWorksTimeout() {
+    queueReleasedWorks();
+}
+
+void CCodecBufferChannel::queueReleasedWorks() {
+    std::list<std::unique_ptr<C2Work>> items;
+    c2_status_t err = queueWorks(&items, false /* clientQueued */);
+    if (err != C2_OK) {
+        ALOGE("[%s] failed to queue held works (err = %d)", mName, err);
+        mCCodecCallback->onError(UNKNOWN_ERROR, ACTION_CODE_FATAL);
+    }
 }
 
 void CCodecBufferChannel::onInputBufferDone(
@@ -2458,6 +2594,8 @@ bool CCodecBufferChannel::handleWork(
             newPipelineDelay.value_or(input->pipelineDelay) +
             kSmoothnessFactor;
         input->inputDelay = newInputDelay.value_or(input->inputDelay);
+        mWorkBatcher.lock()->minWorksInFlight(
+                newNumSlots - kSmoothnessFactor + 1);
         if (input->buffers->isArrayMode()) {
             if (input->numSlots >= newNumSlots) {
                 input->numExtraSlots = 0;
@@ -2694,6 +2832,7 @@ void CCodecBufferChannel::sendOutputBuffers() {
                     outBuffer->meta()->setObject("accessUnitInfo", obj);
                 }
             }
+            trackFrame(outBuffer, FrameLatencyTracker::OUTPUT_AVAILABLE);
             mCallback->onOutputBufferAvailable(index, outBuffer);
             break;
         }
@@ -2800,6 +2939,16 @@ PipelineWatcher::Clock::duration CCodecBufferChannel::elapsed() {
     return mPipelineWatcher.lock()->elapsed(PipelineWatcher::Clock::now(), n);
 }
 
+void CCodecBufferChannel::dumpPipeline(std::string *out) {
+    mPipelineWatcher.lock()->dump(out);
+}
+
+void CCodecBufferChannel::getFrameLatencyMetrics(const sp<AMessage> &metrics) {
+    if (mTrackFrameLatencies) {
+        mFrameLatencyTracker.lock()->exportMetrics(metrics);
+    }
+}
+
 void CCodecBufferChannel::setMetaMode(MetaMode mode) {
     mMetaMode = mode;
 }
@@ -33,9 +33,11 @@
 #include <media/stagefright/CodecBase.h>
 
 #include "CCodecBuffers.h"
+#include "FrameLatencyTracker.h"
 #include "FrameReassembler.h"
 #include "InputSurfaceWrapper.h"
 #include "PipelineWatcher.h"
+#include "WorkBatcher.h"
 
 namespace android {
 
@@ -48,6 +50,8 @@ public:
     virtual void onOutputFramesRendered(int64_t mediaTimeUs, nsecs_t renderTimeNs) = 0;
     virtual void onOutputBuffersChanged() = 0;
     virtual void onFirstTunnelFrameReady() = 0;
+    // Works are held back; call onHeldWorksTimeout() in |timeoutUs|.
+    virtual void onWorksHeld(int64_t timeoutUs) = 0;
 };
 
 /**
@@ -210,8 +214,25 @@ public:
      */
     void onInputBufferDone(uint64_t frameIndex, size_t arrayIndex);
 
+    /**
+     * Queue the works held back for batching to the component, if they have
+     * been held for the batch latency bound.
+     */
+    void onHeldWorksTimeout();
+
     PipelineWatcher::Clock::duration elapsed();
 
+    /**
+     * Append the latency histograms of the pipeline stages to |out|.
+     */
+    void dumpPipeline(std::string *out);
+
+    /**
+     * Set the frame latency percentiles to |metrics|, if frame latency
+     * tracking is enabled.
+     */
+    void getFrameLatencyMetrics(const sp<AMessage> &metrics);
+
     enum MetaMode {
         MODE_NONE,
         MODE_ANW,
@@ -311,6 +332,14 @@ private:
     status_t queueInputBufferInternal(sp<MediaCodecBuffer> buffer,
                                       std::shared_ptr<C2LinearBlock> encryptedBlock = nullptr,
                                       size_t blockSize = 0);
+    // Queues |items| queued by the client, or the held works released after a
+    // work is done or on timeout if |clientQueued| is false, to the component
+    // through mWorkBatcher, which may hold them back to queue them in a batch.
+    c2_status_t queueWorks(std::list<std::unique_ptr<C2Work>> *items, bool clientQueued);
+    // Queues the held works released by mWorkBatcher, if any.
+    void queueReleasedWorks();
+    // Records |event| of the frame of |buffer| to mFrameLatencyTracker.
+    void trackFrame(const sp<MediaCodecBuffer> &buffer, FrameLatencyTracker::Event event);
     bool handleWork(
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
             const C2StreamInitDataInfo::output *initData);
@@ -397,6 +426,14 @@ private:
     MetaMode mMetaMode;
 
     Mutexed<PipelineWatcher> mPipelineWatcher;
+    // Held by queueWorks() from taking works out of mWorkBatcher until they
+    // are queued to the component, so that they reach the component in order.
+    // mWorkBatcher itself is not locked across the queue() call.
+    std::mutex mQueueWorksLock;
+    Mutexed<WorkBatcher> mWorkBatcher;
+    // mFrameLatencyTracker is only used while mTrackFrameLatencies is true.
+    std::atomic_bool mTrackFrameLatencies;
+    Mutexed<FrameLatencyTracker> mFrameLatencyTracker;
 
     std::atomic_bool mInputMetEos;
     std::once_flag mRenderWarningFlag;
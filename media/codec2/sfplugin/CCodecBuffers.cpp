@@ -148,6 +148,8 @@ sp<Codec2Buffer> InputBuffers::cloneAndReleaseBuffer(const sp<MediaCodecBuffer>
         return nullptr;
     }
     copy->meta()->extend(buffer->meta());
+    ++mNumCopies;
+    mNumCopiedBytes += copy->size();
     return copy;
 }
 
@@ -729,6 +731,18 @@ bool FlexBuffersImpl::expireComponentBuffer(const std::shared_ptr<C2Buffer> &c2b
     return false;
 }
 
+sp<Codec2Buffer> FlexBuffersImpl::findClientBuffer(
+        const sp<MediaCodecBuffer> &buffer,
+        std::weak_ptr<C2Buffer> *compBuffer) const {
+    for (const Entry &entry : mBuffers) {
+        if (entry.clientBuffer == buffer) {
+            *compBuffer = entry.compBuffer;
+            return entry.clientBuffer;
+        }
+    }
+    return nullptr;
+}
+
 void FlexBuffersImpl::flush() {
     ALOGV("[%s] buffers are flushed %zu", mName, mBuffers.size());
     mBuffers.clear();
@@ -1015,10 +1029,21 @@ sp<Codec2Buffer> SlotInputBuffers::createNewBuffer() {
 
 // LinearInputBuffers
 
+void LinearInputBuffers::setRecycleDepth(size_t depth) {
+    mRecycledBuffers.clear();
+    mRecycledBuffers.shrink_to_fit();
+    mRecycledBuffers.reserve(depth);
+    mRecycleDepth = depth;
+}
+
 bool LinearInputBuffers::requestNewBuffer(size_t *index, sp<MediaCodecBuffer> *buffer) {
-    sp<Codec2Buffer> newBuffer = createNewBuffer();
+    sp<Codec2Buffer> newBuffer = takeRecycledBuffer();
     if (newBuffer == nullptr) {
-        return false;
+        newBuffer = createNewBuffer();
+        if (newBuffer == nullptr) {
+            return false;
+        }
+        ++mNumFetchedBlocks;
     }
     *index = mImpl.assignSlot(newBuffer);
     *buffer = newBuffer;
@@ -1029,7 +1054,54 @@ bool LinearInputBuffers::releaseBuffer(
         const sp<MediaCodecBuffer> &buffer,
         std::shared_ptr<C2Buffer> *c2buffer,
         bool release) {
-    return mImpl.releaseSlot(buffer, c2buffer, release);
+    sp<Codec2Buffer> clientBuffer;
+    std::weak_ptr<C2Buffer> compBuffer;
+    if (release && mRecycledBuffers.size() < mRecycleDepth) {
+        clientBuffer = mImpl.findClientBuffer(buffer, &compBuffer);
+    }
+    if (!mImpl.releaseSlot(buffer, c2buffer, release)) {
+        return false;
+    }
+    if (clientBuffer) {
+        if (c2buffer && *c2buffer) {
+            compBuffer = *c2buffer;
+        }
+        mRecycledBuffers.push_back({std::move(clientBuffer), std::move(compBuffer)});
+    }
+    return true;
+}
+
+void LinearInputBuffers::removeRecycledBuffer(size_t i) {
+    // Move the last entry in its place, so that the vector never reallocates.
+    if (i + 1 < mRecycledBuffers.size()) {
+        mRecycledBuffers[i] = std::move(mRecycledBuffers.back());
+    }
+    mRecycledBuffers.pop_back();
+}
+
+sp<Codec2Buffer> LinearInputBuffers::takeRecycledBuffer() {
+    for (size_t i = 0; i < mRecycledBuffers.size(); ) {
+        RecycledBuffer &entry = mRecycledBuffers[i];
+        if (entry.buffer->format() != mFormat) {
+            // allocated for a previous format, which may have asked for a
+            // smaller capacity
+            removeRecycledBuffer(i);
+            continue;
+        }
+        // The block is shared with the component until the C2Buffer object
+        // wrapping it goes away.
+        if (!entry.compBuffer.expired()) {
+            ++i;
+            continue;
+        }
+        sp<Codec2Buffer> buffer = std::move(entry.buffer);
+        removeRecycledBuffer(i);
+        buffer->meta()->clear();
+        buffer->setRange(0, buffer->capacity());
+        ++mNumRecycledBlocks;
+        return buffer;
+    }
+    return nullptr;
 }
 
 bool LinearInputBuffers::expireComponentBuffer(
@@ -1041,6 +1113,8 @@ void LinearInputBuffers::flush() {
     // This is no-op by default unless we're in array mode where we need to keep
     // track of the flushed work.
     mImpl.flush();
+    // Return the kept blocks to the pool; the storage stays for the next run.
+    mRecycledBuffers.clear();
 }
 
 std::unique_ptr<InputBuffers> LinearInputBuffers::toArrayMode(size_t size) {
@@ -18,6 +18,7 @@
 
 #define CCODEC_BUFFERS_H_
 
+#include <list>
 #include <optional>
 #include <string>
 #include <vector>
@@ -169,12 +170,22 @@ public:
      */
     virtual size_t numClientBuffers() const = 0;
 
+    /**
+     * Return the number of input buffers copied by cloneAndReleaseBuffer(),
+     * and the number of bytes copied with them.
+     */
+    size_t numCopies() const { return mNumCopies; }
+    size_t numCopiedBytes() const { return mNumCopiedBytes; }
+
 protected:
     virtual sp<Codec2Buffer> createNewBuffer() = 0;
 
     // Pool to obtain blocks for input buffers.
     std::shared_ptr<C2BlockPool> mPool;
 
+    size_t mNumCopies = 0;
+    size_t mNumCopiedBytes = 0;
+
 private:
     DISALLOW_EVIL_CONSTRUCTORS(InputBuffers);
 };
@@ -611,6 +622,18 @@ public:
      */
     bool expireComponentBuffer(const std::shared_ptr<C2Buffer> &c2buffer);
 
+    /**
+     * Find the slot of a buffer given to the client.
+     *
+     * \param   buffer[in]       the buffer previously assigned a slot.
+     * \param   compBuffer[out]  the C2Buffer object of the slot, which the
+     *                           component may still hold.
+     * \return  the buffer in the slot; nullptr if not found.
+     */
+    sp<Codec2Buffer> findClientBuffer(
+            const sp<MediaCodecBuffer> &buffer,
+            std::weak_ptr<C2Buffer> *compBuffer) const;
+
     /**
      * The client abandoned all known buffers, so reclaim the ownership.
      */
@@ -860,6 +883,22 @@ public:
           mImpl(mName) { }
     ~LinearInputBuffers() override = default;
 
+    /**
+     * Keep up to |depth| buffers released by the client, and hand them out
+     * again once the component is done with their blocks, instead of fetching
+     * and mapping a new block from the pool for every input buffer. |depth|
+     * is normally the number of input slots of the pipeline; 0 disables
+     * recycling. Kept buffers are dropped on flush().
+     */
+    void setRecycleDepth(size_t depth);
+
+    /**
+     * Return the number of buffers handed out with a newly fetched block, and
+     * with a recycled block.
+     */
+    size_t numFetchedBlocks() const { return mNumFetchedBlocks; }
+    size_t numRecycledBlocks() const { return mNumRecycledBlocks; }
+
     bool requestNewBuffer(size_t *index, sp<MediaCodecBuffer> *buffer) override;
 
     bool releaseBuffer(
@@ -886,6 +925,20 @@ protected:
 private:
     static sp<Codec2Buffer> Alloc(
             const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format);
+
+    // Returns a released buffer whose block the component no longer holds.
+    sp<Codec2Buffer> takeRecycledBuffer();
+    void removeRecycledBuffer(size_t i);
+
+    struct RecycledBuffer {
+        sp<Codec2Buffer> buffer;
+        std::weak_ptr<C2Buffer> compBuffer;
+    };
+    // At most mRecycleDepth entries, allocated once by setRecycleDepth().
+    std::vector<RecycledBuffer> mRecycledBuffers;
+    size_t mRecycleDepth = 0;
+    size_t mNumFetchedBlocks = 0;
+    size_t mNumRecycledBlocks = 0;
 };
 
 class EncryptedLinearInputBuffers : public LinearInputBuffers {
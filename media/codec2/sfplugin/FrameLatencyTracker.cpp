@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameLatencyTracker"
+#define ATRACE_TAG  ATRACE_TAG_VIDEO
+
+#include <algorithm>
+#include <iterator>
+
+#include <log/log.h>
+#include <media/stagefright/MediaCodecMetricsConstants.h>
+#include <utils/Trace.h>
+
+#include "FrameLatencyTracker.h"
+
+namespace android {
+
+namespace {
+
+constexpr const char *kEventNames[] = {
+    "input queued",
+    "component queued",
+    "component done",
+    "output available",
+    "rendered",
+};
+static_assert(std::size(kEventNames) == FrameLatencyTracker::NUM_EVENTS);
+
+constexpr const char *kStageNames[] = {
+    "input->component",
+    "component",
+    "component->output",
+    "output->render",
+    "end-to-end",
+};
+static_assert(std::size(kStageNames) == FrameLatencyTracker::NUM_STAGES);
+
+// Used in media metrics keys.
+constexpr const char *kStageKeys[] = {
+    "input-to-component",
+    "component",
+    "component-to-output",
+    "output-to-render",
+    "end-to-end",
+};
+static_assert(std::size(kStageKeys) == FrameLatencyTracker::NUM_STAGES);
+
+constexpr int kPercentiles[] = { 50, 90, 99 };
+
+}  // namespace
+
+FrameLatencyTracker::FrameLatencyTracker() : mFrames(kCapacity) {}
+
+void FrameLatencyTracker::start(const std::string &name) {
+    for (size_t i = 0; i < NUM_EVENTS; ++i) {
+        mTraceNames[i] = "[" + name + "] " + kEventNames[i];
+    }
+    flush();
+    for (Histogram &stage : mStages) {
+        stage.clear();
+    }
+}
+
+void FrameLatencyTracker::onEvent(
+        uint64_t frameIndex, Event event, const Clock::time_point &now) {
+    Frame &frame = mFrames[frameIndex % mFrames.size()];
+    if (frame.frameIndex != frameIndex || !(frame.inUse || frame.finished)) {
+        if (frame.inUse) {
+            ALOGV("onEvent: frame #%llu evicted by frame #%llu",
+                  (unsigned long long)frame.frameIndex, (unsigned long long)frameIndex);
+            finish(&frame);
+        }
+        frame = Frame();
+        frame.inUse = true;
+        frame.frameIndex = frameIndex;
+    } else if (frame.finished || frame.has(event)) {
+        return;
+    }
+    frame.times[event] = now;
+    frame.events |= (1u << event);
+    if (event > INPUT_QUEUED && frame.has(Event(event - 1))) {
+        mStages[event - 1].add(now - frame.times[event - 1]);
+    }
+
+    const int32_t cookie = int32_t(frameIndex);
+    if (frame.tracing) {
+        ATRACE_ASYNC_END(mTraceNames[frame.lastEvent].c_str(), cookie);
+        frame.tracing = false;
+    }
+    frame.lastEvent = event;
+    if (event == RENDERED) {
+        finish(&frame);
+    } else if (ATRACE_ENABLED()) {
+        ATRACE_ASYNC_BEGIN(mTraceNames[event].c_str(), cookie);
+        frame.tracing = true;
+    }
+}
+
+void FrameLatencyTracker::onOutputReleased(
+        uint64_t frameIndex, bool rendered, const Clock::time_point &now) {
+    if (rendered) {
+        onEvent(frameIndex, RENDERED, now);
+        return;
+    }
+    Frame &frame = mFrames[frameIndex % mFrames.size()];
+    if (frame.inUse && frame.frameIndex == frameIndex) {
+        finish(&frame);
+    }
+}
+
+void FrameLatencyTracker::flush() {
+    for (Frame &frame : mFrames) {
+        if (frame.inUse) {
+            finish(&frame);
+        }
+        frame = Frame();
+    }
+}
+
+size_t FrameLatencyTracker::count(Stage stage) const {
+    return mStages[stage].total;
+}
+
+FrameLatencyTracker::Clock::duration FrameLatencyTracker::percentile(
+        Stage stage, int percentile) const {
+    return std::chrono::microseconds(mStages[stage].percentileUs(percentile));
+}
+
+void FrameLatencyTracker::dump(std::string *out) const {
+    for (size_t i = 0; i < NUM_STAGES; ++i) {
+        const Histogram &stage = mStages[i];
+        out->append(kStageNames[i]).append(": n=").append(std::to_string(stage.total));
+        if (stage.total > 0) {
+            for (int p : kPercentiles) {
+                out->append(" p").append(std::to_string(p)).append("=")
+                        .append(std::to_string(stage.percentileUs(p))).append("us");
+            }
+            out->append(" max=").append(std::to_string(stage.maxUs)).append("us");
+        }
+        out->append("\n");
+    }
+}
+
+void FrameLatencyTracker::exportMetrics(const sp<AMessage> &metrics) const {
+    for (size_t i = 0; i < NUM_STAGES; ++i) {
+        const Histogram &stage = mStages[i];
+        if (stage.total == 0) {
+            continue;
+        }
+        std::string prefix = std::string(kCodecFrameLatencyPrefix) + kStageKeys[i] + ".";
+        metrics->setInt64((prefix + "n").c_str(), stage.total);
+        for (int p : kPercentiles) {
+            metrics->setInt64((prefix + "p" + std::to_string(p)).c_str(), stage.percentileUs(p));
+        }
+        metrics->setInt64((prefix + "max").c_str(), stage.maxUs);
+    }
+}
+
+void FrameLatencyTracker::finish(Frame *frame) {
+    if (frame->tracing) {
+        ATRACE_ASYNC_END(mTraceNames[frame->lastEvent].c_str(), int32_t(frame->frameIndex));
+        frame->tracing = false;
+    }
+    if (frame->has(INPUT_QUEUED)) {
+        if (frame->has(RENDERED)) {
+            mStages[END_TO_END].add(frame->times[RENDERED] - frame->times[INPUT_QUEUED]);
+        } else if (frame->has(OUTPUT_AVAILABLE)) {
+            mStages[END_TO_END].add(frame->times[OUTPUT_AVAILABLE] - frame->times[INPUT_QUEUED]);
+        }
+    }
+    frame->inUse = false;
+    frame->finished = true;
+}
+
+void FrameLatencyTracker::Histogram::clear() {
+    std::fill(std::begin(counts), std::end(counts), 0u);
+    total = 0;
+    maxUs = 0;
+}
+
+void FrameLatencyTracker::Histogram::add(Clock::duration latency) {
+    int64_t us = std::max(int64_t(0),
+            int64_t(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+    // Values below kSubBuckets get a bucket each. Above, [2^e, 2^(e+1)) is split
+    // into kSubBuckets buckets of equal width.
+    size_t bucket = us;
+    if (us >= int64_t(kSubBuckets)) {
+        int e = 63 - __builtin_clzll(us);
+        bucket = (e - 2) * kSubBuckets + ((us >> (e - 3)) & (kSubBuckets - 1));
+    }
+    ++counts[std::min(bucket, kNumBuckets - 1)];
+    ++total;
+    maxUs = std::max(maxUs, us);
+}
+
+int64_t FrameLatencyTracker::Histogram::percentileUs(int percentile) const {
+    if (total == 0) {
+        return 0;
+    }
+    // the rank of the sample, rounded up
+    size_t rank = std::max(size_t(1), (total * std::clamp(percentile, 0, 100) + 99) / 100);
+    size_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            if (i < kSubBuckets) {
+                return std::min(int64_t(i + 1), maxUs);
+            }
+            int e = i / kSubBuckets + 2;
+            int64_t end = int64_t(kSubBuckets + i % kSubBuckets + 1) << (e - 3);
+            return std::min(end, maxUs);
+        }
+    }
+    return maxUs;
+}
+
+}  // namespace android
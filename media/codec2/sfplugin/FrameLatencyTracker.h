@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_LATENCY_TRACKER_H_
+#define FRAME_LATENCY_TRACKER_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <media/stagefright/foundation/AMessage.h>
+
+namespace android {
+
+/**
+ * FrameLatencyTracker records when each frame passes through the stages of
+ * MediaCodec and CCodec, and summarizes the time spent in each stage.
+ *
+ * Frames are identified by their frame index, and kept in a fixed size ring.
+ * A frame is finished when its output is rendered or released, or when a
+ * newer frame takes its slot in the ring.
+ *
+ * While atrace is enabled, each stage of each frame is also traced as an async
+ * slice named after the codec and the stage, with the frame index as cookie.
+ */
+class FrameLatencyTracker {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Event : size_t {
+        // the client queued the input buffer
+        INPUT_QUEUED,
+        // the work item was queued to the component
+        COMPONENT_QUEUED,
+        // the component returned the work item
+        COMPONENT_DONE,
+        // the output buffer was made available to the client for dequeue
+        OUTPUT_AVAILABLE,
+        // the client released the output buffer to be rendered
+        RENDERED,
+        NUM_EVENTS,
+    };
+
+    enum Stage : size_t {
+        // the stages between consecutive events
+        INPUT_TO_COMPONENT,
+        IN_COMPONENT,
+        COMPONENT_TO_OUTPUT,
+        OUTPUT_TO_RENDER,
+        // from INPUT_QUEUED to RENDERED, or to OUTPUT_AVAILABLE if the
+        // output was released without rendering
+        END_TO_END,
+        NUM_STAGES,
+    };
+
+    // Number of frames in flight the tracker can follow.
+    static constexpr size_t kCapacity = 64;
+
+    FrameLatencyTracker();
+    ~FrameLatencyTracker() = default;
+
+    /**
+     * Set the codec name used for the trace slices, and clear the stats.
+     */
+    void start(const std::string &name);
+
+    /**
+     * Record |event| of frame |frameIndex|. Repeated events of a frame are
+     * ignored.
+     */
+    void onEvent(uint64_t frameIndex, Event event, const Clock::time_point &now);
+
+    /**
+     * The client released the output buffer of frame |frameIndex|, with or
+     * without rendering it.
+     */
+    void onOutputReleased(uint64_t frameIndex, bool rendered, const Clock::time_point &now);
+
+    /**
+     * Finish all frames in flight. The stats are kept.
+     */
+    void flush();
+
+    /**
+     * Return the number of samples of |stage|.
+     */
+    size_t count(Stage stage) const;
+
+    /**
+     * Return an upper bound of the |percentile|-th percentile of the
+     * latency of |stage|, within 1/8 of the value, or zero without samples.
+     */
+    Clock::duration percentile(Stage stage, int percentile) const;
+
+    /**
+     * Append the stats to |out| in human readable form.
+     */
+    void dump(std::string *out) const;
+
+    /**
+     * Set the stats to |metrics| with media metrics keys.
+     */
+    void exportMetrics(const sp<AMessage> &metrics) const;
+
+private:
+    struct Frame {
+        Frame() : inUse(false), finished(false), tracing(false), frameIndex(0), events(0),
+                  lastEvent(NUM_EVENTS) {}
+
+        bool inUse;
+        bool finished;
+        // an async trace slice is open for |lastEvent|
+        bool tracing;
+        uint64_t frameIndex;
+        uint32_t events;
+        Event lastEvent;
+        Clock::time_point times[NUM_EVENTS];
+
+        bool has(Event event) const { return (events & (1u << event)) != 0; }
+    };
+
+    /**
+     * Latency histogram with 8 linear buckets per power of two microseconds.
+     */
+    struct Histogram {
+        static constexpr size_t kSubBuckets = 8;
+        static constexpr size_t kNumBuckets = 256;
+
+        Histogram() { clear(); }
+        void clear();
+        void add(Clock::duration latency);
+        int64_t percentileUs(int percentile) const;
+
+        uint32_t counts[kNumBuckets];
+        size_t total;
+        int64_t maxUs;
+    };
+
+    std::string mTraceNames[NUM_EVENTS];
+    std::vector<Frame> mFrames;
+    Histogram mStages[NUM_STAGES];
+
+    void finish(Frame *frame);
+};
+
+}  // namespace android
+
+#endif  // FRAME_LATENCY_TRACKER_H_
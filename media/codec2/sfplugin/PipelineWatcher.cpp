@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PipelineWatcher"
 
+#include <algorithm>
 #include <numeric>
 
 #include <log/log.h>
@@ -58,40 +59,58 @@ void PipelineWatcher::onWorkQueued(
           (unsigned long long)frameIndex,
           buffers.size(),
           (long long)queuedAt.time_since_epoch().count());
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it != mFramesInPipeline.end()) {
+    if (findFrame(frameIndex)) {
         ALOGD("onWorkQueued: Duplicate frame index (%llu); previous entry removed",
               (unsigned long long)frameIndex);
-        (void)mFramesInPipeline.erase(it);
+        onWorkDone(frameIndex);
+    }
+    if (mNumFrames >= mFrames.size()) {
+        grow();
+    }
+    std::vector<Frame> &bucket = bucketFor(frameIndex);
+    bucket.emplace_back();
+    Frame &frame = bucket.back();
+    frame.frameIndex = frameIndex;
+    frame.buffers = std::move(buffers);
+    frame.numPendingBuffers = std::count_if(
+            frame.buffers.begin(), frame.buffers.end(),
+            [](const std::shared_ptr<C2Buffer> &buffer) { return buffer != nullptr; });
+    frame.queuedAt = queuedAt;
+    ++mNumFrames;
+    if (frame.numPendingBuffers == 0) {
+        frame.inputReleasedAt = queuedAt;
+        ++mNumFramesWithInputReleased;
     }
-    (void)mFramesInPipeline.try_emplace(frameIndex, std::move(buffers), queuedAt);
 }
 
 std::shared_ptr<C2Buffer> PipelineWatcher::onInputBufferReleased(
         uint64_t frameIndex, size_t arrayIndex) {
     ALOGV("onInputBufferReleased(frameIndex=%llu, arrayIndex=%zu)",
           (unsigned long long)frameIndex, arrayIndex);
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it == mFramesInPipeline.end()) {
+    Frame *frame = findFrame(frameIndex);
+    if (!frame) {
         ALOGD("onInputBufferReleased: frameIndex not found (%llu); ignored",
               (unsigned long long)frameIndex);
         return nullptr;
     }
-    if (it->second.buffers.size() <= arrayIndex) {
+    if (frame->buffers.size() <= arrayIndex) {
         ALOGD("onInputBufferReleased: buffers at %llu: size %zu, requested index: %zu",
-              (unsigned long long)frameIndex, it->second.buffers.size(), arrayIndex);
+              (unsigned long long)frameIndex, frame->buffers.size(), arrayIndex);
         return nullptr;
     }
-    std::shared_ptr<C2Buffer> buffer(std::move(it->second.buffers[arrayIndex]));
+    std::shared_ptr<C2Buffer> buffer(std::move(frame->buffers[arrayIndex]));
     ALOGD_IF(!buffer, "onInputBufferReleased: buffer already released (%llu:%zu)",
              (unsigned long long)frameIndex, arrayIndex);
+    if (buffer && --frame->numPendingBuffers == 0) {
+        releaseInput(frame, Clock::now());
+    }
     return buffer;
 }
 
 void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
     ALOGV("onWorkDone(frameIndex=%llu)", (unsigned long long)frameIndex);
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it == mFramesInPipeline.end()) {
+    Frame *frame = findFrame(frameIndex);
+    if (!frame) {
         if (!mTunneled) {
             ALOGD("onWorkDone: frameIndex not found (%llu); ignored",
                   (unsigned long long)frameIndex);
@@ -101,31 +120,39 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
         }
         return;
     }
-    (void)mFramesInPipeline.erase(it);
+    Clock::time_point now = Clock::now();
+    if (frame->numPendingBuffers > 0) {
+        // the component did not report the input buffers released earlier
+        frame->numPendingBuffers = 0;
+        releaseInput(frame, now);
+    }
+    mInputReleasedToDone.add(now - frame->inputReleasedAt);
+    mQueuedToDone.add(now - frame->queuedAt);
+    removeFrame(frameIndex);
+    --mNumFrames;
+    --mNumFramesWithInputReleased;
 }
 
 void PipelineWatcher::flush() {
     ALOGV("flush");
-    mFramesInPipeline.clear();
+    for (std::vector<Frame> &bucket : mFrames) {
+        bucket.clear();
+    }
+    mNumFrames = 0;
+    mNumFramesWithInputReleased = 0;
+}
+
+size_t PipelineWatcher::numWorksInPipeline() const {
+    return mNumFrames;
 }
 
 bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
-    if (mFramesInPipeline.size() >=
+    if (mNumFrames >=
             mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
-        ALOGV("pipelineFull: too many frames in pipeline (%zu)", mFramesInPipeline.size());
+        ALOGV("pipelineFull: too many frames in pipeline (%zu)", mNumFrames);
         return true;
     }
-    size_t sizeWithInputReleased = std::count_if(
-            mFramesInPipeline.begin(),
-            mFramesInPipeline.end(),
-            [](const decltype(mFramesInPipeline)::value_type &value) {
-                for (const std::shared_ptr<C2Buffer> &buffer : value.second.buffers) {
-                    if (buffer) {
-                        return false;
-                    }
-                }
-                return true;
-            });
+    size_t sizeWithInputReleased = mNumFramesWithInputReleased;
     if (sizeWithInputReleased >=
             mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
         ALOGV("pipelineFull: too many frames in pipeline, with input released (%zu)",
@@ -133,37 +160,112 @@ bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
         return true;
     }
 
-    size_t sizeWithInputsPending = mFramesInPipeline.size() - sizeWithInputReleased;
+    size_t sizeWithInputsPending = mNumFrames - sizeWithInputReleased;
     if (sizeWithInputsPending > mPipelineDelay + mInputDelay + mSmoothnessFactor) {
         ALOGV("pipelineFull: too many inputs pending (%zu) in pipeline, with inputs released (%zu)",
               sizeWithInputsPending, sizeWithInputReleased);
         return true;
     }
     ALOGV("pipeline has room (total: %zu, input released: %zu)",
-          mFramesInPipeline.size(), sizeWithInputReleased);
+          mNumFrames, sizeWithInputReleased);
     if (pipelineRoom) {
         *pipelineRoom = mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor
-                                - mFramesInPipeline.size();
+                                - mNumFrames;
     }
     return false;
 }
 
 PipelineWatcher::Clock::duration PipelineWatcher::elapsed(
         const PipelineWatcher::Clock::time_point &now, size_t n) const {
-    if (mFramesInPipeline.size() <= n) {
+    if (mNumFrames <= n) {
         return Clock::duration::zero();
     }
-    std::vector<Clock::duration> durations;
-    for (const decltype(mFramesInPipeline)::value_type &value : mFramesInPipeline) {
-        Clock::duration elapsed = now - value.second.queuedAt;
-        ALOGV("elapsed: frameIndex = %llu elapsed = %lldms",
-              (unsigned long long)value.first,
-              std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
-        durations.push_back(elapsed);
+    mDurations.clear();
+    for (const std::vector<Frame> &bucket : mFrames) {
+        for (const Frame &frame : bucket) {
+            Clock::duration elapsed = now - frame.queuedAt;
+            ALOGV("elapsed: frameIndex = %llu elapsed = %lldms",
+                  (unsigned long long)frame.frameIndex,
+                  std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+            mDurations.push_back(elapsed);
+        }
     }
-    std::nth_element(durations.begin(), durations.begin() + n, durations.end(),
+    std::nth_element(mDurations.begin(), mDurations.begin() + n, mDurations.end(),
                      std::greater<Clock::duration>());
-    return durations[n];
+    return mDurations[n];
+}
+
+size_t PipelineWatcher::capacity() const {
+    return mFrames.size();
+}
+
+void PipelineWatcher::dump(std::string *out) const {
+    mQueuedToInputReleased.dump("queued->input released", out);
+    mInputReleasedToDone.dump("input released->done", out);
+    mQueuedToDone.dump("queued->done", out);
+}
+
+std::vector<PipelineWatcher::Frame> &PipelineWatcher::bucketFor(uint64_t frameIndex) {
+    return mFrames[frameIndex & (mFrames.size() - 1)];
+}
+
+PipelineWatcher::Frame *PipelineWatcher::findFrame(uint64_t frameIndex) {
+    for (Frame &frame : bucketFor(frameIndex)) {
+        if (frame.frameIndex == frameIndex) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+void PipelineWatcher::removeFrame(uint64_t frameIndex) {
+    std::vector<Frame> &bucket = bucketFor(frameIndex);
+    for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+        if (it->frameIndex == frameIndex) {
+            bucket.erase(it);
+            return;
+        }
+    }
+}
+
+void PipelineWatcher::grow() {
+    std::vector<std::vector<Frame>> frames(mFrames.size() * 2);
+    for (std::vector<Frame> &bucket : mFrames) {
+        for (Frame &frame : bucket) {
+            frames[frame.frameIndex & (frames.size() - 1)].push_back(std::move(frame));
+        }
+    }
+    ALOGD("grew to track %zu frames", frames.size());
+    mFrames.swap(frames);
+}
+
+void PipelineWatcher::releaseInput(Frame *frame, const Clock::time_point &now) {
+    frame->inputReleasedAt = now;
+    mQueuedToInputReleased.add(now - frame->queuedAt);
+    ++mNumFramesWithInputReleased;
+}
+
+void PipelineWatcher::Histogram::add(Clock::duration latency) {
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(latency).count();
+    size_t bucket = 0;
+    while (bucket + 1 < kNumBuckets && ms >= (int64_t(1) << bucket)) {
+        ++bucket;
+    }
+    ++counts[bucket];
+    ++total;
+}
+
+void PipelineWatcher::Histogram::dump(const char *name, std::string *out) const {
+    out->append(name).append(": ").append(std::to_string(total));
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        out->append(" <");
+        out->append(i + 1 < kNumBuckets ? std::to_string(1 << i) + "ms" : "inf");
+        out->append(":").append(std::to_string(counts[i]));
+    }
+    out->append("\n");
 }
 
 }  // namespace android
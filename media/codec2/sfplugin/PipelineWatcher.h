@@ -18,8 +18,9 @@
 #define PIPELINE_WATCHER_H_
 
 #include <chrono>
-#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <C2Work.h>
 
@@ -33,12 +34,19 @@ class PipelineWatcher {
 public:
     typedef std::chrono::steady_clock Clock;
 
+    // Initial number of frames the watcher can track before it grows. Must be
+    // a power of two.
+    static constexpr size_t kInitialCapacity = 32;
+
     PipelineWatcher()
         : mInputDelay(0),
           mPipelineDelay(0),
           mOutputDelay(0),
           mSmoothnessFactor(0),
-          mTunneled(false) {}
+          mTunneled(false),
+          mFrames(kInitialCapacity),
+          mNumFrames(0),
+          mNumFramesWithInputReleased(0) {}
     ~PipelineWatcher() = default;
 
     /**
@@ -106,6 +114,12 @@ public:
      */
     void flush();
 
+    /**
+     * \return  the number of work items queued to the component and not
+     *          done yet.
+     */
+    size_t numWorksInPipeline() const;
+
     /**
      * \param   pipelineRoom   additional work items that pipeline can take
      *                         before getting full.
@@ -126,6 +140,16 @@ public:
      */
     Clock::duration elapsed(const Clock::time_point &now, size_t n) const;
 
+    /**
+     * \return  the number of frames the watcher can track before it grows.
+     */
+    size_t capacity() const;
+
+    /**
+     * Append the latency histograms of the work items done so far to |out|.
+     */
+    void dump(std::string *out) const;
+
 private:
     uint32_t mInputDelay;
     uint32_t mPipelineDelay;
@@ -134,14 +158,45 @@ private:
     bool mTunneled;
 
     struct Frame {
-        Frame(std::vector<std::shared_ptr<C2Buffer>> &&b,
-              const Clock::time_point &q)
-            : buffers(b),
-              queuedAt(q) {}
+        uint64_t frameIndex = 0;
         std::vector<std::shared_ptr<C2Buffer>> buffers;
-        const Clock::time_point queuedAt;
+        // number of buffers not released yet
+        size_t numPendingBuffers = 0;
+        Clock::time_point queuedAt;
+        Clock::time_point inputReleasedAt;
+    };
+    // Frames in the pipeline, in a ring of buckets indexed by the low bits of
+    // the frame index. Frame indices in the pipeline are mostly consecutive,
+    // so buckets rarely hold more than one frame. The ring doubles when the
+    // number of frames reaches its size, so it grows with the number of frames
+    // in flight, not with the range of their indices; a frame the component
+    // never returns doesn't make it grow. Buckets keep their storage, so a
+    // steady stream of frames doesn't allocate.
+    std::vector<std::vector<Frame>> mFrames;
+    size_t mNumFrames;
+    size_t mNumFramesWithInputReleased;
+    // scratch space for elapsed()
+    mutable std::vector<Clock::duration> mDurations;
+
+    std::vector<Frame> &bucketFor(uint64_t frameIndex);
+    Frame *findFrame(uint64_t frameIndex);
+    void removeFrame(uint64_t frameIndex);
+    void grow();
+    void releaseInput(Frame *frame, const Clock::time_point &now);
+
+    // Counts of latencies in power-of-two buckets of milliseconds:
+    // [0, 1ms), [1ms, 2ms), [2ms, 4ms), ... [512ms, inf).
+    struct Histogram {
+        static constexpr size_t kNumBuckets = 11;
+        uint64_t counts[kNumBuckets] = {};
+        uint64_t total = 0;
+
+        void add(Clock::duration latency);
+        void dump(const char *name, std::string *out) const;
     };
-    std::map<uint64_t, Frame> mFramesInPipeline;
+    Histogram mQueuedToInputReleased;
+    Histogram mInputReleasedToDone;
+    Histogram mQueuedToDone;
 };
 
 }  // namespace android
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "WorkBatcher"
+
+#include <algorithm>
+
+#include <log/log.h>
+
+#include "WorkBatcher.h"
+
+namespace android {
+
+WorkBatcher &WorkBatcher::maxBatchSize(size_t value) {
+    mMaxBatchSize = std::max(value, size_t(1));
+    return *this;
+}
+
+WorkBatcher &WorkBatcher::maxLatency(Clock::duration value) {
+    mMaxLatency = value;
+    return *this;
+}
+
+WorkBatcher &WorkBatcher::minWorksInFlight(size_t value) {
+    // Without a work item in the component, nothing would release held ones.
+    mMinWorksInFlight = std::max(value, size_t(1));
+    return *this;
+}
+
+void WorkBatcher::onWorkQueued(
+        std::list<std::unique_ptr<C2Work>> *items,
+        size_t worksInFlight,
+        const Clock::time_point &now) {
+    bool hold = (mHeldWorks.size() + items->size() < mMaxBatchSize)
+            && (worksInFlight >= mMinWorksInFlight)
+            && (mHeldWorks.empty() || now - mOldestHeldAt < mMaxLatency);
+    for (const std::unique_ptr<C2Work> &work : *items) {
+        if (!hold) {
+            break;
+        }
+        // Flags and config updates may change how the component handles
+        // the following work items, so they are not delayed.
+        hold = (work->input.flags == 0) && work->input.configUpdate.empty();
+    }
+    if (hold) {
+        if (mHeldWorks.empty()) {
+            mOldestHeldAt = now;
+        }
+        mHeldWorks.splice(mHeldWorks.end(), *items);
+        ALOGV("onWorkQueued: holding %zu work items (%zu in flight)",
+              mHeldWorks.size(), worksInFlight);
+        return;
+    }
+    mHeldWorks.splice(mHeldWorks.end(), *items);
+    releaseHeldWorks(items);
+}
+
+void WorkBatcher::onWorkDone(
+        std::list<std::unique_ptr<C2Work>> *items,
+        size_t worksInFlight,
+        const Clock::time_point &now) {
+    if (mHeldWorks.empty()) {
+        return;
+    }
+    if (worksInFlight < mMinWorksInFlight || now - mOldestHeldAt >= mMaxLatency) {
+        releaseHeldWorks(items);
+    }
+}
+
+void WorkBatcher::flush() {
+    ALOGV("flush: dropping %zu work items", mHeldWorks.size());
+    mHeldWorks.clear();
+}
+
+size_t WorkBatcher::numHeldWorks() const {
+    return mHeldWorks.size();
+}
+
+WorkBatcher::Clock::time_point WorkBatcher::heldWorksDeadline() const {
+    if (mHeldWorks.empty()) {
+        return Clock::time_point::max();
+    }
+    return mOldestHeldAt + mMaxLatency;
+}
+
+void WorkBatcher::releaseHeldWorks(std::list<std::unique_ptr<C2Work>> *items) {
+    ALOGV("releasing %zu work items", mHeldWorks.size());
+    items->splice(items->end(), mHeldWorks);
+}
+
+}  // namespace android
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WORK_BATCHER_H_
+#define WORK_BATCHER_H_
+
+#include <chrono>
+#include <list>
+#include <memory>
+
+#include <C2Work.h>
+
+namespace android {
+
+/**
+ * WorkBatcher holds back work items queued by the client while the component
+ * has enough work to proceed, so that they are queued to the component
+ * together in a single queue() call.
+ *
+ * Work items are held only while the number of work items in the component
+ * is at least |minWorksInFlight|, which shall be large enough for the
+ * component to finish a work item without more input. The held work items are
+ * released when
+ *   - the component is about to run out of work items,
+ *   - |maxBatchSize| work items are held,
+ *   - the oldest held work item was queued |maxLatency| ago, or
+ *   - the client queues a work item with flags or config updates.
+ * Work items are always released in the order they were queued.
+ *
+ * The latency bound is only checked on events; the owner shall call
+ * onWorkDone() at heldWorksDeadline() if nothing else happens until then.
+ */
+class WorkBatcher {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    WorkBatcher()
+        : mMaxBatchSize(1),
+          mMaxLatency(Clock::duration::zero()),
+          mMinWorksInFlight(1) {}
+    ~WorkBatcher() = default;
+
+    /**
+     * \param value the maximum number of work items queued to the component
+     *              at once. 1 disables batching.
+     * \return  this object
+     */
+    WorkBatcher &maxBatchSize(size_t value);
+
+    /**
+     * \param value the maximum time to hold a work item back
+     * \return  this object
+     */
+    WorkBatcher &maxLatency(Clock::duration value);
+
+    /**
+     * \param value the number of work items in the component for it to
+     *              proceed without more input, e.g. input delay + pipeline
+     *              delay + 1.
+     * \return  this object
+     */
+    WorkBatcher &minWorksInFlight(size_t value);
+
+    /**
+     * Client queued work items.
+     *
+     * \param items[in,out]   the work items queued by the client. On return,
+     *                        the work items to queue to the component now,
+     *                        which may be empty.
+     * \param worksInFlight   number of work items queued to the component and
+     *                        not done yet
+     * \param now             current time
+     */
+    void onWorkQueued(
+            std::list<std::unique_ptr<C2Work>> *items,
+            size_t worksInFlight,
+            const Clock::time_point &now);
+
+    /**
+     * The component finished a work item.
+     *
+     * \param items[out]      the held work items to queue to the component
+     *                        now, if any.
+     * \param worksInFlight   number of work items queued to the component and
+     *                        not done yet
+     * \param now             current time
+     */
+    void onWorkDone(
+            std::list<std::unique_ptr<C2Work>> *items,
+            size_t worksInFlight,
+            const Clock::time_point &now);
+
+    /**
+     * Drop the held work items.
+     */
+    void flush();
+
+    /**
+     * Return the number of work items held back.
+     */
+    size_t numHeldWorks() const;
+
+    /**
+     * Return when the oldest held work item is due to be released, or
+     * Clock::time_point::max() if no work item is held.
+     */
+    Clock::time_point heldWorksDeadline() const;
+
+private:
+    size_t mMaxBatchSize;
+    Clock::duration mMaxLatency;
+    size_t mMinWorksInFlight;
+
+    std::list<std::unique_ptr<C2Work>> mHeldWorks;
+    Clock::time_point mOldestHeldAt;
+
+    void releaseHeldWorks(std::list<std::unique_ptr<C2Work>> *items);
+};
+
+}  // namespace android
+
+#endif  // WORK_BATCHER_H_
@@ -112,6 +112,8 @@ private:
     void stop(bool pushBlankBuffer);
     void flush();
     void release(bool sendCallback, bool pushBlankBuffer);
+    /// report the frame latencies of the session to the media metrics
+    void reportFrameLatencies();
 
     /**
      * Creates an input surface for the current device configuration compatible with CCodec.
@@ -127,6 +129,9 @@ private:
     void setInputSurface(const sp<PersistentSurface> &surface);
     status_t setupInputSurface(const std::shared_ptr<InputSurfaceWrapper> &surface);
 
+    /// handle a work returned by the component
+    void handleWorkDone(std::unique_ptr<C2Work> work);
+
     void setDeadline(
             const TimePoint &now,
             const std::chrono::milliseconds &timeout,
@@ -150,6 +155,7 @@ private:
 
         kWhatWorkDone,
         kWhatWatch,
+        kWhatHeldWorksTimeout,
     };
 
     enum {
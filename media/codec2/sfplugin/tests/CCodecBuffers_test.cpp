@@ -914,4 +914,154 @@ TEST(LinearOutputBuffersTest, PcmConvertFormat) {
     ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
 }
 
+static std::shared_ptr<LinearInputBuffers> GetLinearInputBuffers() {
+    std::shared_ptr<LinearInputBuffers> buffers =
+        std::make_shared<LinearInputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    format->setInt32(KEY_MAX_INPUT_SIZE, 4096);
+    buffers->setFormat(format);
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != OK) {
+        return nullptr;
+    }
+    buffers->setPool(pool);
+    return buffers;
+}
+
+// Fills |buffer| like a client would, and queues it the way CCodecBufferChannel
+// does.
+static std::shared_ptr<C2Buffer> QueueInputBuffer(
+        const std::shared_ptr<InputBuffers> &buffers, const sp<MediaCodecBuffer> &buffer) {
+    for (size_t i = 0; i < 1024; ++i) {
+        buffer->base()[i] = i & 0xFF;
+    }
+    buffer->setRange(0, 1024);
+    std::shared_ptr<C2Buffer> c2Buffer;
+    if (!buffers->releaseBuffer(buffer, &c2Buffer, false)
+            || !buffers->releaseBuffer(buffer, nullptr, true)) {
+        return nullptr;
+    }
+    return c2Buffer;
+}
+
+TEST(LinearInputBuffersTest, ZeroCopy) {
+    std::shared_ptr<LinearInputBuffers> buffers = GetLinearInputBuffers();
+    ASSERT_NE(nullptr, buffers);
+
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &clientBuffer));
+    ASSERT_GE(clientBuffer->capacity(), 4096u);
+    std::shared_ptr<C2Buffer> c2Buffer = QueueInputBuffer(buffers, clientBuffer);
+    ASSERT_NE(nullptr, c2Buffer);
+
+    // The component reads what the client wrote, without a copy.
+    ASSERT_EQ(C2BufferData::LINEAR, c2Buffer->data().type());
+    ASSERT_EQ(1u, c2Buffer->data().linearBlocks().size());
+    C2ReadView view = c2Buffer->data().linearBlocks().front().map().get();
+    ASSERT_EQ(C2_OK, view.error());
+    ASSERT_EQ(1024u, view.capacity());
+    for (size_t i = 0; i < 1024; ++i) {
+        ASSERT_EQ(i & 0xFF, view.data()[i]) << "at " << i;
+    }
+    EXPECT_EQ(0u, buffers->numCopies());
+    EXPECT_EQ(0u, buffers->numCopiedBytes());
+
+    // In array mode, buffers are copied when the component needs more buffers
+    // than the client has slots.
+    std::unique_ptr<InputBuffers> array = buffers->toArrayMode(4);
+    ASSERT_TRUE(array->requestNewBuffer(&index, &clientBuffer));
+    clientBuffer->setRange(0, 1024);
+    sp<Codec2Buffer> copy = array->cloneAndReleaseBuffer(clientBuffer);
+    ASSERT_NE(nullptr, copy);
+    EXPECT_EQ(1u, array->numCopies());
+    EXPECT_EQ(1024u, array->numCopiedBytes());
+}
+
+TEST(LinearInputBuffersTest, RecycleBlocks) {
+    std::shared_ptr<LinearInputBuffers> buffers = GetLinearInputBuffers();
+    ASSERT_NE(nullptr, buffers);
+    buffers->setRecycleDepth(4);
+
+    size_t index;
+    sp<MediaCodecBuffer> first;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &first));
+    first->meta()->setInt64("timeUs", 1000);
+    std::shared_ptr<C2Buffer> c2Buffer = QueueInputBuffer(buffers, first);
+    ASSERT_NE(nullptr, c2Buffer);
+
+    // The component still holds the block of the first buffer.
+    sp<MediaCodecBuffer> second;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &second));
+    EXPECT_NE(first->base(), second->base());
+    EXPECT_EQ(2u, buffers->numFetchedBlocks());
+    EXPECT_EQ(0u, buffers->numRecycledBlocks());
+
+    // Once the component releases it, the block is handed out again as is.
+    ASSERT_TRUE(buffers->expireComponentBuffer(c2Buffer));
+    c2Buffer.reset();
+    uint8_t *base = first->base();
+    first.clear();
+    sp<MediaCodecBuffer> third;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &third));
+    EXPECT_EQ(base, third->base());
+    EXPECT_EQ(0u, third->offset());
+    EXPECT_EQ(third->capacity(), third->size());
+    EXPECT_FALSE(third->meta()->contains("timeUs"));
+    EXPECT_EQ(2u, buffers->numFetchedBlocks());
+    EXPECT_EQ(1u, buffers->numRecycledBlocks());
+
+    // Buffers discarded by the client are recycled right away.
+    ASSERT_TRUE(buffers->releaseBuffer(second, nullptr, true));
+    base = second->base();
+    second.clear();
+    sp<MediaCodecBuffer> fourth;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &fourth));
+    EXPECT_EQ(base, fourth->base());
+    EXPECT_EQ(2u, buffers->numRecycledBlocks());
+    EXPECT_EQ(0u, buffers->numCopies());
+}
+
+TEST(LinearInputBuffersTest, RecycleDepthAndFlush) {
+    std::shared_ptr<LinearInputBuffers> buffers = GetLinearInputBuffers();
+    ASSERT_NE(nullptr, buffers);
+    buffers->setRecycleDepth(2);
+
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffers[3];
+    for (sp<MediaCodecBuffer> &buffer : clientBuffers) {
+        ASSERT_TRUE(buffers->requestNewBuffer(&index, &buffer));
+    }
+    EXPECT_EQ(3u, buffers->numFetchedBlocks());
+
+    // Only as many buffers as the depth are kept.
+    for (sp<MediaCodecBuffer> &buffer : clientBuffers) {
+        ASSERT_TRUE(buffers->releaseBuffer(buffer, nullptr, true));
+        buffer.clear();
+    }
+    for (sp<MediaCodecBuffer> &buffer : clientBuffers) {
+        ASSERT_TRUE(buffers->requestNewBuffer(&index, &buffer));
+    }
+    EXPECT_EQ(4u, buffers->numFetchedBlocks());
+    EXPECT_EQ(2u, buffers->numRecycledBlocks());
+
+    // Flushing drops the kept buffers.
+    for (sp<MediaCodecBuffer> &buffer : clientBuffers) {
+        ASSERT_TRUE(buffers->releaseBuffer(buffer, nullptr, true));
+        buffer.clear();
+    }
+    buffers->flush();
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &clientBuffers[0]));
+    EXPECT_EQ(5u, buffers->numFetchedBlocks());
+    EXPECT_EQ(2u, buffers->numRecycledBlocks());
+
+    // A depth of 0 disables recycling.
+    buffers->setRecycleDepth(0);
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffers[0], nullptr, true));
+    clientBuffers[0].clear();
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &clientBuffers[0]));
+    EXPECT_EQ(6u, buffers->numFetchedBlocks());
+    EXPECT_EQ(2u, buffers->numRecycledBlocks());
+}
+
 } // namespace android
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures how many small audio access units per second go through MediaCodec
+// and CCodec with the raw audio decoder, for each work batch size. The batch
+// size is set with the debug.stagefright.ccodec_work_batch_size property, so
+// this needs to run as shell or root.
+
+#include <string.h>
+
+#include <string>
+
+#include <android-base/properties.h>
+#include <benchmark/benchmark.h>
+#include <binder/ProcessState.h>
+#include <media/MediaCodecBuffer.h>
+#include <media/stagefright/MediaCodec.h>
+#include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+static constexpr size_t kNumAccessUnits = 2000;
+// 64 stereo 16-bit samples
+static constexpr size_t kAccessUnitSize = 256;
+static constexpr int64_t kTimeoutUs = 10000;
+
+// Decodes kNumAccessUnits access units, and returns false on errors.
+static bool decode(const sp<MediaCodec> &codec) {
+    size_t numQueued = 0;
+    bool eos = false;
+    while (!eos) {
+        size_t index;
+        sp<MediaCodecBuffer> buffer;
+        while (numQueued <= kNumAccessUnits
+                && codec->dequeueInputBuffer(&index, 0) == OK) {
+            if (codec->getInputBuffer(index, &buffer) != OK) {
+                return false;
+            }
+            memset(buffer->base(), numQueued & 0xFF, kAccessUnitSize);
+            bool last = (numQueued == kNumAccessUnits);
+            if (codec->queueInputBuffer(
+                    index, 0, last ? 0 : kAccessUnitSize, numQueued * 1333,
+                    last ? BUFFER_FLAG_END_OF_STREAM : 0) != OK) {
+                return false;
+            }
+            ++numQueued;
+        }
+        size_t offset, size;
+        int64_t timeUs;
+        uint32_t flags;
+        status_t err = codec->dequeueOutputBuffer(
+                &index, &offset, &size, &timeUs, &flags, kTimeoutUs);
+        if (err == OK) {
+            eos = (flags & BUFFER_FLAG_END_OF_STREAM) != 0;
+            if (codec->releaseOutputBuffer(index) != OK) {
+                return false;
+            }
+        } else if (err != -EAGAIN && err != INFO_FORMAT_CHANGED
+                && err != INFO_OUTPUT_BUFFERS_CHANGED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void BM_RawAudioDecoder(benchmark::State &state) {
+    android::base::SetProperty(
+            "debug.stagefright.ccodec_work_batch_size", std::to_string(state.range(0)));
+    sp<ALooper> looper = new ALooper;
+    looper->start();
+    for (auto _ : state) {
+        state.PauseTiming();
+        sp<MediaCodec> codec = MediaCodec::CreateByComponentName(looper, "c2.android.raw.decoder");
+        if (codec == nullptr) {
+            state.SkipWithError("failed to create the raw decoder");
+            break;
+        }
+        sp<AMessage> format = new AMessage;
+        format->setString(KEY_MIME, MIMETYPE_AUDIO_RAW);
+        format->setInt32(KEY_SAMPLE_RATE, 48000);
+        format->setInt32(KEY_CHANNEL_COUNT, 2);
+        format->setInt32(KEY_MAX_INPUT_SIZE, kAccessUnitSize);
+        if (codec->configure(format, nullptr, nullptr, 0) != OK || codec->start() != OK) {
+            codec->release();
+            state.SkipWithError("failed to start the raw decoder");
+            break;
+        }
+        state.ResumeTiming();
+
+        bool ok = decode(codec);
+
+        state.PauseTiming();
+        codec->release();
+        state.ResumeTiming();
+        if (!ok) {
+            state.SkipWithError("failed to decode");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumAccessUnits);
+    looper->stop();
+    android::base::SetProperty("debug.stagefright.ccodec_work_batch_size", "");
+}
+
+BENCHMARK(BM_RawAudioDecoder)->Arg(1)->Arg(4)->Arg(16)->ArgName("batch")->UseRealTime();
+
+int main(int argc, char **argv) {
+    ProcessState::self()->startThreadPool();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
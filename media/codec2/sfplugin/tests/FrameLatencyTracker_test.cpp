@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameLatencyTracker.h"
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/MediaCodecMetricsConstants.h>
+
+namespace android {
+
+using namespace std::chrono_literals;
+
+class FrameLatencyTrackerTest : public ::testing::Test {
+protected:
+    FrameLatencyTrackerTest() : mNow(FrameLatencyTracker::Clock::now()) {
+        mTracker.start("test");
+    }
+
+    // Passes frame |frameIndex| through all events |interval| apart, starting
+    // at mNow.
+    void runFrame(uint64_t frameIndex, FrameLatencyTracker::Clock::duration interval) {
+        FrameLatencyTracker::Clock::time_point time = mNow;
+        for (size_t i = 0; i < FrameLatencyTracker::NUM_EVENTS; ++i) {
+            mTracker.onEvent(frameIndex, FrameLatencyTracker::Event(i), time);
+            time += interval;
+        }
+    }
+
+    FrameLatencyTracker mTracker;
+    FrameLatencyTracker::Clock::time_point mNow;
+};
+
+TEST_F(FrameLatencyTrackerTest, Stages) {
+    runFrame(0, 1ms);
+    for (size_t i = 0; i < FrameLatencyTracker::END_TO_END; ++i) {
+        FrameLatencyTracker::Stage stage = FrameLatencyTracker::Stage(i);
+        EXPECT_EQ(1u, mTracker.count(stage));
+        EXPECT_EQ(1ms, mTracker.percentile(stage, 50));
+    }
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::END_TO_END));
+    EXPECT_EQ(4ms, mTracker.percentile(FrameLatencyTracker::END_TO_END, 50));
+
+    // events after the frame is finished are ignored
+    mTracker.onEvent(0, FrameLatencyTracker::OUTPUT_AVAILABLE, mNow + 10ms);
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::COMPONENT_TO_OUTPUT));
+}
+
+TEST_F(FrameLatencyTrackerTest, OutputReleasedWithoutRendering) {
+    mTracker.onEvent(0, FrameLatencyTracker::INPUT_QUEUED, mNow);
+    mTracker.onEvent(0, FrameLatencyTracker::COMPONENT_QUEUED, mNow + 1ms);
+    mTracker.onEvent(0, FrameLatencyTracker::COMPONENT_DONE, mNow + 3ms);
+    // repeated events are ignored
+    mTracker.onEvent(0, FrameLatencyTracker::COMPONENT_DONE, mNow + 4ms);
+    mTracker.onEvent(0, FrameLatencyTracker::OUTPUT_AVAILABLE, mNow + 6ms);
+    mTracker.onOutputReleased(0, false /* rendered */, mNow + 10ms);
+
+    EXPECT_EQ(2ms, mTracker.percentile(FrameLatencyTracker::IN_COMPONENT, 50));
+    EXPECT_EQ(3ms, mTracker.percentile(FrameLatencyTracker::COMPONENT_TO_OUTPUT, 50));
+    EXPECT_EQ(0u, mTracker.count(FrameLatencyTracker::OUTPUT_TO_RENDER));
+    EXPECT_EQ(6ms, mTracker.percentile(FrameLatencyTracker::END_TO_END, 50));
+}
+
+TEST_F(FrameLatencyTrackerTest, Percentiles) {
+    for (uint64_t i = 0; i < 100; ++i) {
+        runFrame(i, (i + 1) * 100us);
+    }
+    EXPECT_EQ(100u, mTracker.count(FrameLatencyTracker::IN_COMPONENT));
+    // within 1/8 above the exact value
+    auto near = [](FrameLatencyTracker::Clock::duration actual,
+                   FrameLatencyTracker::Clock::duration expected) {
+        return actual >= expected && actual <= expected + expected / 8;
+    };
+    EXPECT_TRUE(near(mTracker.percentile(FrameLatencyTracker::IN_COMPONENT, 50), 5000us));
+    EXPECT_TRUE(near(mTracker.percentile(FrameLatencyTracker::IN_COMPONENT, 90), 9000us));
+    EXPECT_EQ(10000us, mTracker.percentile(FrameLatencyTracker::IN_COMPONENT, 99));
+    EXPECT_EQ(10000us, mTracker.percentile(FrameLatencyTracker::IN_COMPONENT, 100));
+}
+
+TEST_F(FrameLatencyTrackerTest, Eviction) {
+    // A frame without output is finished when a newer frame takes its slot.
+    mTracker.onEvent(0, FrameLatencyTracker::INPUT_QUEUED, mNow);
+    mTracker.onEvent(0, FrameLatencyTracker::COMPONENT_QUEUED, mNow);
+    mTracker.onEvent(0, FrameLatencyTracker::OUTPUT_AVAILABLE, mNow + 5ms);
+    runFrame(FrameLatencyTracker::kCapacity, 1ms);
+    EXPECT_EQ(2u, mTracker.count(FrameLatencyTracker::END_TO_END));
+    // COMPONENT_DONE was missed for frame 0.
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::COMPONENT_TO_OUTPUT));
+
+    // frame 0 is gone
+    mTracker.onOutputReleased(0, true /* rendered */, mNow);
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::OUTPUT_TO_RENDER));
+}
+
+TEST_F(FrameLatencyTrackerTest, FlushAndStart) {
+    mTracker.onEvent(0, FrameLatencyTracker::INPUT_QUEUED, mNow);
+    mTracker.flush();
+    mTracker.onEvent(0, FrameLatencyTracker::COMPONENT_QUEUED, mNow + 1ms);
+    EXPECT_EQ(0u, mTracker.count(FrameLatencyTracker::INPUT_TO_COMPONENT));
+
+    runFrame(1, 1ms);
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::INPUT_TO_COMPONENT));
+    mTracker.flush();
+    EXPECT_EQ(1u, mTracker.count(FrameLatencyTracker::INPUT_TO_COMPONENT));
+    mTracker.start("test");
+    EXPECT_EQ(0u, mTracker.count(FrameLatencyTracker::INPUT_TO_COMPONENT));
+}
+
+TEST_F(FrameLatencyTrackerTest, Metrics) {
+    sp<AMessage> metrics = new AMessage;
+    mTracker.exportMetrics(metrics);
+    EXPECT_EQ(0u, metrics->countEntries());
+
+    runFrame(0, 1ms);
+    mTracker.exportMetrics(metrics);
+    std::string prefix = std::string(kCodecFrameLatencyPrefix) + "end-to-end.";
+    int64_t value = 0;
+    EXPECT_TRUE(metrics->findInt64((prefix + "n").c_str(), &value));
+    EXPECT_EQ(1, value);
+    EXPECT_TRUE(metrics->findInt64((prefix + "p99").c_str(), &value));
+    EXPECT_EQ(4000, value);
+    EXPECT_TRUE(metrics->findInt64((prefix + "max").c_str(), &value));
+    EXPECT_EQ(4000, value);
+
+    std::string dump;
+    mTracker.dump(&dump);
+    EXPECT_NE(std::string::npos,
+              dump.find("end-to-end: n=1 p50=4000us p90=4000us p99=4000us max=4000us\n")) << dump;
+}
+
+}  // namespace android
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PipelineWatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <C2PlatformSupport.h>
+
+namespace android {
+
+using namespace std::chrono_literals;
+
+static std::vector<std::shared_ptr<C2Buffer>> MakeBuffers() {
+    std::shared_ptr<C2BlockPool> pool;
+    std::shared_ptr<C2LinearBlock> block;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK
+            || pool->fetchLinearBlock(
+                    16, {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block) != C2_OK) {
+        return {};
+    }
+    return { C2Buffer::CreateLinearBuffer(block->share(0, 16, C2Fence())) };
+}
+
+TEST(PipelineWatcherTest, PipelineFull) {
+    PipelineWatcher watcher;
+    watcher.inputDelay(2).pipelineDelay(1).outputDelay(1).smoothnessFactor(1);
+    PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+
+    size_t room = 0;
+    EXPECT_FALSE(watcher.pipelineFull(&room));
+    EXPECT_EQ(5u, room);
+    for (uint64_t i = 0; i < 4; ++i) {
+        watcher.onWorkQueued(i, MakeBuffers(), now);
+    }
+    EXPECT_FALSE(watcher.pipelineFull(&room));
+    EXPECT_EQ(1u, room);
+    EXPECT_EQ(4u, watcher.numWorksInPipeline());
+
+    // 3 works with input released fill the pipeline + output delay.
+    for (uint64_t i = 0; i < 3; ++i) {
+        EXPECT_NE(nullptr, watcher.onInputBufferReleased(i, 0));
+    }
+    EXPECT_TRUE(watcher.pipelineFull());
+    EXPECT_EQ(nullptr, watcher.onInputBufferReleased(0, 0));
+    EXPECT_EQ(nullptr, watcher.onInputBufferReleased(0, 1));
+    EXPECT_EQ(nullptr, watcher.onInputBufferReleased(10, 0));
+
+    watcher.onWorkDone(0);
+    EXPECT_FALSE(watcher.pipelineFull());
+    EXPECT_EQ(3u, watcher.numWorksInPipeline());
+
+    // unknown and repeated frame indices are ignored
+    watcher.onWorkDone(0);
+    watcher.onWorkDone(100);
+    EXPECT_EQ(3u, watcher.numWorksInPipeline());
+
+    watcher.flush();
+    EXPECT_EQ(0u, watcher.numWorksInPipeline());
+    EXPECT_FALSE(watcher.pipelineFull(&room));
+    EXPECT_EQ(5u, room);
+}
+
+TEST(PipelineWatcherTest, Grow) {
+    PipelineWatcher watcher;
+    PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+    // A stuck frame, and frames that wrap around the ring several times.
+    watcher.onWorkQueued(0, MakeBuffers(), now);
+    const uint64_t kNumFrames = PipelineWatcher::kInitialCapacity * 5;
+    for (uint64_t i = 1; i < kNumFrames; ++i) {
+        watcher.onWorkQueued(i, MakeBuffers(), now + i * 1ms);
+        if (i > 3) {
+            watcher.onWorkDone(i - 3);
+        }
+    }
+    EXPECT_EQ(4u, watcher.numWorksInPipeline());
+    // The stuck frame doesn't make the ring grow with the range of indices.
+    EXPECT_EQ(PipelineWatcher::kInitialCapacity, watcher.capacity());
+    EXPECT_NE(nullptr, watcher.onInputBufferReleased(0, 0));
+    EXPECT_NE(nullptr, watcher.onInputBufferReleased(kNumFrames - 1, 0));
+
+    // a lot of frames in flight at once
+    watcher.flush();
+    for (uint64_t i = 0; i < kNumFrames; ++i) {
+        watcher.onWorkQueued(i, MakeBuffers(), now);
+    }
+    EXPECT_EQ(kNumFrames, watcher.numWorksInPipeline());
+    EXPECT_GE(watcher.capacity(), kNumFrames);
+    for (uint64_t i = 0; i < kNumFrames; ++i) {
+        EXPECT_NE(nullptr, watcher.onInputBufferReleased(i, 0)) << i;
+        watcher.onWorkDone(i);
+    }
+    EXPECT_EQ(0u, watcher.numWorksInPipeline());
+}
+
+TEST(PipelineWatcherTest, Elapsed) {
+    PipelineWatcher watcher;
+    PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+    watcher.onWorkQueued(7, MakeBuffers(), now - 30ms);
+    watcher.onWorkQueued(8, MakeBuffers(), now - 10ms);
+    watcher.onWorkQueued(9, {}, now - 20ms);
+    EXPECT_EQ(30ms, watcher.elapsed(now, 0));
+    EXPECT_EQ(20ms, watcher.elapsed(now, 1));
+    EXPECT_EQ(10ms, watcher.elapsed(now, 2));
+    EXPECT_EQ(PipelineWatcher::Clock::duration::zero(), watcher.elapsed(now, 3));
+}
+
+TEST(PipelineWatcherTest, Dump) {
+    PipelineWatcher watcher;
+    PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+    watcher.onWorkQueued(0, MakeBuffers(), now - 3s);
+    watcher.onWorkQueued(1, MakeBuffers(), now);
+    EXPECT_NE(nullptr, watcher.onInputBufferReleased(0, 0));
+    watcher.onWorkDone(0);
+    watcher.onWorkDone(1);
+
+    std::string dump;
+    watcher.dump(&dump);
+    EXPECT_NE(std::string::npos, dump.find("queued->input released: 2 <1ms:1 <inf:1\n")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("input released->done: 2 <1ms:2\n")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("queued->done: 2 <1ms:1 <inf:1\n")) << dump;
+}
+
+} // namespace android
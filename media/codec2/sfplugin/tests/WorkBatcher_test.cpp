@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WorkBatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <C2Config.h>
+
+namespace android {
+
+class WorkBatcherTest : public ::testing::Test {
+protected:
+    WorkBatcherTest() : mFrameIndex(0) {
+        mBatcher.maxBatchSize(4)
+                .maxLatency(std::chrono::milliseconds(20))
+                .minWorksInFlight(2);
+    }
+
+    std::list<std::unique_ptr<C2Work>> makeWork(uint32_t flags = 0) {
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.ordinal.frameIndex = mFrameIndex++;
+        work->input.flags = C2FrameData::flags_t(flags);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        return items;
+    }
+
+    static std::vector<uint64_t> frameIndices(const std::list<std::unique_ptr<C2Work>> &items) {
+        std::vector<uint64_t> indices;
+        for (const std::unique_ptr<C2Work> &work : items) {
+            indices.push_back(work->input.ordinal.frameIndex.peeku());
+        }
+        return indices;
+    }
+
+    WorkBatcher mBatcher;
+    uint64_t mFrameIndex;
+    WorkBatcher::Clock::time_point mNow;
+};
+
+TEST_F(WorkBatcherTest, NoBatchingWhileComponentStarves) {
+    for (size_t worksInFlight = 0; worksInFlight < 2; ++worksInFlight) {
+        std::list<std::unique_ptr<C2Work>> items = makeWork();
+        mBatcher.onWorkQueued(&items, worksInFlight, mNow);
+        EXPECT_EQ(1u, items.size());
+        EXPECT_EQ(0u, mBatcher.numHeldWorks());
+    }
+}
+
+TEST_F(WorkBatcherTest, BatchSize) {
+    for (size_t i = 0; i < 3; ++i) {
+        std::list<std::unique_ptr<C2Work>> items = makeWork();
+        mBatcher.onWorkQueued(&items, 2, mNow);
+        EXPECT_TRUE(items.empty());
+        EXPECT_EQ(i + 1, mBatcher.numHeldWorks());
+    }
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_EQ(std::vector<uint64_t>({0, 1, 2, 3}), frameIndices(items));
+    EXPECT_EQ(0u, mBatcher.numHeldWorks());
+}
+
+TEST_F(WorkBatcherTest, BatchSizeOneDisablesBatching) {
+    mBatcher.maxBatchSize(1);
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 10, mNow);
+    EXPECT_EQ(1u, items.size());
+}
+
+TEST_F(WorkBatcherTest, Latency) {
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_TRUE(items.empty());
+
+    // not released while the component is busy and the work is recent
+    mBatcher.onWorkDone(&items, 2, mNow + std::chrono::milliseconds(19));
+    EXPECT_TRUE(items.empty());
+
+    mBatcher.onWorkDone(&items, 2, mNow + std::chrono::milliseconds(20));
+    EXPECT_EQ(std::vector<uint64_t>({0}), frameIndices(items));
+
+    // the client queues after the latency bound
+    items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_TRUE(items.empty());
+    items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow + std::chrono::milliseconds(25));
+    EXPECT_EQ(std::vector<uint64_t>({1, 2}), frameIndices(items));
+}
+
+TEST_F(WorkBatcherTest, HeldWorksDeadline) {
+    EXPECT_EQ(WorkBatcher::Clock::time_point::max(), mBatcher.heldWorksDeadline());
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    // the deadline is that of the oldest held work
+    items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow + std::chrono::milliseconds(5));
+    EXPECT_EQ(mNow + std::chrono::milliseconds(20), mBatcher.heldWorksDeadline());
+
+    mBatcher.onWorkDone(&items, 2, mBatcher.heldWorksDeadline());
+    EXPECT_EQ(std::vector<uint64_t>({0, 1}), frameIndices(items));
+    EXPECT_EQ(WorkBatcher::Clock::time_point::max(), mBatcher.heldWorksDeadline());
+}
+
+TEST_F(WorkBatcherTest, ReleaseWhenComponentRunsOutOfWork) {
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 3, mNow);
+    items = makeWork();
+    mBatcher.onWorkQueued(&items, 3, mNow);
+    EXPECT_EQ(2u, mBatcher.numHeldWorks());
+
+    mBatcher.onWorkDone(&items, 2, mNow);
+    EXPECT_TRUE(items.empty());
+    mBatcher.onWorkDone(&items, 1, mNow);
+    EXPECT_EQ(std::vector<uint64_t>({0, 1}), frameIndices(items));
+    EXPECT_EQ(0u, mBatcher.numHeldWorks());
+}
+
+TEST_F(WorkBatcherTest, FlagsAreNotDelayed) {
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_TRUE(items.empty());
+
+    items = makeWork(C2FrameData::FLAG_END_OF_STREAM);
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_EQ(std::vector<uint64_t>({0, 1}), frameIndices(items));
+
+    items = makeWork();
+    items.front()->input.configUpdate.push_back(
+            C2Param::Copy(C2StreamBitrateInfo::input(0u, 1000)));
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_EQ(1u, items.size());
+}
+
+TEST_F(WorkBatcherTest, Flush) {
+    std::list<std::unique_ptr<C2Work>> items = makeWork();
+    mBatcher.onWorkQueued(&items, 2, mNow);
+    EXPECT_EQ(1u, mBatcher.numHeldWorks());
+    mBatcher.flush();
+    EXPECT_EQ(0u, mBatcher.numHeldWorks());
+    mBatcher.onWorkDone(&items, 0, mNow);
+    EXPECT_TRUE(items.empty());
+}
+
+} // namespace android
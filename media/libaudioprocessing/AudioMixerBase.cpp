@@ -652,6 +652,10 @@ void AudioMixerBase::process__validate()
             n |= NEEDS_MUTE;
         }
         t->needs = n;
+        t->mFusedMix = (n & (NEEDS_MUTE | NEEDS_RESAMPLE | NEEDS_AUX)) == 0
+                && t->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+                && t->mMixerChannelCount == FCC_2
+                && t->useStereoVolume();
 
         if (n & NEEDS_MUTE) {
             t->hook = &TrackBase::track__nop;
@@ -751,6 +755,7 @@ void AudioMixerBase::process__validate()
             if (!t->doesResample() && t->isVolumeMuted()) {
                 t->needs |= NEEDS_MUTE;
                 t->hook = &TrackBase::track__nop;
+                t->mFusedMix = false;
             } else {
                 allMuted = false;
             }
@@ -1115,8 +1120,34 @@ void AudioMixerBase::process__genericNoResampling()
         do {
             const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
             memset(outTemp, 0, sizeof(outTemp));
+            // Tracks eligible for the fused kernel are collected here and accumulated
+            // together, so outTemp is read and written once for all of them.
+            const float *fusedIn[kMaxFusedTracks];
+            float fusedVolume[kMaxFusedTracks][FCC_2];
+            TrackBase *fusedTracks[kMaxFusedTracks];
+            size_t fusedCount = 0;
+            const auto mixFused = [&]() {
+                volumeMultiTracksStereo<float, float, float>(reinterpret_cast<float *>(outTemp),
+                        frameCount, fusedIn, fusedVolume, fusedCount);
+                for (size_t i = 0; i < fusedCount; ++i) {
+                    TrackBase * const ft = fusedTracks[i];
+                    ft->mIn = fusedIn[i] + frameCount * FCC_2;
+                    ft->frameCount -= frameCount;
+                }
+                fusedCount = 0;
+            };
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->canMixFused(frameCount)) {
+                    fusedIn[fusedCount] = static_cast<const float *>(t->mIn);
+                    fusedVolume[fusedCount][0] = t->mVolume[0];
+                    fusedVolume[fusedCount][1] = t->mVolume[1];
+                    fusedTracks[fusedCount] = t.get();
+                    if (++fusedCount == kMaxFusedTracks) {
+                        mixFused();
+                    }
+                    continue;
+                }
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1151,6 +1182,9 @@ void AudioMixerBase::process__genericNoResampling()
                     }
                 }
             }
+            if (fusedCount > 0) {
+                mixFused();
+            }
 
             const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
             convertMixerFormat(out, t1->mMixerFormat, outTemp, t1->mMixerInFormat,
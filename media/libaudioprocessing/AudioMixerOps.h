@@ -21,6 +21,20 @@
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define MIXER_OPS_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define MIXER_OPS_USE_NEON (false)
+#endif
+
+#if !MIXER_OPS_USE_NEON && defined(__SSE__)
+#define MIXER_OPS_USE_SSE (true)
+#include <xmmintrin.h>
+#else
+#define MIXER_OPS_USE_SSE (false)
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -604,6 +618,76 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * volumeMultiTracksStereo mixes several stereo tracks into the output at once.
+ *
+ * This is the multi-track equivalent of calling volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>
+ * once per track without aux, but each output frame is loaded and stored only once
+ * while the contribution of every track is accumulated in registers.
+ *
+ *   TO: int32_t (Q4.27) or float
+ *   TI: int32_t (Q4.27) or int16_t (Q0.15) or float
+ *   TV: int32_t (U4.28) or int16_t (U4.12) or float
+ *   in: array of trackCount interleaved stereo input pointers, each frameCount long.
+ *   vol: array of trackCount left/right volume pairs.
+ *
+ * The <float, float, float> variant is vectorized with NEON or SSE where available;
+ * the accumulation order per sample is identical to the scalar version.
+ *
+ * This accumulates into the out pointer.
+ */
+template <typename TO, typename TI, typename TV>
+inline void volumeMultiTracksStereo(TO* out, size_t frameCount,
+        const TI* const* in, const TV (*vol)[FCC_2], size_t trackCount)
+{
+    size_t i = 0;
+    if constexpr (std::is_same_v<TO, float> && std::is_same_v<TI, float>
+            && std::is_same_v<TV, float>) {
+#if MIXER_OPS_USE_NEON
+        // 4 stereo frames (2 vectors) per iteration.
+        for (; i + 4 <= frameCount; i += 4) {
+            float* const o = out + i * FCC_2;
+            float32x4_t acc0 = vld1q_f32(o);
+            float32x4_t acc1 = vld1q_f32(o + 4);
+            for (size_t t = 0; t < trackCount; ++t) {
+                const float32x2_t lr = vld1_f32(vol[t]);
+                const float32x4_t v = vcombine_f32(lr, lr);
+                const float* const p = in[t] + i * FCC_2;
+                acc0 = vmlaq_f32(acc0, vld1q_f32(p), v);
+                acc1 = vmlaq_f32(acc1, vld1q_f32(p + 4), v);
+            }
+            vst1q_f32(o, acc0);
+            vst1q_f32(o + 4, acc1);
+        }
+#elif MIXER_OPS_USE_SSE
+        // 4 stereo frames (2 vectors) per iteration.
+        for (; i + 4 <= frameCount; i += 4) {
+            float* const o = out + i * FCC_2;
+            __m128 acc0 = _mm_loadu_ps(o);
+            __m128 acc1 = _mm_loadu_ps(o + 4);
+            for (size_t t = 0; t < trackCount; ++t) {
+                const __m128 v = _mm_setr_ps(vol[t][0], vol[t][1], vol[t][0], vol[t][1]);
+                const float* const p = in[t] + i * FCC_2;
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(p), v));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(p + 4), v));
+            }
+            _mm_storeu_ps(o, acc0);
+            _mm_storeu_ps(o + 4, acc1);
+        }
+#endif
+    }
+    for (; i < frameCount; ++i) {
+        TO left = out[i * FCC_2];
+        TO right = out[i * FCC_2 + 1];
+        for (size_t t = 0; t < trackCount; ++t) {
+            left += MixMul<TO, TI, TV>(in[t][i * FCC_2], vol[t][0]);
+            right += MixMul<TO, TI, TV>(in[t][i * FCC_2 + 1], vol[t][1]);
+        }
+        out[i * FCC_2] = left;
+        out[i * FCC_2 + 1] = right;
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
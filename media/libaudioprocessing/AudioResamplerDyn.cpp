@@ -23,6 +23,11 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -181,8 +186,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +211,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -255,24 +258,52 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     createKaiserFir(c, stopBandAtten, fcr);
 }
 
+// The coefficient type of a filter bank, as part of its cache key.
+template<typename TC>
+static constexpr audio_format_t firCoefsFormat() {
+    if constexpr (std::is_same_v<TC, float>) {
+        return AUDIO_FORMAT_PCM_FLOAT;
+    } else if constexpr (std::is_same_v<TC, int32_t>) {
+        return AUDIO_FORMAT_PCM_32_BIT;
+    } else {
+        static_assert(std::is_same_v<TC, int16_t>, "unsupported coefficient type");
+        return AUDIO_FORMAT_PCM_16_BIT;
+    }
+}
+
+// Process-wide cache of filter banks for all AudioResamplerDyn instantiations.
+// A design is fully determined by the coefficient type and the parameters below,
+// which are derived from the input and output sample rates and the quality.
+// Entries are weak so the filter bank is freed with its last resampler.
+using FirCoefsKey = std::tuple<audio_format_t /* coefficient type */, int /* L */,
+        int /* halfNumCoefs */, double /* stopBandAtten */, double /* fcr */>;
+static std::mutex gFirCoefsLock;
+static std::map<FirCoefsKey, std::weak_ptr<const void>> gFirCoefsCache; // by gFirCoefsLock
+
 template<typename TC, typename TI, typename TO>
-void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
-        double stopBandAtten, double fcr) {
-    // compute the normalized transition bandwidth
-    const double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
-    const int phases = c.mL;
-    const int halfLength = c.mHalfNumCoefs;
+std::shared_ptr<const typename AudioResamplerDyn<TC, TI, TO>::FirCoefs>
+AudioResamplerDyn<TC, TI, TO>::getFirCoefs(
+        int L, int halfNumCoefs, double stopBandAtten, double fcr)
+{
+    const FirCoefsKey key{firCoefsFormat<TC>(), L, halfNumCoefs, stopBandAtten, fcr};
+    std::lock_guard<std::mutex> guard(gFirCoefsLock);
+    auto it = gFirCoefsCache.find(key);
+    if (it != gFirCoefsCache.end()) {
+        // The entry was created for this key, so it holds a FirCoefs of type TC.
+        std::shared_ptr<const FirCoefs> coefs =
+                std::static_pointer_cast<const FirCoefs>(it->second.lock());
+        if (coefs) {
+            ALOGV("%s: reusing filter L:%d halfNumCoefs:%d", __func__, L, halfNumCoefs);
+            return coefs;
+        }
+    }
 
-    // create buffer
-    TC *coefs = nullptr;
+    auto coefs = std::make_shared<FirCoefs>();
     int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
+            reinterpret_cast<void **>(&coefs->mCoefs),
             CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
+            (L + 1) * halfNumCoefs * sizeof(TC));
     LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
 
     // square the computed minimum passband value (extra safety).
     double attenuation =
@@ -280,17 +311,43 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     attenuation *= attenuation;
 
     // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    firKaiserGen(coefs->mCoefs, L, halfNumCoefs, stopBandAtten, fcr, attenuation);
+
+    coefs->mNormalizedTransitionBandwidth = firKaiserTbw(halfNumCoefs, stopBandAtten);
+    coefs->mFilterAttenuation = attenuation;
+    coefs->mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+
+    // prune entries whose filter banks have been released.
+    for (auto expired = gFirCoefsCache.begin(); expired != gFirCoefsCache.end(); ) {
+        if (expired->second.expired()) {
+            expired = gFirCoefsCache.erase(expired);
+        } else {
+            ++expired;
+        }
+    }
+    gFirCoefsCache[key] = coefs;
+    return coefs;
+}
+
+template<typename TC, typename TI, typename TO>
+void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
+        double stopBandAtten, double fcr) {
+    mFirCoefs = getFirCoefs(c.mL, c.mHalfNumCoefs, stopBandAtten, fcr);
+    c.mFirCoefs = mFirCoefs->mCoefs;
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
-    mNormalizedTransitionBandwidth = tbw;
-    mFilterAttenuation = attenuation;
+    mNormalizedTransitionBandwidth = mFirCoefs->mNormalizedTransitionBandwidth;
+    mFilterAttenuation = mFirCoefs->mFilterAttenuation;
     mStopbandAttenuationDb = stopBandAtten;
-    mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+    mPassbandRippleDb = mFirCoefs->mPassbandRippleDb;
 
 #if 0
     // Keep this debug code in case an app causes resampler design issues.
+    const TC* const coefs = c.mFirCoefs;
+    const int phases = c.mL;
+    const double tbw = mNormalizedTransitionBandwidth;
+    const double attenuation = mFilterAttenuation;
     const double halfbw = tbw * 0.5;
     // print basic filter stats
     ALOGD("L:%d  hnc:%d  stopBandAtten:%lf  fcr:%lf  atten:%lf  tbw:%lf\n",
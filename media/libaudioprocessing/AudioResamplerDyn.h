@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_DYN_H
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
@@ -147,6 +148,27 @@ private:
         size_t mStateCount; // size of state in units of TI.
     };
 
+    // An immutable polyphase filter bank with its design criteria.
+    // Filter banks are shared by all resamplers using the same design,
+    // keyed on the coefficient type TC and the filter parameters, see getFirCoefs().
+    struct FirCoefs {
+        FirCoefs() = default;
+        FirCoefs(const FirCoefs&) = delete;
+        FirCoefs& operator=(const FirCoefs&) = delete;
+        ~FirCoefs() { free(mCoefs); }
+
+        TC* mCoefs = nullptr;        // (L + 1) * halfNumCoefs, cache line aligned
+        double mNormalizedTransitionBandwidth = 0.;
+        double mFilterAttenuation = 0.;
+        double mPassbandRippleDb = 0.;
+    };
+
+    // Returns the filter bank for the given design from the process-wide,
+    // reference counted coefficient cache shared by all instantiations,
+    // designing it only if no other resampler currently holds an identical one.
+    static std::shared_ptr<const FirCoefs> getFirCoefs(
+            int L, int halfNumCoefs, double stopBandAtten, double fcr);
+
     void createKaiserFir(Constants &c, double stopBandAtten,
             int inSampleRate, int outSampleRate, double tbwCheat);
 
@@ -166,7 +188,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const FirCoefs> mFirCoefs; // if a filter is created, this is not null
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
@@ -148,6 +148,10 @@ public:
     // If kUseNewMixer is false, this is ignored or may be overridden internally
     static constexpr bool kUseFloat = true;
 
+    // Maximum number of tracks accumulated per call to the fused multi-track kernel.
+    // Larger groups are processed in several passes.
+    static constexpr size_t kMaxFusedTracks = 32;
+
 #ifdef FLOAT_AUX
     using TYPE_AUX = float;
     static_assert(kUseNewMixer && kUseFloat,
@@ -233,6 +237,12 @@ public:
         bool        useStereoVolume() const { return channelMask == AUDIO_CHANNEL_OUT_STEREO
                                         && isAudioChannelPositionMask(mMixerChannelMask); }
 
+        // True if the next frames of this track may be accumulated by the fused
+        // multi-track kernel (see process__genericNoResampling).
+        bool        canMixFused(size_t frames) const {
+                        return mFusedMix && mIn != nullptr && frameCount >= frames
+                                && (volumeInc[0] | volumeInc[1]) == 0; }
+
         static hook_t getTrackHook(int trackType, uint32_t channelCount,
                 audio_format_t mixerInFormat, audio_format_t mixerOutFormat);
 
@@ -299,6 +309,10 @@ public:
 
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
+        // Float stereo track without resampling, aux or mute, eligible for the
+        // fused multi-track mixing kernel. Set by process__validate().
+        bool           mFusedMix = false;
+
         // consider volume muted only if all channel volume (floating point) is 0.f
         inline bool isVolumeMuted() const {
             for (const auto volume : mVolume) {
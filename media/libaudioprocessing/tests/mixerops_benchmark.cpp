@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include <array>
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 #define LOG_ALWAYS_FATAL(...)
 
 #include <../AudioMixerOps.h>
@@ -101,4 +103,61 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// Mixes state.range(0) stereo tracks, one track at a time (the original per-track path).
+static void BM_VolumeMultiPerTrack(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+    const size_t trackCount = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<float> in(SAMPLE_COUNT * trackCount, 0.5f);
+    std::vector<float> vol(FCC_2 * trackCount, 0.25f);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(in.data());
+        for (size_t t = 0; t < trackCount; ++t) {
+            volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>(out.data(), FRAME_COUNT,
+                    &in[t * SAMPLE_COUNT], (float *)nullptr, &vol[t * FCC_2], 0.f);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.counters["ns/frame"] = benchmark::Counter(state.iterations() * FRAME_COUNT,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// Mixes state.range(0) stereo tracks with the fused multi-track kernel.
+static void BM_VolumeMultiTracksStereo(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+    const size_t trackCount = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<float> in(SAMPLE_COUNT * trackCount, 0.5f);
+    std::vector<const float *> inp(trackCount);
+    std::vector<std::array<float, FCC_2>> vol(trackCount, {0.25f, 0.25f});
+    for (size_t t = 0; t < trackCount; ++t) {
+        inp[t] = &in[t * SAMPLE_COUNT];
+    }
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(in.data());
+        volumeMultiTracksStereo<float, float, float>(out.data(), FRAME_COUNT, inp.data(),
+                reinterpret_cast<const float (*)[FCC_2]>(vol.data()), trackCount);
+        benchmark::ClobberMemory();
+    }
+    state.counters["ns/frame"] = benchmark::Counter(state.iterations() * FRAME_COUNT,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+static void TrackCountArgs(benchmark::internal::Benchmark* b) {
+    for (int trackCount : {1, 2, 4, 8, 16, 24, 32}) {
+        b->Arg(trackCount);
+    }
+}
+
+BENCHMARK(BM_VolumeMultiPerTrack)->Apply(TrackCountArgs);
+BENCHMARK(BM_VolumeMultiTracksStereo)->Apply(TrackCountArgs);
+
 BENCHMARK_MAIN();
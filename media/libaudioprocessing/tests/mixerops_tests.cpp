@@ -173,3 +173,34 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+TEST(mixerops, multitrack_stereo) {
+    // The fused multi-track kernel must match mixing the tracks one at a time.
+    constexpr size_t FRAME_COUNT = 37; // not a multiple of the vector width.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+    constexpr size_t TRACK_COUNT = 20;
+
+    float in[TRACK_COUNT][SAMPLE_COUNT];
+    const float *inp[TRACK_COUNT];
+    float vol[TRACK_COUNT][FCC_2];
+    for (size_t t = 0; t < TRACK_COUNT; ++t) {
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            in[t][i] = (float)((t * SAMPLE_COUNT + i) % 17) / 17.f - 0.5f;
+        }
+        inp[t] = in[t];
+        vol[t][0] = 1.f / (t + 1);
+        vol[t][1] = 0.5f / (t + 1);
+    }
+
+    for (size_t trackCount = 1; trackCount <= TRACK_COUNT; ++trackCount) {
+        float expected[SAMPLE_COUNT]{};
+        float actual[SAMPLE_COUNT]{};
+        for (size_t t = 0; t < trackCount; ++t) {
+            volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>(
+                    expected, FRAME_COUNT, in[t], (float *)nullptr, vol[t], 0.f);
+        }
+        volumeMultiTracksStereo<float, float, float>(actual, FRAME_COUNT, inp, vol, trackCount);
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            EXPECT_FLOAT_EQ(expected[i], actual[i]) << "trackCount:" << trackCount << " i:" << i;
+        }
+    }
+}
@@ -601,3 +601,45 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same design share one immutable filter bank.
+TEST(audioflinger_resampler, sharedcoefficients) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto createResampler = [](size_t channels, int inSampleRate, int outSampleRate,
+            android::AudioResampler::src_quality quality) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT, channels, outSampleRate, quality)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+
+    auto r1 = createResampler(2, 44100, 48000, android::AudioResampler::DYN_HIGH_QUALITY);
+    auto r2 = createResampler(2, 44100, 48000, android::AudioResampler::DYN_HIGH_QUALITY);
+    auto r3 = createResampler(8, 44100, 48000, android::AudioResampler::DYN_HIGH_QUALITY);
+    auto r4 = createResampler(2, 32000, 48000, android::AudioResampler::DYN_HIGH_QUALITY);
+
+    // channel count does not affect the design.
+    EXPECT_EQ(r1->getFilterCoefs(), r2->getFilterCoefs());
+    EXPECT_EQ(r1->getFilterCoefs(), r3->getFilterCoefs());
+    EXPECT_NE(r1->getFilterCoefs(), r4->getFilterCoefs());
+
+    // the filter bank remains valid after the resampler that created it is gone.
+    const float *coefs = r2->getFilterCoefs();
+    std::vector<float> saved(coefs, coefs + (r2->getPhases() + 1) * r2->getHalfLength());
+    r1.reset();
+    EXPECT_EQ(0, memcmp(saved.data(), r2->getFilterCoefs(), saved.size() * sizeof(float)));
+
+    // the same design with another coefficient type has its own filter bank.
+    using Resampler32Type = android::AudioResamplerDyn<int32_t, int16_t, int32_t>;
+    std::unique_ptr<Resampler32Type> r5(
+            static_cast<Resampler32Type *>(
+                    android::AudioResampler::create(AUDIO_FORMAT_PCM_16_BIT, 2, 48000,
+                            android::AudioResampler::DYN_HIGH_QUALITY)));
+    r5->setSampleRate(44100);
+    EXPECT_EQ(r2->getPhases(), r5->getPhases());
+    EXPECT_EQ(r2->getHalfLength(), r5->getHalfLength());
+    EXPECT_NE(static_cast<const void *>(r2->getFilterCoefs()),
+            static_cast<const void *>(r5->getFilterCoefs()));
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ReadAheadSource"
+#include <utils/Log.h>
+
+#include <datasource/ReadAheadSource.h>
+#include <media/stagefright/MediaErrors.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace android {
+
+ReadAheadSource::ReadAheadSource(
+        const sp<DataSource> &source,
+        size_t blockSize,
+        size_t maxReadAheadBlocks,
+        size_t maxCachedBlocks)
+    : mSource(source),
+      mBlockSize(std::max(blockSize, (size_t)1)),
+      mMaxReadAheadBlocks(maxReadAheadBlocks),
+      // a miss reads at most 2 * mMaxReadAheadBlocks + 1 blocks, which must all fit
+      mMaxCachedBlocks(std::max(maxCachedBlocks, 2 * maxReadAheadBlocks + 2)),
+      mUseCount(0),
+      mEndOffset(-1),
+      mStats() {
+    mName = String8::format("ReadAheadSource(%s)", mSource->toString().c_str());
+    off64_t size;
+    if (mSource->getSize(&size) == OK && size >= 0) {
+        mEndOffset = size;
+    }
+    mStreams.reserve(kMaxStreams);
+}
+
+ReadAheadSource::~ReadAheadSource() {
+    ALOGV("%s: %llu hits, %llu misses, %llu bypassed, %llu bytes served, "
+            "%llu bytes read in %llu reads",
+            mName.c_str(),
+            (unsigned long long)mStats.mHits,
+            (unsigned long long)mStats.mMisses,
+            (unsigned long long)mStats.mBypassed,
+            (unsigned long long)mStats.mBytesServed,
+            (unsigned long long)mStats.mBytesRead,
+            (unsigned long long)mStats.mSourceReads);
+}
+
+status_t ReadAheadSource::initCheck() const {
+    return mSource->initCheck();
+}
+
+ssize_t ReadAheadSource::readAt(off64_t offset, void *data, size_t size) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (offset < 0 || size == 0 || size > (uint64_t)(INT64_MAX - offset)) {
+        return mSource->readAt(offset, data, size);
+    }
+
+    Stream *stream = updateStream_l(offset, size);
+
+    if (size >= mBlockSize * mMaxReadAheadBlocks) {
+        ++mStats.mBypassed;
+        ++mStats.mSourceReads;
+        const ssize_t n = mSource->readAt(offset, data, size);
+        if (n > 0) {
+            mStats.mBytesRead += n;
+            mStats.mBytesServed += n;
+        }
+        return n;
+    }
+
+    bool missed = false;
+    size_t copied = 0;
+    while (copied < size) {
+        const off64_t position = offset + copied;
+        if (mEndOffset >= 0 && position >= mEndOffset) {
+            // The end seen so far is not final, as a file may still be written
+            // or downloaded.
+            missed = true;
+            const ssize_t n = readThrough_l(position, (uint8_t *)data + copied, size - copied);
+            if (n < 0 && copied == 0) {
+                return n;
+            }
+            copied += std::max(n, (ssize_t)0);
+            break;
+        }
+        const int64_t blockNumber = position / mBlockSize;
+        auto it = mBlocks.find(blockNumber);
+        if (it == mBlocks.end()) {
+            missed = true;
+            // the blocks for the rest of this read, and the read-ahead of its stream
+            const size_t needed = (position + (size - copied) - 1) / mBlockSize - blockNumber + 1;
+            const size_t readAhead = stream->mReadAheadBlocks;
+            if (readAhead > 0) {
+                stream->mReadAheadBlocks = std::min(readAhead * 2, mMaxReadAheadBlocks);
+            }
+            const ssize_t n = fill_l(blockNumber, needed + readAhead);
+            if (n <= 0) {
+                if (copied == 0) {
+                    return n;
+                }
+                break;
+            }
+            it = mBlocks.find(blockNumber);
+            if (it == mBlocks.end()) {
+                break;
+            }
+        }
+
+        Block &block = it->second;
+        block.mLastUse = ++mUseCount;
+        const size_t inBlock = position - blockNumber * mBlockSize;
+        if (inBlock >= block.mSize) {
+            // past the data of a block cut short by a short read of the source
+            missed = true;
+            const ssize_t n = readThrough_l(position, (uint8_t *)data + copied, size - copied);
+            if (n < 0 && copied == 0) {
+                return n;
+            }
+            copied += std::max(n, (ssize_t)0);
+            break;
+        }
+        const size_t n = std::min(size - copied, block.mSize - inBlock);
+        memcpy((uint8_t *)data + copied, block.mData.get() + inBlock, n);
+        copied += n;
+    }
+
+    if (missed) {
+        ++mStats.mMisses;
+    } else {
+        ++mStats.mHits;
+    }
+    mStats.mBytesServed += copied;
+    return copied;
+}
+
+ReadAheadSource::Stream *ReadAheadSource::updateStream_l(off64_t offset, size_t size) {
+    // A read continues a stream if it starts within a block of where the last
+    // read of the stream ended, skipping the samples of interleaved tracks.
+    Stream *stream = nullptr;
+    for (Stream &candidate : mStreams) {
+        const off64_t distance = offset >= candidate.mNextOffset
+                ? offset - candidate.mNextOffset : candidate.mNextOffset - offset;
+        if (distance <= (off64_t)mBlockSize) {
+            stream = &candidate;
+            break;
+        }
+    }
+
+    if (stream != nullptr) {
+        if (stream->mReadAheadBlocks == 0) {
+            stream->mReadAheadBlocks = std::min((size_t)1, mMaxReadAheadBlocks);
+        }
+    } else {
+        if (mStreams.size() < kMaxStreams) {
+            mStreams.emplace_back();
+            stream = &mStreams.back();
+        } else {
+            stream = &*std::min_element(mStreams.begin(), mStreams.end(),
+                    [](const Stream &a, const Stream &b) {
+                        return a.mLastUse < b.mLastUse;
+                    });
+        }
+        stream->mReadAheadBlocks = 0;
+    }
+    stream->mNextOffset = offset + size;
+    stream->mLastUse = ++mUseCount;
+    return stream;
+}
+
+ssize_t ReadAheadSource::fill_l(int64_t blockNumber, size_t numBlocks) {
+    // Read up to the next cached block only.
+    auto next = mBlocks.lower_bound(blockNumber);
+    if (next != mBlocks.end()) {
+        numBlocks = std::min(numBlocks, (size_t)(next->first - blockNumber));
+    }
+    const off64_t start = blockNumber * mBlockSize;
+    size_t length = numBlocks * mBlockSize;
+    if (mEndOffset >= 0) {
+        if (start >= mEndOffset) {
+            return 0;
+        }
+        length = std::min(length, (size_t)(mEndOffset - start));
+    }
+
+    if (mReadBuffer.size() < length) {
+        mReadBuffer.resize(length);
+    }
+    ++mStats.mSourceReads;
+    const ssize_t n = mSource->readAt(start, mReadBuffer.data(), length);
+    if (n <= 0) {
+        if (n == 0 && mEndOffset < 0) {
+            mEndOffset = start;
+        }
+        return n;
+    }
+    if ((size_t)n > length) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    mStats.mBytesRead += n;
+    if ((size_t)n < length && mEndOffset < 0) {
+        mEndOffset = start + n;
+    }
+
+    for (size_t pos = 0; pos < (size_t)n; pos += mBlockSize) {
+        while (mBlocks.size() >= mMaxCachedBlocks) {
+            evictBlock_l();
+        }
+        Block &block = mBlocks[blockNumber + pos / mBlockSize];
+        block.mLastUse = ++mUseCount;
+        block.mSize = std::min(mBlockSize, n - pos);
+        if (!mFreeData.empty()) {
+            block.mData = std::move(mFreeData.back());
+            mFreeData.pop_back();
+        } else {
+            block.mData.reset(new uint8_t[mBlockSize]);
+        }
+        memcpy(block.mData.get(), mReadBuffer.data() + pos, block.mSize);
+    }
+    return n;
+}
+
+ssize_t ReadAheadSource::readThrough_l(off64_t offset, void *data, size_t size) {
+    ++mStats.mSourceReads;
+    const ssize_t n = mSource->readAt(offset, data, size);
+    if (n <= 0) {
+        return n;
+    }
+    mStats.mBytesRead += n;
+    if (mEndOffset >= 0 && offset + n > mEndOffset) {
+        // The source grew. Forget its end, and the block cut short there, so
+        // that the new data is cached again.
+        auto it = mBlocks.find(mEndOffset / mBlockSize);
+        if (it != mBlocks.end() && it->second.mSize < mBlockSize) {
+            mFreeData.push_back(std::move(it->second.mData));
+            mBlocks.erase(it);
+        }
+        mEndOffset = -1;
+    }
+    return n;
+}
+
+void ReadAheadSource::evictBlock_l() {
+    auto oldest = mBlocks.begin();
+    for (auto it = mBlocks.begin(); it != mBlocks.end(); ++it) {
+        if (it->second.mLastUse < oldest->second.mLastUse) {
+            oldest = it;
+        }
+    }
+    if (oldest != mBlocks.end()) {
+        mFreeData.push_back(std::move(oldest->second.mData));
+        mBlocks.erase(oldest);
+    }
+}
+
+void ReadAheadSource::flush_l() {
+    for (auto &entry : mBlocks) {
+        mFreeData.push_back(std::move(entry.second.mData));
+    }
+    mBlocks.clear();
+    mStreams.clear();
+}
+
+status_t ReadAheadSource::getSize(off64_t *size) {
+    Mutex::Autolock autoLock(mLock);
+    return mSource->getSize(size);
+}
+
+uint32_t ReadAheadSource::flags() {
+    return mSource->flags();
+}
+
+void ReadAheadSource::close() {
+    Mutex::Autolock autoLock(mLock);
+    flush_l();
+    mSource->close();
+}
+
+status_t ReadAheadSource::reconnectAtOffset(off64_t offset) {
+    Mutex::Autolock autoLock(mLock);
+    flush_l();
+    return mSource->reconnectAtOffset(offset);
+}
+
+sp<IDataSource> ReadAheadSource::getIDataSource() const {
+    return mSource->getIDataSource();
+}
+
+String8 ReadAheadSource::getUri() {
+    return mSource->getUri();
+}
+
+String8 ReadAheadSource::getMIMEType() const {
+    return mSource->getMIMEType();
+}
+
+String8 ReadAheadSource::toString() {
+    return mName;
+}
+
+void ReadAheadSource::getStats(Stats *stats) const {
+    Mutex::Autolock autoLock(mLock);
+    *stats = mStats;
+}
+
+}  // namespace android
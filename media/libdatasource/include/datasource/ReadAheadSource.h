@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef READ_AHEAD_SOURCE_H_
+
+#define READ_AHEAD_SOURCE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <media/DataSource.h>
+#include <utils/String8.h>
+#include <utils/threads.h>
+
+namespace android {
+
+// A DataSource that serves the many small, scattered reads of extractors from
+// a cache of aligned blocks of the wrapped source.
+//
+// Misses are filled with a single read of the missing blocks. Reads are
+// grouped into streams, so that the interleaved reads of each track of a file
+// are recognized as sequential; a sequential stream reads ahead, doubling the
+// number of blocks read on each miss up to maxReadAheadBlocks. Reads at least
+// as large as the read-ahead limit bypass the cache, and so do reads at or
+// past the end of the source seen so far, so that a source still growing is
+// read to its current end.
+class ReadAheadSource : public DataSource {
+public:
+    struct Stats {
+        uint64_t mHits;         // reads served from the cache only
+        uint64_t mMisses;       // reads that needed reads of the wrapped source
+        uint64_t mBypassed;     // reads passed through to the wrapped source
+        uint64_t mBytesServed;  // bytes returned by this source
+        uint64_t mBytesRead;    // bytes read from the wrapped source
+        uint64_t mSourceReads;  // reads of the wrapped source
+    };
+
+    static const size_t kDefaultBlockSize = 32 * 1024;
+    static const size_t kDefaultMaxReadAheadBlocks = 8;
+    static const size_t kDefaultMaxCachedBlocks = 48;
+
+    explicit ReadAheadSource(
+            const sp<DataSource> &source,
+            size_t blockSize = kDefaultBlockSize,
+            size_t maxReadAheadBlocks = kDefaultMaxReadAheadBlocks,
+            size_t maxCachedBlocks = kDefaultMaxCachedBlocks);
+
+    virtual status_t initCheck() const;
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size);
+    virtual status_t getSize(off64_t *size);
+    virtual uint32_t flags();
+    virtual void close();
+    virtual status_t reconnectAtOffset(off64_t offset);
+    virtual sp<IDataSource> getIDataSource() const;
+    virtual String8 getUri();
+    virtual String8 getMIMEType() const;
+    virtual String8 toString();
+
+    void getStats(Stats *stats) const;
+
+protected:
+    virtual ~ReadAheadSource();
+
+private:
+    struct Block {
+        uint64_t mLastUse;
+        size_t mSize;   // less than mBlockSize only for the last block of the source
+        std::unique_ptr<uint8_t[]> mData;
+    };
+
+    struct Stream {
+        uint64_t mLastUse;
+        off64_t mNextOffset;
+        size_t mReadAheadBlocks;
+    };
+
+    enum {
+        kMaxStreams = 8,
+    };
+
+    sp<DataSource> mSource;
+    const size_t mBlockSize;
+    const size_t mMaxReadAheadBlocks;
+    const size_t mMaxCachedBlocks;
+    String8 mName;
+
+    mutable Mutex mLock;
+    uint64_t mUseCount;
+    off64_t mEndOffset;     // end of the source seen so far, or -1 while unknown
+    std::map<int64_t, Block> mBlocks;   // by block number
+    std::vector<Stream> mStreams;
+    std::vector<uint8_t> mReadBuffer;
+    std::vector<std::unique_ptr<uint8_t[]>> mFreeData;  // of evicted blocks
+    Stats mStats;
+
+    Stream *updateStream_l(off64_t offset, size_t size);
+    ssize_t fill_l(int64_t blockNumber, size_t numBlocks);
+    ssize_t readThrough_l(off64_t offset, void *data, size_t size);
+    void evictBlock_l();
+    void flush_l();
+
+    ReadAheadSource(const ReadAheadSource &);
+    ReadAheadSource &operator=(const ReadAheadSource &);
+};
+
+}  // namespace android
+
+#endif  // READ_AHEAD_SOURCE_H_
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "ReadAheadSource_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <datasource/ReadAheadSource.h>
+#include <media/stagefright/MediaErrors.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace android {
+
+static const size_t kBlockSize = 4096;
+static const size_t kMaxReadAheadBlocks = 8;
+
+// A DataSource reading from memory, which counts its reads.
+class MemorySource : public DataSource {
+public:
+    explicit MemorySource(size_t size, bool knownSize = true)
+        : mKnownSize(knownSize),
+          mError(OK),
+          mNumReads(0) {
+        mData.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            mData[i] = i * 13 + (i >> 10);
+        }
+    }
+
+    virtual status_t initCheck() const {
+        return OK;
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        ++mNumReads;
+        if (mError != OK) {
+            return mError;
+        }
+        if (offset < 0) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        if ((size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    virtual status_t getSize(off64_t *size) {
+        if (!mKnownSize) {
+            return ERROR_UNSUPPORTED;
+        }
+        *size = mData.size();
+        return OK;
+    }
+
+    std::vector<uint8_t> mData;
+    bool mKnownSize;
+    status_t mError;
+    size_t mNumReads;
+};
+
+class ReadAheadSourceTest : public ::testing::Test {
+protected:
+    void init(size_t size, bool knownSize = true) {
+        mSource = new MemorySource(size, knownSize);
+        mReadAhead = new ReadAheadSource(mSource, kBlockSize, kMaxReadAheadBlocks, 32);
+    }
+
+    // Reads through the cache and checks the result against the source.
+    void checkRead(off64_t offset, size_t size) {
+        std::vector<uint8_t> expected(size);
+        std::vector<uint8_t> actual(size);
+        const size_t numReads = mSource->mNumReads;
+        const ssize_t expectedSize = mSource->readAt(offset, expected.data(), size);
+        mSource->mNumReads = numReads;
+        ASSERT_EQ(mReadAhead->readAt(offset, actual.data(), size), expectedSize)
+                << "offset " << offset << " size " << size;
+        if (expectedSize > 0) {
+            ASSERT_EQ(memcmp(actual.data(), expected.data(), expectedSize), 0)
+                    << "offset " << offset << " size " << size;
+        }
+    }
+
+    ReadAheadSource::Stats stats() const {
+        ReadAheadSource::Stats stats;
+        mReadAhead->getStats(&stats);
+        return stats;
+    }
+
+    sp<MemorySource> mSource;
+    sp<ReadAheadSource> mReadAhead;
+};
+
+TEST_F(ReadAheadSourceTest, RandomReadsMatchSource) {
+    init(1000 * 1000);
+    uint32_t seed = 1;
+    for (int i = 0; i < 5000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const off64_t offset = (seed >> 4) % (mSource->mData.size() + kBlockSize);
+        seed = seed * 1103515245 + 12345;
+        const size_t size = 1 + (seed >> 4) % (kBlockSize * kMaxReadAheadBlocks + kBlockSize);
+        checkRead(offset, size);
+    }
+    EXPECT_EQ(stats().mSourceReads, mSource->mNumReads);
+}
+
+TEST_F(ReadAheadSourceTest, SequentialReadsAreCoalesced) {
+    init(1024 * 1024);
+    for (off64_t offset = 0; offset < (off64_t)mSource->mData.size(); offset += 188) {
+        checkRead(offset, 188);
+    }
+    const ReadAheadSource::Stats s = stats();
+    // Read-ahead grows to kMaxReadAheadBlocks blocks per read of the source.
+    EXPECT_LT(s.mSourceReads, mSource->mData.size() / (kBlockSize * kMaxReadAheadBlocks) + 8);
+    EXPECT_EQ(s.mBytesRead, mSource->mData.size());
+    EXPECT_EQ(s.mBytesServed, mSource->mData.size());
+    EXPECT_EQ(s.mHits + s.mMisses, (mSource->mData.size() + 187) / 188);
+    EXPECT_EQ(s.mMisses, s.mSourceReads);
+}
+
+TEST_F(ReadAheadSourceTest, InterleavedStreamsReadAhead) {
+    init(2 * 1024 * 1024);
+    // Two tracks stored in separate halves of the file, read in turns, each
+    // skipping a little of its half between samples.
+    const off64_t half = mSource->mData.size() / 2;
+    for (off64_t offset = 0; offset + 300 < half; offset += 400) {
+        checkRead(offset, 300);
+        checkRead(half + offset, 300);
+    }
+    const ReadAheadSource::Stats s = stats();
+    EXPECT_LT(s.mSourceReads, mSource->mData.size() / (kBlockSize * kMaxReadAheadBlocks) + 16);
+    // The read-ahead of the first track may run into the start of the second.
+    EXPECT_LE(s.mBytesRead, mSource->mData.size() + kBlockSize * kMaxReadAheadBlocks);
+}
+
+TEST_F(ReadAheadSourceTest, LargeReadsBypassCache) {
+    init(1024 * 1024);
+    checkRead(1000, kBlockSize * kMaxReadAheadBlocks);
+    const ReadAheadSource::Stats s = stats();
+    EXPECT_EQ(s.mBypassed, 1u);
+    EXPECT_EQ(s.mSourceReads, 1u);
+    EXPECT_EQ(s.mBytesRead, kBlockSize * kMaxReadAheadBlocks);
+}
+
+TEST_F(ReadAheadSourceTest, RepeatedReadsHit) {
+    init(100 * 1000);
+    checkRead(5000, 100);
+    for (int i = 0; i < 10; ++i) {
+        checkRead(5000, 100);
+        checkRead(4500, 600);
+    }
+    const ReadAheadSource::Stats s = stats();
+    EXPECT_EQ(s.mMisses, 1u);
+    EXPECT_EQ(s.mHits, 20u);
+    EXPECT_EQ(s.mSourceReads, 1u);
+}
+
+TEST_F(ReadAheadSourceTest, UnknownSize) {
+    init(10000, false /* knownSize */);
+    checkRead(9000, 2000);
+    checkRead(9999, 1);
+    checkRead(10000, 1);
+    checkRead(20000, 1);
+    checkRead(0, 10000);
+    checkRead(8000, 4000);
+}
+
+TEST_F(ReadAheadSourceTest, GrowingSource) {
+    for (bool knownSize : {true, false}) {
+        // The last block is cached short, and the end of the source is seen.
+        init(10000, knownSize);
+        checkRead(9000, 2000);
+        checkRead(10000, 100);
+
+        // The source is still being written.
+        const size_t oldSize = mSource->mData.size();
+        mSource->mData.resize(30000);
+        for (size_t i = oldSize; i < mSource->mData.size(); ++i) {
+            mSource->mData[i] = i * 7;
+        }
+        checkRead(10000, 100);
+        checkRead(9900, 200);
+        checkRead(8000, 8000);
+        checkRead(29000, 2000);
+        checkRead(30000, 1);
+        EXPECT_EQ(stats().mSourceReads, mSource->mNumReads);
+    }
+}
+
+TEST_F(ReadAheadSourceTest, ErrorsArePropagated) {
+    init(100 * 1000);
+    checkRead(0, 100);
+    mSource->mError = ERROR_IO;
+    uint8_t data[100];
+    // Cached data is still served.
+    EXPECT_EQ(mReadAhead->readAt(50, data, sizeof(data)), (ssize_t)sizeof(data));
+    EXPECT_EQ(mReadAhead->readAt(50000, data, sizeof(data)), ERROR_IO);
+    EXPECT_EQ(mReadAhead->readAt(kBlockSize - 50, data, sizeof(data)), 50);
+    EXPECT_EQ(mReadAhead->readAt(-1, data, sizeof(data)), ERROR_IO);
+    mSource->mError = OK;
+    checkRead(50000, 100);
+}
+
+}  // namespace android
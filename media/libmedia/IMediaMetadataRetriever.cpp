@@ -113,16 +113,19 @@ public:
         return reply.readInt32();
     }
 
-    sp<IMemory> getFrameAtTime(int64_t timeUs, int option, int colorFormat, bool metaOnly)
+    sp<IMemory> getFrameAtTime(int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight)
     {
-        ALOGV("getTimeAtTime: time(%" PRId64 " us), option(%d), colorFormat(%d) metaOnly(%d)",
-                timeUs, option, colorFormat, metaOnly);
+        ALOGV("getTimeAtTime: time(%" PRId64 " us), option(%d), colorFormat(%d) metaOnly(%d)"
+                " dst(%dx%d)", timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
         Parcel data, reply;
         data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
         data.writeInt64(timeUs);
         data.writeInt32(option);
         data.writeInt32(colorFormat);
         data.writeInt32(metaOnly);
+        data.writeInt32(dstWidth);
+        data.writeInt32(dstHeight);
         remote()->transact(GET_FRAME_AT_TIME, data, &reply);
         status_t ret = reply.readInt32();
         if (ret != NO_ERROR) {
@@ -131,16 +134,19 @@ public:
         return interface_cast<IMemory>(reply.readStrongBinder());
     }
 
-    sp<IMemory> getImageAtIndex(int index, int colorFormat, bool metaOnly, bool thumbnail)
+    sp<IMemory> getImageAtIndex(int index, int colorFormat, bool metaOnly, bool thumbnail,
+            int dstWidth, int dstHeight)
     {
-        ALOGV("getImageAtIndex: index %d, colorFormat(%d) metaOnly(%d) thumbnail(%d)",
-                index, colorFormat, metaOnly, thumbnail);
+        ALOGV("getImageAtIndex: index %d, colorFormat(%d) metaOnly(%d) thumbnail(%d)"
+                " dst(%dx%d)", index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
         Parcel data, reply;
         data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
         data.writeInt32(index);
         data.writeInt32(colorFormat);
         data.writeInt32(metaOnly);
         data.writeInt32(thumbnail);
+        data.writeInt32(dstWidth);
+        data.writeInt32(dstHeight);
         remote()->transact(GET_IMAGE_AT_INDEX, data, &reply);
         status_t ret = reply.readInt32();
         if (ret != NO_ERROR) {
@@ -312,9 +318,12 @@ status_t BnMediaMetadataRetriever::onTransact(
             int option = data.readInt32();
             int colorFormat = data.readInt32();
             bool metaOnly = (data.readInt32() != 0);
-            ALOGV("getTimeAtTime: time(%" PRId64 " us), option(%d), colorFormat(%d), metaOnly(%d)",
-                    timeUs, option, colorFormat, metaOnly);
-            sp<IMemory> bitmap = getFrameAtTime(timeUs, option, colorFormat, metaOnly);
+            int dstWidth = data.readInt32();
+            int dstHeight = data.readInt32();
+            ALOGV("getTimeAtTime: time(%" PRId64 " us), option(%d), colorFormat(%d), metaOnly(%d)"
+                    " dst(%dx%d)", timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
+            sp<IMemory> bitmap = getFrameAtTime(
+                    timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
             if (bitmap != 0) {  // Don't send NULL across the binder interface
                 reply->writeInt32(NO_ERROR);
                 reply->writeStrongBinder(IInterface::asBinder(bitmap));
@@ -329,9 +338,12 @@ status_t BnMediaMetadataRetriever::onTransact(
             int colorFormat = data.readInt32();
             bool metaOnly = (data.readInt32() != 0);
             bool thumbnail = (data.readInt32() != 0);
-            ALOGV("getImageAtIndex: index(%d), colorFormat(%d), metaOnly(%d), thumbnail(%d)",
-                    index, colorFormat, metaOnly, thumbnail);
-            sp<IMemory> bitmap = getImageAtIndex(index, colorFormat, metaOnly, thumbnail);
+            int dstWidth = data.readInt32();
+            int dstHeight = data.readInt32();
+            ALOGV("getImageAtIndex: index(%d), colorFormat(%d), metaOnly(%d), thumbnail(%d)"
+                    " dst(%dx%d)", index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
+            sp<IMemory> bitmap = getImageAtIndex(
+                    index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
             if (bitmap != 0) {  // Don't send NULL across the binder interface
                 reply->writeInt32(NO_ERROR);
                 reply->writeStrongBinder(IInterface::asBinder(bitmap));
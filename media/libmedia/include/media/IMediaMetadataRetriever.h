@@ -42,10 +42,14 @@ public:
     virtual status_t        setDataSource(int fd, int64_t offset, int64_t length) = 0;
     virtual status_t        setDataSource(
             const sp<IDataSource>& dataSource, const char *mime) = 0;
+    // A non-zero |dstWidth| and |dstHeight| ask for a frame scaled down to fit
+    // within them. The frame may still be returned at its full size.
     virtual sp<IMemory>     getFrameAtTime(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly) = 0;
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight) = 0;
     virtual sp<IMemory>     getImageAtIndex(
-            int index, int colorFormat, bool metaOnly, bool thumbnail) = 0;
+            int index, int colorFormat, bool metaOnly, bool thumbnail,
+            int dstWidth, int dstHeight) = 0;
     virtual sp<IMemory>     getImageRectAtIndex(
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory>     getFrameAtIndex(
@@ -44,9 +44,11 @@ public:
     virtual status_t    setDataSource(int fd, int64_t offset, int64_t length) = 0;
     virtual status_t    setDataSource(const sp<DataSource>& source, const char *mime) = 0;
     virtual sp<IMemory> getFrameAtTime(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly) = 0;
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight) = 0;
     virtual sp<IMemory> getImageAtIndex(
-            int index, int colorFormat, bool metaOnly, bool thumbnail) = 0;
+            int index, int colorFormat, bool metaOnly, bool thumbnail,
+            int dstWidth, int dstHeight) = 0;
     virtual sp<IMemory> getImageRectAtIndex(
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory> getFrameAtIndex(
@@ -96,9 +96,10 @@ public:
     status_t setDataSource(
             const sp<IDataSource>& dataSource, const char *mime = NULL);
     sp<IMemory> getFrameAtTime(int64_t timeUs, int option,
-            int colorFormat, bool metaOnly = false);
+            int colorFormat, bool metaOnly = false, int dstWidth = 0, int dstHeight = 0);
     sp<IMemory> getImageAtIndex(int index,
-            int colorFormat, bool metaOnly = false, bool thumbnail = false);
+            int colorFormat, bool metaOnly = false, bool thumbnail = false,
+            int dstWidth = 0, int dstHeight = 0);
     sp<IMemory> getImageRectAtIndex(
             int index, int colorFormat, int left, int top, int right, int bottom);
     sp<IMemory>  getFrameAtIndex(
@@ -138,28 +138,32 @@ status_t MediaMetadataRetriever::setDataSource(
 }
 
 sp<IMemory> MediaMetadataRetriever::getFrameAtTime(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly)
+        int64_t timeUs, int option, int colorFormat, bool metaOnly,
+        int dstWidth, int dstHeight)
 {
-    ALOGV("getFrameAtTime: time(%" PRId64 " us) option(%d) colorFormat(%d) metaOnly(%d)",
-            timeUs, option, colorFormat, metaOnly);
+    ALOGV("getFrameAtTime: time(%" PRId64 " us) option(%d) colorFormat(%d) metaOnly(%d)"
+            " dst(%dx%d)", timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
     Mutex::Autolock _l(mLock);
     if (mRetriever == 0) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
-    return mRetriever->getFrameAtTime(timeUs, option, colorFormat, metaOnly);
+    return mRetriever->getFrameAtTime(
+            timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
 }
 
 sp<IMemory> MediaMetadataRetriever::getImageAtIndex(
-        int index, int colorFormat, bool metaOnly, bool thumbnail) {
-    ALOGV("getImageAtIndex: index(%d) colorFormat(%d) metaOnly(%d) thumbnail(%d)",
-            index, colorFormat, metaOnly, thumbnail);
+        int index, int colorFormat, bool metaOnly, bool thumbnail,
+        int dstWidth, int dstHeight) {
+    ALOGV("getImageAtIndex: index(%d) colorFormat(%d) metaOnly(%d) thumbnail(%d) dst(%dx%d)",
+            index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
     Mutex::Autolock _l(mLock);
     if (mRetriever == 0) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
-    return mRetriever->getImageAtIndex(index, colorFormat, metaOnly, thumbnail);
+    return mRetriever->getImageAtIndex(
+            index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
 }
 
 sp<IMemory> MediaMetadataRetriever::getImageRectAtIndex(
@@ -194,17 +194,19 @@ status_t MetadataRetrieverClient::setDataSource(
 Mutex MetadataRetrieverClient::sLock;
 
 sp<IMemory> MetadataRetrieverClient::getFrameAtTime(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly)
+        int64_t timeUs, int option, int colorFormat, bool metaOnly,
+        int dstWidth, int dstHeight)
 {
-    ALOGV("getFrameAtTime: time(%lld us) option(%d) colorFormat(%d), metaOnly(%d)",
-            (long long)timeUs, option, colorFormat, metaOnly);
+    ALOGV("getFrameAtTime: time(%lld us) option(%d) colorFormat(%d), metaOnly(%d) dst(%dx%d)",
+            (long long)timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
     if (mRetriever == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
-    sp<IMemory> frame = mRetriever->getFrameAtTime(timeUs, option, colorFormat, metaOnly);
+    sp<IMemory> frame = mRetriever->getFrameAtTime(
+            timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
     if (frame == NULL) {
         ALOGE("failed to capture a video frame");
         return NULL;
@@ -213,16 +215,18 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtTime(
 }
 
 sp<IMemory> MetadataRetrieverClient::getImageAtIndex(
-        int index, int colorFormat, bool metaOnly, bool thumbnail) {
-    ALOGV("getImageAtIndex: index(%d) colorFormat(%d), metaOnly(%d) thumbnail(%d)",
-            index, colorFormat, metaOnly, thumbnail);
+        int index, int colorFormat, bool metaOnly, bool thumbnail,
+        int dstWidth, int dstHeight) {
+    ALOGV("getImageAtIndex: index(%d) colorFormat(%d), metaOnly(%d) thumbnail(%d) dst(%dx%d)",
+            index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
     if (mRetriever == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
-    sp<IMemory> frame = mRetriever->getImageAtIndex(index, colorFormat, metaOnly, thumbnail);
+    sp<IMemory> frame = mRetriever->getImageAtIndex(
+            index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
     if (frame == NULL) {
         ALOGE("failed to extract image");
         return NULL;
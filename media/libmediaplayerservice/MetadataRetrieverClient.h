@@ -51,9 +51,11 @@ public:
     virtual status_t                setDataSource(int fd, int64_t offset, int64_t length);
     virtual status_t                setDataSource(const sp<IDataSource>& source, const char *mime);
     virtual sp<IMemory>             getFrameAtTime(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly);
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight);
     virtual sp<IMemory>             getImageAtIndex(
-            int index, int colorFormat, bool metaOnly, bool thumbnail);
+            int index, int colorFormat, bool metaOnly, bool thumbnail,
+            int dstWidth, int dstHeight);
     virtual sp<IMemory>             getImageRectAtIndex(
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory>             getFrameAtIndex(
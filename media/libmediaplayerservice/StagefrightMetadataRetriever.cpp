@@ -131,11 +131,12 @@ status_t StagefrightMetadataRetriever::setDataSource(
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getImageAtIndex(
-        int index, int colorFormat, bool metaOnly, bool thumbnail) {
-    ALOGV("getImageAtIndex: index(%d) colorFormat(%d) metaOnly(%d) thumbnail(%d)",
-            index, colorFormat, metaOnly, thumbnail);
+        int index, int colorFormat, bool metaOnly, bool thumbnail,
+        int dstWidth, int dstHeight) {
+    ALOGV("getImageAtIndex: index(%d) colorFormat(%d) metaOnly(%d) thumbnail(%d) dst(%dx%d)",
+            index, colorFormat, metaOnly, thumbnail, dstWidth, dstHeight);
 
-    return getImageInternal(index, colorFormat, metaOnly, thumbnail, NULL);
+    return getImageInternal(index, colorFormat, metaOnly, thumbnail, NULL, dstWidth, dstHeight);
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
@@ -149,12 +150,13 @@ sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
         return mDecoder->extractFrame(&rect);
     }
 
-    return getImageInternal(
-            index, colorFormat, false /*metaOnly*/, false /*thumbnail*/, &rect);
+    return getImageInternal(index, colorFormat, false /*metaOnly*/, false /*thumbnail*/,
+            &rect, 0 /*dstWidth*/, 0 /*dstHeight*/);
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
-        int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect) {
+        int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect,
+        int dstWidth, int dstHeight) {
     mDecoder.clear();
     mLastDecodedIndex = -1;
 
@@ -285,6 +287,7 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
         sp<MediaImageDecoder> decoder = new MediaImageDecoder(componentName, trackMeta, source);
+        decoder->setTargetSize(dstWidth, dstHeight);
         int64_t frameTimeUs = thumbnail ? -1 : 0;
         if (decoder->init(frameTimeUs, 0 /*option*/, colorFormat) == OK) {
             sp<IMemory> frame = decoder->extractFrame(rect);
@@ -306,11 +309,12 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getFrameAtTime(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
-    ALOGV("getFrameAtTime: %" PRId64 " us option: %d colorFormat: %d, metaOnly: %d",
-            timeUs, option, colorFormat, metaOnly);
+        int64_t timeUs, int option, int colorFormat, bool metaOnly,
+        int dstWidth, int dstHeight) {
+    ALOGV("getFrameAtTime: %" PRId64 " us option: %d colorFormat: %d, metaOnly: %d"
+            " dst: %dx%d", timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
 
-    return getFrameInternal(timeUs, option, colorFormat, metaOnly);
+    return getFrameInternal(timeUs, option, colorFormat, metaOnly, dstWidth, dstHeight);
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
@@ -325,12 +329,13 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
         return frame;
     }
 
-    return getFrameInternal(frameIndex,
-            MediaSource::ReadOptions::SEEK_FRAME_INDEX, colorFormat, metaOnly);
+    return getFrameInternal(frameIndex, MediaSource::ReadOptions::SEEK_FRAME_INDEX,
+            colorFormat, metaOnly, 0 /*dstWidth*/, 0 /*dstHeight*/);
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+        int64_t timeUs, int option, int colorFormat, bool metaOnly,
+        int dstWidth, int dstHeight) {
     mDecoder.clear();
     mLastDecodedIndex = -1;
 
@@ -417,6 +422,7 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
         sp<VideoFrameDecoder> decoder = new VideoFrameDecoder(componentName, trackMeta, source);
+        decoder->setTargetSize(dstWidth, dstHeight);
         if (decoder->init(timeUs, option, colorFormat) == OK) {
             sp<IMemory> frame = decoder->extractFrame();
             if (frame != nullptr) {
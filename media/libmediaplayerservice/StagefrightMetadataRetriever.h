@@ -42,9 +42,11 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
     virtual status_t setDataSource(const sp<DataSource>& source, const char *mime);
 
     virtual sp<IMemory> getFrameAtTime(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly);
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight);
     virtual sp<IMemory> getImageAtIndex(
-            int index, int colorFormat, bool metaOnly, bool thumbnail);
+            int index, int colorFormat, bool metaOnly, bool thumbnail,
+            int dstWidth, int dstHeight);
     virtual sp<IMemory> getImageRectAtIndex(
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory> getFrameAtIndex(
@@ -69,10 +71,12 @@ private:
     void clearMetadata();
 
     sp<IMemory> getFrameInternal(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly);
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            int dstWidth, int dstHeight);
 
     sp<IMemory> getImageInternal(
-            int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect);
+            int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect,
+            int dstWidth, int dstHeight);
 
     StagefrightMetadataRetriever(const StagefrightMetadataRetriever &);
 
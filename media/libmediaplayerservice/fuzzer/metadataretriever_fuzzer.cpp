@@ -108,13 +108,15 @@ void MetadataRetrieverFuzzer::getData() {
                     mMdRetriever->getFrameAtTime(mFdp.ConsumeIntegral<int64_t>() /* timeUs */,
                                                  mFdp.ConsumeIntegral<int32_t>() /* option */,
                                                  mFdp.ConsumeIntegral<int32_t>() /* colorFormat */,
-                                                 mFdp.ConsumeBool() /* metaOnly */);
+                                                 mFdp.ConsumeBool() /* metaOnly */,
+                                                 0 /* dstWidth */, 0 /* dstHeight */);
                 },
                 [&]() {
                     mMdRetriever->getImageAtIndex(mFdp.ConsumeIntegral<int32_t>() /* index */,
                                                   mFdp.ConsumeIntegral<int32_t>() /* colorFormat */,
                                                   mFdp.ConsumeBool() /* metaOnly */,
-                                                  mFdp.ConsumeBool() /* thumbnail */);
+                                                  mFdp.ConsumeBool() /* thumbnail */,
+                                                  0 /* dstWidth */, 0 /* dstHeight */);
                 },
                 [&]() {
                     mMdRetriever->getImageRectAtIndex(
@@ -128,7 +130,8 @@ void MetadataRetrieverFuzzer::getData() {
                 [&]() {
                     mMdRetriever->getFrameAtIndex(mFdp.ConsumeIntegral<int32_t>() /* index */,
                                                   mFdp.ConsumeIntegral<int32_t>() /* colorFormat */,
-                                                  mFdp.ConsumeBool() /* metaOnly */);
+                                                  mFdp.ConsumeBool() /* metaOnly */,
+                                                 0 /* dstWidth */, 0 /* dstHeight */);
                 },
                 [&]() { mMdRetriever->extractAlbumArt(); },
                 [&]() {
@@ -22,6 +22,7 @@
 #include "include/HevcUtils.h"
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
 #include <mediadrm/ICrypto.h>
@@ -52,9 +53,17 @@ static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
 // To make codec for thumbnail less important, give it a value more than 0.
 static const int kThumbnailImportance = 1;
 
+// Threads converting a frame to the output color format. 0 uses one per online CPU.
+// Serial by default, as each conversion starts its threads.
+static size_t getColorConverterThreads() {
+    int32_t numThreads = property_get_int32("media.stagefright.thumbnail.convert_threads", 1);
+    return numThreads >= 0 ? numThreads : 1;
+}
+
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
-        int32_t dstBpp, uint32_t bitDepth, bool allocRotated, bool metaOnly) {
+        int32_t dstBpp, uint32_t bitDepth, bool allocRotated, bool metaOnly,
+        int32_t scaledWidth, int32_t scaledHeight) {
     int32_t rotationAngle;
     if (!trackMeta->findInt32(kKeyRotation, &rotationAngle)) {
         rotationAngle = 0;  // By default, no rotation
@@ -106,6 +115,20 @@ sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         }
     }
 
+    if (scaledWidth > 0 && scaledHeight > 0 && width > 0 && height > 0
+            && (scaledWidth != width || scaledHeight != height)) {
+        // The display size and crop are given for the full-size frame.
+        displayWidth = std::max(1, (int32_t)((int64_t)displayWidth * scaledWidth / width));
+        displayHeight = std::max(1, (int32_t)((int64_t)displayHeight * scaledHeight / height));
+        displayLeft = (int64_t)displayLeft * scaledWidth / width;
+        displayTop = (int64_t)displayTop * scaledHeight / height;
+        width = scaledWidth;
+        height = scaledHeight;
+        // A scaled frame cannot be decoded by tiles.
+        tileWidth = 0;
+        tileHeight = 0;
+    }
+
     if (allocRotated) {
         if (rotationAngle == 90 || rotationAngle == 270) {
             // swap width and height for 90 & 270 degrees rotation
@@ -151,14 +174,21 @@ sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
         int32_t dstBpp, uint8_t bitDepth, bool allocRotated = false) {
     return allocVideoFrame(trackMeta, width, height, tileWidth, tileHeight, dstBpp, bitDepth,
-            allocRotated, false /*metaOnly*/);
+            allocRotated, false /*metaOnly*/, 0 /*scaledWidth*/, 0 /*scaledHeight*/);
+}
+
+sp<IMemory> allocScaledVideoFrame(const sp<MetaData>& trackMeta,
+        int32_t width, int32_t height, int32_t scaledWidth, int32_t scaledHeight,
+        int32_t dstBpp, uint8_t bitDepth) {
+    return allocVideoFrame(trackMeta, width, height, 0, 0, dstBpp, bitDepth,
+            false /*allocRotated*/, false /*metaOnly*/, scaledWidth, scaledHeight);
 }
 
 sp<IMemory> allocMetaFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
         int32_t dstBpp, uint8_t bitDepth) {
     return allocVideoFrame(trackMeta, width, height, tileWidth, tileHeight, dstBpp, bitDepth,
-            false /*allocRotated*/, true /*metaOnly*/);
+            false /*allocRotated*/, true /*metaOnly*/, 0 /*scaledWidth*/, 0 /*scaledHeight*/);
 }
 
 bool isAvif(const sp<MetaData> &trackMeta) {
@@ -285,6 +315,8 @@ FrameDecoder::FrameDecoder(
       mSource(source),
       mDstFormat(OMX_COLOR_Format16bitRGB565),
       mDstBpp(2),
+      mTargetWidth(0),
+      mTargetHeight(0),
       mHaveMoreInputs(true),
       mFirstSample(true) {
 }
@@ -296,6 +328,37 @@ FrameDecoder::~FrameDecoder() {
     }
 }
 
+void FrameDecoder::setTargetSize(int32_t width, int32_t height) {
+    mTargetWidth = width;
+    mTargetHeight = height;
+}
+
+bool FrameDecoder::getScaledSize(int32_t width, int32_t height,
+        int32_t *scaledWidth, int32_t *scaledHeight) const {
+    if (mTargetWidth <= 0 || mTargetHeight <= 0 || width <= 0 || height <= 0) {
+        return false;
+    }
+    // the target size is for the frame as displayed
+    int32_t targetWidth = mTargetWidth;
+    int32_t targetHeight = mTargetHeight;
+    int32_t rotationAngle;
+    if (mTrackMeta->findInt32(kKeyRotation, &rotationAngle)
+            && (rotationAngle == 90 || rotationAngle == 270)) {
+        std::swap(targetWidth, targetHeight);
+    }
+    if (width <= targetWidth && height <= targetHeight) {
+        return false;
+    }
+    if ((int64_t)width * targetHeight > (int64_t)height * targetWidth) {
+        *scaledWidth = targetWidth;
+        *scaledHeight = std::max(1, (int32_t)((int64_t)height * targetWidth / width));
+    } else {
+        *scaledWidth = std::max(1, (int32_t)((int64_t)width * targetHeight / height));
+        *scaledHeight = targetHeight;
+    }
+    return true;
+}
+
 bool isHDR(const sp<AMessage> &format) {
     uint32_t standard, transfer;
     if (!format->findInt32("color-standard", (int32_t*)&standard)) {
@@ -688,30 +751,6 @@ status_t VideoFrameDecoder::onOutputReceived(
         bitDepth = 10;
     }
 
-    if (mFrame == NULL) {
-        sp<IMemory> frameMem = allocVideoFrame(
-                trackMeta(),
-                (crop_right - crop_left + 1),
-                (crop_bottom - crop_top + 1),
-                0,
-                0,
-                dstBpp(),
-                bitDepth,
-                mCaptureLayer != nullptr /*allocRotated*/);
-        if (frameMem == nullptr) {
-            return NO_MEMORY;
-        }
-
-        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
-
-        setFrame(frameMem);
-    }
-
-    mFrame->mDurationUs = durationUs;
-
-    if (mCaptureLayer != nullptr) {
-        return captureSurface();
-    }
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
 
     uint32_t standard, range, transfer;
@@ -732,10 +771,50 @@ status_t VideoFrameDecoder::onOutputReceived(
             converter.setSrcMediaImage2(*imageData);
         }
     }
+
+    if (mFrame == NULL) {
+        int32_t frameWidth = crop_right - crop_left + 1;
+        int32_t frameHeight = crop_bottom - crop_top + 1;
+        sp<IMemory> frameMem;
+        int32_t scaledWidth, scaledHeight;
+        // scale the frame as it is converted, rather than converting the full frame
+        if (mCaptureLayer == nullptr && converter.isScalingSupported()
+                && getScaledSize(frameWidth, frameHeight, &scaledWidth, &scaledHeight)) {
+            ALOGV("scaling %dx%d frame to %dx%d",
+                    frameWidth, frameHeight, scaledWidth, scaledHeight);
+            frameMem = allocScaledVideoFrame(
+                    trackMeta(), frameWidth, frameHeight, scaledWidth, scaledHeight,
+                    dstBpp(), bitDepth);
+        } else {
+            frameMem = allocVideoFrame(
+                    trackMeta(),
+                    frameWidth,
+                    frameHeight,
+                    0,
+                    0,
+                    dstBpp(),
+                    bitDepth,
+                    mCaptureLayer != nullptr /*allocRotated*/);
+        }
+        if (frameMem == nullptr) {
+            return NO_MEMORY;
+        }
+
+        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+
+        setFrame(frameMem);
+    }
+
+    mFrame->mDurationUs = durationUs;
+
+    if (mCaptureLayer != nullptr) {
+        return captureSurface();
+    }
     if (srcFormat == COLOR_FormatYUV420Flexible && imgObj.get() == nullptr) {
         return ERROR_UNSUPPORTED;
     }
     converter.setSrcColorSpace(standard, range, transfer);
+    converter.setNumThreads(getColorConverterThreads());
     if (converter.isValid()) {
         ScopedTrace trace(ATRACE_TAG, "FrameDecoder::ColorConverter");
         converter.convert(
@@ -827,6 +906,23 @@ MediaImageDecoder::MediaImageDecoder(
 sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
         int64_t frameTimeUs, int /*seekMode*/,
         MediaSource::ReadOptions *options, sp<Surface> * /*window*/) {
+    // Decode the stand-alone thumbnail instead of the image if the image
+    // would be scaled down to the size of the thumbnail or smaller anyway.
+    int32_t imageWidth, imageHeight, scaledWidth, scaledHeight, thumbWidth, thumbHeight;
+    if (frameTimeUs >= 0
+            && trackMeta()->findInt32(kKeyWidth, &imageWidth)
+            && trackMeta()->findInt32(kKeyHeight, &imageHeight)
+            && getScaledSize(imageWidth, imageHeight, &scaledWidth, &scaledHeight)
+            && findThumbnailInfo(trackMeta(), &thumbWidth, &thumbHeight)
+            && thumbWidth >= scaledWidth && thumbHeight >= scaledHeight
+            // with the same aspect ratio, give or take a pixel
+            && std::abs((int64_t)thumbWidth * imageHeight - (int64_t)thumbHeight * imageWidth)
+                    <= std::max(imageWidth, imageHeight)) {
+        ALOGV("decoding %dx%d thumbnail for %dx%d frame of %dx%d image",
+                thumbWidth, thumbHeight, scaledWidth, scaledHeight, imageWidth, imageHeight);
+        frameTimeUs = -1;
+    }
+
     sp<MetaData> overrideMeta;
     if (frameTimeUs < 0) {
         uint32_t type;
@@ -983,19 +1079,6 @@ status_t MediaImageDecoder::onOutputReceived(
         bitDepth = 10;
     }
 
-    if (mFrame == NULL) {
-        sp<IMemory> frameMem = allocVideoFrame(
-                trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
-
-        if (frameMem == nullptr) {
-            return NO_MEMORY;
-        }
-
-        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
-
-        setFrame(frameMem);
-    }
-
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
 
     uint32_t standard, range, transfer;
@@ -1020,6 +1103,30 @@ status_t MediaImageDecoder::onOutputReceived(
         return ERROR_UNSUPPORTED;
     }
     converter.setSrcColorSpace(standard, range, transfer);
+    converter.setNumThreads(getColorConverterThreads());
+
+    if (mFrame == NULL) {
+        sp<IMemory> frameMem;
+        int32_t scaledWidth, scaledHeight;
+        // Only whole images are scaled, as rects are decoded into the full-size frame.
+        if (mTargetTiles == mGridRows * mGridCols && converter.isScalingSupported()
+                && getScaledSize(mWidth, mHeight, &scaledWidth, &scaledHeight)) {
+            ALOGV("scaling %dx%d image to %dx%d", mWidth, mHeight, scaledWidth, scaledHeight);
+            frameMem = allocScaledVideoFrame(
+                    trackMeta(), mWidth, mHeight, scaledWidth, scaledHeight, dstBpp(), bitDepth);
+        } else {
+            frameMem = allocVideoFrame(
+                    trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
+        }
+
+        if (frameMem == nullptr) {
+            return NO_MEMORY;
+        }
+
+        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+
+        setFrame(frameMem);
+    }
 
     int32_t crop_left, crop_top, crop_right, crop_bottom;
     if (!outputFormat->findRect("crop", &crop_left, &crop_top, &crop_right, &crop_bottom)) {
@@ -1056,6 +1163,18 @@ status_t MediaImageDecoder::onOutputReceived(
 
     *done = (++mTilesDecoded >= mTargetTiles);
 
+    if (mFrame->mWidth != (uint32_t)mWidth || mFrame->mHeight != (uint32_t)mHeight) {
+        // Scale the tile into its part of the scaled frame.
+        dstLeft = (int64_t)dstLeft * mFrame->mWidth / mWidth;
+        dstTop = (int64_t)dstTop * mFrame->mHeight / mHeight;
+        dstRight = (int64_t)(dstRight + 1) * mFrame->mWidth / mWidth - 1;
+        dstBottom = (int64_t)(dstBottom + 1) * mFrame->mHeight / mHeight - 1;
+        if (dstRight < dstLeft || dstBottom < dstTop) {
+            // the tile is smaller than a pixel of the scaled frame
+            return OK;
+        }
+    }
+
     if (converter.isValid()) {
         converter.convert(
                 (const uint8_t *)videoFrameBuffer->data(),
@@ -22,6 +22,7 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <pthread.h>
 #include <sys/prctl.h>
 #include <sys/stat.h>
@@ -72,6 +73,7 @@ static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
+static const uint64_t kDataSyncIntervalBytes = 16 * 1024 * 1024;
 
 static const char kMetaKey_Version[]    = "com.android.version";
 static const char kMetaKey_Manufacturer[]      = "com.android.manufacturer";
@@ -533,6 +535,12 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mPaused = false;
     mStarted = false;
     mWriterThreadStarted = false;
+    mDataSyncThreadStarted = false;
+    mDataSyncPending = false;
+    mDataSyncDone = false;
+    mBytesSinceDataSync = 0;
+    mNumDataSyncs = 0;
+    mMaxDataSyncDuration = std::chrono::microseconds::zero();
     mSendNotify = false;
     mWriteSeekErr = false;
     mFallocateErr = false;
@@ -1130,6 +1138,7 @@ status_t MPEG4Writer::stopWriterThread() {
         err = UNKNOWN_ERROR;
     }
     mWriterThreadStarted = false;
+    stopDataSyncThread();
     return err;
 }
 
@@ -1633,12 +1642,12 @@ void MPEG4Writer::unlock() {
 }
 
 off64_t MPEG4Writer::addSample_l(
-        MediaBuffer *buffer, bool usePrefix,
-        uint32_t tiffHdrOffset, size_t *bytesWritten) {
+        MediaBuffer *buffer, uint32_t tiffHdrOffset, size_t *bytesWritten) {
     off64_t old_offset = mOffset;
     int64_t offset;
     ALOGV("buffer->range_length:%lld", (long long)buffer->range_length());
     if (buffer->meta_data().findInt64(kKeySampleFileOffset, &offset)) {
+        flushPendingWrites_l();
         ALOGV("offset:%lld, old_offset:%lld", (long long)offset, (long long)old_offset);
         if (mMaxOffsetAppend > offset) {
             // This has already been appended, skip updating mOffset value.
@@ -1662,20 +1671,20 @@ off64_t MPEG4Writer::addSample_l(
 
     ALOGV("mOffset:%lld, mMaxOffsetAppend:%lld", (long long)mOffset, (long long)mMaxOffsetAppend);
 
-    if (usePrefix) {
-        addMultipleLengthPrefixedSamples_l(buffer);
-    } else {
-        if (tiffHdrOffset > 0) {
-            tiffHdrOffset = htonl(tiffHdrOffset);
-            writeOrPostError(mFd, &tiffHdrOffset, 4);  // exif_tiff_header_offset field
-            mOffset += 4;
-        }
-
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(),
-                         buffer->range_length());
-
-        mOffset += buffer->range_length();
+    // Length prefixed samples are already formatted by the track thread, so
+    // the sample is written as is.
+    if (mPendingWrites.size() + 2 > (size_t)IOV_MAX) {
+        flushPendingWrites_l();
     }
+    if (tiffHdrOffset > 0) {
+        // exif_tiff_header_offset field
+        mPendingTiffHdrOffsets.push_back(htonl(tiffHdrOffset));
+        mPendingWrites.push_back({ &mPendingTiffHdrOffsets.back(), 4 });
+        mOffset += 4;
+    }
+    mPendingWrites.push_back({ (uint8_t *)buffer->data() + buffer->range_offset(),
+                               buffer->range_length() });
+    mOffset += buffer->range_length();
     *bytesWritten = mOffset - old_offset;
 
     ALOGV("mOffset:%lld, old_offset:%lld, bytesWritten:%lld", (long long)mOffset,
@@ -1684,69 +1693,53 @@ off64_t MPEG4Writer::addSample_l(
     return old_offset;
 }
 
-static void StripStartcode(MediaBuffer *buffer) {
-    if (buffer->range_length() < 4) {
+void MPEG4Writer::flushPendingWrites_l() {
+    if (mPendingWrites.empty()) {
         return;
     }
-
-    const uint8_t *ptr =
-        (const uint8_t *)buffer->data() + buffer->range_offset();
-
-    if (!memcmp(ptr, "\x00\x00\x00\x01", 4)) {
-        ALOGV("stripping start code");
-        buffer->set_range(
-                buffer->range_offset() + 4, buffer->range_length() - 4);
-    }
+    writevOrPostError(mFd, mPendingWrites.data(), mPendingWrites.size());
+    mPendingWrites.clear();
+    mPendingTiffHdrOffsets.clear();
 }
 
-void MPEG4Writer::addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer) {
-    const uint8_t *dataStart = (const uint8_t *)buffer->data() + buffer->range_offset();
-    const uint8_t *currentNalStart = dataStart;
+/*
+ * Copy the NAL units of the |size| bytes of |data|, which has its first start
+ * code stripped, to |dst| with each start code replaced by the length of the
+ * NAL unit. |dst| must have room for |size| + 4 bytes.
+ * Return the number of bytes copied.
+ */
+static size_t CopyLengthPrefixedNalUnits(
+        const uint8_t *data, size_t size, bool use4ByteNalLength, uint8_t *dst) {
+    uint8_t *out = dst;
+    auto copyNalUnit = [&out, use4ByteNalLength](const uint8_t *nal, size_t length) {
+        if (use4ByteNalLength) {
+            out[0] = length >> 24;
+            out[1] = (length >> 16) & 0xff;
+            out[2] = (length >> 8) & 0xff;
+            out[3] = length & 0xff;
+            out += 4;
+        } else {
+            CHECK_LT(length, 65536u);
+            out[0] = length >> 8;
+            out[1] = length & 0xff;
+            out += 2;
+        }
+        memcpy(out, nal, length);
+        out += length;
+    };
+
+    const uint8_t *currentNalStart = data;
     const uint8_t *nextNalStart;
-    const uint8_t *data = dataStart;
+    const uint8_t *searchData = data;
     size_t nextNalSize;
-    size_t searchSize = buffer->range_length();
-
-    while (getNextNALUnit(&data, &searchSize, &nextNalStart,
+    size_t searchSize = size;
+    while (getNextNALUnit(&searchData, &searchSize, &nextNalStart,
             &nextNalSize, true) == OK) {
-        size_t currentNalSize = nextNalStart - currentNalStart - 4 /* strip start-code */;
-        MediaBuffer *nalBuf = new MediaBuffer((void *)currentNalStart, currentNalSize);
-        addLengthPrefixedSample_l(nalBuf);
-        nalBuf->release();
-
+        copyNalUnit(currentNalStart, nextNalStart - currentNalStart - 4 /* strip start-code */);
         currentNalStart = nextNalStart;
     }
-
-    size_t currentNalOffset = currentNalStart - dataStart;
-    buffer->set_range(buffer->range_offset() + currentNalOffset,
-            buffer->range_length() - currentNalOffset);
-    addLengthPrefixedSample_l(buffer);
-}
-
-void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
-    ALOGV("alp:buffer->range_length:%lld", (long long)buffer->range_length());
-    size_t length = buffer->range_length();
-    if (mUse4ByteNalLength) {
-        ALOGV("mUse4ByteNalLength");
-        uint8_t x[4];
-        x[0] = length >> 24;
-        x[1] = (length >> 16) & 0xff;
-        x[2] = (length >> 8) & 0xff;
-        x[3] = length & 0xff;
-        writeOrPostError(mFd, &x, 4);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
-        mOffset += length + 4;
-    } else {
-        ALOGV("mUse2ByteNalLength");
-        CHECK_LT(length, 65536u);
-
-        uint8_t x[2];
-        x[0] = length >> 8;
-        x[1] = length & 0xff;
-        writeOrPostError(mFd, &x, 2);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
-        mOffset += length + 2;
-    }
+    copyNalUnit(currentNalStart, size - (currentNalStart - data));
+    return out - dst;
 }
 
 size_t MPEG4Writer::write(
@@ -1785,11 +1778,20 @@ size_t MPEG4Writer::write(
 }
 
 void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
+    const struct iovec iov = { const_cast<void *>(buf), count };
+    writevOrPostError(fd, &iov, 1);
+}
+
+void MPEG4Writer::writevOrPostError(int fd, const struct iovec *iov, int iovcnt) {
     if (mWriteSeekErr == true)
         return;
 
+    size_t count = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        count += iov[i].iov_len;
+    }
     auto beforeTP = std::chrono::high_resolution_clock::now();
-    ssize_t bytesWritten = ::write(fd, buf, count);
+    ssize_t bytesWritten = ::writev(fd, iov, iovcnt);
     auto afterTP = std::chrono::high_resolution_clock::now();
     auto writeDuration =
             std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
@@ -1801,17 +1803,19 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     /* Write as much as possible during stop() execution when there was an error
      * (mWriteSeekErr == true) in the previous call to write() or lseek64().
      */
-    if (bytesWritten == count)
+    if (bytesWritten == count) {
+        onDataWritten(count);
         return;
+    }
     mWriteSeekErr = true;
     // Note that errno is not changed even when bytesWritten < count.
-    ALOGE("writeOrPostError bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
+    ALOGE("writevOrPostError bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
           std::strerror(errno), errno);
 
     // Can't guarantee that file is usable or write would succeed anymore, hence signal to stop.
     sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
     msg->setInt32("err", ERROR_IO);
-    WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
+    WARN_UNLESS(msg->post() == OK, "writevOrPostError:error posting ERROR_IO");
 }
 
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
@@ -2793,20 +2797,19 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     ALOGV("writeChunkToFile: %" PRId64 " from %s track",
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
+    // The samples of the chunk are written together, and released after that.
     int32_t isFirstSample = true;
-    while (!chunk->mSamples.empty()) {
-        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
-
+    for (List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+         it != chunk->mSamples.end(); ++it) {
         uint32_t tiffHdrOffset;
         if (!(*it)->meta_data().findInt32(
                 kKeyExifTiffOffset, (int32_t*)&tiffHdrOffset)) {
             tiffHdrOffset = 0;
         }
         bool isExif = (tiffHdrOffset > 0);
-        bool usePrefix = chunk->mTrack->usePrefix() && !isExif;
 
         size_t bytesWritten;
-        off64_t offset = addSample_l(*it, usePrefix, tiffHdrOffset, &bytesWritten);
+        off64_t offset = addSample_l(*it, tiffHdrOffset, &bytesWritten);
 
         if (chunk->mTrack->isHeif()) {
             chunk->mTrack->addItemOffsetAndSize(offset, bytesWritten, isExif);
@@ -2814,10 +2817,13 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
             chunk->mTrack->addChunkOffset(offset);
             isFirstSample = false;
         }
+    }
+    flushPendingWrites_l();
 
+    for (List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+         it != chunk->mSamples.end(); ++it) {
         (*it)->release();
         (*it) = NULL;
-        chunk->mSamples.erase(it);
     }
     chunk->mSamples.clear();
 }
@@ -2942,9 +2948,83 @@ status_t MPEG4Writer::startWriterThread() {
     pthread_create(&mThread, &attr, ThreadWrapper, this);
     pthread_attr_destroy(&attr);
     mWriterThreadStarted = true;
+    startDataSyncThread();
     return OK;
 }
 
+void MPEG4Writer::startDataSyncThread() {
+    std::lock_guard<std::mutex> l(mDataSyncLock);
+    mDataSyncPending = false;
+    mDataSyncDone = false;
+    mBytesSinceDataSync = 0;
+    mNumDataSyncs = 0;
+    mMaxDataSyncDuration = std::chrono::microseconds::zero();
+    mDataSyncThread = std::thread(&MPEG4Writer::dataSyncThread, this);
+    mDataSyncThreadStarted = true;
+}
+
+void MPEG4Writer::stopDataSyncThread() {
+    {
+        std::lock_guard<std::mutex> l(mDataSyncLock);
+        if (!mDataSyncThreadStarted) {
+            return;
+        }
+        mDataSyncDone = true;
+        mDataSyncThreadStarted = false;
+    }
+    mDataSyncCondition.notify_one();
+    mDataSyncThread.join();
+    ALOGD("%" PRIu32 " background data syncs, longest %lld us",
+          mNumDataSyncs, (long long)mMaxDataSyncDuration.count());
+}
+
+void MPEG4Writer::onDataWritten(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> l(mDataSyncLock);
+        if (!mDataSyncThreadStarted) {
+            return;
+        }
+        mBytesSinceDataSync += bytes;
+        if (mBytesSinceDataSync < kDataSyncIntervalBytes) {
+            return;
+        }
+        // A sync still in progress covers the data written so far only in
+        // part, so request another one.
+        mBytesSinceDataSync = 0;
+        mDataSyncPending = true;
+    }
+    mDataSyncCondition.notify_one();
+}
+
+void MPEG4Writer::dataSyncThread() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4WriterSync", 0, 0, 0);
+
+    if (mIsBackgroundMode) {
+        androidSetThreadPriority(0 /* tid (0 = current) */, ANDROID_PRIORITY_BACKGROUND);
+    }
+
+    std::unique_lock<std::mutex> l(mDataSyncLock);
+    while (true) {
+        mDataSyncCondition.wait(l, [this] { return mDataSyncPending || mDataSyncDone; });
+        if (mDataSyncDone) {
+            break;
+        }
+        mDataSyncPending = false;
+        l.unlock();
+        // Writes go on in parallel; fdatasync() only waits for the writeback
+        // of the data written before the call.
+        auto beforeTP = std::chrono::steady_clock::now();
+        if (fdatasync(mFd) != 0) {
+            ALOGW("(ignored)fdatasync err:%s(%d)", std::strerror(errno), errno);
+        }
+        auto syncDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - beforeTP);
+        l.lock();
+        ++mNumDataSyncs;
+        mMaxDataSyncDuration = std::max(mMaxDataSyncDuration, syncDuration);
+    }
+}
+
 
 status_t MPEG4Writer::Track::start(MetaData *params) {
     if (!mDone && mPaused) {
@@ -3686,16 +3766,34 @@ status_t MPEG4Writer::Track::threadEntry() {
 
         ++nActualFrames;
 
+        bool usePrefix = this->usePrefix() && !isExif;
+
         // Make a deep copy of the MediaBuffer and Metadata and release
         // the original as soon as we can
-        MediaBuffer *copy = new MediaBuffer(buffer->range_length());
+        MediaBuffer *copy;
         if (sampleFileOffset != -1) {
+            copy = new MediaBuffer(buffer->range_length());
             copy->meta_data().setInt64(kKeySampleFileOffset, sampleFileOffset);
+            copy->set_range(0, buffer->range_length());
+        } else if (usePrefix) {
+            // Convert the NAL units to length prefixed ones while copying, so
+            // that the writer thread only needs to write the sample out.
+            const uint8_t *data = (const uint8_t *)buffer->data() + buffer->range_offset();
+            size_t size = buffer->range_length();
+            if (size >= 4 && !memcmp(data, "\x00\x00\x00\x01", 4)) {
+                ALOGV("stripping start code");
+                data += 4;
+                size -= 4;
+            }
+            copy = new MediaBuffer(size + 4);
+            copy->set_range(0, CopyLengthPrefixedNalUnits(
+                    data, size, mOwner->useNalLengthFour(), (uint8_t *)copy->data()));
         } else {
+            copy = new MediaBuffer(buffer->range_length());
             memcpy(copy->data(), (uint8_t*)buffer->data() + buffer->range_offset(),
                    buffer->range_length());
+            copy->set_range(0, buffer->range_length());
         }
-        copy->set_range(0, buffer->range_length());
 
         meta_data = new MetaData(buffer->meta_data());
         buffer->release();
@@ -3703,20 +3801,7 @@ status_t MPEG4Writer::Track::threadEntry() {
         if (isExif) {
             copy->meta_data().setInt32(kKeyExifTiffOffset, tiffHdrOffset);
         }
-        bool usePrefix = this->usePrefix() && !isExif;
-        if (sampleFileOffset == -1 && usePrefix) {
-            StripStartcode(copy);
-        }
         size_t sampleSize = copy->range_length();
-        if (sampleFileOffset == -1 && usePrefix) {
-            if (mOwner->useNalLengthFour()) {
-                ALOGV("nallength4");
-                sampleSize += 4;
-            } else {
-                ALOGV("nallength2");
-                sampleSize += 2;
-            }
-        }
 
         // Max file size or duration handling
         mMdatSizeBytes += sampleSize;
@@ -3981,8 +4066,8 @@ status_t MPEG4Writer::Track::threadEntry() {
         }
         if (!hasMultipleTracks) {
             size_t bytesWritten;
-            off64_t offset = mOwner->addSample_l(
-                    copy, usePrefix, tiffHdrOffset, &bytesWritten);
+            off64_t offset = mOwner->addSample_l(copy, tiffHdrOffset, &bytesWritten);
+            mOwner->flushPendingWrites_l();
 
             if (mIsHeif) {
                 addItemOffsetAndSize(offset, bytesWritten, isExif);
@@ -27,6 +27,7 @@
 #include <media/stagefright/InterfaceUtils.h>
 #include <media/stagefright/MediaExtractor.h>
 #include <media/stagefright/MediaExtractorFactory.h>
+#include <media/stagefright/foundation/ABase.h>
 #include <android/IMediaExtractor.h>
 #include <android/IMediaExtractorService.h>
 #include <nativeloader/dlext_namespaces.h>
@@ -37,8 +38,170 @@
 #include <dirent.h>
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace android {
 
+// Sniffers mostly issue many small reads close to the start of the file.
+static const size_t kSniffWindowSize = 128 * 1024;
+
+// Sniffers beyond this many run on the threads already started.
+static const size_t kMaxSniffThreads = 4;
+
+// Threads shared by all sniffs, started on first use and kept for the life of
+// the process, so that a sniff does not pay for creating threads.
+class SniffThreadPool {
+public:
+    static SniffThreadPool &Get() {
+        // never destroyed, as the threads are never joined
+        static SniffThreadPool *pool = new SniffThreadPool();
+        return *pool;
+    }
+
+    // Runs |work| on the calling thread and on up to |helpers| pool threads,
+    // and returns once every run that started has completed. Pool threads busy
+    // with other sniffs are not waited for: the runs they have not picked up
+    // by the time the calling thread is done are dropped.
+    void run(size_t helpers, const std::function<void()> &work) {
+        Job job = { &work, helpers, 0 };
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            while (mThreadCount < std::min(helpers, kMaxSniffThreads - 1)) {
+                std::thread(&SniffThreadPool::threadLoop, this).detach();
+                ++mThreadCount;
+            }
+            mJobs.push_back(&job);
+        }
+        mWorkAvailable.notify_all();
+
+        work();
+
+        std::unique_lock<std::mutex> lock(mLock);
+        if (job.unclaimed > 0) {
+            mJobs.erase(std::find(mJobs.begin(), mJobs.end(), &job));
+            job.unclaimed = 0;
+        }
+        mWorkDone.wait(lock, [&job] { return job.running == 0; });
+    }
+
+private:
+    struct Job {
+        const std::function<void()> *work;
+        size_t unclaimed;
+        size_t running;
+    };
+
+    SniffThreadPool() : mThreadCount(0) {}
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mLock);
+        for (;;) {
+            mWorkAvailable.wait(lock, [this] { return !mJobs.empty(); });
+            Job *job = mJobs.front();
+            if (--job->unclaimed == 0) {
+                mJobs.pop_front();
+            }
+            ++job->running;
+            lock.unlock();
+            (*job->work)();
+            lock.lock();
+            if (--job->running == 0) {
+                mWorkDone.notify_all();
+            }
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    std::deque<Job *> mJobs;
+    size_t mThreadCount;
+
+    DISALLOW_EVIL_CONSTRUCTORS(SniffThreadPool);
+};
+
+// The DataSource given to concurrent sniffers. Reads within the first
+// kSniffWindowSize bytes are served from a copy read once, up front; all other
+// calls are serialized, as DataSources are not required to be thread-safe.
+class SniffDataSource : public DataSource {
+public:
+    explicit SniffDataSource(const sp<DataSource> &source)
+        : mSource(source),
+          mWindowSize(0) {
+        // no larger than the source, as most files sniffed in parallel are small
+        off64_t sourceSize;
+        size_t windowSize = kSniffWindowSize;
+        if (mSource->getSize(&sourceSize) == OK && sourceSize >= 0
+                && (uint64_t)sourceSize < windowSize) {
+            windowSize = sourceSize;
+        }
+        mWindow.reset(new (std::nothrow) uint8_t[windowSize]);
+        if (mWindow != nullptr) {
+            const ssize_t n = mSource->readAt(0, mWindow.get(), windowSize);
+            mWindowSize = n > 0 ? n : 0;
+        }
+    }
+
+    virtual status_t initCheck() const {
+        return mSource->initCheck();
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        if (offset < 0) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        size_t copied = 0;
+        if ((uint64_t)offset < mWindowSize) {
+            copied = std::min(size, mWindowSize - (size_t)offset);
+            memcpy(data, mWindow.get() + offset, copied);
+            if (copied == size) {
+                return size;
+            }
+        }
+        Mutex::Autolock autoLock(mLock);
+        const ssize_t n = mSource->readAt(offset + copied, (uint8_t *)data + copied, size - copied);
+        if (n < 0) {
+            return copied > 0 ? (ssize_t)copied : n;
+        }
+        return copied + n;
+    }
+
+    virtual status_t getSize(off64_t *size) {
+        Mutex::Autolock autoLock(mLock);
+        return mSource->getSize(size);
+    }
+
+    virtual uint32_t flags() {
+        Mutex::Autolock autoLock(mLock);
+        return mSource->flags();
+    }
+
+    virtual String8 getUri() {
+        Mutex::Autolock autoLock(mLock);
+        return mSource->getUri();
+    }
+
+    virtual String8 toString() {
+        return String8::format("SniffDataSource(%s)", mSource->toString().c_str());
+    }
+
+private:
+    sp<DataSource> mSource;
+    Mutex mLock;
+    std::unique_ptr<uint8_t[]> mWindow;
+    size_t mWindowSize;
+
+    DISALLOW_EVIL_CONSTRUCTORS(SniffDataSource);
+};
+
 // static
 sp<IMediaExtractor> MediaExtractorFactory::Create(
         const sp<DataSource> &source, const char *mime) {
@@ -127,6 +290,12 @@ Mutex MediaExtractorFactory::gPluginMutex;
 std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
 bool MediaExtractorFactory::gIgnoreVersion = false;
+std::atomic<bool> MediaExtractorFactory::gParallelSniffing(true);
+
+// static
+void MediaExtractorFactory::SetParallelSniffing(bool parallel) {
+    gParallelSniffing = parallel;
+}
 
 // static
 void *MediaExtractorFactory::sniff(
@@ -144,39 +313,77 @@ void *MediaExtractorFactory::sniff(
         plugins = gPlugins;
     }
 
-    void *bestCreator = NULL;
-    for (auto it = plugins->begin(); it != plugins->end(); ++it) {
-        ALOGV("sniffing %s", (*it)->def.extractor_name);
-        float newConfidence;
-        void *newMeta = nullptr;
-        FreeMetaFunc newFreeMeta = nullptr;
-
-        void *curCreator = NULL;
-        if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
-            curCreator = (void*) (*it)->def.u.v2.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        } else if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
-            curCreator = (void*) (*it)->def.u.v3.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+    struct SniffResult {
+        void *creator = nullptr;
+        float confidence = 0.0f;
+        void *meta = nullptr;
+        FreeMetaFunc freeMeta = nullptr;
+    };
+    const std::vector<sp<ExtractorPlugin>> sniffers(plugins->begin(), plugins->end());
+    std::vector<SniffResult> results(sniffers.size());
+
+    // Only local files are sniffed in parallel; network sources are out of
+    // scope. Their sniffing is bound by the latency of the network rather than
+    // by the sniffers. Past the window, concurrent sniffers would also read at
+    // scattered offsets, and each read outside the range cached by
+    // NuCachedSource2 makes it drop its cache and reconnect at that offset.
+    const uint32_t flags = source->flags();
+    const bool parallel = gParallelSniffing && sniffers.size() > 1
+            && (flags & DataSourceBase::kIsLocalFileSource)
+            && !(flags & (DataSourceBase::kIsHTTPBasedSource
+                    | DataSourceBase::kIsCachingDataSource));
+    // wrap() is not thread-safe, so the CDataSource is created before any sniffer runs
+    sp<DataSource> sniffSource = parallel ? new SniffDataSource(source) : source;
+    CDataSource *csource = sniffSource->wrap();
+
+    auto sniffOne = [&sniffers, &results, csource](size_t i) {
+        const ExtractorDef &def = sniffers[i]->def;
+        ALOGV("sniffing %s", def.extractor_name);
+        SniffResult &result = results[i];
+        if (def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
+            result.creator = (void*) def.u.v2.sniff(
+                    csource, &result.confidence, &result.meta, &result.freeMeta);
+        } else if (def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
+            result.creator = (void*) def.u.v3.sniff(
+                    csource, &result.confidence, &result.meta, &result.freeMeta);
+        }
+    };
+
+    if (parallel) {
+        std::atomic<size_t> next(0);
+        auto sniffNext = [&sniffers, &next, &sniffOne]() {
+            for (size_t i = next++; i < sniffers.size(); i = next++) {
+                sniffOne(i);
+            }
+        };
+        SniffThreadPool::Get().run(std::min(sniffers.size(), kMaxSniffThreads) - 1, sniffNext);
+    } else {
+        for (size_t i = 0; i < sniffers.size(); ++i) {
+            sniffOne(i);
         }
+    }
 
-        if (curCreator) {
-            if (newConfidence > *confidence) {
-                *confidence = newConfidence;
+    // Pick in plugin order, so that ties resolve as they do when sniffing sequentially.
+    void *bestCreator = NULL;
+    for (size_t i = 0; i < sniffers.size(); ++i) {
+        SniffResult &result = results[i];
+        if (result.creator) {
+            if (result.confidence > *confidence) {
+                *confidence = result.confidence;
                 if (*meta != nullptr && *freeMeta != nullptr) {
                     (*freeMeta)(*meta);
                 }
-                *meta = newMeta;
-                *freeMeta = newFreeMeta;
-                plugin = *it;
-                bestCreator = curCreator;
-                *creatorVersion = (*it)->def.def_version;
-            } else {
-                if (newMeta != nullptr && newFreeMeta != nullptr) {
-                    newFreeMeta(newMeta);
-                }
+                *meta = result.meta;
+                *freeMeta = result.freeMeta;
+                plugin = sniffers[i];
+                bestCreator = result.creator;
+                *creatorVersion = sniffers[i]->def.def_version;
+                continue;
             }
         }
+        if (result.meta != nullptr && result.freeMeta != nullptr) {
+            result.freeMeta(result.meta);
+        }
     }
 
     return bestCreator;
@@ -282,6 +489,7 @@ void MediaExtractorFactory::LoadExtractors() {
     }
 
     gIgnoreVersion = property_get_bool("debug.extractor.ignore_version", false);
+    gParallelSniffing = property_get_bool("media.stagefright.extractor.parallel_sniff", true);
 
     std::shared_ptr<std::list<sp<ExtractorPlugin>>> newList(new std::list<sp<ExtractorPlugin>>());
 
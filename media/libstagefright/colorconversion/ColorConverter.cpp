@@ -30,8 +30,12 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
 #include <functional>
+#include <thread>
+#include <vector>
 #include <sys/time.h>
+#include <unistd.h>
 
 #define PERF_PROFILING 0
 
@@ -464,7 +468,8 @@ ColorConverter::ColorConverter(
       mDstFormat(to),
       mSrcColorSpace({0, 0, 0}),
       mClip(NULL),
-      mClip10Bit(NULL) {
+      mClip10Bit(NULL),
+      mNumThreads(1) {
 }
 
 ColorConverter::~ColorConverter() {
@@ -557,6 +562,34 @@ void ColorConverter::setSrcColorSpace(
     mSrcColorSpace.mTransfer = transfer;
 }
 
+void ColorConverter::setNumThreads(size_t numThreads) {
+    mNumThreads = numThreads;
+}
+
+bool ColorConverter::isScalingSupported() const {
+    if (!(mDstFormat == OMX_COLOR_Format16bitRGB565
+            || mDstFormat == OMX_COLOR_Format32BitRGBA8888
+            || mDstFormat == OMX_COLOR_Format32bitBGRA8888)) {
+        return false;
+    }
+    switch ((int32_t)mSrcFormat) {
+        case COLOR_FormatYUV420Flexible:
+            return mSrcImage
+                    && mSrcImage->getMediaImage2().mType == MediaImage2::MEDIA_IMAGE_TYPE_YUV
+                    && mSrcImage->getMediaImage2().mNumPlanes == 3
+                    && mSrcImage->getBitDepth() == ImageBitDepth8;
+
+        case OMX_COLOR_FormatYUV420Planar:
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            return !mSrcImage || mSrcImage->getBitDepth() == ImageBitDepth8;
+
+        default:
+            return false;
+    }
+}
+
 /*
  * If stride is non-zero, client's stride will be used. For planar
  * or semi-planar YUV formats, stride must be even numbers.
@@ -657,42 +690,26 @@ status_t ColorConverter::convert(
             dstWidth, dstHeight, dstStride,
             dstCropLeft, dstCropTop, dstCropRight, dstCropBottom, mDstFormat);
 
+    const bool scaled = src.cropWidth() != dst.cropWidth()
+            || src.cropHeight() != dst.cropHeight();
     if (!(src.isValid()
             && dst.isValid()
             && (src.mCropLeft & 1) == 0
-            && src.cropWidth() == dst.cropWidth()
-            && src.cropHeight() == dst.cropHeight())) {
+            && (!scaled || (isScalingSupported()
+                    && dst.cropWidth() <= src.cropWidth()
+                    && dst.cropHeight() <= src.cropHeight())))) {
         return ERROR_UNSUPPORTED;
     }
 #if PERF_PROFILING
     int64_t startTimeUs = ALooper::GetNowUs();
 #endif
-    status_t err;
+    // the layout of the fixed formats is set up before any bands are converted
     switch ((int32_t)mSrcFormat) {
-        case COLOR_FormatYUV420Flexible:
-            err = convertYUVMediaImage(src, dst);
-            break;
-
         case OMX_COLOR_FormatYUV420Planar:
             if (!mSrcImage) {
                 mSrcImage = Image(CreateYUV420PlanarMediaImage2(
                         srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/));
             }
-            err = convertYUVMediaImage(src, dst);
-
-            break;
-
-        case OMX_COLOR_FormatYUV420Planar16:
-            err = convertYUV420Planar16(src, dst);
-            break;
-
-        case COLOR_FormatYUVP010:
-            err = convertYUVP010(src, dst);
-
-            break;
-
-        case OMX_COLOR_FormatCbYCrY:
-            err = convertCbYCrY(src, dst);
             break;
 
         case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
@@ -700,8 +717,6 @@ status_t ColorConverter::convert(
                 mSrcImage = Image(CreateYUV420SemiPlanarMediaImage2(
                     srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/, false));
             }
-            err = convertYUVMediaImage(src, dst);
-
             break;
 
         case OMX_COLOR_FormatYUV420SemiPlanar:
@@ -710,16 +725,21 @@ status_t ColorConverter::convert(
                 mSrcImage = Image(CreateYUV420SemiPlanarMediaImage2(
                     srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/));
             }
-            err = convertYUVMediaImage(src, dst);
-
             break;
 
         default:
-
-            CHECK(!"Should not be here. Unknown color conversion.");
             break;
     }
 
+    status_t err;
+    if (scaled) {
+        err = convertYUVMediaImageScaled(src, dst);
+    } else if (mNumThreads == 1) {
+        err = convertRows(src, dst);
+    } else {
+        err = convertInBands(src, dst);
+    }
+
 #if PERF_PROFILING
     int64_t endTimeUs = ALooper::GetNowUs();
     ALOGD("%s image took %lld us", asString_ColorFormat(mSrcFormat,"Unknown"),
@@ -729,6 +749,110 @@ status_t ColorConverter::convert(
     return err;
 }
 
+status_t ColorConverter::convertRows(
+        const BitmapParams &src, const BitmapParams &dst) {
+    status_t err;
+    switch ((int32_t)mSrcFormat) {
+        case COLOR_FormatYUV420Flexible:
+        case OMX_COLOR_FormatYUV420Planar:
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            err = convertYUVMediaImage(src, dst);
+            break;
+
+        case OMX_COLOR_FormatYUV420Planar16:
+            err = convertYUV420Planar16(src, dst);
+            break;
+
+        case COLOR_FormatYUVP010:
+            err = convertYUVP010(src, dst);
+            break;
+
+        case OMX_COLOR_FormatCbYCrY:
+            err = convertCbYCrY(src, dst);
+            break;
+
+        default:
+
+            CHECK(!"Should not be here. Unknown color conversion.");
+            break;
+    }
+    return err;
+}
+
+status_t ColorConverter::convertInBands(
+        const BitmapParams &src, const BitmapParams &dst) {
+    // Bands of fewer rows are not worth a thread, and neither are frames
+    // smaller than this many pixels, such as the tiles of a HEIC image.
+    static constexpr size_t kMinRowsPerBand = 64;
+    static constexpr size_t kMinPixelsToBand = 1024 * 1024;
+    static constexpr size_t kMaxThreads = 16;
+
+    if (src.cropWidth() * src.cropHeight() < kMinPixelsToBand) {
+        return convertRows(src, dst);
+    }
+
+    size_t numThreads = mNumThreads;
+    if (numThreads == 0) {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        numThreads = numCpus > 0 ? numCpus : 1;
+    }
+    numThreads = std::min(numThreads, kMaxThreads);
+
+    const size_t height = src.cropHeight();
+    size_t numBands = std::min(numThreads, height / kMinRowsPerBand);
+    if (numBands <= 1) {
+        return convertRows(src, dst);
+    }
+
+    // Bands start on the first row of a chroma row, so that each band reads
+    // the chroma rows the whole frame would.
+    size_t rowAlignment = 2;
+    if (mSrcImage) {
+        const MediaImage2 &image = mSrcImage->getMediaImage2();
+        rowAlignment = std::max({rowAlignment,
+                (size_t)image.mPlane[MediaImage2::PlaneIndex::U].mVertSubsampling,
+                (size_t)image.mPlane[MediaImage2::PlaneIndex::V].mVertSubsampling});
+    }
+    size_t bandHeight = (height + numBands - 1) / numBands;
+    bandHeight = (bandHeight + rowAlignment - 1) / rowAlignment * rowAlignment;
+    numBands = (height + bandHeight - 1) / bandHeight;
+
+    // the clip tables are shared by the bands, so set them up first
+    initClip();
+    initClip10Bit();
+
+    std::vector<status_t> results(numBands, OK);
+    auto convertBand = [&](size_t band) {
+        const size_t top = band * bandHeight;
+        const size_t rows = std::min(bandHeight, height - top);
+        BitmapParams bandSrc = src;
+        bandSrc.mCropTop += top;
+        bandSrc.mCropBottom = bandSrc.mCropTop + rows - 1;
+        BitmapParams bandDst = dst;
+        bandDst.mCropTop += top;
+        bandDst.mCropBottom = bandDst.mCropTop + rows - 1;
+        results[band] = convertRows(bandSrc, bandDst);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t band = 1; band < numBands; ++band) {
+        threads.emplace_back(convertBand, band);
+    }
+    convertBand(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (status_t err : results) {
+        if (err != OK) {
+            return err;
+        }
+    }
+    return OK;
+}
+
 const struct ColorConverter::Coeffs *ColorConverter::getMatrix() const {
     const bool isFullRange = mSrcColorSpace.mRange == ColorUtils::kColorRangeFull;
     const bool is10Bit = (mSrcFormat == COLOR_FormatYUVP010
@@ -1373,6 +1497,120 @@ status_t ColorConverter::convertYUVMediaImage(
     return OK;
 }
 
+status_t ColorConverter::convertYUVMediaImageScaled(
+        const BitmapParams &src, const BitmapParams &dst) {
+    if (!mSrcImage || mSrcImage->getBitDepth() != ImageBitDepth8) {
+        return ERROR_UNSUPPORTED;
+    }
+    const MediaImage2 image = mSrcImage->getMediaImage2();
+    const MediaImage2::PlaneInfo &yPlane = image.mPlane[MediaImage2::PlaneIndex::Y];
+    const MediaImage2::PlaneInfo &uPlane = image.mPlane[MediaImage2::PlaneIndex::U];
+    const MediaImage2::PlaneInfo &vPlane = image.mPlane[MediaImage2::PlaneIndex::V];
+    if (uPlane.mHorizSubsampling == 0 || uPlane.mVertSubsampling == 0
+            || vPlane.mHorizSubsampling == 0 || vPlane.mVertSubsampling == 0) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    const struct Coeffs *matrix = getMatrix();
+    if (!matrix) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    signed _b_u = matrix->_b_u;
+    signed _neg_g_u = -matrix->_g_u;
+    signed _neg_g_v = -matrix->_g_v;
+    signed _r_v = matrix->_r_v;
+    signed _y = matrix->_y;
+    signed _c16 = matrix->_c16;
+
+    uint32_t y_offset = 0, u_offset = 0, v_offset = 0;
+    size_t src_stride_y = 0, src_stride_u = 0, src_stride_v = 0;
+    if (getSrcYUVPlaneOffsetAndStride(src, &y_offset, &u_offset, &v_offset,
+            &src_stride_y, &src_stride_u, &src_stride_v) != OK) {
+        return ERROR_UNSUPPORTED;
+    }
+    const uint8_t *src_y = (const uint8_t *)src.mBits + y_offset;
+    const uint8_t *src_u = (const uint8_t *)src.mBits + u_offset;
+    const uint8_t *src_v = (const uint8_t *)src.mBits + v_offset;
+
+    uint8_t *kAdjustedClip = initClip();
+    auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip);
+
+    const size_t srcWidth = src.cropWidth();
+    const size_t srcHeight = src.cropHeight();
+    const size_t dstWidth = dst.cropWidth();
+    const size_t dstHeight = dst.cropHeight();
+
+    // Offsets of the samples of each src column, relative to the crop.
+    std::vector<uint32_t> yCol(srcWidth), uCol(srcWidth), vCol(srcWidth);
+    for (size_t x = 0; x < srcWidth; ++x) {
+        yCol[x] = x * yPlane.mColInc;
+        uCol[x] = ((src.mCropLeft + x) / uPlane.mHorizSubsampling
+                - src.mCropLeft / uPlane.mHorizSubsampling) * uPlane.mColInc;
+        vCol[x] = ((src.mCropLeft + x) / vPlane.mHorizSubsampling
+                - src.mCropLeft / vPlane.mHorizSubsampling) * vPlane.mColInc;
+    }
+    // dst column x averages the src columns [left[x], left[x + 1]).
+    std::vector<size_t> left(dstWidth + 1);
+    for (size_t x = 0; x <= dstWidth; ++x) {
+        left[x] = x * srcWidth / dstWidth;
+    }
+    // A box holds up to the whole crop, whose sums can overflow 32 bits.
+    std::vector<uint64_t> ySum(dstWidth), uSum(dstWidth), vSum(dstWidth);
+
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+            + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+
+    for (size_t y = 0; y < dstHeight; ++y) {
+        const size_t top = y * srcHeight / dstHeight;
+        const size_t bottom = (y + 1) * srcHeight / dstHeight;
+        std::fill(ySum.begin(), ySum.end(), 0);
+        std::fill(uSum.begin(), uSum.end(), 0);
+        std::fill(vSum.begin(), vSum.end(), 0);
+
+        for (size_t row = top; row < bottom; ++row) {
+            const uint8_t *row_y = src_y + row * src_stride_y;
+            const uint8_t *row_u = src_u + ((src.mCropTop + row) / uPlane.mVertSubsampling
+                    - src.mCropTop / uPlane.mVertSubsampling) * src_stride_u;
+            const uint8_t *row_v = src_v + ((src.mCropTop + row) / vPlane.mVertSubsampling
+                    - src.mCropTop / vPlane.mVertSubsampling) * src_stride_v;
+            for (size_t x = 0; x < dstWidth; ++x) {
+                uint32_t ys = 0, us = 0, vs = 0;
+                for (size_t col = left[x]; col < left[x + 1]; ++col) {
+                    ys += row_y[yCol[col]];
+                    us += row_u[uCol[col]];
+                    vs += row_v[vCol[col]];
+                }
+                ySum[x] += ys;
+                uSum[x] += us;
+                vSum[x] += vs;
+            }
+        }
+
+        for (size_t x = 0; x < dstWidth; ++x) {
+            const uint64_t count = (left[x + 1] - left[x]) * (bottom - top);
+            signed y1 = (signed)((ySum[x] + count / 2) / count);
+            signed u = (signed)((uSum[x] + count / 2) / count) - 128;
+            signed v = (signed)((vSum[x] + count / 2) / count) - 128;
+
+            signed u_b = u * _b_u;
+            signed u_g = u * _neg_g_u;
+            signed v_g = v * _neg_g_v;
+            signed v_r = v * _r_v;
+
+            y1 = y1 - _c16;
+            signed tmp1 = y1 * _y + 128;
+            signed b1 = (tmp1 + u_b) / 256;
+            signed g1 = (tmp1 + v_g + u_g) / 256;
+            signed r1 = (tmp1 + v_r) / 256;
+
+            writeToDst(dst_ptr + x * dst.mBpp, false, r1, g1, b1, 0, 0, 0);
+        }
+        dst_ptr += dst.mStride;
+    }
+    return OK;
+}
+
 status_t ColorConverter::convertYUV420Planar16(
         const BitmapParams &src, const BitmapParams &dst) {
     if (mDstFormat == OMX_COLOR_FormatYUV444Y410) {
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures ColorConverter across source formats and frame sizes, converting
+// on 1 to all online CPUs, and scaling 8-bit frames down to thumbnails. Before
+// measuring, each multi-threaded conversion is checked against the
+// single-threaded one.
+
+#include <string.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+
+using namespace android;
+
+static const struct {
+    const char *name;
+    OMX_COLOR_FORMATTYPE src;
+    OMX_COLOR_FORMATTYPE dst;
+    size_t srcBpp;  // bytes per luma sample
+    size_t dstBpp;
+} kConversions[] = {
+    {"I420-RGBA8888", OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888, 1, 4},
+    {"NV12-RGB565", OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format16bitRGB565, 1, 2},
+    {"NV21-BGRA8888", OMX_QCOM_COLOR_FormatYVU420SemiPlanar, OMX_COLOR_Format32bitBGRA8888, 1, 4},
+    {"I420P16-RGBA8888", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32BitRGBA8888, 2, 4},
+    {"I420P16-Y410", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410, 2, 4},
+    {"P010-RGBA1010102", (OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010,
+            (OMX_COLOR_FORMATTYPE)COLOR_Format32bitABGR2101010, 2, 4},
+};
+
+static const struct {
+    size_t width;
+    size_t height;
+} kSizes[] = {
+    {1920, 1080}, {3840, 2160}, {7680, 4320},
+};
+
+// 0 uses all online CPUs
+static const int kNumThreads[] = {1, 2, 4, 0};
+
+static void BM_ColorConverter(benchmark::State &state) {
+    const auto &conversion = kConversions[state.range(0)];
+    const size_t width = kSizes[state.range(1)].width;
+    const size_t height = kSizes[state.range(1)].height;
+    const size_t numThreads = state.range(2);
+    state.SetLabel(conversion.name);
+
+    const size_t srcStride = width * conversion.srcBpp;
+    std::vector<uint8_t> src(srcStride * height * 3 / 2);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = (i * 7 + i / srcStride) & 0xFF;
+    }
+    std::vector<uint8_t> dst(width * height * conversion.dstBpp);
+
+    ColorConverter converter(conversion.src, conversion.dst);
+    if (!converter.isValid()) {
+        state.SkipWithError("conversion not supported");
+        return;
+    }
+    auto convert = [&]() {
+        return converter.convert(
+                src.data(), width, height, srcStride, 0, 0, width - 1, height - 1,
+                dst.data(), width, height, 0, 0, 0, width - 1, height - 1);
+    };
+
+    if (numThreads != 1) {
+        converter.setNumThreads(1);
+        if (convert() != OK) {
+            state.SkipWithError("conversion failed");
+            return;
+        }
+        const std::vector<uint8_t> expected = dst;
+        memset(dst.data(), 0, dst.size());
+        converter.setNumThreads(numThreads);
+        if (convert() != OK || dst != expected) {
+            state.SkipWithError("multi-threaded conversion differs");
+            return;
+        }
+    }
+
+    converter.setNumThreads(numThreads);
+    for (auto _ : state) {
+        convert();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+static void ColorConverterArgs(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"conversion", "size", "threads"});
+    for (size_t conversion = 0; conversion < std::size(kConversions); ++conversion) {
+        for (size_t size = 0; size < std::size(kSizes); ++size) {
+            for (int numThreads : kNumThreads) {
+                b->Args({(int64_t)conversion, (int64_t)size, numThreads});
+            }
+        }
+    }
+}
+
+// Scales 8-bit frames down to thumbnails as they are converted.
+static void BM_ColorConverterScaled(benchmark::State &state) {
+    const auto &conversion = kConversions[state.range(0)];
+    const size_t width = kSizes[state.range(1)].width;
+    const size_t height = kSizes[state.range(1)].height;
+    const size_t dstWidth = state.range(2);
+    const size_t dstHeight = dstWidth * height / width;
+    state.SetLabel(conversion.name);
+
+    std::vector<uint8_t> src(width * height * 3 / 2);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = (i * 7 + i / width) & 0xFF;
+    }
+    std::vector<uint8_t> dst(dstWidth * dstHeight * conversion.dstBpp);
+
+    ColorConverter converter(conversion.src, conversion.dst);
+    if (!converter.isValid() || !converter.isScalingSupported()) {
+        state.SkipWithError("scaling not supported");
+        return;
+    }
+    for (auto _ : state) {
+        if (converter.convert(
+                src.data(), width, height, width, 0, 0, width - 1, height - 1,
+                dst.data(), dstWidth, dstHeight, 0, 0, 0, dstWidth - 1, dstHeight - 1) != OK) {
+            state.SkipWithError("conversion failed");
+            return;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+static void ColorConverterScaledArgs(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"conversion", "size", "dstWidth"});
+    for (size_t conversion = 0; conversion < std::size(kConversions); ++conversion) {
+        if (kConversions[conversion].srcBpp != 1) {
+            continue;
+        }
+        for (size_t size = 0; size < std::size(kSizes); ++size) {
+            for (int dstWidth : {160, 512}) {
+                b->Args({(int64_t)conversion, (int64_t)size, dstWidth});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(ColorConverterArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ColorConverterScaled)->Apply(ColorConverterScaledArgs)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the thumbnail scaling of ColorConverter, which box-filters the src
+// crop as it converts it, with a reference downscale: the planes are averaged
+// here, sampling the chroma of each luma pixel of the crop, and the result is
+// converted at its own size as a 4:4:4 image, which goes through the same
+// per-pixel arithmetic.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/MediaErrors.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kDstBpp = 4;
+constexpr size_t kDstBorder = 2;
+constexpr uint8_t kDstFill = 0xa5;
+
+enum Layout {
+    I420,   // OMX_COLOR_FormatYUV420Planar
+    NV21,   // COLOR_FormatYUV420Flexible, V and U interleaved
+};
+
+struct ScaleCase {
+    size_t width, height;
+    size_t cropLeft, cropTop, cropRight, cropBottom;
+    size_t dstWidth, dstHeight;
+};
+
+void PrintTo(const ScaleCase &c, std::ostream *os) {
+    *os << c.width << "x" << c.height << " crop (" << c.cropLeft << "," << c.cropTop << ")-("
+            << c.cropRight << "," << c.cropBottom << ") to " << c.dstWidth << "x" << c.dstHeight;
+}
+
+// A 4:2:0 frame of random samples.
+struct Frame {
+    size_t mWidth, mHeight;
+    std::vector<uint8_t> mBits;
+    MediaImage2 mImage;
+
+    Frame(Layout layout, size_t width, size_t height, uint32_t seed)
+        : mWidth(width), mHeight(height), mBits(width * height * 3 / 2), mImage() {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> sample(0, 255);
+        for (uint8_t &bits : mBits) {
+            bits = sample(rng);
+        }
+
+        mImage.mType = MediaImage2::MEDIA_IMAGE_TYPE_YUV;
+        mImage.mNumPlanes = 3;
+        mImage.mWidth = width;
+        mImage.mHeight = height;
+        mImage.mBitDepth = 8;
+        mImage.mBitDepthAllocated = 8;
+        MediaImage2::PlaneInfo &y = mImage.mPlane[MediaImage2::Y];
+        MediaImage2::PlaneInfo &u = mImage.mPlane[MediaImage2::U];
+        MediaImage2::PlaneInfo &v = mImage.mPlane[MediaImage2::V];
+        y = {0, 1, (int32_t)width, 1, 1};
+        if (layout == I420) {
+            u = {(uint32_t)(width * height), 1, (int32_t)width / 2, 2, 2};
+            v = {(uint32_t)(width * height * 5 / 4), 1, (int32_t)width / 2, 2, 2};
+        } else {
+            u = {(uint32_t)(width * height + 1), 2, (int32_t)width, 2, 2};
+            v = {(uint32_t)(width * height), 2, (int32_t)width, 2, 2};
+        }
+    }
+
+    // The sample of plane |index| for the luma pixel at (x, y) of the frame
+    uint8_t sample(MediaImage2::PlaneIndex index, size_t x, size_t y) const {
+        const MediaImage2::PlaneInfo &plane = mImage.mPlane[index];
+        return mBits[plane.mOffset + (y / plane.mVertSubsampling) * plane.mRowInc
+                + (x / plane.mHorizSubsampling) * plane.mColInc];
+    }
+};
+
+// An RGBA frame of the dst size, with a border around the crop that
+// conversions must not write.
+struct DstFrame {
+    size_t mWidth, mHeight, mStride;
+    std::vector<uint8_t> mBits;
+
+    DstFrame(size_t width, size_t height)
+        : mWidth(width + 2 * kDstBorder),
+          mHeight(height + 2 * kDstBorder),
+          mStride(mWidth * kDstBpp),
+          mBits(mStride * mHeight, kDstFill) {}
+
+    const uint8_t *pixel(size_t x, size_t y) const {
+        return mBits.data() + (y + kDstBorder) * mStride + (x + kDstBorder) * kDstBpp;
+    }
+
+    status_t convert(ColorConverter &converter, const void *srcBits,
+            size_t srcWidth, size_t srcHeight, size_t srcStride,
+            size_t cropLeft, size_t cropTop, size_t cropRight, size_t cropBottom) {
+        return converter.convert(srcBits, srcWidth, srcHeight, srcStride,
+                cropLeft, cropTop, cropRight, cropBottom,
+                mBits.data(), mWidth, mHeight, mStride,
+                kDstBorder, kDstBorder, mWidth - kDstBorder - 1, mHeight - kDstBorder - 1);
+    }
+};
+
+// Box-filters the crop of |frame| down to |dstWidth| x |dstHeight|, and
+// converts the result as a 4:4:4 image into |dst|.
+void referenceScale(const Frame &frame, const ScaleCase &c, DstFrame *dst) {
+    const size_t srcWidth = c.cropRight - c.cropLeft + 1;
+    const size_t srcHeight = c.cropBottom - c.cropTop + 1;
+    // the stride of a MediaImage2 source must be even
+    const size_t stride = (c.dstWidth + 1) & ~1;
+    const size_t planeSize = stride * c.dstHeight;
+    std::vector<uint8_t> bits(3 * planeSize);
+
+    for (size_t y = 0; y < c.dstHeight; ++y) {
+        const size_t top = y * srcHeight / c.dstHeight;
+        const size_t bottom = (y + 1) * srcHeight / c.dstHeight;
+        for (size_t x = 0; x < c.dstWidth; ++x) {
+            const size_t left = x * srcWidth / c.dstWidth;
+            const size_t right = (x + 1) * srcWidth / c.dstWidth;
+            uint64_t sums[3] = {0, 0, 0};
+            for (size_t row = top; row < bottom; ++row) {
+                for (size_t col = left; col < right; ++col) {
+                    for (uint32_t plane = MediaImage2::Y; plane <= MediaImage2::V; ++plane) {
+                        sums[plane] += frame.sample((MediaImage2::PlaneIndex)plane,
+                                c.cropLeft + col, c.cropTop + row);
+                    }
+                }
+            }
+            const uint64_t count = (right - left) * (bottom - top);
+            ASSERT_GT(count, 0u) << "empty box at " << x << "," << y;
+            for (uint32_t plane = MediaImage2::Y; plane <= MediaImage2::V; ++plane) {
+                bits[plane * planeSize + y * stride + x] = (sums[plane] + count / 2) / count;
+            }
+        }
+    }
+
+    MediaImage2 image = {};
+    image.mType = MediaImage2::MEDIA_IMAGE_TYPE_YUV;
+    image.mNumPlanes = 3;
+    image.mWidth = c.dstWidth;
+    image.mHeight = c.dstHeight;
+    image.mBitDepth = 8;
+    image.mBitDepthAllocated = 8;
+    for (uint32_t plane = MediaImage2::Y; plane <= MediaImage2::V; ++plane) {
+        image.mPlane[plane] = {(uint32_t)(plane * planeSize), 1, (int32_t)stride, 1, 1};
+    }
+    ColorConverter converter(
+            (OMX_COLOR_FORMATTYPE)COLOR_FormatYUV420Flexible, OMX_COLOR_Format32BitRGBA8888);
+    converter.setSrcMediaImage2(image);
+    ASSERT_TRUE(converter.isValid());
+    ASSERT_EQ(OK, dst->convert(converter, bits.data(), c.dstWidth, c.dstHeight, stride,
+            0, 0, c.dstWidth - 1, c.dstHeight - 1));
+}
+
+class ColorConverterScaleTest
+    : public ::testing::TestWithParam<std::tuple<Layout, ScaleCase>> {};
+
+TEST_P(ColorConverterScaleTest, MatchesReferenceDownscale) {
+    const Layout layout = std::get<0>(GetParam());
+    const ScaleCase &c = std::get<1>(GetParam());
+    const Frame frame(layout, c.width, c.height, c.width * 1000 + c.dstWidth);
+
+    std::unique_ptr<ColorConverter> converter;
+    if (layout == I420) {
+        converter.reset(new ColorConverter(
+                OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888));
+    } else {
+        converter.reset(new ColorConverter(
+                (OMX_COLOR_FORMATTYPE)COLOR_FormatYUV420Flexible,
+                OMX_COLOR_Format32BitRGBA8888));
+        converter->setSrcMediaImage2(frame.mImage);
+    }
+    ASSERT_TRUE(converter->isValid());
+    ASSERT_TRUE(converter->isScalingSupported());
+
+    DstFrame scaled(c.dstWidth, c.dstHeight);
+    ASSERT_EQ(OK, scaled.convert(*converter, frame.mBits.data(), c.width, c.height, c.width,
+            c.cropLeft, c.cropTop, c.cropRight, c.cropBottom));
+    DstFrame reference(c.dstWidth, c.dstHeight);
+    referenceScale(frame, c, &reference);
+    if (HasFatalFailure()) return;
+
+    for (size_t y = 0; y < scaled.mHeight; ++y) {
+        for (size_t x = 0; x < scaled.mWidth; ++x) {
+            const uint8_t *pixel = scaled.mBits.data() + y * scaled.mStride + x * kDstBpp;
+            const bool inCrop = x >= kDstBorder && x < scaled.mWidth - kDstBorder
+                    && y >= kDstBorder && y < scaled.mHeight - kDstBorder;
+            const uint8_t *expected = inCrop
+                    ? reference.pixel(x - kDstBorder, y - kDstBorder)
+                    : reference.mBits.data() + y * reference.mStride + x * kDstBpp;
+            ASSERT_EQ(0, memcmp(pixel, expected, kDstBpp))
+                    << (inCrop ? "pixel " : "border ") << x << "," << y << ": "
+                    << (int)pixel[0] << " " << (int)pixel[1] << " " << (int)pixel[2]
+                    << " instead of "
+                    << (int)expected[0] << " " << (int)expected[1] << " " << (int)expected[2];
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Scales, ColorConverterScaleTest,
+        ::testing::Combine(
+                ::testing::Values(I420, NV21),
+                ::testing::Values(
+                        // whole frames, by an integer and a fractional factor
+                        ScaleCase{64, 48, 0, 0, 63, 47, 32, 24},
+                        ScaleCase{64, 48, 0, 0, 63, 47, 21, 17},
+                        // an odd crop top, width and height, so that the crop
+                        // starts and ends on either row of a chroma sample
+                        ScaleCase{66, 50, 2, 1, 62, 47, 13, 11},
+                        ScaleCase{66, 50, 4, 3, 64, 49, 31, 23},
+                        // boxes of one and two columns and rows
+                        ScaleCase{30, 20, 4, 3, 28, 18, 25, 15},
+                        // scaled in one direction only
+                        ScaleCase{40, 30, 2, 5, 38, 29, 37, 9},
+                        ScaleCase{40, 30, 2, 5, 38, 29, 5, 25},
+                        // down to a single pixel
+                        ScaleCase{16, 16, 0, 0, 15, 15, 1, 1},
+                        ScaleCase{18, 14, 2, 1, 16, 12, 1, 1})));
+
+// A box of 32M bright pixels sums to more than 32 bits hold. Its average
+// matches that of a small frame of the same samples.
+TEST(ColorConverterScaleTest, LargeBox) {
+    constexpr size_t kWidth = 8192;
+    constexpr size_t kHeight = 4096;
+    std::vector<uint8_t> large(kWidth * kHeight * 3 / 2, 128);
+    memset(large.data(), 250, kWidth * kHeight);
+    std::vector<uint8_t> small(16 * 16 * 3 / 2, 128);
+    memset(small.data(), 250, 16 * 16);
+
+    ColorConverter converter(OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888);
+    ASSERT_TRUE(converter.isValid());
+    DstFrame scaled(1, 1);
+    ASSERT_EQ(OK, scaled.convert(converter, large.data(), kWidth, kHeight, kWidth,
+            0, 0, kWidth - 1, kHeight - 1));
+    // a converter keeps the plane layout of the first frame it converts
+    ColorConverter smallConverter(
+            OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888);
+    DstFrame expected(1, 1);
+    ASSERT_EQ(OK, expected.convert(smallConverter, small.data(), 16, 16, 16, 0, 0, 15, 15));
+    EXPECT_EQ(0, memcmp(expected.pixel(0, 0), scaled.pixel(0, 0), kDstBpp))
+            << (int)scaled.pixel(0, 0)[0] << " instead of " << (int)expected.pixel(0, 0)[0];
+}
+
+TEST(ColorConverterScaleTest, RejectsUpscaling) {
+    const Frame frame(I420, 32, 32, 1);
+    ColorConverter converter(OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888);
+    DstFrame dst(16, 40);
+    EXPECT_EQ(ERROR_UNSUPPORTED,
+            dst.convert(converter, frame.mBits.data(), 32, 32, 32, 0, 0, 31, 31));
+    // nothing written
+    for (uint8_t bits : dst.mBits) {
+        ASSERT_EQ(kDstFill, bits);
+    }
+}
+
+}  // namespace
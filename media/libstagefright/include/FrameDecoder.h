@@ -45,6 +45,12 @@ struct FrameDecoder : public RefBase {
             const sp<MetaData> &trackMeta,
             const sp<IMediaSource> &source);
 
+    // Asks for frames scaled down to fit within |width| x |height|, keeping
+    // their aspect ratio, as they are converted to the output color format.
+    // Must be called before init(). Frames that cannot be scaled while they
+    // are converted are extracted at their full size.
+    void setTargetSize(int32_t width, int32_t height);
+
     status_t init(int64_t frameTimeUs, int option, int colorFormat);
 
     sp<IMemory> extractFrame(FrameRect *rect = NULL);
@@ -82,6 +88,11 @@ protected:
     int32_t dstBpp()             const      { return mDstBpp; }
     void setFrame(const sp<IMemory> &frameMem) { mFrameMemory = frameMem; }
 
+    // Returns true and the size fitting the target size if a frame of
+    // |width| x |height| should be scaled down.
+    bool getScaledSize(int32_t width, int32_t height,
+            int32_t *scaledWidth, int32_t *scaledHeight) const;
+
 private:
     AString mComponentName;
     sp<MetaData> mTrackMeta;
@@ -89,6 +100,8 @@ private:
     OMX_COLOR_FORMATTYPE mDstFormat;
     ui::PixelFormat mCaptureFormat;
     int32_t mDstBpp;
+    int32_t mTargetWidth;
+    int32_t mTargetHeight;
     sp<IMemory> mFrameMemory;
     MediaSource::ReadOptions mReadOptions;
     sp<MediaCodec> mDecoder;
@@ -42,6 +42,17 @@ struct ColorConverter {
 
     void setSrcColorSpace(uint32_t standard, uint32_t range, uint32_t transfer);
 
+    // Splits conversions of frames of at least a megapixel into bands of rows,
+    // converted in parallel by up to |numThreads| threads including the calling
+    // thread, which are started for each conversion. 0 uses one thread per
+    // online CPU. Conversions are single-threaded by default.
+    void setNumThreads(size_t numThreads);
+
+    // Returns true if convert() can scale the src crop down to a smaller dst
+    // crop, averaging the src pixels under each dst pixel as it converts them.
+    // Otherwise the crops must be the same size.
+    bool isScalingSupported() const;
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight, size_t srcStride,
@@ -166,6 +177,7 @@ private:
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
     uint16_t *mClip10Bit;
+    size_t mNumThreads;
 
     uint8_t *initClip();
     uint16_t *initClip10Bit();
@@ -173,6 +185,12 @@ private:
     // resolve YUVFormat from YUV420Flexible
     bool isValidForMediaImage2() const;
 
+    // converts the rows of the src crop, which may be a band of the frame
+    status_t convertRows(const BitmapParams &src, const BitmapParams &dst);
+
+    // splits the conversion into bands of rows converted in parallel
+    status_t convertInBands(const BitmapParams &src, const BitmapParams &dst);
+
     // get plane offsets from Formats
     status_t getSrcYUVPlaneOffsetAndStride(
             const BitmapParams &src,
@@ -186,6 +204,10 @@ private:
     status_t convertYUVMediaImage(
         const BitmapParams &src, const BitmapParams &dst);
 
+    // box-filters the src crop down to the dst crop while converting it
+    status_t convertYUVMediaImageScaled(
+        const BitmapParams &src, const BitmapParams &dst);
+
     // returns the YUV2RGB matrix coefficients according to the color aspects and bit depth
     const struct Coeffs *getMatrix() const;
 
@@ -19,15 +19,20 @@
 #define MPEG4_WRITER_H_
 
 #include <stdio.h>
+#include <sys/uio.h>
 
 #include <media/stagefright/MediaWriter.h>
 #include <utils/List.h>
 #include <utils/threads.h>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <mutex>
 #include <queue>
+#include <thread>
+#include <vector>
 
 namespace android {
 
@@ -63,6 +68,8 @@ public:
     inline size_t write(const void *ptr, size_t size, size_t nmemb);
     // Write to file system by calling ::write() or post error message to looper on failure.
     void writeOrPostError(int fd, const void *buf, size_t count);
+    // Write to file system by calling ::writev() or post error message to looper on failure.
+    void writevOrPostError(int fd, const struct iovec *iov, int iovcnt);
     // Seek in the file by calling ::lseek64() or post error message to looper on failure.
     void seekOrPostError(int fd, off64_t offset, int whence);
     void endBox();
@@ -134,6 +141,24 @@ private:
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
 
+    // Sample data queued by addSample_l() to be written with a single writev().
+    std::vector<struct iovec> mPendingWrites;
+    // Storage for the exif tiff header offsets referenced by mPendingWrites.
+    std::deque<uint32_t> mPendingTiffHdrOffsets;
+
+    // Background fdatasync() of the written data, so that the page cache
+    // does not build up into a long stall at the final fsync(), or in the
+    // middle of the recording when the kernel starts the writeback itself.
+    std::thread mDataSyncThread;
+    std::mutex mDataSyncLock;
+    std::condition_variable mDataSyncCondition;
+    bool mDataSyncThreadStarted;
+    bool mDataSyncPending;
+    bool mDataSyncDone;
+    uint64_t mBytesSinceDataSync;
+    uint32_t mNumDataSyncs;
+    std::chrono::microseconds mMaxDataSyncDuration;
+
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
 
@@ -264,6 +289,14 @@ private:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Background data sync handling
+    void startDataSyncThread();
+    void stopDataSyncThread();
+    void dataSyncThread();
+    // Account for |bytes| written, and wake up the data sync thread once
+    // enough data has been written since the last sync.
+    void onDataWritten(size_t bytes);
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -294,11 +327,11 @@ private:
     void initInternal(int fd, bool isFirstSession);
 
     // Acquire lock before calling these methods
+    // The sample data may only be queued to be written. The buffer must be
+    // kept until flushPendingWrites_l() is called.
     off64_t addSample_l(
-            MediaBuffer *buffer, bool usePrefix,
-            uint32_t tiffHdrOffset, size_t *bytesWritten);
-    void addLengthPrefixedSample_l(MediaBuffer *buffer);
-    void addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer);
+            MediaBuffer *buffer, uint32_t tiffHdrOffset, size_t *bytesWritten);
+    void flushPendingWrites_l();
     uint16_t addProperty_l(const ItemProperty &);
     status_t reserveItemId_l(size_t numItems, uint16_t *itemIdBase);
     uint16_t addItem_l(const ItemInfo &);
@@ -19,6 +19,7 @@
 #define MEDIA_BUFFER_GROUP_H_
 
 #include <list>
+#include <string>
 
 #include <media/MediaExtractorPluginApi.h>
 #include <media/NdkMediaErrorPriv.h>
@@ -43,6 +44,10 @@ public:
 
     bool has_buffers();
 
+    // Adds up to |buffers| buffers of |buffer_size| bytes, within the growth
+    // limit, so that acquiring buffers of up to that size does not allocate.
+    void prewarm(size_t buffers, size_t buffer_size);
+
     // If nonBlocking is false, it blocks until a buffer is available and
     // passes it to the caller in *buffer, while returning OK.
     // The returned buffer will have a reference count of 1.
@@ -56,6 +61,9 @@ public:
 
     size_t buffers() const;
 
+    // Appends the buffer counts and acquire statistics of the group to |out|.
+    void dump(std::string *out) const;
+
     // If buffer is nullptr, have acquire_buffer() check for remote release.
     virtual void signalBufferReturned(MediaBufferBase *buffer);
 
@@ -107,6 +115,8 @@ private:
     MediaBufferGroup(const MediaBufferGroup &);
     MediaBufferGroup &operator=(const MediaBufferGroup &);
     void init(size_t buffers, size_t buffer_size, size_t growthLimit);
+    // Takes a reference to |buffer| for the caller of acquire_buffer().
+    void acquired(MediaBufferBase *buffer);
 };
 
 }  // namespace android
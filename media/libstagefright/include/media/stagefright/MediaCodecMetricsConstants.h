@@ -25,6 +25,10 @@ namespace android {
 // NB: These are not yet exposed as public Java API constants.
 inline constexpr char kCodecPixelFormat[] =
         "android.media.mediacodec.pixel-format";
+// Per-stage frame latencies in us, reported when frame latency tracking is
+// enabled. Keys are <prefix><stage>.{n,p50,p90,p99,max}.
+inline constexpr char kCodecFrameLatencyPrefix[] =
+        "android.media.mediacodec.frame-latency.";
 
 }
 
@@ -19,6 +19,7 @@
 #define MEDIA_EXTRACTOR_FACTORY_H_
 
 #include <stdio.h>
+#include <atomic>
 #include <unordered_set>
 
 #include <android/dlext.h>
@@ -39,11 +40,20 @@ public:
     static std::vector<std::string> getSupportedTypes();
     static void LoadExtractors();
 
+    // Sniffing evaluates all extractor plugins against a source. When parallel, plugins
+    // sniffing a local file run concurrently on a small pool of threads, against a copy of
+    // the start of the file that is read once; otherwise, one after the other on the source
+    // itself. Network sources are always sniffed one plugin after the other. Defaults to the
+    // value of the media.stagefright.extractor.parallel_sniff property (true) once
+    // extractors are loaded.
+    static void SetParallelSniffing(bool parallel);
+
 private:
     static Mutex gPluginMutex;
     static std::shared_ptr<std::list<sp<ExtractorPlugin>>> gPlugins;
     static bool gPluginsRegistered;
     static bool gIgnoreVersion;
+    static std::atomic<bool> gParallelSniffing;
 
     static void RegisterExtractors(
             const char *libDirPath, const android_dlextinfo* dlextinfo,
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the time from a data source to an extractor for each container
+// type, with the extractor plugins sniffed one after the other or
+// concurrently, and with a per-read latency emulating slower sources such as
+// FUSE or network backed files.
+//
+// Uses the resource files of ExtractorFactoryTest, by default from
+// /data/local/tmp/; pass --res=<directory> to use another location.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <datasource/FileSource.h>
+#include <media/stagefright/MediaExtractorFactory.h>
+#include <utils/String8.h>
+
+using namespace android;
+
+static const char *kInputFiles[] = {
+    "loudsoftaac.aac", "testamr.amr", "amrwb.wav", "john_cage.ogg", "monotestgsm.wav",
+    "segment000001.ts", "sinesweepflac.flac", "testopus.opus", "midi_a.mid",
+    "sinesweepvorbis.mkv", "sinesweepoggmp4.mp4", "sinesweepmp3lame.mp3",
+    "swirl_144x136_vp9.webm", "swirl_144x136_vp8.webm", "swirl_132x130_mpeg4.mp4",
+};
+
+static std::string gRes = "/data/local/tmp/";
+
+// Adds a fixed latency to every read of the wrapped source.
+class SlowSource : public DataSource {
+public:
+    SlowSource(const sp<DataSource> &source, useconds_t latencyUs)
+        : mSource(source),
+          mLatencyUs(latencyUs) {
+    }
+
+    virtual status_t initCheck() const {
+        return mSource->initCheck();
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        if (mLatencyUs > 0) {
+            usleep(mLatencyUs);
+        }
+        return mSource->readAt(offset, data, size);
+    }
+
+    virtual status_t getSize(off64_t *size) {
+        return mSource->getSize(size);
+    }
+
+    virtual uint32_t flags() {
+        return mSource->flags();
+    }
+
+private:
+    sp<DataSource> mSource;
+    useconds_t mLatencyUs;
+};
+
+// Arguments: the read latency in us, and whether sniffing is parallel.
+static void BM_CreateExtractor(benchmark::State &state, const char *fileName) {
+    const std::string path = gRes + fileName;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        state.SkipWithError(("Unable to open " + path).c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    MediaExtractorFactory::LoadExtractors();
+    MediaExtractorFactory::SetParallelSniffing(state.range(1) != 0);
+    for (auto _ : state) {
+        sp<DataSource> source =
+                new SlowSource(new FileSource(dup(fd), 0, st.st_size), state.range(0));
+        sp<IMediaExtractor> extractor = MediaExtractorFactory::CreateFromService(source);
+        if (extractor == nullptr) {
+            state.SkipWithError(("No extractor for " + path).c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(extractor);
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    for (int i = 1; i < argc; ++i) {
+        if (!strncmp(argv[i], "--res=", 6)) {
+            gRes = argv[i] + 6;
+            if (!gRes.empty() && gRes.back() != '/') {
+                gRes += '/';
+            }
+        }
+    }
+
+    for (const char *fileName : kInputFiles) {
+        benchmark::RegisterBenchmark(fileName, BM_CreateExtractor, fileName)
+                ->ArgNames({"latencyUs", "parallel"})
+                ->ArgsProduct({{0, 200, 2000}, {0, 1}})
+                ->Unit(benchmark::kMicrosecond)
+                ->UseRealTime();
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
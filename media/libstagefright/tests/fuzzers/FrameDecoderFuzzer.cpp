@@ -59,6 +59,10 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     } else {
         decoder = sp<VideoFrameDecoder>::make(componentName, trackMeta, source);
     }
+    if (decoder.get() && fdp.ConsumeBool()) {
+        decoder->setTargetSize(fdp.ConsumeIntegral<uint16_t>() /* width */,
+                               fdp.ConsumeIntegral<uint16_t>() /* height */);
+    }
 
     if (decoder.get() &&
         decoder->init(fdp.ConsumeIntegral<uint64_t>() /* frameTimeUs */,
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the sustained bitrate of MPEG4Writer for a synthetic high bitrate
+// AVC track and an AMR audio track, and the longest time a producer is
+// blocked while pushing a sample, which is what backs up into the encoders.
+//
+// The output goes either to a memfd, i.e. tmpfs, or to a file opened with
+// O_SYNC under /data/local/tmp, where every write waits for the storage.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+#include <media/mediarecorder.h>
+#include <media/stagefright/MediaAdapter.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/MPEG4Writer.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+
+using namespace android;
+
+static constexpr int32_t kFrameRate = 30;
+static constexpr int32_t kNumVideoFrames = 300;
+static constexpr int32_t kSyncFrameInterval = 30;
+static constexpr int32_t kSlicesPerFrame = 4;
+// 20 ms AMR-NB frames
+static constexpr int64_t kAudioFrameDurationUs = 20000;
+static constexpr size_t kAudioFrameSize = 32;
+static constexpr const char *kThrottledFile = "/data/local/tmp/MPEG4WriterBenchmark.mp4";
+
+// Baseline profile SPS and PPS.
+static const uint8_t kAvcc[] = {
+    0x01, 0x42, 0x00, 0x1e, 0xff, 0xe1,
+    0x00, 0x09, 0x67, 0x42, 0x00, 0x1e, 0x95, 0xa8, 0x28, 0x0f, 0x64,
+    0x01,
+    0x00, 0x04, 0x68, 0xce, 0x38, 0x80,
+};
+
+// Returns an Annex B access unit of |size| bytes made of kSlicesPerFrame NAL units.
+static sp<ABuffer> makeAccessUnit(size_t size, bool sync) {
+    sp<ABuffer> buffer = new ABuffer(size);
+    uint8_t *data = buffer->data();
+    // payload without start code emulation
+    memset(data, 0xa5, size);
+    const size_t sliceSize = size / kSlicesPerFrame;
+    for (int32_t i = 0; i < kSlicesPerFrame; ++i) {
+        uint8_t *slice = data + i * sliceSize;
+        slice[0] = 0x00;
+        slice[1] = 0x00;
+        slice[2] = 0x00;
+        slice[3] = 0x01;
+        slice[4] = sync ? 0x65 : 0x41;
+    }
+    return buffer;
+}
+
+// Pushes a sample with the contents of |payload|, and returns how long the
+// call was blocked.
+static std::chrono::microseconds pushSample(
+        const sp<MediaAdapter> &track, const sp<ABuffer> &payload, int64_t timeUs, bool sync) {
+    MediaBuffer *buffer = new MediaBuffer(payload);
+    // Released in MediaAdapter::signalBufferReturned().
+    buffer->add_ref();
+    buffer->set_range(0, payload->size());
+    buffer->meta_data().setInt64(kKeyTime, timeUs);
+    buffer->meta_data().setInt64(kKeyDecodingTime, timeUs);
+    if (sync) {
+        buffer->meta_data().setInt32(kKeyIsSyncFrame, true);
+    }
+    auto start = std::chrono::steady_clock::now();
+    CHECK_EQ(track->pushBuffer(buffer), (status_t)OK);
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+}
+
+static int openOutput(bool throttled) {
+    if (throttled) {
+        return open(kThrottledFile, O_CREAT | O_TRUNC | O_RDWR | O_SYNC, S_IRUSR | S_IWUSR);
+    }
+    return memfd_create("MPEG4WriterBenchmark", 0);
+}
+
+// range(0): 1 to write to the throttled file, 0 to write to tmpfs
+// range(1): video bitrate in Mbps
+static void BM_MPEG4Writer(benchmark::State &state) {
+    const bool throttled = state.range(0) != 0;
+    const size_t frameSize = state.range(1) * 1000000 / 8 / kFrameRate;
+    const sp<ABuffer> syncFrame = makeAccessUnit(frameSize, true);
+    const sp<ABuffer> frame = makeAccessUnit(frameSize, false);
+    const sp<ABuffer> audioFrame = new ABuffer(kAudioFrameSize);
+    memset(audioFrame->data(), 0x3c, kAudioFrameSize);
+
+    std::chrono::microseconds maxStall = std::chrono::microseconds::zero();
+    int64_t totalBytes = 0;
+    for (auto _ : state) {
+        int fd = openOutput(throttled);
+        if (fd < 0) {
+            state.SkipWithError("failed to open the output");
+            return;
+        }
+
+        sp<MetaData> videoMeta = new MetaData;
+        videoMeta->setCString(kKeyMIMEType, MEDIA_MIMETYPE_VIDEO_AVC);
+        videoMeta->setInt32(kKeyWidth, 7680);
+        videoMeta->setInt32(kKeyHeight, 4320);
+        videoMeta->setData(kKeyAVCC, kTypeAVCC, kAvcc, sizeof(kAvcc));
+        sp<MediaAdapter> video = new MediaAdapter(videoMeta);
+
+        sp<MetaData> audioMeta = new MetaData;
+        audioMeta->setCString(kKeyMIMEType, MEDIA_MIMETYPE_AUDIO_AMR_NB);
+        audioMeta->setInt32(kKeySampleRate, 8000);
+        audioMeta->setInt32(kKeyChannelCount, 1);
+        sp<MediaAdapter> audio = new MediaAdapter(audioMeta);
+
+        sp<MPEG4Writer> writer = new MPEG4Writer(fd);
+        CHECK_EQ(writer->addSource(video), (status_t)OK);
+        CHECK_EQ(writer->addSource(audio), (status_t)OK);
+        sp<MetaData> fileMeta = new MetaData;
+        fileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_MPEG_4);
+        CHECK_EQ(writer->start(fileMeta.get()), (status_t)OK);
+
+        int64_t audioTimeUs = 0;
+        for (int32_t i = 0; i < kNumVideoFrames; ++i) {
+            const int64_t timeUs = int64_t(i) * 1000000 / kFrameRate;
+            const bool sync = (i % kSyncFrameInterval) == 0;
+            maxStall = std::max(maxStall,
+                                pushSample(video, sync ? syncFrame : frame, timeUs, sync));
+            for (; audioTimeUs <= timeUs; audioTimeUs += kAudioFrameDurationUs) {
+                maxStall = std::max(maxStall, pushSample(audio, audioFrame, audioTimeUs, true));
+            }
+            totalBytes += frameSize;
+        }
+        video->stop();
+        audio->stop();
+        CHECK_EQ(writer->stop(), (status_t)OK);
+        close(fd);
+    }
+    if (throttled) {
+        unlink(kThrottledFile);
+    }
+
+    state.SetBytesProcessed(totalBytes);
+    state.counters["max_stall_ms"] = maxStall.count() / 1000.0;
+}
+
+BENCHMARK(BM_MPEG4Writer)
+        ->ArgNames({"throttled", "mbps"})
+        ->ArgsProduct({{0, 1}, {50, 200}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ExtractorIndexCache"
+#include <utils/Log.h>
+
+#include "ExtractorIndexCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+
+#include <media/stagefright/DataSourceBase.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/MediaErrors.h>
+
+namespace android {
+
+namespace {
+
+const uint32_t kMagic = FOURCC("xidx");
+// Bump whenever the layout of the entry or of any section changes.
+const uint32_t kVersion = 2;
+
+// The entry is written in native byte order; it never leaves the device.
+struct EntryHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint8_t mIdentity[48];
+    uint32_t mNumSections;
+    uint32_t mReserved;
+    uint64_t mChecksum;     // of everything following the header
+};
+
+struct SectionHeader {
+    uint32_t mType;
+    uint32_t mId;
+    uint64_t mOffset;       // from the start of the entry, 8-byte aligned
+    uint64_t mSize;
+};
+
+static_assert(sizeof(EntryHeader) == 72, "unexpected EntryHeader layout");
+static_assert(sizeof(SectionHeader) == 24, "unexpected SectionHeader layout");
+
+const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+const uint64_t kFnvPrime = 0x100000001b3ull;
+
+__attribute__((no_sanitize("integer")))
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash = kFnvOffsetBasis) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+size_t alignUp(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+Mutex gDirectoryLock;
+String8 *gDirectory = NULL;     // set by SetDirectory(), overrides the property
+
+String8 getDirectory() {
+    Mutex::Autolock autoLock(gDirectoryLock);
+    return gDirectory != NULL ? *gDirectory : String8();
+}
+
+// Gets the status of the file behind |source|, if it has a local path.
+bool statSource(DataSourceHelper *source, struct stat *st) {
+    char uri[PATH_MAX];
+    if (!source->getUri(uri, sizeof(uri))) {
+        return false;
+    }
+    const char *path = uri;
+    if (!strncasecmp(path, "file://", 7)) {
+        path += 7;
+    }
+    return path[0] == '/' && stat(path, st) == 0 && S_ISREG(st->st_mode);
+}
+
+}  // namespace
+
+// static
+void ExtractorIndexCache::SetDirectory(const char *path) {
+    Mutex::Autolock autoLock(gDirectoryLock);
+    if (gDirectory == NULL) {
+        gDirectory = new String8();
+    }
+    gDirectory->setTo(path != NULL ? path : "");
+}
+
+// static
+sp<ExtractorIndexCache> ExtractorIndexCache::Open(DataSourceHelper *source, uint32_t format) {
+    const String8 directory = getDirectory();
+    if (directory.empty()) {
+        return NULL;
+    }
+
+    off64_t fileSize;
+    if ((source->flags() & (DataSourceBase::kIsHTTPBasedSource
+                | DataSourceBase::kIsCachingDataSource))
+            || source->getSize(&fileSize) != OK || fileSize <= 0) {
+        return NULL;
+    }
+
+    // Without the status of the file, an edit that keeps its size and both
+    // ends would go unnoticed.
+    struct stat st;
+    if (!statSource(source, &st) || st.st_size != fileSize) {
+        ALOGV("cannot identify the file of the source, not cached");
+        return NULL;
+    }
+
+    static_assert(sizeof(Identity) == sizeof(EntryHeader::mIdentity),
+            "Identity does not fit EntryHeader");
+    Identity identity;
+    memset(&identity, 0, sizeof(identity));
+    identity.mFormat = format;
+    identity.mFileSize = fileSize;
+    identity.mMtimeNs = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    identity.mDevice = st.st_dev;
+    identity.mInode = st.st_ino;
+
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[kIdentityBytes]);
+    if (buffer == NULL) {
+        return NULL;
+    }
+    const size_t headSize = fileSize < (off64_t)kIdentityBytes ? fileSize : kIdentityBytes;
+    if (source->readAt(0, buffer.get(), headSize) != (ssize_t)headSize) {
+        return NULL;
+    }
+    uint64_t hash = hashBytes(buffer.get(), headSize);
+    if (fileSize > (off64_t)kIdentityBytes) {
+        const size_t tailSize = fileSize - kIdentityBytes < (off64_t)kIdentityBytes
+                ? fileSize - kIdentityBytes : kIdentityBytes;
+        if (source->readAt(fileSize - tailSize, buffer.get(), tailSize) != (ssize_t)tailSize) {
+            return NULL;
+        }
+        hash = hashBytes(buffer.get(), tailSize, hash);
+    }
+    identity.mContentHash = hash;
+
+    const String8 path = String8::format("%s/%08x-%016" PRIx64 ".idx",
+            directory.c_str(), format, hashBytes(&identity, sizeof(identity)));
+
+    sp<ExtractorIndexCache> cache = new ExtractorIndexCache(identity, path);
+    cache->mapEntry();
+    return cache;
+}
+
+ExtractorIndexCache::ExtractorIndexCache(const Identity &identity, const String8 &path)
+    : mIdentity(identity),
+      mPath(path),
+      mMapping(NULL),
+      mMappingSize(0) {
+}
+
+ExtractorIndexCache::~ExtractorIndexCache() {
+    if (mMapping != NULL) {
+        munmap(mMapping, mMappingSize);
+        mMapping = NULL;
+    }
+}
+
+void ExtractorIndexCache::mapEntry() {
+    int fd = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGV("no index cache entry %s", mPath.c_str());
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(EntryHeader)
+            || (uint64_t)st.st_size > kMaxEntrySize) {
+        close(fd);
+        return;
+    }
+    const size_t size = st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        ALOGW("cannot map index cache entry %s: %s", mPath.c_str(), strerror(errno));
+        return;
+    }
+
+    const uint8_t *base = (const uint8_t *)mapping;
+    const EntryHeader *header = (const EntryHeader *)base;
+    const uint64_t tableSize = (uint64_t)header->mNumSections * sizeof(SectionHeader);
+    bool valid = header->mMagic == kMagic
+            && header->mVersion == kVersion
+            && memcmp(header->mIdentity, &mIdentity, sizeof(mIdentity)) == 0
+            && tableSize <= size - sizeof(EntryHeader)
+            && header->mChecksum == hashBytes(base + sizeof(EntryHeader),
+                    size - sizeof(EntryHeader));
+
+    std::map<SectionKey, std::pair<const void *, size_t>> sections;
+    const SectionHeader *table = (const SectionHeader *)(base + sizeof(EntryHeader));
+    for (uint32_t i = 0; valid && i < header->mNumSections; ++i) {
+        const SectionHeader &section = table[i];
+        if (section.mOffset % 8 != 0
+                || section.mOffset < sizeof(EntryHeader) + tableSize
+                || section.mOffset > size
+                || section.mSize > size - section.mOffset) {
+            valid = false;
+            break;
+        }
+        sections[SectionKey(section.mType, section.mId)] =
+                std::make_pair(base + section.mOffset, (size_t)section.mSize);
+    }
+
+    if (!valid) {
+        // Stale or damaged; it is replaced on the next store().
+        ALOGW("ignoring invalid index cache entry %s", mPath.c_str());
+        munmap(mapping, size);
+        return;
+    }
+
+    ALOGV("mapped index cache entry %s with %zu sections", mPath.c_str(), sections.size());
+    mMapping = mapping;
+    mMappingSize = size;
+    mSections.swap(sections);
+}
+
+bool ExtractorIndexCache::find(
+        uint32_t type, uint32_t id, const void **data, size_t *size) const {
+    Mutex::Autolock autoLock(mLock);
+    auto it = mSections.find(SectionKey(type, id));
+    if (it == mSections.end()) {
+        return false;
+    }
+    *data = it->second.first;
+    *size = it->second.second;
+    return true;
+}
+
+status_t ExtractorIndexCache::store(uint32_t type, uint32_t id, const void *data, size_t size) {
+    if (size > kMaxEntrySize) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    Mutex::Autolock autoLock(mLock);
+    mStorage.emplace_back(alignUp(size) / 8);
+    std::vector<uint64_t> &copy = mStorage.back();
+    if (size > 0) {
+        memcpy(copy.data(), data, size);
+    }
+    mSections[SectionKey(type, id)] = std::make_pair(copy.data(), size);
+    return writeEntry();
+}
+
+status_t ExtractorIndexCache::writeEntry() {
+    // Lay out the header, the section table, then each section 8-byte aligned.
+    uint64_t entrySize = sizeof(EntryHeader) + mSections.size() * sizeof(SectionHeader);
+    for (const auto &section : mSections) {
+        entrySize += alignUp(section.second.second);
+    }
+    if (entrySize > kMaxEntrySize) {
+        ALOGW("index cache entry would be too large (%" PRIu64 " bytes)", entrySize);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    std::vector<uint8_t> entry(entrySize, 0);
+    EntryHeader *header = (EntryHeader *)entry.data();
+    header->mMagic = kMagic;
+    header->mVersion = kVersion;
+    memcpy(header->mIdentity, &mIdentity, sizeof(mIdentity));
+    header->mNumSections = mSections.size();
+
+    SectionHeader *table = (SectionHeader *)(entry.data() + sizeof(EntryHeader));
+    uint64_t offset = sizeof(EntryHeader) + mSections.size() * sizeof(SectionHeader);
+    for (const auto &section : mSections) {
+        table->mType = section.first.first;
+        table->mId = section.first.second;
+        table->mOffset = offset;
+        table->mSize = section.second.second;
+        if (section.second.second > 0) {
+            memcpy(entry.data() + offset, section.second.first, section.second.second);
+        }
+        offset += alignUp(section.second.second);
+        ++table;
+    }
+    header->mChecksum = hashBytes(entry.data() + sizeof(EntryHeader),
+            entry.size() - sizeof(EntryHeader));
+
+    // Write a private file and rename it over the entry, so that readers
+    // only ever see complete entries.
+    static std::atomic<uint32_t> sTempCounter(0);
+    const String8 tempPath = String8::format("%s.%d.%u.tmp",
+            mPath.c_str(), getpid(), sTempCounter.fetch_add(1));
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        ALOGW("cannot create %s: %s", tempPath.c_str(), strerror(errno));
+        return -errno;
+    }
+    size_t written = 0;
+    while (written < entry.size()) {
+        const ssize_t n = ::write(fd, entry.data() + written, entry.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += n;
+    }
+    const bool ok = close(fd) == 0 && written == entry.size();
+    if (!ok || rename(tempPath.c_str(), mPath.c_str()) != 0) {
+        ALOGW("cannot write index cache entry %s: %s", mPath.c_str(), strerror(errno));
+        unlink(tempPath.c_str());
+        return UNKNOWN_ERROR;
+    }
+    ALOGV("wrote index cache entry %s (%zu bytes)", mPath.c_str(), entry.size());
+    return OK;
+}
+
+}  // namespace android
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EXTRACTOR_INDEX_CACHE_H_
+
+#define EXTRACTOR_INDEX_CACHE_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <utils/RefBase.h>
+#include <utils/String8.h>
+#include <utils/threads.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// An optional, persistent cache of the seek indexes an extractor derives
+// from a file (e.g. the presentation order of an MP4 track, or the cluster
+// positions of a Matroska file without Cues), so that they need not be
+// rebuilt every time the same file is opened.
+//
+// Each file has at most one cache entry, named after and validated against
+// the identity of the file: its size, modification time, device and inode,
+// and a hash of its first and last kIdentityBytes. Only sources exposing the
+// local path of their file can be identified, so sources opened from a file
+// descriptor are not cached. An entry is a versioned file of typed sections
+// that is mapped read-only, so cached sections are used in place.
+//
+// The cache is disabled unless the process sets a directory with
+// SetDirectory(). Entries are written from the calling process, so it is
+// not enabled in media.extractor, whose seccomp policy does not allow the
+// writes. Stale entries are never used; removing old entries is left to the
+// owner of the directory.
+class ExtractorIndexCache : public RefBase {
+public:
+    // Bytes hashed at each end of the file to identify it.
+    static const size_t kIdentityBytes = 64 * 1024;
+
+    // Entries larger than this are neither written nor mapped.
+    static const size_t kMaxEntrySize = 32 * 1024 * 1024;
+
+    // Returns the cache for the file behind |source|, or NULL if the cache is
+    // disabled or the file cannot be identified. |format| is a fourcc that
+    // distinguishes entries written by different extractors for one file.
+    static sp<ExtractorIndexCache> Open(DataSourceHelper *source, uint32_t format);
+
+    // Overrides the cache directory; NULL or "" disables the cache.
+    static void SetDirectory(const char *path);
+
+    // Looks up section (|type|, |id|). On success, |*data| remains valid for
+    // the lifetime of this object and is aligned to 8 bytes.
+    bool find(uint32_t type, uint32_t id, const void **data, size_t *size) const;
+
+    // Adds or replaces section (|type|, |id|) and rewrites the cache entry.
+    status_t store(uint32_t type, uint32_t id, const void *data, size_t size);
+
+protected:
+    virtual ~ExtractorIndexCache();
+
+private:
+    struct Identity {
+        uint32_t mFormat;
+        uint32_t mReserved;
+        uint64_t mFileSize;
+        int64_t mMtimeNs;
+        uint64_t mDevice;
+        uint64_t mInode;
+        uint64_t mContentHash;
+    };
+
+    typedef std::pair<uint32_t, uint32_t> SectionKey;
+
+    mutable Mutex mLock;
+    Identity mIdentity;
+    String8 mPath;
+
+    // the mapped entry, if a valid one was found for this file
+    void *mMapping;
+    size_t mMappingSize;
+
+    // copies of the sections stored since; never resized once added, so
+    // pointers into them stay valid
+    std::list<std::vector<uint64_t>> mStorage;
+
+    // all sections, pointing into mMapping or mStorage
+    std::map<SectionKey, std::pair<const void *, size_t>> mSections;
+
+    ExtractorIndexCache(const Identity &identity, const String8 &path);
+
+    void mapEntry();
+    status_t writeEntry();
+
+    ExtractorIndexCache(const ExtractorIndexCache &);
+    ExtractorIndexCache &operator=(const ExtractorIndexCache &);
+};
+
+}  // namespace android
+
+#endif  // EXTRACTOR_INDEX_CACHE_H_
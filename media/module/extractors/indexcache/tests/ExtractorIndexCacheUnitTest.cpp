@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <ExtractorIndexCache.h>
+#include <gtest/gtest.h>
+#include <media/stagefright/DataSourceBase.h>
+
+namespace {
+
+using android::DataSourceBase;
+using android::DataSourceHelper;
+using android::ExtractorIndexCache;
+using android::OK;
+using android::sp;
+
+const uint32_t kFormat = 0x74657374;    // 'test'
+const uint32_t kSection = 0x73656374;   // 'sect'
+
+// A CDataSource reading from memory, exposing the path of a file with the
+// same size. The cache identifies the source through the status of that file.
+struct MemorySource {
+    std::vector<uint8_t> mData;
+    uint32_t mFlags = DataSourceBase::kIsLocalFileSource;
+    std::string mPath;
+    struct timespec mMtime = {1000000000, 0};
+
+    static ssize_t ReadAt(void *handle, off64_t offset, void *data, size_t size) {
+        const MemorySource *source = (const MemorySource *)handle;
+        if (offset < 0 || (size_t)offset >= source->mData.size()) {
+            return 0;
+        }
+        size = std::min(size, source->mData.size() - (size_t)offset);
+        memcpy(data, source->mData.data() + offset, size);
+        return size;
+    }
+    static android::status_t GetSize(void *handle, off64_t *size) {
+        *size = ((const MemorySource *)handle)->mData.size();
+        return OK;
+    }
+    static uint32_t Flags(void *handle) {
+        return ((const MemorySource *)handle)->mFlags;
+    }
+    static bool GetUri(void *handle, char *uri, size_t size) {
+        const std::string &path = ((const MemorySource *)handle)->mPath;
+        if (path.empty() || path.size() >= size) {
+            return false;
+        }
+        strcpy(uri, path.c_str());
+        return true;
+    }
+
+    // Rewrites the file in place, keeping its inode, with mData and mMtime.
+    void syncFile() {
+        FILE *file = fopen(mPath.c_str(), "wb");
+        ASSERT_NE(file, nullptr) << mPath;
+        ASSERT_EQ(fwrite(mData.data(), 1, mData.size(), file), mData.size());
+        ASSERT_EQ(fclose(file), 0);
+        const struct timespec times[2] = {mMtime, mMtime};
+        ASSERT_EQ(utimensat(AT_FDCWD, mPath.c_str(), times, 0), 0);
+    }
+
+    sp<ExtractorIndexCache> open() {
+        if (!mPath.empty()) {
+            syncFile();
+        }
+        android::CDataSource csource = {ReadAt, GetSize, Flags, GetUri, this};
+        DataSourceHelper helper(&csource);
+        return ExtractorIndexCache::Open(&helper, kFormat);
+    }
+};
+
+class ExtractorIndexCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char dir[] = "/tmp/ExtractorIndexCacheTest.XXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        mDirectory = dir;
+        ExtractorIndexCache::SetDirectory(mDirectory.c_str());
+
+        mSourcePath = createFile();
+        ASSERT_FALSE(mSourcePath.empty());
+        mSource.mPath = mSourcePath;
+        mSource.mData.resize(3 * ExtractorIndexCache::kIdentityBytes);
+        for (size_t i = 0; i < mSource.mData.size(); ++i) {
+            mSource.mData[i] = i * 7 + (i >> 8);
+        }
+    }
+
+    void TearDown() override {
+        for (const std::string &entry : listEntries()) {
+            unlink(entry.c_str());
+        }
+        rmdir(mDirectory.c_str());
+        ExtractorIndexCache::SetDirectory(nullptr);
+        if (!mSourcePath.empty()) {
+            unlink(mSourcePath.c_str());
+        }
+    }
+
+    static std::string createFile() {
+        char path[] = "/tmp/ExtractorIndexCacheTest.source.XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            return std::string();
+        }
+        close(fd);
+        return path;
+    }
+
+    std::vector<std::string> listEntries() const {
+        std::vector<std::string> entries;
+        DIR *dir = opendir(mDirectory.c_str());
+        if (dir == nullptr) {
+            return entries;
+        }
+        while (const struct dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                entries.push_back(mDirectory + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+        return entries;
+    }
+
+    std::string mDirectory;
+    std::string mSourcePath;
+    MemorySource mSource;
+};
+
+TEST_F(ExtractorIndexCacheTest, DisabledWithoutDirectory) {
+    ExtractorIndexCache::SetDirectory(nullptr);
+    EXPECT_EQ(mSource.open(), nullptr);
+    ExtractorIndexCache::SetDirectory("");
+    EXPECT_EQ(mSource.open(), nullptr);
+}
+
+TEST_F(ExtractorIndexCacheTest, DisabledForRemoteSources) {
+    mSource.mFlags = DataSourceBase::kIsHTTPBasedSource;
+    EXPECT_EQ(mSource.open(), nullptr);
+    mSource.mFlags = DataSourceBase::kIsCachingDataSource;
+    EXPECT_EQ(mSource.open(), nullptr);
+}
+
+TEST_F(ExtractorIndexCacheTest, DisabledWithoutLocalPath) {
+    // e.g. a source opened from a file descriptor
+    mSource.mPath.clear();
+    EXPECT_EQ(mSource.open(), nullptr);
+}
+
+TEST_F(ExtractorIndexCacheTest, StoredSectionsPersist) {
+    const std::vector<uint32_t> first = {1, 2, 3, 4, 5};
+    const std::vector<uint8_t> second = {9, 8, 7};
+    {
+        sp<ExtractorIndexCache> cache = mSource.open();
+        ASSERT_NE(cache, nullptr);
+        const void *data;
+        size_t size;
+        EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+        ASSERT_EQ(cache->store(kSection, 0, first.data(), first.size() * sizeof(uint32_t)), OK);
+        ASSERT_EQ(cache->store(kSection, 1, second.data(), second.size()), OK);
+        ASSERT_TRUE(cache->find(kSection, 0, &data, &size));
+        EXPECT_EQ(size, first.size() * sizeof(uint32_t));
+    }
+    EXPECT_EQ(listEntries().size(), 1u);
+
+    sp<ExtractorIndexCache> cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    const void *data;
+    size_t size;
+    ASSERT_TRUE(cache->find(kSection, 0, &data, &size));
+    EXPECT_EQ((uintptr_t)data % 8, 0u);
+    ASSERT_EQ(size, first.size() * sizeof(uint32_t));
+    EXPECT_EQ(memcmp(data, first.data(), size), 0);
+    ASSERT_TRUE(cache->find(kSection, 1, &data, &size));
+    EXPECT_EQ((uintptr_t)data % 8, 0u);
+    ASSERT_EQ(size, second.size());
+    EXPECT_EQ(memcmp(data, second.data(), size), 0);
+    EXPECT_FALSE(cache->find(kSection, 2, &data, &size));
+
+    // Replacing a section keeps the others.
+    const uint8_t replacement = 42;
+    ASSERT_EQ(cache->store(kSection, 1, &replacement, 1), OK);
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    ASSERT_TRUE(cache->find(kSection, 1, &data, &size));
+    ASSERT_EQ(size, 1u);
+    EXPECT_EQ(*(const uint8_t *)data, replacement);
+    EXPECT_TRUE(cache->find(kSection, 0, &data, &size));
+}
+
+TEST_F(ExtractorIndexCacheTest, ModifiedFileMisses) {
+    const uint64_t value = 0x0123456789abcdefull;
+    ASSERT_EQ(mSource.open()->store(kSection, 0, &value, sizeof(value)), OK);
+
+    const void *data;
+    size_t size;
+    // Changing the end of the file changes its identity.
+    mSource.mData.back() ^= 1;
+    sp<ExtractorIndexCache> cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+
+    // So does changing its size.
+    mSource.mData.back() ^= 1;
+    mSource.mData.push_back(0);
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+
+    mSource.mData.pop_back();
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    EXPECT_TRUE(cache->find(kSection, 0, &data, &size));
+}
+
+TEST_F(ExtractorIndexCacheTest, EditedOrReplacedFileMisses) {
+    const uint64_t value = 0x0123456789abcdefull;
+    ASSERT_EQ(mSource.open()->store(kSection, 0, &value, sizeof(value)), OK);
+    const void *data;
+    size_t size;
+    ASSERT_TRUE(mSource.open()->find(kSection, 0, &data, &size));
+
+    // An edit in the middle keeps the size and both ends, but not the
+    // modification time.
+    mSource.mData[mSource.mData.size() / 2] ^= 1;
+    mSource.mMtime.tv_nsec = 1;
+    sp<ExtractorIndexCache> cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+
+    // Another file with the same size, contents and modification time
+    mSource.mData[mSource.mData.size() / 2] ^= 1;
+    mSource.mMtime.tv_nsec = 0;
+    ASSERT_TRUE(mSource.open()->find(kSection, 0, &data, &size));
+    const std::string otherPath = createFile();
+    ASSERT_FALSE(otherPath.empty());
+    mSource.mPath = otherPath;
+    cache = mSource.open();
+    unlink(otherPath.c_str());
+    ASSERT_NE(cache, nullptr);
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+}
+
+TEST_F(ExtractorIndexCacheTest, DamagedEntryIgnored) {
+    const std::vector<uint8_t> section(1000, 0x5a);
+    ASSERT_EQ(mSource.open()->store(kSection, 0, section.data(), section.size()), OK);
+    const std::vector<std::string> entries = listEntries();
+    ASSERT_EQ(entries.size(), 1u);
+
+    // Flip a byte in the section data.
+    FILE *file = fopen(entries[0].c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fseek(file, -10, SEEK_END), 0);
+    fputc(0, file);
+    fclose(file);
+
+    sp<ExtractorIndexCache> cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    const void *data;
+    size_t size;
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+
+    // The next store replaces the damaged entry.
+    ASSERT_EQ(cache->store(kSection, 0, section.data(), section.size()), OK);
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    ASSERT_TRUE(cache->find(kSection, 0, &data, &size));
+    EXPECT_EQ(size, section.size());
+
+    // Truncated entries are ignored as well.
+    ASSERT_EQ(truncate(entries[0].c_str(), 40), 0);
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    EXPECT_FALSE(cache->find(kSection, 0, &data, &size));
+}
+
+TEST_F(ExtractorIndexCacheTest, SmallFiles) {
+    mSource.mData.resize(100);
+    sp<ExtractorIndexCache> cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    const uint32_t value = 7;
+    ASSERT_EQ(cache->store(kSection, 3, &value, sizeof(value)), OK);
+    cache = mSource.open();
+    ASSERT_NE(cache, nullptr);
+    const void *data;
+    size_t size;
+    ASSERT_TRUE(cache->find(kSection, 3, &data, &size));
+    EXPECT_EQ(*(const uint32_t *)data, value);
+
+    mSource.mData.clear();
+    EXPECT_EQ(mSource.open(), nullptr);
+}
+
+}  // namespace
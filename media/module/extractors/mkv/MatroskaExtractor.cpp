@@ -22,6 +22,7 @@
 #include "MatroskaExtractor.h"
 #include "common/webmids.h"
 
+#include <ExtractorIndexCache.h>
 #include <media/stagefright/DataSourceBase.h>
 #include <media/ExtractorUtils.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -38,6 +39,7 @@
 
 #include <arpa/inet.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <vector>
 
 namespace android {
@@ -584,7 +586,7 @@ int64_t BlockIterator::blockTimeUs() const {
 }
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
-    mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
+    mCluster = mExtractor->findCluster_l(seekTimeUs * 1000ll);
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
         ALOGE("get last blockenry failed!");
@@ -1336,7 +1338,9 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
       mSegment(NULL),
       mExtractedThumbnails(false),
       mIsWebm(false),
-      mSeekPreRollNs(0) {
+      mSeekPreRollNs(0),
+      mClusterIndex(NULL),
+      mClusterIndexSize(0) {
     off64_t size;
     mIsLiveStreaming =
         (mDataSource->flags()
@@ -1405,9 +1409,16 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
                 long len;
                 ret = mSegment->LoadCluster(pos, len);
                 ALOGV("has Cue data, Cluster num=%ld", mSegment->GetCount());
+            } else if (loadClusterIndex()) {
+                long len;
+                ret = mSegment->LoadCluster(pos, len);
+                ALOGV("no Cue data, using cached index of %zu clusters", mClusterIndexSize);
             } else  {
                 long status_Load = mSegment->Load();
                 ALOGW("no Cue data,Segment Load status:%ld",status_Load);
+                if (status_Load >= 0) {
+                    storeClusterIndex();
+                }
             }
         } else if (ret > 0) {
             ret = mkvparser::E_BUFFER_NOT_FULL;
@@ -1436,6 +1447,72 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
     addTracks();
 }
 
+// Index cache section holding the ClusterIndexEntry of every cluster, in file order.
+static const uint32_t kClusterIndexSection = FOURCC("clus");
+
+// Files with fewer clusters load quickly enough without the cache.
+static const size_t kMinIndexCacheClusters = 64;
+
+bool MatroskaExtractor::loadClusterIndex() {
+    mIndexCache = ExtractorIndexCache::Open(mDataSource, FOURCC("mkv "));
+    const void *data;
+    size_t size;
+    if (mIndexCache == NULL
+            || !mIndexCache->find(kClusterIndexSection, 0 /* id */, &data, &size)) {
+        return false;
+    }
+    const ClusterIndexEntry *entries = (const ClusterIndexEntry *)data;
+    const size_t count = size / sizeof(ClusterIndexEntry);
+    bool valid = count > 0 && size % sizeof(ClusterIndexEntry) == 0
+            && entries[0].mPosition >= 0;
+    for (size_t i = 1; valid && i < count; ++i) {
+        valid = entries[i].mPosition > entries[i - 1].mPosition
+                && entries[i].mTimeNs >= entries[i - 1].mTimeNs;
+    }
+    if (!valid) {
+        ALOGW("ignoring invalid cached cluster index");
+        return false;
+    }
+    mClusterIndex = entries;
+    mClusterIndexSize = count;
+    return true;
+}
+
+void MatroskaExtractor::storeClusterIndex() {
+    if (mIndexCache == NULL || mSegment->GetCount() < (long)kMinIndexCacheClusters) {
+        return;
+    }
+    std::vector<ClusterIndexEntry> entries;
+    entries.reserve(mSegment->GetCount());
+    for (const mkvparser::Cluster *cluster = mSegment->GetFirst();
+            cluster != NULL && !cluster->EOS(); cluster = mSegment->GetNext(cluster)) {
+        const long long timeNs = cluster->GetTime();
+        if (timeNs < 0 || (!entries.empty() && timeNs < entries.back().mTimeNs)) {
+            // a damaged or unusual file; keep seeking through mkvparser
+            return;
+        }
+        entries.push_back({timeNs, cluster->GetPosition()});
+    }
+    mIndexCache->store(kClusterIndexSection, 0 /* id */,
+            entries.data(), entries.size() * sizeof(ClusterIndexEntry));
+}
+
+// Same as mkvparser::Segment::FindCluster, but also finds clusters that are not loaded
+// yet when the cluster index is cached.
+const mkvparser::Cluster *MatroskaExtractor::findCluster_l(long long timeNs) const {
+    if (mClusterIndex == NULL) {
+        return mSegment->FindCluster(timeNs);
+    }
+    const ClusterIndexEntry *it = std::upper_bound(
+            mClusterIndex, mClusterIndex + mClusterIndexSize, timeNs,
+            [](long long time, const ClusterIndexEntry &entry) {
+                return time < entry.mTimeNs;
+            });
+    const ClusterIndexEntry &entry = it == mClusterIndex ? *it : *(it - 1);
+    const mkvparser::Cluster *cluster = mSegment->FindOrPreloadCluster(entry.mPosition);
+    return cluster != NULL ? cluster : mSegment->FindCluster(timeNs);
+}
+
 MatroskaExtractor::~MatroskaExtractor() {
     delete mSegment;
     mSegment = NULL;
@@ -23,6 +23,7 @@
 #include <media/MediaExtractorPluginApi.h>
 #include <media/MediaExtractorPluginHelper.h>
 #include <media/NdkMediaFormat.h>
+#include <utils/RefBase.h>
 #include <utils/Vector.h>
 #include <utils/threads.h>
 
@@ -31,6 +32,7 @@ namespace android {
 struct AMessage;
 class String8;
 
+class ExtractorIndexCache;
 class MetaData;
 struct DataSourceBaseReader;
 struct MatroskaSource;
@@ -92,6 +94,17 @@ private:
     bool mIsWebm;
     int64_t mSeekPreRollNs;
 
+    // Start time and position (relative to the segment) of every cluster of a file
+    // without Cues. Cached by the first open of the file, which has to load all clusters
+    // to seek; later opens only preload the clusters they seek to.
+    struct ClusterIndexEntry {
+        int64_t mTimeNs;
+        int64_t mPosition;
+    };
+    sp<ExtractorIndexCache> mIndexCache;
+    const ClusterIndexEntry *mClusterIndex;
+    size_t mClusterIndexSize;
+
     status_t synthesizeAVCC(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG2(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG4(TrackInfo *trackInfo, size_t index);
@@ -106,6 +119,9 @@ private:
             const mkvparser::VideoTrack *vtrack,
             AMediaFormat *meta);
     bool isLiveStreaming() const;
+    bool loadClusterIndex();
+    void storeClusterIndex();
+    const mkvparser::Cluster *findCluster_l(long long timeNs) const;
 
     MatroskaExtractor(const MatroskaExtractor &);
     MatroskaExtractor &operator=(const MatroskaExtractor &);
@@ -34,6 +34,7 @@
 #include "ItemTable.h"
 
 #include <media/esds/ESDS.h>
+#include <ExtractorIndexCache.h>
 #include <ID3.h>
 #include <media/stagefright/DataSourceBase.h>
 #include <media/ExtractorUtils.h>
@@ -678,6 +679,8 @@ status_t MPEG4Extractor::readMetaData() {
     status_t err;
     bool sawMoovOrSidx = false;
 
+    mIndexCache = ExtractorIndexCache::Open(mDataSource, FOURCC("mp4 "));
+
     while (!((mHasMoovBox && sawMoovOrSidx && (mMdatFound || mMoofFound)) ||
              (mIsHeif && (mPreferHeif || !mHasMoovBox) &&
                      (mItemTable != NULL) && mItemTable->isValid()))) {
@@ -1021,6 +1024,12 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 }
 
                 mLastTrack->sampleTable = new SampleTable(mDataSource);
+
+                int32_t trackId;
+                if (mIndexCache != NULL && AMediaFormat_getInt32(
+                        mLastTrack->meta, AMEDIAFORMAT_KEY_TRACK_ID, &trackId)) {
+                    mLastTrack->sampleTable->setIndexCache(mIndexCache, trackId);
+                }
             }
 
             bool isTrack = false;
@@ -31,12 +31,7 @@ namespace android {
 
 SampleIterator::SampleIterator(SampleTable *table)
     : mTable(table),
-      mInitialized(false),
-      mTimeToSampleIndex(0),
-      mTTSSampleIndex(0),
-      mTTSSampleTime(0),
-      mTTSCount(0),
-      mTTSDuration(0) {
+      mInitialized(false) {
     reset();
 }
 
@@ -50,6 +45,34 @@ void SampleIterator::reset() {
     mChunkDesc = 0;
 }
 
+void SampleIterator::restoreChunkRange(uint32_t sampleIndex) {
+    // find the last checkpoint at or before sampleIndex
+    size_t left = 0;
+    size_t right = mChunkRangeCheckpoints.size();
+    while (left < right) {
+        size_t center = left + (right - left) / 2;
+        if (sampleIndex < mChunkRangeCheckpoints[center].mFirstChunkSampleIndex) {
+            right = center;
+        } else {
+            left = center + 1;
+        }
+    }
+    if (left == 0) {
+        return;
+    }
+    const ChunkRange &range = mChunkRangeCheckpoints[left - 1];
+    if (range.mFirstChunkSampleIndex <= mFirstChunkSampleIndex) {
+        return;     // the current range is at least as close
+    }
+    mSampleToChunkIndex = range.mSampleToChunkIndex;
+    mFirstChunk = range.mFirstChunk;
+    mFirstChunkSampleIndex = range.mFirstChunkSampleIndex;
+    mStopChunk = range.mStopChunk;
+    mStopChunkSampleIndex = range.mStopChunkSampleIndex;
+    mSamplesPerChunk = range.mSamplesPerChunk;
+    mChunkDesc = range.mChunkDesc;
+}
+
 status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     ALOGV("seekTo(%d)", sampleIndex);
 
@@ -73,6 +96,10 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         reset();
     }
 
+    if (sampleIndex >= mStopChunkSampleIndex) {
+        restoreChunkRange(sampleIndex);
+    }
+
     if (sampleIndex >= mStopChunkSampleIndex) {
         status_t err;
         if ((err = findChunkRange(sampleIndex)) != OK) {
@@ -136,13 +163,6 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     }
 
     mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
-    if (sampleIndex < mTTSSampleIndex) {
-        mTimeToSampleIndex = 0;
-        mTTSSampleIndex = 0;
-        mTTSSampleTime = 0;
-        mTTSCount = 0;
-        mTTSDuration = 0;
-    }
 
     status_t err;
     if ((err = findSampleTimeAndDuration(
@@ -194,6 +214,13 @@ status_t SampleIterator::findChunkRange(uint32_t sampleIndex) {
         }
 
         ++mSampleToChunkIndex;
+
+        if (mSampleToChunkIndex ==
+                (mChunkRangeCheckpoints.size() + 1) * SampleTable::kCheckpointInterval) {
+            mChunkRangeCheckpoints.push({mSampleToChunkIndex, mFirstChunk,
+                    mFirstChunkSampleIndex, mStopChunk, mStopChunkSampleIndex,
+                    mSamplesPerChunk, mChunkDesc});
+        }
     }
 
     return OK;
@@ -312,37 +339,10 @@ status_t SampleIterator::findSampleTimeAndDuration(
         return ERROR_OUT_OF_RANGE;
     }
 
-    while (true) {
-        if (mTTSSampleIndex > UINT32_MAX - mTTSCount) {
-            return ERROR_OUT_OF_RANGE;
-        }
-        if(sampleIndex < mTTSSampleIndex + mTTSCount) {
-            break;
-        }
-        if (mTimeToSampleIndex == mTable->mTimeToSampleCount ||
-            (mTTSDuration != 0 && mTTSCount > UINT64_MAX / mTTSDuration) ||
-            mTTSSampleTime > UINT64_MAX - (mTTSCount * mTTSDuration)) {
-            return ERROR_OUT_OF_RANGE;
-        }
-
-        mTTSSampleIndex += mTTSCount;
-        mTTSSampleTime += mTTSCount * mTTSDuration;
-
-        mTTSCount = mTable->mTimeToSample[2 * mTimeToSampleIndex];
-        mTTSDuration = mTable->mTimeToSample[2 * mTimeToSampleIndex + 1];
-
-        ++mTimeToSampleIndex;
-    }
-
-    // below is equivalent to:
-    // *time = mTTSSampleTime + mTTSDuration * (sampleIndex - mTTSSampleIndex);
-    uint64_t tmp;
-    if (__builtin_sub_overflow(sampleIndex, mTTSSampleIndex, &tmp) ||
-            __builtin_mul_overflow(mTTSDuration, tmp, &tmp) ||
-            __builtin_add_overflow(mTTSSampleTime, tmp, &tmp)) {
-        return ERROR_OUT_OF_RANGE;
+    status_t err = mTable->getSampleDecodeTimeAndDuration(sampleIndex, time, duration);
+    if (err != OK) {
+        return err;
     }
-    *time = tmp;
 
     int32_t offset = mTable->getCompositionTimeOffset(sampleIndex);
     if ((offset < 0 && *time < (offset == INT32_MIN ?
@@ -357,8 +357,6 @@ status_t SampleIterator::findSampleTimeAndDuration(
         *time -= (offset == INT32_MIN ? INT64_MAX : (-offset));
     }
 
-    *duration = mTTSDuration;
-
     return OK;
 }
 
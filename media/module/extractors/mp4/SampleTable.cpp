@@ -18,13 +18,18 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <limits>
+#include <vector>
 
 #include "SampleTable.h"
 #include "SampleIterator.h"
 
 #include <arpa/inet.h>
 
+#include <ExtractorIndexCache.h>
+
 #include <media/MediaExtractorPluginApi.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ByteUtils.h>
@@ -49,6 +54,15 @@ const uint32_t SampleTable::kSampleSizeTypeCompact = FOURCC("stz2");
 
 const off64_t kMaxOffset = std::numeric_limits<off64_t>::max();
 
+// Index cache section holding the presentation order of a track: a SampleOrderHeader
+// followed by mDeltaSize bytes per sample, as in mSampleOrderDeltas.
+const uint32_t kSampleOrderSection = FOURCC("sord");
+
+struct SampleOrderHeader {
+    uint32_t mNumSamples;
+    uint32_t mDeltaSize;
+};
+
 struct SampleTable::CompositionDeltaLookup {
     CompositionDeltaLookup();
 
@@ -58,6 +72,11 @@ struct SampleTable::CompositionDeltaLookup {
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
 private:
+    struct Position {
+        size_t mDeltaEntry;
+        size_t mEntrySampleIndex;
+    };
+
     Mutex mLock;
 
     const int32_t *mDeltaEntries;
@@ -66,6 +85,9 @@ private:
     size_t mCurrentDeltaEntry;
     size_t mCurrentEntrySampleIndex;
 
+    // position at every kCheckpointInterval-th entry walked so far
+    std::vector<Position> mCheckpoints;
+
     DISALLOW_EVIL_CONSTRUCTORS(CompositionDeltaLookup);
 };
 
@@ -84,6 +106,7 @@ void SampleTable::CompositionDeltaLookup::setEntries(
     mNumDeltaEntries = numDeltaEntries;
     mCurrentDeltaEntry = 0;
     mCurrentEntrySampleIndex = 0;
+    mCheckpoints.clear();
 }
 
 int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
@@ -94,10 +117,19 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
         return 0;
     }
 
+    // resume from the last checkpoint at or before sampleIndex, if that is closer
+    auto it = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), sampleIndex,
+            [](uint32_t index, const Position &position) {
+                return index < position.mEntrySampleIndex;
+            });
     if (sampleIndex < mCurrentEntrySampleIndex) {
         mCurrentDeltaEntry = 0;
         mCurrentEntrySampleIndex = 0;
     }
+    if (it != mCheckpoints.begin() && (it - 1)->mEntrySampleIndex > mCurrentEntrySampleIndex) {
+        mCurrentDeltaEntry = (it - 1)->mDeltaEntry;
+        mCurrentEntrySampleIndex = (it - 1)->mEntrySampleIndex;
+    }
 
     while (mCurrentDeltaEntry < mNumDeltaEntries) {
         uint32_t sampleCount = mDeltaEntries[2 * mCurrentDeltaEntry];
@@ -107,6 +139,10 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
 
         mCurrentEntrySampleIndex += sampleCount;
         ++mCurrentDeltaEntry;
+
+        if (mCurrentDeltaEntry == (mCheckpoints.size() + 1) * kCheckpointInterval) {
+            mCheckpoints.push_back({mCurrentDeltaEntry, mCurrentEntrySampleIndex});
+        }
     }
 
     return 0;
@@ -114,6 +150,111 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+struct SampleTable::TimeToSampleLookup {
+    TimeToSampleLookup();
+
+    void setEntries(const uint32_t *entries, uint32_t numEntries);
+
+    // Returns the decode time and duration of sample |sampleIndex|.
+    status_t getSampleTimeAndDuration(
+            uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
+
+private:
+    struct Position {
+        uint32_t mEntry;        // index of the next entry
+        uint32_t mSampleIndex;  // first sample of the current entry
+        uint64_t mSampleTime;   // decode time of mSampleIndex
+        uint32_t mCount;        // number of samples of the current entry
+        uint64_t mDuration;     // duration of each sample of the current entry
+    };
+
+    Mutex mLock;
+
+    const uint32_t *mEntries;
+    uint32_t mNumEntries;
+
+    Position mCurrent;
+
+    // position at every kCheckpointInterval-th entry walked so far
+    std::vector<Position> mCheckpoints;
+
+    DISALLOW_EVIL_CONSTRUCTORS(TimeToSampleLookup);
+};
+
+SampleTable::TimeToSampleLookup::TimeToSampleLookup()
+    : mEntries(NULL),
+      mNumEntries(0),
+      mCurrent{} {
+}
+
+void SampleTable::TimeToSampleLookup::setEntries(
+        const uint32_t *entries, uint32_t numEntries) {
+    Mutex::Autolock autolock(mLock);
+
+    mEntries = entries;
+    mNumEntries = numEntries;
+    mCurrent = {};
+    mCheckpoints.clear();
+}
+
+status_t SampleTable::TimeToSampleLookup::getSampleTimeAndDuration(
+        uint32_t sampleIndex, uint64_t *time, uint64_t *duration) {
+    Mutex::Autolock autolock(mLock);
+
+    // resume from the last checkpoint at or before sampleIndex, if that is closer
+    auto it = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), sampleIndex,
+            [](uint32_t index, const Position &position) {
+                return index < position.mSampleIndex;
+            });
+    if (sampleIndex < mCurrent.mSampleIndex) {
+        mCurrent = {};
+    }
+    if (it != mCheckpoints.begin() && (it - 1)->mSampleIndex > mCurrent.mSampleIndex) {
+        mCurrent = *(it - 1);
+    }
+
+    while (true) {
+        if (mCurrent.mSampleIndex > UINT32_MAX - mCurrent.mCount) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        if (sampleIndex < mCurrent.mSampleIndex + mCurrent.mCount) {
+            break;
+        }
+        if (mCurrent.mEntry == mNumEntries ||
+            (mCurrent.mDuration != 0 && mCurrent.mCount > UINT64_MAX / mCurrent.mDuration) ||
+            mCurrent.mSampleTime > UINT64_MAX - (mCurrent.mCount * mCurrent.mDuration)) {
+            return ERROR_OUT_OF_RANGE;
+        }
+
+        mCurrent.mSampleIndex += mCurrent.mCount;
+        mCurrent.mSampleTime += mCurrent.mCount * mCurrent.mDuration;
+
+        mCurrent.mCount = mEntries[2 * mCurrent.mEntry];
+        mCurrent.mDuration = mEntries[2 * mCurrent.mEntry + 1];
+
+        ++mCurrent.mEntry;
+
+        if (mCurrent.mEntry == (mCheckpoints.size() + 1) * kCheckpointInterval) {
+            mCheckpoints.push_back(mCurrent);
+        }
+    }
+
+    // below is equivalent to:
+    // *time = mSampleTime + mDuration * (sampleIndex - mSampleIndex);
+    uint64_t tmp;
+    if (__builtin_sub_overflow(sampleIndex, mCurrent.mSampleIndex, &tmp) ||
+            __builtin_mul_overflow(mCurrent.mDuration, tmp, &tmp) ||
+            __builtin_add_overflow(mCurrent.mSampleTime, tmp, &tmp)) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    *time = tmp;
+    *duration = mCurrent.mDuration;
+
+    return OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 SampleTable::SampleTable(DataSourceHelper *source)
     : mDataSource(source),
       mChunkOffsetOffset(-1),
@@ -128,7 +269,13 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
-      mSampleTimeEntries(NULL),
+      mTimeToSampleLookup(new TimeToSampleLookup),
+      mSampleOrderBuilt(false),
+      mSampleOrderValid(false),
+      mSampleOrderDeltaSize(0),
+      mSampleOrderDeltas(NULL),
+      mSampleOrderStorage(NULL),
+      mIndexCacheId(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -151,14 +298,18 @@ SampleTable::~SampleTable() {
     delete[] mTimeToSample;
     mTimeToSample = NULL;
 
+    delete mTimeToSampleLookup;
+    mTimeToSampleLookup = NULL;
+
     delete mCompositionDeltaLookup;
     mCompositionDeltaLookup = NULL;
 
     delete[] mCompositionTimeDeltaEntries;
     mCompositionTimeDeltaEntries = NULL;
 
-    delete[] mSampleTimeEntries;
-    mSampleTimeEntries = NULL;
+    free(mSampleOrderStorage);
+    mSampleOrderStorage = NULL;
+    mSampleOrderDeltas = NULL;
 
     delete mSampleIterator;
     mSampleIterator = NULL;
@@ -426,6 +577,8 @@ status_t SampleTable::setTimeToSampleParams(
         mTimeToSample[i] = ntohl(mTimeToSample[i]);
     }
 
+    mTimeToSampleLookup->setEntries(mTimeToSample, mTimeToSampleCount);
+
     mHasTimeToSample = true;
     return OK;
 }
@@ -615,103 +768,208 @@ uint32_t abs_difference(uint64_t time1, uint64_t time2) {
     return time1 > time2 ? time1 - time2 : time2 - time1;
 }
 
-// static
-int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
-    const SampleTimeEntry *a = (const SampleTimeEntry *)_a;
-    const SampleTimeEntry *b = (const SampleTimeEntry *)_b;
+status_t SampleTable::getSampleDecodeTimeAndDuration(
+        uint32_t sampleIndex, uint64_t *time, uint64_t *duration) {
+    return mTimeToSampleLookup->getSampleTimeAndDuration(sampleIndex, time, duration);
+}
 
-    if (a->mCompositionTime < b->mCompositionTime) {
-        return -1;
-    } else if (a->mCompositionTime > b->mCompositionTime) {
-        return 1;
+uint64_t SampleTable::getCompositionTime(uint32_t sampleIndex) {
+    uint64_t sampleTime;
+    uint64_t duration;
+    if (getSampleDecodeTimeAndDuration(sampleIndex, &sampleTime, &duration) != OK) {
+        // Technically this should not happen if the file is well-formed,
+        // but you know... there's (gasp) malformed content out there.
+        return 0;
     }
 
-    return 0;
+    int32_t compTimeDelta = getCompositionTimeOffset(sampleIndex);
+    if (compTimeDelta < 0 && sampleTime <
+            (compTimeDelta == INT32_MIN ? INT32_MAX : uint32_t(-compTimeDelta))) {
+        ALOGV("%llu + %d would overflow, clamping", (unsigned long long) sampleTime,
+                compTimeDelta);
+        return 0;
+    }
+    if (compTimeDelta > 0 && sampleTime > UINT64_MAX - compTimeDelta) {
+        ALOGV("%llu + %d would overflow, clamping", (unsigned long long) sampleTime,
+                compTimeDelta);
+        return UINT64_MAX;
+    }
+    return compTimeDelta > 0 ? sampleTime + compTimeDelta : sampleTime - (-compTimeDelta);
+}
+
+uint32_t SampleTable::getSampleIndexInPresentationOrder(uint32_t order) const {
+    // computed in 64 bits, as the deltas are negative for samples moved forward
+    switch (mSampleOrderDeltaSize) {
+        case 1:
+            return (int64_t)order + ((const int8_t *)mSampleOrderDeltas)[order];
+        case 2:
+            return (int64_t)order + ((const int16_t *)mSampleOrderDeltas)[order];
+        case 4:
+            return (int64_t)order + ((const int32_t *)mSampleOrderDeltas)[order];
+        default:
+            return order;
+    }
+}
+
+uint64_t SampleTable::getSampleTime(uint32_t order, uint64_t scale_num, uint64_t scale_den) {
+    if (order >= mNumSampleSizes || !mSampleOrderValid || scale_den == 0) {
+        return 0;
+    }
+    return (getCompositionTime(getSampleIndexInPresentationOrder(order)) * scale_num)
+            / scale_den;
 }
 
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (mSampleOrderBuilt || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
+    mSampleOrderBuilt = true;
 
-    mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
-    if (mTotalSize > kMaxTotalSize) {
+    if (loadSampleOrder_l()) {
+        return;
+    }
+
+    // Without reordering, presentation order is decode order and there is nothing to build.
+    bool reordered = false;
+    if (mCompositionTimeDeltaEntries != NULL) {
+        uint64_t previousTime = 0;
+        for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+            const uint64_t time = getCompositionTime(i);
+            if (time < previousTime) {
+                reordered = true;
+                break;
+            }
+            previousTime = time;
+        }
+    }
+    if (!reordered) {
+        mSampleOrderValid = true;
+        storeSampleOrder_l();
+        return;
+    }
+
+    // The sort needs the composition time of every sample, but only temporarily.
+    struct SampleTimeEntry {
+        uint64_t mCompositionTime;
+        uint32_t mSampleIndex;
+    };
+    const uint64_t sortSize = (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
+    if (mTotalSize + sortSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
               "    Requested sample entry table size = %llu\n"
               "    Eventual sample table size >= %llu\n"
               "    Allowed sample table size = %llu\n",
-              (unsigned long long)mNumSampleSizes * sizeof(SampleTimeEntry),
-              (unsigned long long)mTotalSize,
+              (unsigned long long)sortSize,
+              (unsigned long long)(mTotalSize + sortSize),
               (unsigned long long)kMaxTotalSize);
         return;
     }
 
-    mSampleTimeEntries = new (std::nothrow) SampleTimeEntry[mNumSampleSizes];
-
-    if (!mSampleTimeEntries) {
+    SampleTimeEntry *entries = new (std::nothrow) SampleTimeEntry[mNumSampleSizes];
+    if (!entries) {
         ALOGE("Cannot allocate sample entry table with %llu entries.",
                 (unsigned long long)mNumSampleSizes);
         return;
     }
-    memset(mSampleTimeEntries, 0, sizeof(SampleTimeEntry) * mNumSampleSizes);
-
-    uint32_t sampleIndex = 0;
-    uint64_t sampleTime = 0;
-
-    for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
-        uint32_t n = mTimeToSample[2 * i];
-        uint32_t delta = mTimeToSample[2 * i + 1];
-
-        for (uint32_t j = 0; j < n; ++j) {
-            if (sampleIndex < mNumSampleSizes) {
-                // Technically this should always be the case if the file
-                // is well-formed, but you know... there's (gasp) malformed
-                // content out there.
-
-                mSampleTimeEntries[sampleIndex].mSampleIndex = sampleIndex;
-
-                int32_t compTimeDelta =
-                    mCompositionDeltaLookup->getCompositionTimeOffset(
-                            sampleIndex);
-
-                if ((compTimeDelta < 0 && sampleTime <
-                        (compTimeDelta == INT32_MIN ?
-                                INT32_MAX : uint32_t(-compTimeDelta)))
-                        || (compTimeDelta > 0 &&
-                                sampleTime > UINT64_MAX - compTimeDelta)) {
-                    ALOGE("%llu + %d would overflow, clamping",
-                            (unsigned long long) sampleTime, compTimeDelta);
-                    if (compTimeDelta < 0) {
-                        sampleTime = 0;
-                    } else {
-                        sampleTime = UINT64_MAX;
-                    }
-                    compTimeDelta = 0;
-                }
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        entries[i].mCompositionTime = getCompositionTime(i);
+        entries[i].mSampleIndex = i;
+    }
+    std::sort(entries, entries + mNumSampleSizes,
+            [](const SampleTimeEntry &a, const SampleTimeEntry &b) {
+                return a.mCompositionTime < b.mCompositionTime
+                        || (a.mCompositionTime == b.mCompositionTime
+                                && a.mSampleIndex < b.mSampleIndex);
+            });
+
+    // Store the displacements with the narrowest type that fits them all.
+    int64_t maxDelta = 0;
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        maxDelta = std::max(maxDelta, std::abs((int64_t)entries[i].mSampleIndex - i));
+    }
+    const uint32_t deltaSize = maxDelta <= INT8_MAX ? 1 : maxDelta <= INT16_MAX ? 2 : 4;
+    const uint64_t allocSize = (uint64_t)mNumSampleSizes * deltaSize;
+    mSampleOrderStorage = malloc(allocSize);
+    if (mSampleOrderStorage == NULL) {
+        ALOGE("Cannot allocate sample order table with %llu entries.",
+                (unsigned long long)mNumSampleSizes);
+        delete[] entries;
+        return;
+    }
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        const int64_t delta = (int64_t)entries[i].mSampleIndex - i;
+        switch (deltaSize) {
+            case 1: ((int8_t *)mSampleOrderStorage)[i] = delta; break;
+            case 2: ((int16_t *)mSampleOrderStorage)[i] = delta; break;
+            default: ((int32_t *)mSampleOrderStorage)[i] = delta; break;
+        }
+    }
+    delete[] entries;
 
-                mSampleTimeEntries[sampleIndex].mCompositionTime =
-                        compTimeDelta > 0 ? sampleTime + compTimeDelta:
-                                sampleTime - (-compTimeDelta);
-            }
+    mTotalSize += allocSize;
+    mSampleOrderDeltas = mSampleOrderStorage;
+    mSampleOrderDeltaSize = deltaSize;
+    mSampleOrderValid = true;
+    storeSampleOrder_l();
+}
 
-            ++sampleIndex;
-            if (sampleTime > UINT64_MAX - delta) {
-                ALOGE("%llu + %u would overflow, clamping",
-                    (unsigned long long) sampleTime, delta);
-                sampleTime = UINT64_MAX;
-            } else {
-                sampleTime += delta;
-            }
+void SampleTable::setIndexCache(const sp<ExtractorIndexCache> &cache, uint32_t id) {
+    Mutex::Autolock autoLock(mLock);
+    mIndexCache = cache;
+    mIndexCacheId = id;
+}
+
+bool SampleTable::loadSampleOrder_l() {
+    const void *data;
+    size_t size;
+    if (mIndexCache == NULL || mNumSampleSizes < kMinIndexCacheSamples
+            || !mIndexCache->find(kSampleOrderSection, mIndexCacheId, &data, &size)
+            || size < sizeof(SampleOrderHeader)) {
+        return false;
+    }
+    const SampleOrderHeader *header = (const SampleOrderHeader *)data;
+    const uint32_t deltaSize = header->mDeltaSize;
+    if (header->mNumSamples != mNumSampleSizes
+            || (deltaSize != 0 && deltaSize != 1 && deltaSize != 2 && deltaSize != 4)
+            || size != sizeof(SampleOrderHeader) + (uint64_t)mNumSampleSizes * deltaSize) {
+        ALOGW("ignoring cached sample order of track %u", mIndexCacheId);
+        return false;
+    }
+
+    // The entry matched this file, but the deltas are still bounds checked before use.
+    mSampleOrderDeltas = deltaSize == 0 ? NULL : header + 1;
+    mSampleOrderDeltaSize = deltaSize;
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        if (getSampleIndexInPresentationOrder(i) >= mNumSampleSizes) {
+            ALOGW("ignoring cached sample order of track %u", mIndexCacheId);
+            mSampleOrderDeltas = NULL;
+            mSampleOrderDeltaSize = 0;
+            return false;
         }
     }
+    ALOGV("using cached sample order of track %u", mIndexCacheId);
+    mSampleOrderValid = true;
+    return true;
+}
 
-    qsort(mSampleTimeEntries, mNumSampleSizes, sizeof(SampleTimeEntry),
-          CompareIncreasingTime);
+void SampleTable::storeSampleOrder_l() {
+    if (mIndexCache == NULL || mNumSampleSizes < kMinIndexCacheSamples) {
+        return;
+    }
+    const size_t deltasSize = (size_t)mNumSampleSizes * mSampleOrderDeltaSize;
+    std::vector<uint8_t> section(sizeof(SampleOrderHeader) + deltasSize);
+    SampleOrderHeader *header = (SampleOrderHeader *)section.data();
+    header->mNumSamples = mNumSampleSizes;
+    header->mDeltaSize = mSampleOrderDeltaSize;
+    if (deltasSize > 0) {
+        memcpy(header + 1, mSampleOrderDeltas, deltasSize);
+    }
+    mIndexCache->store(kSampleOrderSection, mIndexCacheId, section.data(), section.size());
 }
 
 status_t SampleTable::findSampleAtTime(
@@ -719,7 +977,7 @@ status_t SampleTable::findSampleAtTime(
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
-    if (mSampleTimeEntries == NULL) {
+    if (!mSampleOrderValid) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,7 +985,7 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSampleIndexInPresentationOrder(req_time);
         return OK;
     }
 
@@ -743,7 +1001,7 @@ status_t SampleTable::findSampleAtTime(
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSampleIndexInPresentationOrder(center);
             return OK;
         }
     }
@@ -792,7 +1050,7 @@ status_t SampleTable::findSampleAtTime(
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSampleIndexInPresentationOrder(closestIndex);
     return OK;
 }
 
@@ -986,7 +1244,14 @@ status_t SampleTable::getMetaDataForSample(
                     && (mSyncSamples[mLastSyncSampleIndex] <= sampleIndex)
                 ? mLastSyncSampleIndex : 0;
 
-            while (i < mNumSyncSamples && mSyncSamples[i] < sampleIndex) {
+            // step forward when playing sequentially, but search when seeking
+            for (size_t steps = 0; i < mNumSyncSamples && mSyncSamples[i] < sampleIndex;
+                    ++steps) {
+                if (steps == kCheckpointInterval) {
+                    i = std::lower_bound(mSyncSamples + i, mSyncSamples + mNumSyncSamples,
+                            sampleIndex) - mSyncSamples;
+                    break;
+                }
                 ++i;
             }
 
@@ -33,6 +33,7 @@ namespace android {
 struct AMessage;
 struct CDataSource;
 class DataSourceHelper;
+class ExtractorIndexCache;
 class SampleTable;
 class String8;
 namespace heif {
@@ -174,6 +175,9 @@ private:
 
     sp<ItemTable> mItemTable;
 
+    // optional persistent cache of the sample tables' presentation order
+    sp<ExtractorIndexCache> mIndexCache;
+
     status_t parseTrackHeader(off64_t data_offset, off64_t data_size);
 
     status_t parseSegmentIndex(off64_t data_offset, size_t data_size);
@@ -57,16 +57,23 @@ private:
     uint32_t mSamplesPerChunk;
     uint32_t mChunkDesc;
 
+    // Sample-to-chunk position at every SampleTable::kCheckpointInterval-th entry
+    // walked so far, see SampleTable.
+    struct ChunkRange {
+        uint32_t mSampleToChunkIndex;
+        uint32_t mFirstChunk;
+        uint32_t mFirstChunkSampleIndex;
+        uint32_t mStopChunk;
+        uint32_t mStopChunkSampleIndex;
+        uint32_t mSamplesPerChunk;
+        uint32_t mChunkDesc;
+    };
+    Vector<ChunkRange> mChunkRangeCheckpoints;
+
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
     Vector<size_t> mCurrentChunkSampleSizes;
 
-    uint32_t mTimeToSampleIndex;
-    uint32_t mTTSSampleIndex;
-    uint64_t mTTSSampleTime;
-    uint32_t mTTSCount;
-    uint64_t mTTSDuration;
-
     uint32_t mCurrentSampleIndex;
     off64_t mCurrentSampleOffset;
     size_t mCurrentSampleSize;
@@ -74,6 +81,7 @@ private:
     uint64_t mCurrentSampleDuration;
 
     void reset();
+    void restoreChunkRange(uint32_t sampleIndex);
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
@@ -29,6 +29,7 @@
 namespace android {
 
 class DataSourceHelper;
+class ExtractorIndexCache;
 struct SampleIterator;
 
 class SampleTable : public RefBase {
@@ -93,11 +94,22 @@ public:
         mDefaultSampleSize = sampleSize;
     }
 
+    // Reuses the presentation order of the samples from |cache|, under section id |id|,
+    // and stores it there once built. Call before any lookup.
+    void setIndexCache(const sp<ExtractorIndexCache> &cache, uint32_t id);
+
 protected:
     ~SampleTable();
 
 private:
     struct CompositionDeltaLookup;
+    struct TimeToSampleLookup;
+
+    // Lookups walking the run-length coded stts, ctts and stsc tables record their position
+    // at every kCheckpointInterval-th entry the first time they pass it, so that seeking
+    // backwards (or far forwards) resumes from the nearest checkpoint rather than walking
+    // from the first entry. Checkpoints are only recorded for the part of the file visited.
+    static const uint32_t kCheckpointInterval = 64;
 
     static const uint32_t kChunkOffsetType32;
     static const uint32_t kChunkOffsetType64;
@@ -107,6 +119,9 @@ private:
     // Limit the total size of all internal tables to 200MiB.
     static const size_t kMaxTotalSize = 200 * (1 << 20);
 
+    // Presentation orders of fewer samples are cheaper to build than to cache.
+    static const uint32_t kMinIndexCacheSamples = 1024;
+
     DataSourceHelper *mDataSource;
     Mutex mLock;
 
@@ -125,12 +140,23 @@ private:
     bool mHasTimeToSample;
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
-
-    struct SampleTimeEntry {
-        uint32_t mSampleIndex;
-        uint64_t mCompositionTime;
-    };
-    SampleTimeEntry *mSampleTimeEntries;
+    TimeToSampleLookup *mTimeToSampleLookup;
+
+    // Presentation (composition time) order of the samples, built by the first time-based
+    // lookup. If presentation order is decode order, which is the case without ctts or
+    // without frame reordering, no table is needed and mSampleOrderDeltaSize is 0.
+    // Otherwise, as reordering is local, the table only stores for each presentation order
+    // position p the (small) difference between the index of its sample and p, using
+    // mSampleOrderDeltaSize bytes per sample. The table is either owned (mSampleOrderStorage)
+    // or mapped from mIndexCache.
+    bool mSampleOrderBuilt;
+    bool mSampleOrderValid;
+    uint32_t mSampleOrderDeltaSize;
+    const void *mSampleOrderDeltas;
+    void *mSampleOrderStorage;
+
+    sp<ExtractorIndexCache> mIndexCache;
+    uint32_t mIndexCacheId;
 
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
@@ -155,20 +181,25 @@ private:
 
     friend struct SampleIterator;
 
-    // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
-    }
+    // Returns the index of the sample at presentation order position |order|.
+    uint32_t getSampleIndexInPresentationOrder(uint32_t order) const;
+
+    // Returns the composition time of the sample at presentation order position |order|,
+    // scaled by scale_num / scale_den. normally we don't round
+    uint64_t getSampleTime(uint32_t order, uint64_t scale_num, uint64_t scale_den);
+
+    // Returns the composition time of sample |sampleIndex|, clamped to the uint64_t range,
+    // or 0 if the sample is not covered by the time-to-sample table.
+    uint64_t getCompositionTime(uint32_t sampleIndex);
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
-
-    static int CompareIncreasingTime(const void *, const void *);
+    status_t getSampleDecodeTimeAndDuration(
+            uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
 
     void buildSampleEntriesTable();
+    bool loadSampleOrder_l();
+    void storeSampleOrder_l();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
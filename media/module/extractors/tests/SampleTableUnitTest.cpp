@@ -0,0 +1,543 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SampleTableUnitTest"
+#include <utils/Log.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include <SampleTable.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kNumSamples = 5000;
+constexpr uint32_t kRandomSeed = 700;
+constexpr uint32_t kRandomSeeks = 2000;
+constexpr uint32_t kGroupSize = 4;   // a P frame followed by 3 B frames, in decode order
+
+constexpr uint32_t kFlags[] = {
+        SampleTable::kFlagBefore, SampleTable::kFlagAfter, SampleTable::kFlagClosest};
+
+// A CDataSource reading from memory.
+struct MemorySource {
+    std::vector<uint8_t> mData;
+
+    static ssize_t ReadAt(void *handle, off64_t offset, void *data, size_t size) {
+        const MemorySource *source = (const MemorySource *)handle;
+        if (offset < 0 || (size_t)offset >= source->mData.size()) {
+            return 0;
+        }
+        size = std::min(size, source->mData.size() - (size_t)offset);
+        memcpy(data, source->mData.data() + offset, size);
+        return size;
+    }
+    static status_t GetSize(void *handle, off64_t *size) {
+        *size = ((const MemorySource *)handle)->mData.size();
+        return OK;
+    }
+    static uint32_t Flags(void *) {
+        return 0;
+    }
+    static bool GetUri(void *, char *, size_t) {
+        return false;
+    }
+};
+
+// The sample layout of a track, with each table kept as written to the file, and the
+// metadata of every sample computed by walking these tables from the start.
+struct Track {
+    struct Run {
+        uint32_t mFirst;    // first chunk (1-based) for stsc, sample count for stts and ctts
+        uint32_t mValue;    // samples per chunk, duration or composition offset
+    };
+
+    std::vector<uint32_t> mChunkOffsets;
+    std::vector<Run> mSampleToChunk;
+    std::vector<uint32_t> mSampleSizes;
+    std::vector<Run> mTimeToSample;
+    std::vector<Run> mCompositionOffsets;   // empty without ctts
+    std::vector<uint32_t> mSyncSamples;     // 1-based, empty without stss
+
+    struct Sample {
+        off64_t mOffset;
+        size_t mSize;
+        uint64_t mDecodeTime;
+        uint64_t mDuration;
+        uint64_t mCompositionTime;
+        bool mIsSync;
+        uint32_t mLastSampleInChunk;
+    };
+    std::vector<Sample> mSamples;
+
+    // first sample of each stsc run
+    std::vector<uint32_t> mSampleToChunkFirstSamples;
+
+    // sample indices in presentation order
+    std::vector<uint32_t> mPresentationOrder;
+
+    void generate(bool reordered, std::mt19937 &rng);
+    void computeSamples();
+
+    // Results SampleTable::findSampleAtTime() and findSyncSampleNear() must match.
+    status_t findSampleAtTime(uint64_t reqTime, uint64_t scaleNum, uint64_t scaleDen,
+            uint32_t *sampleIndex, uint32_t flags) const;
+    status_t findSyncSampleNear(uint32_t start, uint32_t *sampleIndex, uint32_t flags) const;
+};
+
+void Track::generate(bool reordered, std::mt19937 &rng) {
+    // stsz
+    for (uint32_t i = 0; i < kNumSamples; ++i) {
+        mSampleSizes.push_back(100 + rng() % 1000);
+    }
+
+    // stsc, with short runs of chunks with the same number of samples
+    uint32_t numChunks = 0;
+    for (uint32_t remaining = kNumSamples; remaining > 0; ) {
+        uint32_t samplesPerChunk = 1 + rng() % 6;
+        uint32_t chunks = 1 + rng() % 3;
+        if (samplesPerChunk * chunks > remaining) {
+            samplesPerChunk = 1;
+            chunks = remaining;
+        }
+        mSampleToChunk.push_back({numChunks + 1, samplesPerChunk});
+        numChunks += chunks;
+        remaining -= samplesPerChunk * chunks;
+    }
+
+    // stco, with gaps between chunks
+    uint32_t sample = 0;
+    uint32_t offset = 4096;
+    for (size_t run = 0; run < mSampleToChunk.size(); ++run) {
+        const uint32_t endChunk = run + 1 < mSampleToChunk.size()
+                ? mSampleToChunk[run + 1].mFirst : numChunks + 1;
+        for (uint32_t chunk = mSampleToChunk[run].mFirst; chunk < endChunk; ++chunk) {
+            mChunkOffsets.push_back(offset);
+            for (uint32_t i = 0; i < mSampleToChunk[run].mValue; ++i) {
+                offset += mSampleSizes[sample++];
+            }
+            offset += rng() % 100;
+        }
+    }
+
+    // stts, with short runs of varying durations
+    for (uint32_t remaining = kNumSamples; remaining > 0; ) {
+        static const uint32_t kDurations[] = {1000, 1001, 1002, 3000};
+        const uint32_t count = std::min(remaining, 1 + (uint32_t)(rng() % 5));
+        mTimeToSample.push_back({count, kDurations[rng() % 4]});
+        remaining -= count;
+    }
+
+    if (!reordered) {
+        return;
+    }
+
+    // ctts: each P frame is presented after the B frames following it in decode order
+    for (uint32_t i = 0; i < kNumSamples; i += kGroupSize) {
+        mCompositionOffsets.push_back({1, 6000});
+        mCompositionOffsets.push_back({std::min(kGroupSize, kNumSamples - i) - 1, 1500});
+    }
+
+    // stss: some of the P frames, but not the first one
+    for (uint32_t i = kGroupSize; i < kNumSamples; i += kGroupSize) {
+        if (rng() % 5 == 0) {
+            mSyncSamples.push_back(i + 1);
+        }
+    }
+}
+
+void Track::computeSamples() {
+    mSamples.resize(kNumSamples);
+
+    uint32_t sample = 0;
+    for (size_t run = 0; run < mSampleToChunk.size(); ++run) {
+        const uint32_t endChunk = run + 1 < mSampleToChunk.size()
+                ? mSampleToChunk[run + 1].mFirst : mChunkOffsets.size() + 1;
+        mSampleToChunkFirstSamples.push_back(sample);
+        for (uint32_t chunk = mSampleToChunk[run].mFirst; chunk < endChunk; ++chunk) {
+            off64_t offset = mChunkOffsets[chunk - 1];
+            const uint32_t samplesPerChunk = mSampleToChunk[run].mValue;
+            for (uint32_t i = 0; i < samplesPerChunk; ++i, ++sample) {
+                mSamples[sample].mOffset = offset;
+                mSamples[sample].mSize = mSampleSizes[sample];
+                mSamples[sample].mLastSampleInChunk = sample - i + samplesPerChunk - 1;
+                offset += mSampleSizes[sample];
+            }
+        }
+    }
+
+    sample = 0;
+    uint64_t time = 0;
+    for (const Run &run : mTimeToSample) {
+        for (uint32_t i = 0; i < run.mFirst; ++i, ++sample) {
+            mSamples[sample].mDecodeTime = time;
+            mSamples[sample].mDuration = run.mValue;
+            time += run.mValue;
+        }
+    }
+
+    for (Sample &s : mSamples) {
+        s.mCompositionTime = s.mDecodeTime;
+        s.mIsSync = mSyncSamples.empty();
+    }
+    sample = 0;
+    for (const Run &run : mCompositionOffsets) {
+        for (uint32_t i = 0; i < run.mFirst; ++i, ++sample) {
+            mSamples[sample].mCompositionTime += (int32_t)run.mValue;
+        }
+    }
+    for (uint32_t syncSample : mSyncSamples) {
+        mSamples[syncSample - 1].mIsSync = true;
+    }
+
+    for (uint32_t i = 0; i < kNumSamples; ++i) {
+        mPresentationOrder.push_back(i);
+    }
+    std::stable_sort(mPresentationOrder.begin(), mPresentationOrder.end(),
+            [this](uint32_t a, uint32_t b) {
+                return mSamples[a].mCompositionTime < mSamples[b].mCompositionTime;
+            });
+}
+
+status_t Track::findSampleAtTime(uint64_t reqTime, uint64_t scaleNum, uint64_t scaleDen,
+        uint32_t *sampleIndex, uint32_t flags) const {
+    if (flags == SampleTable::kFlagFrameIndex) {
+        if (reqTime >= kNumSamples) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sampleIndex = mPresentationOrder[reqTime];
+        return OK;
+    }
+
+    auto time = [&](size_t order) {
+        return mSamples[mPresentationOrder[order]].mCompositionTime * scaleNum / scaleDen;
+    };
+    // the first position presented after reqTime
+    const size_t after = std::partition_point(
+            mPresentationOrder.begin(), mPresentationOrder.end(),
+            [&](uint32_t sampleIndex) {
+                return mSamples[sampleIndex].mCompositionTime * scaleNum / scaleDen <= reqTime;
+            }) - mPresentationOrder.begin();
+    if (after > 0 && time(after - 1) == reqTime) {
+        *sampleIndex = mPresentationOrder[after - 1];
+        return OK;
+    }
+
+    if (after == kNumSamples) {
+        if (flags == SampleTable::kFlagAfter) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sampleIndex = mPresentationOrder[after - 1];
+    } else if (after == 0 || flags == SampleTable::kFlagAfter) {
+        *sampleIndex = mPresentationOrder[after];
+    } else if (flags == SampleTable::kFlagBefore) {
+        *sampleIndex = mPresentationOrder[after - 1];
+    } else {
+        *sampleIndex = time(after) - reqTime > reqTime - time(after - 1)
+                ? mPresentationOrder[after - 1] : mPresentationOrder[after];
+    }
+    return OK;
+}
+
+status_t Track::findSyncSampleNear(uint32_t start, uint32_t *sampleIndex, uint32_t flags) const {
+    if (mSyncSamples.empty()) {
+        *sampleIndex = start;
+        return OK;
+    }
+
+    // the first sync sample at or after start, 0-based
+    size_t after = 0;
+    while (after < mSyncSamples.size() && mSyncSamples[after] - 1 < start) {
+        ++after;
+    }
+    if (after < mSyncSamples.size() && mSyncSamples[after] - 1 == start) {
+        *sampleIndex = start;
+        return OK;
+    }
+
+    if (after == mSyncSamples.size()) {
+        if (flags == SampleTable::kFlagAfter) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sampleIndex = mSyncSamples[after - 1] - 1;
+    } else if (after == 0 || flags == SampleTable::kFlagAfter) {
+        *sampleIndex = mSyncSamples[after] - 1;
+    } else if (flags == SampleTable::kFlagBefore) {
+        *sampleIndex = mSyncSamples[after - 1] - 1;
+    } else {
+        const uint64_t time = mSamples[start].mCompositionTime;
+        const uint64_t upper = mSamples[mSyncSamples[after] - 1].mCompositionTime;
+        const uint64_t lower = mSamples[mSyncSamples[after - 1] - 1].mCompositionTime;
+        const uint64_t upperDiff = upper > time ? upper - time : time - upper;
+        const uint64_t lowerDiff = lower > time ? lower - time : time - lower;
+        *sampleIndex = mSyncSamples[(upperDiff > lowerDiff ? after - 1 : after)] - 1;
+    }
+    return OK;
+}
+
+void put32(std::vector<uint8_t> *data, uint32_t value) {
+    data->push_back(value >> 24);
+    data->push_back(value >> 16);
+    data->push_back(value >> 8);
+    data->push_back(value);
+}
+
+// Appends a full box payload, starting with its version and flags, and returns its offset.
+off64_t beginBox(std::vector<uint8_t> *data, uint32_t versionAndFlags) {
+    const off64_t offset = data->size();
+    put32(data, versionAndFlags);
+    return offset;
+}
+
+} // anonymous namespace
+
+class SampleTableTest : public ::testing::TestWithParam<bool /* reordered */> {
+  protected:
+    void SetUp() override {
+        std::mt19937 rng(kRandomSeed);
+        mTrack.generate(GetParam(), rng);
+        mTrack.computeSamples();
+
+        std::vector<uint8_t> &data = mSource.mData;
+        mCSource = {MemorySource::ReadAt, MemorySource::GetSize, MemorySource::Flags,
+                MemorySource::GetUri, &mSource};
+        mHelper.reset(new DataSourceHelper(&mCSource));
+        mTable = new SampleTable(mHelper.get());
+
+        off64_t offset = beginBox(&data, 0);
+        put32(&data, mTrack.mChunkOffsets.size());
+        for (uint32_t chunkOffset : mTrack.mChunkOffsets) {
+            put32(&data, chunkOffset);
+        }
+        ASSERT_EQ(OK, mTable->setChunkOffsetParams(
+                FOURCC("stco"), offset, data.size() - offset));
+
+        offset = beginBox(&data, 0);
+        put32(&data, mTrack.mSampleToChunk.size());
+        for (const Track::Run &run : mTrack.mSampleToChunk) {
+            put32(&data, run.mFirst);
+            put32(&data, run.mValue);
+            put32(&data, 1 /* sample description index */);
+        }
+        ASSERT_EQ(OK, mTable->setSampleToChunkParams(offset, data.size() - offset));
+
+        offset = beginBox(&data, 0);
+        put32(&data, 0 /* sample size */);
+        put32(&data, mTrack.mSampleSizes.size());
+        for (uint32_t size : mTrack.mSampleSizes) {
+            put32(&data, size);
+        }
+        ASSERT_EQ(OK, mTable->setSampleSizeParams(
+                FOURCC("stsz"), offset, data.size() - offset));
+
+        offset = beginBox(&data, 0);
+        put32(&data, mTrack.mTimeToSample.size());
+        for (const Track::Run &run : mTrack.mTimeToSample) {
+            put32(&data, run.mFirst);
+            put32(&data, run.mValue);
+        }
+        ASSERT_EQ(OK, mTable->setTimeToSampleParams(offset, data.size() - offset));
+
+        if (!mTrack.mCompositionOffsets.empty()) {
+            offset = beginBox(&data, 1 << 24 /* version 1, signed offsets */);
+            put32(&data, mTrack.mCompositionOffsets.size());
+            for (const Track::Run &run : mTrack.mCompositionOffsets) {
+                put32(&data, run.mFirst);
+                put32(&data, run.mValue);
+            }
+            ASSERT_EQ(OK, mTable->setCompositionTimeToSampleParams(
+                    offset, data.size() - offset));
+        }
+
+        if (!mTrack.mSyncSamples.empty()) {
+            offset = beginBox(&data, 0);
+            put32(&data, mTrack.mSyncSamples.size());
+            for (uint32_t syncSample : mTrack.mSyncSamples) {
+                put32(&data, syncSample);
+            }
+            ASSERT_EQ(OK, mTable->setSyncSampleParams(offset, data.size() - offset));
+        }
+
+        ASSERT_TRUE(mTable->isValid());
+        ASSERT_EQ(kNumSamples, mTable->countSamples());
+    }
+
+    void expectSample(uint32_t sampleIndex) {
+        off64_t offset;
+        size_t size;
+        uint64_t compositionTime;
+        bool isSyncSample;
+        uint64_t duration;
+        ASSERT_EQ(OK, mTable->getMetaDataForSample(sampleIndex, &offset, &size,
+                &compositionTime, &isSyncSample, &duration)) << "sample " << sampleIndex;
+
+        const Track::Sample &expected = mTrack.mSamples[sampleIndex];
+        EXPECT_EQ(expected.mOffset, offset) << "sample " << sampleIndex;
+        EXPECT_EQ(expected.mSize, size) << "sample " << sampleIndex;
+        EXPECT_EQ(expected.mCompositionTime, compositionTime) << "sample " << sampleIndex;
+        EXPECT_EQ(expected.mIsSync, isSyncSample) << "sample " << sampleIndex;
+        EXPECT_EQ(expected.mDuration, duration) << "sample " << sampleIndex;
+        EXPECT_EQ(expected.mLastSampleInChunk, mTable->getLastSampleIndexInChunk())
+                << "sample " << sampleIndex;
+    }
+
+    // The first sample of every stsc, stts and ctts run, and the last sample before it.
+    std::vector<uint32_t> runBoundaries() const {
+        std::vector<uint32_t> samples = {0, kNumSamples - 1};
+        auto addBoundary = [&samples](uint32_t first) {
+            if (first < kNumSamples) {
+                samples.push_back(first);
+            }
+            if (first > 0) {
+                samples.push_back(first - 1);
+            }
+        };
+        for (uint32_t first : mTrack.mSampleToChunkFirstSamples) {
+            addBoundary(first);
+        }
+        uint32_t first = 0;
+        for (const Track::Run &run : mTrack.mTimeToSample) {
+            addBoundary(first += run.mFirst);
+        }
+        first = 0;
+        for (const Track::Run &run : mTrack.mCompositionOffsets) {
+            addBoundary(first += run.mFirst);
+        }
+        std::sort(samples.begin(), samples.end());
+        samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+        return samples;
+    }
+
+    void expectSampleAtTime(uint64_t reqTime, uint64_t scaleNum, uint64_t scaleDen,
+            uint32_t flags) {
+        uint32_t expected = 0;
+        uint32_t actual = 0;
+        const status_t expectedErr =
+                mTrack.findSampleAtTime(reqTime, scaleNum, scaleDen, &expected, flags);
+        ASSERT_EQ(expectedErr, mTable->findSampleAtTime(
+                reqTime, scaleNum, scaleDen, &actual, flags))
+                << "time " << reqTime << " flags " << flags;
+        if (expectedErr != OK) {
+            return;
+        }
+        // Samples presented at the same time are interchangeable.
+        EXPECT_EQ(mTrack.mSamples[expected].mCompositionTime * scaleNum / scaleDen,
+                mTrack.mSamples[actual].mCompositionTime * scaleNum / scaleDen)
+                << "time " << reqTime << " flags " << flags;
+    }
+
+    MemorySource mSource;
+    CDataSource mCSource;
+    std::unique_ptr<DataSourceHelper> mHelper;
+    sp<SampleTable> mTable;
+    Track mTrack;
+};
+
+TEST_P(SampleTableTest, SequentialAndReverseAccess) {
+    for (uint32_t i = 0; i < kNumSamples; ++i) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(i));
+    }
+    for (uint32_t i = kNumSamples; i-- > 0; ) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(i));
+    }
+
+    off64_t offset;
+    EXPECT_EQ(ERROR_END_OF_STREAM, mTable->getMetaDataForSample(
+            kNumSamples, &offset, nullptr, nullptr));
+}
+
+TEST_P(SampleTableTest, RandomAccess) {
+    std::mt19937 rng(kRandomSeed);
+    for (uint32_t i = 0; i < kRandomSeeks; ++i) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(rng() % kNumSamples));
+    }
+}
+
+TEST_P(SampleTableTest, RunBoundaries) {
+    const std::vector<uint32_t> boundaries = runBoundaries();
+    for (uint32_t sampleIndex : boundaries) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(sampleIndex));
+    }
+    // Backwards, resuming from the checkpoints recorded above
+    for (auto it = boundaries.rbegin(); it != boundaries.rend(); ++it) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(*it));
+    }
+    // Alternating between the first and the last sample
+    for (size_t i = 0; i < boundaries.size() / 2; ++i) {
+        ASSERT_NO_FATAL_FAILURE(expectSample(boundaries[i]));
+        ASSERT_NO_FATAL_FAILURE(expectSample(boundaries[boundaries.size() - 1 - i]));
+    }
+}
+
+TEST_P(SampleTableTest, FindSampleAtTime) {
+    const uint64_t lastTime = mTrack.mSamples[mTrack.mPresentationOrder.back()].mCompositionTime;
+    for (uint32_t flags : kFlags) {
+        ASSERT_NO_FATAL_FAILURE(expectSampleAtTime(0, 1, 1, flags));
+        ASSERT_NO_FATAL_FAILURE(expectSampleAtTime(lastTime + 1, 1, 1, flags));
+        for (const Track::Sample &sample : mTrack.mSamples) {
+            if (sample.mCompositionTime > 0) {
+                ASSERT_NO_FATAL_FAILURE(
+                        expectSampleAtTime(sample.mCompositionTime - 1, 1, 1, flags));
+            }
+            ASSERT_NO_FATAL_FAILURE(expectSampleAtTime(sample.mCompositionTime, 1, 1, flags));
+            ASSERT_NO_FATAL_FAILURE(
+                    expectSampleAtTime(sample.mCompositionTime + 400, 1, 1, flags));
+            // as MPEG4Source does, with a 90kHz media timescale
+            ASSERT_NO_FATAL_FAILURE(expectSampleAtTime(
+                    sample.mCompositionTime * 1000000 / 90000, 1000000, 90000, flags));
+        }
+    }
+
+    for (uint32_t order = 0; order <= kNumSamples; ++order) {
+        ASSERT_NO_FATAL_FAILURE(
+                expectSampleAtTime(order, 1, 1, SampleTable::kFlagFrameIndex));
+    }
+}
+
+TEST_P(SampleTableTest, FindSyncSampleNear) {
+    for (uint32_t flags : kFlags) {
+        for (uint32_t start = 0; start < kNumSamples; ++start) {
+            uint32_t expected = 0;
+            uint32_t actual = 0;
+            const status_t expectedErr = mTrack.findSyncSampleNear(start, &expected, flags);
+            ASSERT_EQ(expectedErr, mTable->findSyncSampleNear(start, &actual, flags))
+                    << "start " << start << " flags " << flags;
+            if (expectedErr == OK) {
+                ASSERT_EQ(expected, actual) << "start " << start << " flags " << flags;
+            }
+        }
+    }
+    // Seeking still works after the closest sync sample search moved the iterator
+    ASSERT_NO_FATAL_FAILURE(expectSample(0));
+    ASSERT_NO_FATAL_FAILURE(expectSample(kNumSamples - 1));
+}
+
+INSTANTIATE_TEST_SUITE_P(SampleTableUnitTest, SampleTableTest, ::testing::Bool(),
+        [](const ::testing::TestParamInfo<bool> &info) {
+            return info.param ? "Reordered" : "DecodeOrder";
+        });
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include <sys/types.h>
 
 #include "AAtomizer.h"
@@ -25,43 +26,96 @@ AAtomizer AAtomizer::gAtomizer;
 
 // static
 const char *AAtomizer::Atomize(const char *name) {
-    return gAtomizer.atomize(name);
+    size_t len;
+    const uint32_t hash = Hash(name, &len);
+    return gAtomizer.atomize(name, len, hash, true /* mayOverflow */);
 }
 
-AAtomizer::AAtomizer() {
-    for (size_t i = 0; i < 128; ++i) {
-        mAtoms.push(List<AString>());
+// static
+const char *AAtomizer::TryAtomize(const char *name, size_t len, uint32_t hash) {
+    const char *atom = gAtomizer.find(name, len, hash);
+    if (atom != nullptr) {
+        return atom;
+    }
+    if (gAtomizer.mNumAtoms.load(std::memory_order_relaxed) >= kMaxAtoms) {
+        return nullptr;     // don't take the lock when the table is known to be full
+    }
+    return gAtomizer.atomize(name, len, hash, false /* mayOverflow */);
+}
+
+AAtomizer::AAtomizer()
+    : mNumAtoms(0) {
+    for (Slot &slot : mSlots) {
+        slot.mAtom.store(nullptr, std::memory_order_relaxed);
+        slot.mHash = 0;
+        slot.mLength = 0;
+    }
+}
+
+const char *AAtomizer::find(const char *name, size_t len, uint32_t hash) const {
+    for (size_t i = hash & (kCapacity - 1); ; i = (i + 1) & (kCapacity - 1)) {
+        const char *atom = mSlots[i].mAtom.load(std::memory_order_acquire);
+        if (atom == nullptr) {
+            return nullptr;
+        }
+        // mHash and mLength were written before the atom was published
+        if (atom == name || (mSlots[i].mHash == hash && mSlots[i].mLength == len
+                && !memcmp(atom, name, len))) {
+            return atom;
+        }
     }
 }
 
-const char *AAtomizer::atomize(const char *name) {
+const char *AAtomizer::atomize(const char *name, size_t len, uint32_t hash, bool mayOverflow) {
     Mutex::Autolock autoLock(mLock);
 
-    const size_t n = mAtoms.size();
-    size_t index = AAtomizer::Hash(name) % n;
-    List<AString> &entry = mAtoms.editItemAt(index);
-    List<AString>::iterator it = entry.begin();
-    while (it != entry.end()) {
+    const char *atom = find(name, len, hash);
+    if (atom != nullptr) {
+        return atom;
+    }
+
+    if (mNumAtoms < kMaxAtoms) {
+        size_t i = hash & (kCapacity - 1);
+        while (mSlots[i].mAtom.load(std::memory_order_relaxed) != nullptr) {
+            i = (i + 1) & (kCapacity - 1);
+        }
+        char *copy = new char[len + 1];
+        memcpy(copy, name, len);
+        copy[len] = '\0';
+        mSlots[i].mHash = hash;
+        mSlots[i].mLength = len;
+        mSlots[i].mAtom.store(copy, std::memory_order_release);
+        mNumAtoms.store(mNumAtoms.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        return copy;
+    }
+
+    if (!mayOverflow) {
+        return nullptr;
+    }
+    for (List<AString>::iterator it = mOverflow.begin(); it != mOverflow.end(); ++it) {
         if ((*it) == name) {
             return (*it).c_str();
         }
-        ++it;
     }
-
-    entry.push_back(AString(name));
-
-    return (*--entry.end()).c_str();
+    mOverflow.push_back(AString(name, len));
+    return (*--mOverflow.end()).c_str();
 }
 
 // static
-uint32_t AAtomizer::Hash(const char *s) {
-    uint32_t sum = 0;
-    while (*s != '\0') {
-        sum = (sum * 31) + *s;
-        ++s;
+__attribute__((no_sanitize("integer")))
+uint32_t AAtomizer::Hash(const char *s, size_t *len) {
+    // 32-bit FNV-1a, which spreads well into the low bits used for the table index
+    uint32_t hash = 2166136261u;
+    const char *p = s;
+    while (*p != '\0') {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+        ++p;
     }
-
-    return sum;
+    if (len != nullptr) {
+        *len = p - s;
+    }
+    return hash;
 }
 
 }  // namespace android
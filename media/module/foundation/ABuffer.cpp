@@ -22,6 +22,21 @@
 
 namespace android {
 
+// static
+void *ABuffer::operator new(size_t size) {
+    return AObjectPool<ABuffer>::Allocate(size);
+}
+
+// static
+void ABuffer::operator delete(void *ptr, size_t size) {
+    AObjectPool<ABuffer>::Free(ptr, size);
+}
+
+// static
+AObjectPoolStats ABuffer::GetAllocationStats() {
+    return AObjectPool<ABuffer>::GetStats();
+}
+
 ABuffer::ABuffer(size_t capacity)
     : mRangeOffset(0),
       mInt32Data(0),
@@ -52,6 +52,21 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     return OK;
 }
 
+// static
+void *AMessage::operator new(size_t size) {
+    return AObjectPool<AMessage>::Allocate(size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+    AObjectPool<AMessage>::Free(ptr, size);
+}
+
+// static
+AObjectPoolStats AMessage::GetAllocationStats() {
+    return AObjectPool<AMessage>::GetStats();
+}
+
 AMessage::AMessage(void)
     : mWhat(0),
       mTarget(0) {
@@ -89,11 +104,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
+    mIndex.clear();
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -150,20 +165,35 @@ static void reportStats() {
 }
 #endif
 
-inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+inline size_t AMessage::findItemIndex(const char *name, size_t len, uint32_t hash) const {
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
     size_t i = 0;
-    for (; i < mItems.size(); i++) {
-        if (len != mItems[i].mNameLength) {
-            continue;
+    if (mIndex.empty()) {
+        for (; i < mItems.size(); i++) {
+#ifdef DUMP_STATS
+            ++memchecks;
+#endif
+            if (mItems[i].hasName(name, len, hash)) {
+                break;
+            }
         }
+    } else {
+        const size_t mask = mIndex.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const uint16_t entry = mIndex[slot];
+            if (entry == 0) {
+                i = mItems.size();
+                break;
+            }
 #ifdef DUMP_STATS
-        ++memchecks;
+            ++memchecks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
-            break;
+            if (mItems[entry - 1].hasName(name, len, hash)) {
+                i = entry - 1;
+                break;
+            }
         }
     }
 #ifdef DUMP_STATS
@@ -179,22 +209,88 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
-// assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
+size_t AMessage::findItemIndex(const char *name) const {
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    return findItemIndex(name, len, hash);
+}
+
+void AMessage::indexItem(size_t ix) {
+    if (mItems.size() < kMinIndexedItems) {
+        return;
+    }
+    if (mIndex.size() < 2 * mItems.size()) {
+        rebuildIndex();  // also indexes item ix
+        return;
+    }
+    const size_t mask = mIndex.size() - 1;
+    size_t slot = mItems[ix].mNameHash & mask;
+    while (mIndex[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = ix + 1;
+}
+
+void AMessage::rebuildIndex() {
+    mIndex.clear();
+    if (mItems.size() < kMinIndexedItems) {
+        return;
+    }
+    size_t size = 2 * kMinIndexedItems;
+    while (size < 2 * mItems.size()) {
+        size <<= 1;
+    }
+    mIndex.resize(size);
+    const size_t mask = size - 1;
+    for (size_t ix = 0; ix < mItems.size(); ++ix) {
+        const Item &item = mItems[ix];
+        size_t slot = item.mNameHash & mask;
+        bool duplicate = false;
+        while (mIndex[slot] != 0) {
+            // a parcel may contain duplicate names; as with a linear scan, the first one wins
+            if (mItems[mIndex[slot] - 1].hasName(item.mName, item.mNameLength, item.mNameHash)) {
+                duplicate = true;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (!duplicate) {
+            mIndex[slot] = ix + 1;
+        }
+    }
+}
+
+void AMessage::Item::setName(const char *name, size_t len, uint32_t hash, bool intern) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    mNameHash = hash;
+    mName = intern ? AAtomizer::TryAtomize(name, len, hash) : nullptr;
+    // fall back to a private copy if the atom table is full
+    mNameOwned = mName == nullptr;
+    if (mNameOwned) {
+        char *copy = new char[len + 1];
+        memcpy(copy, name, len + 1);
+        mName = copy;
+    }
 }
 
-AMessage::Item::Item(const char *name, size_t len)
+void AMessage::Item::freeName() {
+    if (mNameOwned) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameOwned = false;
+}
+
+AMessage::Item::Item(const char *name, size_t len, uint32_t hash)
     : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
-    setName(name, len);
+    // mName, mNameLength, mNameHash and mNameOwned are initialized by setName
+    setName(name, len, hash);
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
-    size_t len = strlen(name);
-    size_t i = findItemIndex(name, len);
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     Item *item;
 
     if (i < mItems.size()) {
@@ -204,7 +300,8 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        mItems.emplace_back(name, len, hash);
+        indexItem(i);
         item = &mItems[i];
     }
 
@@ -213,7 +310,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
 
 const AMessage::Item *AMessage::findItem(
         const char *name, Type type) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         return item->mType == type ? item : NULL;
@@ -223,7 +320,7 @@ const AMessage::Item *AMessage::findItem(
 }
 
 bool AMessage::findAsFloat(const char *name, float *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -250,7 +347,7 @@ bool AMessage::findAsFloat(const char *name, float *value) const {
 }
 
 bool AMessage::findAsInt64(const char *name, int64_t *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -268,7 +365,7 @@ bool AMessage::findAsInt64(const char *name, int64_t *value) const {
 }
 
 bool AMessage::contains(const char *name) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     return i < mItems.size();
 }
 
@@ -491,6 +588,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
     msg->mItems = mItems;
+    msg->mIndex = mIndex;
 
 #ifdef DUMP_STATS
     {
@@ -505,7 +603,12 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        if (!from->mNameOwned) {
+            to->mName = from->mName;   // share the atom
+        } else {
+            // an owned name was not atomized (e.g. it came from a parcel), keep it private
+            to->setName(from->mName, from->mNameLength, from->mNameHash, false /* intern */);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -771,8 +874,12 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        // names from a parcel are not trusted, so are not atomized
+        size_t len;
+        const uint32_t hash = AAtomizer::Hash(name, &len);
+        item->setName(name, len, hash, false /* intern */);
     }
+    msg->rebuildIndex();
 
     return msg;
 }
@@ -1022,13 +1129,14 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (!strcmp(name, mItems[index].mName)) {
         return OK; // name has not changed
     }
-    size_t len = strlen(name);
-    if (findItemIndex(name, len) < mItems.size()) {
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    if (findItemIndex(name, len, hash) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    mItems[index].freeName();
+    mItems[index].setName(name, len, hash);
+    rebuildIndex();
     return OK;
 }
 
@@ -1091,8 +1199,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1100,9 +1207,11 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameOwned = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
+    rebuildIndex();
     return OK;
 }
 
@@ -1146,7 +1255,7 @@ void AMessage::extend(const sp<AMessage> &other) {
 }
 
 size_t AMessage::findEntryByName(const char *name) const {
-    return name == nullptr ? countEntries() : findItemIndex(name, strlen(name));
+    return name == nullptr ? countEntries() : findItemIndex(name);
 }
 
 }  // namespace android
@@ -17,7 +17,9 @@
 #define LOG_TAG "MediaBufferGroup"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <list>
+#include <vector>
 
 #include <binder/MemoryDealer.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -36,11 +38,77 @@ constexpr T MIN(const T &a, const T &b) { return a <= b ? a : b; }
 static const size_t kSharedMemoryThreshold = MIN(
         (size_t)MediaBuffer::kSharedMemThreshold, (size_t)(4 * 1024));
 
+// Free buffers are kept in lists by the power of two of their size.
+static constexpr size_t kNumSizeClasses = sizeof(size_t) * 8;
+
+static size_t sizeClassOf(size_t size) {
+    return size == 0 ? 0 : kNumSizeClasses - 1 - __builtin_clzl(size);
+}
+
 struct MediaBufferGroup::InternalData {
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
     std::list<MediaBufferBase *> mBuffers;
+
+    // Buffers returned to the group, by size class, so that acquire_buffer()
+    // finds a large enough buffer without scanning mBuffers. Buffers can also
+    // become free without being returned (e.g. remote release, claim()), so
+    // acquire_buffer() still scans mBuffers when these are empty. Each list
+    // has room for all buffers of its class, so returning a buffer does not
+    // allocate.
+    std::vector<MediaBufferBase *> mFreeLists[kNumSizeClasses];
+    size_t mNumBuffersInClass[kNumSizeClasses] = {};
+    size_t mNumWaiters = 0;
+
+    // statistics
+    uint64_t mNumAcquired = 0;
+    uint64_t mNumFreeListHits = 0;  // buffers acquired from the free lists
+    uint64_t mNumWaits = 0;         // times acquire_buffer() blocked
+    uint64_t mNumAllocations = 0;   // buffers allocated by acquire_buffer()
+    uint64_t mNumReallocations = 0; // of which replaced a smaller free buffer
+    size_t mNumInUse = 0;
+    size_t mPeakInUse = 0;
+
+    void track(MediaBufferBase *buffer) {
+        size_t sizeClass = sizeClassOf(buffer->size());
+        mFreeLists[sizeClass].reserve(++mNumBuffersInClass[sizeClass]);
+    }
+
+    void untrack(MediaBufferBase *buffer) {
+        size_t sizeClass = sizeClassOf(buffer->size());
+        --mNumBuffersInClass[sizeClass];
+        std::vector<MediaBufferBase *> &freeList = mFreeLists[sizeClass];
+        auto it = std::find(freeList.begin(), freeList.end(), buffer);
+        if (it != freeList.end()) {
+            *it = freeList.back();
+            freeList.pop_back();
+        }
+    }
+
+    // Returns the most recently returned free buffer of at least
+    // |requestedSize| bytes, or nullptr.
+    MediaBufferBase *takeFreeBuffer(size_t requestedSize) {
+        for (size_t sizeClass = sizeClassOf(requestedSize);
+                sizeClass < kNumSizeClasses; ++sizeClass) {
+            std::vector<MediaBufferBase *> &freeList = mFreeLists[sizeClass];
+            for (size_t i = freeList.size(); i > 0; --i) {
+                MediaBufferBase *buffer = freeList[i - 1];
+                // only the first class may have smaller buffers
+                if (buffer->size() < requestedSize) {
+                    continue;
+                }
+                freeList[i - 1] = freeList.back();
+                freeList.pop_back();
+                // Still referenced remotely; scanning finds it once released.
+                if (buffer->refcount() != 0) {
+                    continue;
+                }
+                return buffer;
+            }
+        }
+        return nullptr;
+    }
 };
 
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
@@ -102,6 +170,11 @@ void MediaBufferGroup::init(size_t buffers, size_t buffer_size, size_t growthLim
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
+    if (mInternal->mNumAcquired > 0) {
+        std::string stats;
+        dump(&stats);
+        ALOGV("%s", stats.c_str());
+    }
     for (MediaBufferBase *buffer : mInternal->mBuffers) {
         if (buffer->refcount() != 0) {
             const int localRefcount = buffer->localRefcount();
@@ -137,6 +210,7 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
             && mInternal->mBuffers.size() >= mInternal->mGrowthLimit
             && it != mInternal->mBuffers.end();) {
         if ((*it)->refcount() == 0) {
+            mInternal->untrack(*it);
             (*it)->setObserver(nullptr);
             (*it)->release();
             it = mInternal->mBuffers.erase(it);
@@ -147,6 +221,34 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
 
     buffer->setObserver(this);
     mInternal->mBuffers.emplace_back(buffer);
+    mInternal->track(buffer);
+    if (buffer->refcount() == 0) {
+        mInternal->mFreeLists[sizeClassOf(buffer->size())].push_back(buffer);
+    }
+}
+
+void MediaBufferGroup::prewarm(size_t buffers, size_t buffer_size) {
+    {
+        Mutex::Autolock autoLock(mInternal->mLock);
+        if (mInternal->mGrowthLimit > 0) {
+            size_t room = mInternal->mGrowthLimit
+                    - std::min(mInternal->mBuffers.size(), mInternal->mGrowthLimit);
+            if (buffers > room) {
+                ALOGW("Prewarming only %zu of %zu buffers of size %zu within growthLimit %zu",
+                        room, buffers, buffer_size, mInternal->mGrowthLimit);
+                buffers = room;
+            }
+        }
+    }
+    for (size_t i = 0; i < buffers; ++i) {
+        MediaBuffer *buffer = new MediaBuffer(buffer_size);
+        if (buffer->data() == nullptr) {
+            delete buffer; // don't call release, it's not properly formed
+            ALOGW("Only prewarmed %zu buffers of size %zu", i, buffer_size);
+            break;
+        }
+        add_buffer(buffer);
+    }
 }
 
 bool MediaBufferGroup::has_buffers() {
@@ -165,9 +267,15 @@ status_t MediaBufferGroup::acquire_buffer(
         MediaBufferBase **out, bool nonBlocking, size_t requestedSize) {
     Mutex::Autolock autoLock(mInternal->mLock);
     for (;;) {
+        MediaBufferBase *buffer = mInternal->takeFreeBuffer(requestedSize);
+        if (buffer != nullptr) {
+            ++mInternal->mNumFreeListHits;
+            acquired(buffer);
+            *out = buffer;
+            return OK;
+        }
         size_t smallest = requestedSize;
         size_t biggest = requestedSize;
-        MediaBufferBase *buffer = nullptr;
         auto free = mInternal->mBuffers.end();
         for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
             const size_t size = (*it)->size();
@@ -199,9 +307,12 @@ status_t MediaBufferGroup::acquire_buffer(
                 buffer = nullptr;
             } else {
                 buffer->setObserver(this);
+                ++mInternal->mNumAllocations;
                 if (free != mInternal->mBuffers.end()) {
                     ALOGV("reallocate buffer, requested size %zu vs available %zu",
                             requestedSize, (*free)->size());
+                    ++mInternal->mNumReallocations;
+                    mInternal->untrack(*free);
                     (*free)->setObserver(nullptr);
                     (*free)->release();
                     *free = buffer; // in-place replace
@@ -209,11 +320,11 @@ status_t MediaBufferGroup::acquire_buffer(
                     ALOGV("allocate buffer, requested size %zu", requestedSize);
                     mInternal->mBuffers.emplace_back(buffer);
                 }
+                mInternal->track(buffer);
             }
         }
         if (buffer != nullptr) {
-            buffer->add_ref();
-            buffer->reset();
+            acquired(buffer);
             *out = buffer;
             return OK;
         }
@@ -222,7 +333,10 @@ status_t MediaBufferGroup::acquire_buffer(
             return WOULD_BLOCK;
         }
         // All buffers are in use, block until one of them is returned.
+        ++mInternal->mNumWaits;
+        ++mInternal->mNumWaiters;
         mInternal->mCondition.wait(mInternal->mLock);
+        --mInternal->mNumWaiters;
     }
     // Never gets here.
 }
@@ -231,9 +345,41 @@ size_t MediaBufferGroup::buffers() const {
     return mInternal->mBuffers.size();
 }
 
-void MediaBufferGroup::signalBufferReturned(MediaBufferBase *) {
+void MediaBufferGroup::acquired(MediaBufferBase *buffer) {
+    buffer->add_ref();
+    buffer->reset();
+    ++mInternal->mNumAcquired;
+    mInternal->mPeakInUse = std::max(mInternal->mPeakInUse, ++mInternal->mNumInUse);
+}
+
+void MediaBufferGroup::dump(std::string *out) const {
+    Mutex::Autolock autoLock(mInternal->mLock);
+    out->append("buffers: ").append(std::to_string(mInternal->mBuffers.size()))
+            .append(" (growth limit ").append(std::to_string(mInternal->mGrowthLimit))
+            .append("), in use: ").append(std::to_string(mInternal->mNumInUse))
+            .append(" (peak ").append(std::to_string(mInternal->mPeakInUse))
+            .append("), acquired: ").append(std::to_string(mInternal->mNumAcquired))
+            .append(" (from free lists ").append(std::to_string(mInternal->mNumFreeListHits))
+            .append("), waits: ").append(std::to_string(mInternal->mNumWaits))
+            .append(", allocations: ").append(std::to_string(mInternal->mNumAllocations))
+            .append(" (reallocations ").append(std::to_string(mInternal->mNumReallocations))
+            .append(")\n");
+}
+
+void MediaBufferGroup::signalBufferReturned(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mInternal->mLock);
-    mInternal->mCondition.signal();
+    if (buffer != nullptr) {
+        // Buffers still referenced remotely are found by scanning once released.
+        if (buffer->refcount() == 0) {
+            mInternal->mFreeLists[sizeClassOf(buffer->size())].push_back(buffer);
+        }
+        if (mInternal->mNumInUse > 0) {
+            --mInternal->mNumInUse;
+        }
+    }
+    if (mInternal->mNumWaiters > 0) {
+        mInternal->mCondition.signal();
+    }
 }
 
 }  // namespace android
@@ -20,28 +20,55 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AString.h>
 #include <utils/List.h>
-#include <utils/Vector.h>
 #include <utils/threads.h>
 
 namespace android {
 
+// AAtomizer maps strings to unique, immortal "atoms": equal strings are atomized to the
+// same pointer, so atoms can be compared by pointer.
+//
+// Atoms are kept in a fixed-size open-addressing table. Lookups of existing atoms are
+// lock-free; only the creation of a new atom takes a lock.
 struct AAtomizer {
+    // Returns the atom for |name|, creating it if needed. Always succeeds.
     static const char *Atomize(const char *name);
 
+    // Returns the atom for |name|, creating it only if the atom table has room;
+    // returns nullptr otherwise. |len| and |hash| must be those of |name|, see Hash().
+    // Does not take a lock if |name| is already atomized.
+    static const char *TryAtomize(const char *name, size_t len, uint32_t hash);
+
+    // Returns the hash of the NUL-terminated |s|, and its length in |len| if not null.
+    static uint32_t Hash(const char *s, size_t *len = nullptr);
+
 private:
+    enum {
+        kCapacity = 2048,           // must be a power of 2
+        kMaxAtoms = kCapacity / 2,  // bounds the load factor, so probing always terminates
+    };
+
+    struct Slot {
+        std::atomic<const char *> mAtom;    // published last, with release semantics
+        uint32_t mHash;
+        uint32_t mLength;
+    };
+
     static AAtomizer gAtomizer;
 
-    Mutex mLock;
-    Vector<List<AString> > mAtoms;
+    Mutex mLock;                    // serializes creation of atoms
+    std::atomic<size_t> mNumAtoms;  // only modified with mLock held
+    List<AString> mOverflow;        // atoms created by Atomize() once the table is full
+    Slot mSlots[kCapacity];
 
     AAtomizer();
 
-    const char *atomize(const char *name);
-
-    static uint32_t Hash(const char *s);
+    const char *find(const char *name, size_t len, uint32_t hash) const;
+    const char *atomize(const char *name, size_t len, uint32_t hash, bool mayOverflow);
 
     DISALLOW_EVIL_CONSTRUCTORS(AAtomizer);
 };
@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 #include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AObjectPool.h>
 #include <utils/RefBase.h>
 
 namespace android {
@@ -32,6 +33,13 @@ struct ABuffer : public RefBase {
     explicit ABuffer(size_t capacity);
     ABuffer(void *data, size_t capacity);
 
+    // ABuffer objects (but not their data) are recycled through an AObjectPool.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
+    // Returns the allocation statistics of ABuffer objects in this process.
+    static AObjectPoolStats GetAllocationStats();
+
     uint8_t *base() { return (uint8_t *)mData; }
     uint8_t *data() { return (uint8_t *)mData + mRangeOffset; }
     size_t capacity() const { return mCapacity; }
@@ -21,9 +21,12 @@
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AData.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AObjectPool.h>
 #include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
 
+#include <string.h>
+
 #include <vector>
 
 namespace android {
@@ -92,6 +95,13 @@ struct AMessage : public RefBase {
     void writeToParcel(Parcel *parcel) const;
 #endif // !defined(__ANDROID_VNDK__) && !defined(__ANDROID_APEX__)
 
+    // AMessage objects are recycled through an AObjectPool.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
+    // Returns the allocation statistics of AMessage objects in this process.
+    static AObjectPoolStats GetAllocationStats();
+
     void setWhat(uint32_t what);
     uint32_t what() const;
 
@@ -100,6 +110,10 @@ struct AMessage : public RefBase {
     // removes all items
     void clear();
 
+    // Item names are atomized (see AAtomizer) when the item is created, so copies of a
+    // message share them. Lookups hash the name and compare it by pointer first, so callers
+    // that look up the same names repeatedly may pass names atomized with
+    // AAtomizer::Atomize() to skip the string comparison.
     void setInt32(const char *name, int32_t value);
     void setInt64(const char *name, int64_t value);
     void setSize(const char *name, size_t value);
@@ -309,17 +323,34 @@ private:
         } u;
         const char *mName;
         size_t      mNameLength;
+        uint32_t    mNameHash;      // AAtomizer::Hash() of mName
+        bool        mNameOwned;     // whether mName is a copy owned by this item, or an atom
         Type mType;
-        void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
-        Item(const char *name, size_t length);
+        // assumes item's name was uninitialized or NULL. Unless |intern| is false, the name
+        // is atomized so that it can be shared by copies of this item.
+        void setName(const char *name, size_t len, uint32_t hash, bool intern = true);
+        void freeName();
+        bool hasName(const char *name, size_t len, uint32_t hash) const {
+            return mName == name
+                    || (mNameHash == hash && mNameLength == len && !memcmp(mName, name, len));
+        }
+        Item() : mName(nullptr), mNameLength(0), mNameHash(0), mNameOwned(false),
+                mType(kTypeInt32) { }
+        Item(const char *name, size_t length, uint32_t hash);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // messages with at least this many items keep a hash index of their items
+        kMinIndexedItems = 8,
     };
     std::vector<Item> mItems;
 
+    // Open-addressing (linear probing) hash table of item index + 1, keyed by the name hash,
+    // with 0 for empty slots. Empty if the message has fewer than kMinIndexedItems items.
+    // Its size is a power of 2 and at least twice the number of items.
+    std::vector<uint16_t> mIndex;
+
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
      * item value is freed. Otherwise a new item is added.
@@ -349,7 +380,18 @@ private:
     void setObjectInternal(
             const char *name, const sp<RefBase> &obj, Type type);
 
-    size_t findItemIndex(const char *name, size_t len) const;
+    /**
+     * Returns the index of the item with the given key |name| of length |len| and
+     * AAtomizer::Hash() |hash|, or mItems.size() if the item is not found.
+     */
+    size_t findItemIndex(const char *name, size_t len, uint32_t hash) const;
+    size_t findItemIndex(const char *name) const;
+
+    /** Adds item |ix| to the hash index, growing or creating the index as needed. */
+    void indexItem(size_t ix);
+
+    /** Recreates the hash index from scratch, e.g. after items were removed or renamed. */
+    void rebuildIndex();
 
     void deliver();
 
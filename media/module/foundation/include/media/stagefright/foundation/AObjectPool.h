@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_OBJECT_POOL_H_
+
+#define A_OBJECT_POOL_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace android {
+
+// Allocation statistics of an AObjectPool. Counts are flushed from each thread
+// in batches, so they may lag the actual counts by a few dozen per thread.
+struct AObjectPoolStats {
+    uint64_t mAllocations = 0;      // objects allocated
+    uint64_t mHeapAllocations = 0;  // of which needed a heap allocation
+    uint64_t mFrees = 0;            // objects freed
+    uint64_t mHeapFrees = 0;        // of which were returned to the heap
+};
+
+/*
+ * Recycles the memory of frequently allocated fixed-size foundation objects, such as AMessage
+ * and ABuffer, which are used from class-specific operator new and delete. As RefBase deletes
+ * objects through their virtual destructor, this also applies to objects released by sp<>.
+ *
+ * Each thread caches up to kBatchSize free blocks. Threads which free more objects than they
+ * allocate, like loopers, pass full batches to a shared depot that other threads refill from,
+ * so that producer-consumer patterns are recycled as well. Only the depot takes a lock, once
+ * per batch. Memory beyond the depot capacity is returned to the heap.
+ *
+ * Objects of another size than T (e.g. subclasses) bypass the pool. So do all objects in
+ * ASan and HWASan builds, so that the sanitizers still catch use-after-free and overflows
+ * of these objects; they are still counted in the statistics.
+ */
+template <typename T>
+class AObjectPool {
+public:
+#if __has_feature(address_sanitizer) || __has_feature(hwaddress_sanitizer)
+    static constexpr bool kRecycles = false;
+#else
+    static constexpr bool kRecycles = true;
+#endif
+
+    static void *Allocate(size_t size) {
+        if (size != sizeof(T)) {
+            return ::operator new(size);
+        }
+        ThreadCache &cache = sCache;
+        if (kRecycles && cache.mHead == nullptr && !cache.mDestroyed) {
+            cache.mHead = takeBatch();
+            cache.mCount = cache.mHead == nullptr ? 0 : kBatchSize;
+        }
+        void *ptr;
+        if (cache.mHead != nullptr) {
+            Block *block = cache.mHead;
+            cache.mHead = block->mNext;
+            --cache.mCount;
+            ptr = block;
+        } else {
+            ptr = ::operator new(sizeof(T));
+            ++cache.mStats.mHeapAllocations;
+        }
+        ++cache.mStats.mAllocations;
+        cache.flushStatsIfNeeded();
+        return ptr;
+    }
+
+    static void Free(void *ptr, size_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+        if (size != sizeof(T)) {
+            ::operator delete(ptr);
+            return;
+        }
+        ThreadCache &cache = sCache;
+        ++cache.mStats.mFrees;
+        if (!kRecycles || cache.mDestroyed) {
+            // or freed while this thread is exiting, after its cache was released
+            ::operator delete(ptr);
+            ++cache.mStats.mHeapFrees;
+            cache.flushStatsIfNeeded();
+            return;
+        }
+        if (cache.mCount == kBatchSize) {
+            if (!giveBatch(cache.mHead)) {
+                freeBlocks(cache.mHead);
+                cache.mStats.mHeapFrees += kBatchSize;
+            }
+            cache.mHead = nullptr;
+            cache.mCount = 0;
+        }
+        Block *block = static_cast<Block *>(ptr);
+        block->mNext = cache.mHead;
+        cache.mHead = block;
+        ++cache.mCount;
+        cache.flushStatsIfNeeded();
+    }
+
+    static AObjectPoolStats GetStats() {
+        AObjectPoolStats stats;
+        stats.mAllocations = sAllocations.load(std::memory_order_relaxed);
+        stats.mHeapAllocations = sHeapAllocations.load(std::memory_order_relaxed);
+        stats.mFrees = sFrees.load(std::memory_order_relaxed);
+        stats.mHeapFrees = sHeapFrees.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    enum {
+        kBatchSize = 32,        // free blocks cached per thread, and per depot batch
+        kMaxDepotBatches = 16,  // batches kept in the depot
+    };
+
+    struct Block {
+        Block *mNext;
+    };
+    static_assert(sizeof(T) >= sizeof(Block));
+
+    struct ThreadCache {
+        Block *mHead = nullptr;
+        size_t mCount = 0;
+        bool mDestroyed = false;
+        AObjectPoolStats mStats;    // not yet flushed to the shared counters
+
+        void flushStatsIfNeeded() {
+            if (mStats.mAllocations + mStats.mFrees >= kBatchSize) {
+                flushStats();
+            }
+        }
+
+        void flushStats() {
+            sAllocations.fetch_add(mStats.mAllocations, std::memory_order_relaxed);
+            sHeapAllocations.fetch_add(mStats.mHeapAllocations, std::memory_order_relaxed);
+            sFrees.fetch_add(mStats.mFrees, std::memory_order_relaxed);
+            sHeapFrees.fetch_add(mStats.mHeapFrees, std::memory_order_relaxed);
+            mStats = AObjectPoolStats();
+        }
+
+        ~ThreadCache() {
+            // another thread may still reuse a full batch
+            if (mCount != kBatchSize || !giveBatch(mHead)) {
+                freeBlocks(mHead);
+                mStats.mHeapFrees += mCount;
+            }
+            mHead = nullptr;
+            mCount = 0;
+            mDestroyed = true;
+            flushStats();
+        }
+    };
+
+    static void freeBlocks(Block *head) {
+        while (head != nullptr) {
+            Block *next = head->mNext;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+
+    // Returns a list of kBatchSize free blocks from the depot, or nullptr if it is empty.
+    static Block *takeBatch() {
+        std::lock_guard<std::mutex> lock(sDepotLock);
+        return sDepotCount == 0 ? nullptr : sDepot[--sDepotCount];
+    }
+
+    // Passes a list of kBatchSize free blocks to the depot, unless it is full.
+    static bool giveBatch(Block *batch) {
+        std::lock_guard<std::mutex> lock(sDepotLock);
+        if (sDepotCount == kMaxDepotBatches) {
+            return false;
+        }
+        sDepot[sDepotCount++] = batch;
+        return true;
+    }
+
+    static thread_local ThreadCache sCache;
+
+    static std::mutex sDepotLock;
+    static Block *sDepot[kMaxDepotBatches];     // protected by sDepotLock
+    static size_t sDepotCount;                  // protected by sDepotLock
+
+    static std::atomic<uint64_t> sAllocations;
+    static std::atomic<uint64_t> sHeapAllocations;
+    static std::atomic<uint64_t> sFrees;
+    static std::atomic<uint64_t> sHeapFrees;
+};
+
+template <typename T>
+thread_local typename AObjectPool<T>::ThreadCache AObjectPool<T>::sCache;
+template <typename T>
+std::mutex AObjectPool<T>::sDepotLock;
+template <typename T>
+typename AObjectPool<T>::Block *AObjectPool<T>::sDepot[kMaxDepotBatches];
+template <typename T>
+size_t AObjectPool<T>::sDepotCount = 0;
+template <typename T>
+std::atomic<uint64_t> AObjectPool<T>::sAllocations{0};
+template <typename T>
+std::atomic<uint64_t> AObjectPool<T>::sHeapAllocations{0};
+template <typename T>
+std::atomic<uint64_t> AObjectPool<T>::sFrees{0};
+template <typename T>
+std::atomic<uint64_t> AObjectPool<T>::sHeapFrees{0};
+
+}  // namespace android
+
+#endif  // A_OBJECT_POOL_H_
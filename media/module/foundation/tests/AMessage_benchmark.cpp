@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the cost of building, querying and copying AMessages shaped like
+// the format messages that MediaCodec and CCodec exchange for every format
+// change and output buffer.
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/AAtomizer.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+// keys of a typical video decoder output format, see MediaCodecConstants.h
+static const char *kFormatKeys[] = {
+    "mime", "width", "height", "stride", "slice-height", "color-format",
+    "crop-left", "crop-top", "crop-right", "crop-bottom", "color-standard",
+    "color-range", "color-transfer", "hdr-static-info", "frame-rate",
+    "max-input-size", "priority", "rotation-degrees", "sar-width", "sar-height",
+    "android._dataspace", "android._video-scaling", "csd-0", "csd-1",
+    "profile", "level", "max-width", "max-height", "low-latency", "operating-rate",
+};
+static constexpr size_t kMaxKeys = sizeof(kFormatKeys) / sizeof(kFormatKeys[0]);
+
+static void fillFormat(const sp<AMessage> &msg, const char *const *keys, size_t numKeys) {
+    for (size_t i = 0; i < numKeys; ++i) {
+        msg->setInt32(keys[i], i);
+    }
+}
+
+static void queryFormat(const sp<AMessage> &msg, const char *const *keys, size_t numKeys) {
+    for (size_t i = 0; i < numKeys; ++i) {
+        int32_t value;
+        benchmark::DoNotOptimize(msg->findInt32(keys[i], &value));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+// Sets numKeys items, looks each one up twice and copies the message once,
+// which is about what a format message goes through in the codec framework.
+static void runFormatMessage(benchmark::State& state, const char *const *keys) {
+    const size_t numKeys = state.range(0);
+    for (auto _ : state) {
+        sp<AMessage> msg = new AMessage();
+        fillFormat(msg, keys, numKeys);
+        queryFormat(msg, keys, numKeys);
+        sp<AMessage> copy = msg->dup();
+        queryFormat(copy, keys, numKeys);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_AMessageFormat(benchmark::State& state) {
+    runFormatMessage(state, kFormatKeys);
+}
+
+// Same, but with keys atomized by the caller, so lookups match by pointer.
+static void BM_AMessageFormatAtomized(benchmark::State& state) {
+    const char *keys[kMaxKeys];
+    for (size_t i = 0; i < kMaxKeys; ++i) {
+        keys[i] = AAtomizer::Atomize(kFormatKeys[i]);
+    }
+    runFormatMessage(state, keys);
+}
+
+// Lookups only, including misses, on a message that is already built.
+static void BM_AMessageFind(benchmark::State& state) {
+    const size_t numKeys = state.range(0);
+    sp<AMessage> msg = new AMessage();
+    fillFormat(msg, kFormatKeys, numKeys);
+    for (auto _ : state) {
+        queryFormat(msg, kFormatKeys, kMaxKeys);
+    }
+    state.SetItemsProcessed(state.iterations() * kMaxKeys);
+}
+
+static void FormatArgs(benchmark::internal::Benchmark* b) {
+    b->Arg(4)->Arg(10)->Arg(20)->Arg(kMaxKeys);
+}
+
+BENCHMARK(BM_AMessageFormat)->Apply(FormatArgs);
+BENCHMARK(BM_AMessageFormatAtomized)->Apply(FormatArgs);
+BENCHMARK(BM_AMessageFind)->Apply(FormatArgs);
+
+BENCHMARK_MAIN();
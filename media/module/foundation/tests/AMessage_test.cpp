@@ -21,9 +21,11 @@
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
+#include <media/stagefright/foundation/AAtomizer.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AString.h>
 
 using namespace android;
 
@@ -169,6 +171,75 @@ TEST(AMessage_tests, settersAndGetters) {
   EXPECT_NE(OK, m1->removeEntryByName("notpresent"));
 }
 
+// Messages with many items look up items through a hash index, which must stay consistent
+// as items are added, renamed, removed and copied.
+TEST(AMessage_tests, manyItems) {
+  sp<AMessage> m1 = new AMessage();
+  const size_t kNumItems = 40;
+  for (size_t i = 0; i < kNumItems; ++i) {
+    m1->setInt32(AStringPrintf("key-%zu", i).c_str(), i);
+  }
+  EXPECT_EQ(kNumItems, m1->countEntries());
+  for (size_t i = 0; i < kNumItems; ++i) {
+    int32_t value;
+    EXPECT_TRUE(m1->findInt32(AStringPrintf("key-%zu", i).c_str(), &value));
+    EXPECT_EQ((int32_t)i, value);
+  }
+  EXPECT_FALSE(m1->contains("key-40"));
+
+  // overwriting does not add an item
+  m1->setInt32("key-7", 70);
+  EXPECT_EQ(kNumItems, m1->countEntries());
+
+  EXPECT_EQ(OK, m1->removeEntryByName("key-3"));
+  EXPECT_FALSE(m1->contains("key-3"));
+  EXPECT_EQ(kNumItems - 1, m1->countEntries());
+
+  EXPECT_EQ(ALREADY_EXISTS, m1->setEntryNameAt(m1->findEntryByName("key-4"), "key-5"));
+  EXPECT_EQ(OK, m1->setEntryNameAt(m1->findEntryByName("key-4"), "renamed"));
+  EXPECT_FALSE(m1->contains("key-4"));
+
+  sp<AMessage> m2 = m1->dup();
+  m1->clear();
+  int32_t value;
+  EXPECT_TRUE(m2->findInt32("renamed", &value));
+  EXPECT_EQ(4, value);
+  EXPECT_TRUE(m2->findInt32("key-7", &value));
+  EXPECT_EQ(70, value);
+  EXPECT_TRUE(m2->findInt32("key-39", &value));
+  EXPECT_EQ(39, value);
+  EXPECT_EQ(kNumItems - 1, m2->countEntries());
+
+  // removing items drops below the indexing threshold
+  while (m2->countEntries() > 2) {
+    EXPECT_EQ(OK, m2->removeEntryAt(0));
+  }
+  AMessage::Type type;
+  const char *name = m2->getEntryNameAt(1, &type);
+  ASSERT_NE(nullptr, name);
+  EXPECT_EQ(1u, m2->findEntryByName(AString(name).c_str()));
+}
+
+TEST(AMessage_tests, atomizedNames) {
+  const char *width = AAtomizer::Atomize("width");
+  EXPECT_EQ(width, AAtomizer::Atomize(AString("width").c_str()));
+  EXPECT_STREQ("width", width);
+
+  sp<AMessage> m1 = new AMessage();
+  m1->setInt32(width, 1920);
+  m1->setInt32("height", 1080);
+  int32_t value;
+  EXPECT_TRUE(m1->findInt32("width", &value));
+  EXPECT_EQ(1920, value);
+  EXPECT_TRUE(m1->findInt32(AAtomizer::Atomize("height"), &value));
+  EXPECT_EQ(1080, value);
+
+  // names are shared with copies
+  sp<AMessage> m2 = m1->dup();
+  AMessage::Type type;
+  EXPECT_EQ(m1->getEntryNameAt(0, &type), m2->getEntryNameAt(0, &type));
+}
+
 TEST(AMessage_tests, deliversMultipleMessagesInOrderImmediately) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
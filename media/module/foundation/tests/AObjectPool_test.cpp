@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AObjectPool_test"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AObjectPool.h>
+
+using namespace android;
+
+namespace {
+
+struct Pooled {
+    static void *operator new(size_t size) { return AObjectPool<Pooled>::Allocate(size); }
+    static void operator delete(void *ptr, size_t size) { AObjectPool<Pooled>::Free(ptr, size); }
+    virtual ~Pooled() = default;
+    int64_t mValue[4] = {};
+};
+
+struct Derived : public Pooled {
+    int64_t mMore[4] = {};
+};
+
+}  // namespace
+
+TEST(AObjectPool_test, recyclesOnSameThread) {
+    if (!AObjectPool<Pooled>::kRecycles) {
+        GTEST_SKIP() << "objects are not recycled in sanitizer builds";
+    }
+    // warm up this thread's cache
+    delete new Pooled;
+    const AObjectPoolStats before = AObjectPool<Pooled>::GetStats();
+    for (int i = 0; i < 1000; ++i) {
+        delete new Pooled;
+    }
+    // let this thread flush its counters
+    std::vector<Pooled *> objects;
+    for (int i = 0; i < 64; ++i) {
+        objects.push_back(new Pooled);
+    }
+    for (Pooled *object : objects) {
+        delete object;
+    }
+    const AObjectPoolStats after = AObjectPool<Pooled>::GetStats();
+    EXPECT_GE(after.mAllocations - before.mAllocations, 1000u);
+    // only the 64 simultaneously live objects may need more than the one cached block
+    EXPECT_LE(after.mHeapAllocations - before.mHeapAllocations, 64u);
+}
+
+TEST(AObjectPool_test, bypassesOtherSizes) {
+    Pooled *object = new Derived;
+    static_cast<Derived *>(object)->mMore[3] = 1;
+    delete object;  // sized delete of Derived goes to the heap
+}
+
+// Objects allocated on one thread and freed on another are recycled through the depot.
+TEST(AObjectPool_test, producerConsumer) {
+    constexpr int kRounds = 100;
+    constexpr int kObjects = 256;
+    std::vector<Pooled *> objects(kObjects);
+    auto runRound = [&objects]() {
+        std::thread producer([&objects]() {
+            for (Pooled *&object : objects) {
+                object = new Pooled;
+                object->mValue[0] = 42;
+            }
+        });
+        producer.join();
+        std::thread consumer([&objects]() {
+            for (Pooled *object : objects) {
+                EXPECT_EQ(42, object->mValue[0]);
+                delete object;
+            }
+        });
+        consumer.join();
+    };
+    runRound();
+    // threads flush their counters when they exit
+    const AObjectPoolStats before = AObjectPool<Pooled>::GetStats();
+    for (int round = 1; round < kRounds; ++round) {
+        runRound();
+    }
+    const AObjectPoolStats after = AObjectPool<Pooled>::GetStats();
+    EXPECT_EQ((uint64_t)(kRounds - 1) * kObjects, after.mAllocations - before.mAllocations);
+    if (!AObjectPool<Pooled>::kRecycles) {
+        return;
+    }
+    EXPECT_LT((after.mHeapAllocations - before.mHeapAllocations) * 10,
+            after.mAllocations - before.mAllocations);
+}
+
+TEST(AObjectPool_test, messagesAndBuffers) {
+    const AObjectPoolStats messagesBefore = AMessage::GetAllocationStats();
+    const AObjectPoolStats buffersBefore = ABuffer::GetAllocationStats();
+    for (int i = 0; i < 100; ++i) {
+        sp<AMessage> msg = new AMessage;
+        msg->setBuffer("buffer", new ABuffer(16));
+        sp<AMessage> copy = msg->dup();
+    }
+    EXPECT_GE(AMessage::GetAllocationStats().mAllocations, messagesBefore.mAllocations + 64);
+    EXPECT_GE(ABuffer::GetAllocationStats().mAllocations, buffersBefore.mAllocations + 64);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MediaBufferGroup_test"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+using namespace android;
+
+namespace {
+
+std::string Dump(const MediaBufferGroup &group) {
+    std::string out;
+    group.dump(&out);
+    return out;
+}
+
+}  // namespace
+
+TEST(MediaBufferGroup_test, recyclesWithoutAllocation) {
+    MediaBufferGroup group(2, 1024);
+    for (int i = 0; i < 100; ++i) {
+        MediaBufferBase *first = nullptr;
+        MediaBufferBase *second = nullptr;
+        ASSERT_EQ(OK, group.acquire_buffer(&first, true /* nonBlocking */, 1000));
+        ASSERT_EQ(OK, group.acquire_buffer(&second, true /* nonBlocking */, 1000));
+        EXPECT_NE(first, second);
+        MediaBufferBase *third = nullptr;
+        EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&third, true /* nonBlocking */));
+        EXPECT_EQ(nullptr, third);
+        first->release();
+        second->release();
+    }
+    EXPECT_EQ(2u, group.buffers());
+    const std::string dump = Dump(group);
+    EXPECT_NE(std::string::npos, dump.find("in use: 0 (peak 2)")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("acquired: 200 (from free lists 200)")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("allocations: 0")) << dump;
+}
+
+TEST(MediaBufferGroup_test, picksBufferBySize) {
+    MediaBufferGroup group(4 /* growthLimit */);
+    group.prewarm(2, 100);
+    group.prewarm(2, 5000);
+    // beyond the growth limit
+    group.prewarm(1, 100);
+    EXPECT_EQ(4u, group.buffers());
+
+    MediaBufferBase *large = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&large, true /* nonBlocking */, 3000));
+    EXPECT_EQ(5000u, large->size());
+    MediaBufferBase *small = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&small, true /* nonBlocking */, 50));
+    EXPECT_EQ(100u, small->size());
+    MediaBufferBase *any = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&any, true /* nonBlocking */));
+    any->release();
+    small->release();
+    large->release();
+    EXPECT_NE(std::string::npos, Dump(group).find("allocations: 0")) << Dump(group);
+}
+
+TEST(MediaBufferGroup_test, growsOnceForLargerRequests) {
+    MediaBufferGroup group(1, 100, 2 /* growthLimit */);
+    // replaces the free 100 byte buffer
+    MediaBufferBase *buffer = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, 1000));
+    EXPECT_GE(buffer->size(), 1000u);
+    EXPECT_EQ(1u, group.buffers());
+    buffer->release();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, 1000));
+        EXPECT_GE(buffer->size(), 1000u);
+        buffer->release();
+    }
+    const std::string dump = Dump(group);
+    EXPECT_NE(std::string::npos, dump.find("allocations: 1 (reallocations 1)")) << dump;
+
+    // grows while all buffers are in use
+    MediaBufferBase *first = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&first, true /* nonBlocking */, 1000));
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, 1000));
+    EXPECT_GE(buffer->size(), 1000u);
+    EXPECT_EQ(2u, group.buffers());
+    first->release();
+    buffer->release();
+    EXPECT_NE(std::string::npos, Dump(group).find("allocations: 2 (reallocations 1)"))
+            << Dump(group);
+}
+
+TEST(MediaBufferGroup_test, blocksUntilReturned) {
+    MediaBufferGroup group(1, 100);
+    MediaBufferBase *first = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&first));
+    std::thread releaser([&group, first] {
+        // release once the acquirer is waiting; it counts the wait under the group lock
+        while (Dump(group).find("waits: 1") == std::string::npos) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        first->release();
+    });
+    MediaBufferBase *second = nullptr;
+    ASSERT_EQ(OK, group.acquire_buffer(&second));
+    releaser.join();
+    EXPECT_EQ(first, second);
+    second->release();
+    EXPECT_NE(std::string::npos, Dump(group).find("waits: 1")) << Dump(group);
+}
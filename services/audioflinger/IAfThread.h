@@ -26,6 +26,7 @@
 #include <datapath/AudioStreamOut.h>
 #include <datapath/VolumeInterface.h>
 #include <fastpath/FastMixerDumpState.h>
+#include <fastpath/FastTrackCommandQueue.h>
 #include <media/DeviceDescriptorBase.h>
 #include <media/MmapStreamInterface.h>
 #include <media/audiohal/StreamHalInterface.h>
@@ -535,6 +536,9 @@ public:
 
     virtual bool hasFastMixer() const = 0;
     virtual FastTrackUnderruns getFastTrackUnderruns(size_t fastIndex) const = 0;
+    // Posts an update for an active fast track directly to the FastMixer.
+    // Returns false if there is no FastMixer or its command queue is full.
+    virtual bool postFastTrackCommand(const FastTrackCommand& command) = 0;
     virtual const std::atomic<int64_t>& framesWritten() const = 0;
 
     virtual bool usesHwAvSync() const = 0;
@@ -1531,6 +1531,7 @@ protected:
 public:
     FastTrackUnderruns getFastTrackUnderruns(size_t /* fastIndex */) const override
         { return {}; }
+    bool postFastTrackCommand(const FastTrackCommand& /* command */) override { return false; }
     const std::atomic<int64_t>& framesWritten() const final { return mFramesWritten; }
 
 protected:
@@ -1675,6 +1676,10 @@ public:
                               ALOG_ASSERT(fastIndex < FastMixerState::sMaxFastTracks);
                               return mFastMixerDumpState.mTracks[fastIndex].mUnderruns;
                             }
+    bool postFastTrackCommand(const FastTrackCommand& command) override {
+                              return mFastMixer != nullptr
+                                      && mFastMixer->postTrackCommand(command);
+                            }
 
     status_t threadloop_getHalTimestamp_l(
             ExtendedTimestamp *timestamp) const override
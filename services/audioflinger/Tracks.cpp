@@ -257,6 +257,22 @@ static AttributionSourceState audioServerAttributionSource(pid_t pid) {
    return attributionSource;
 }
 
+// Posts a start or stop of a fast track directly to the FastMixer, so it takes effect at the
+// next fast mixer cycle instead of after the next normal mixer cycle.  The FastMixer discards
+// the command if the track no longer occupies its slot; the state queue then handles it.
+static void postFastTrackCommand(
+        IAfPlaybackThread* playbackThread, IAfTrack* track, FastTrackCommand::Type type) {
+    FastTrackCommand command;
+    command.mType = type;
+    command.mIndex = track->fastIndex();
+    command.mTrackId = track->asExtendedAudioBufferProvider();
+    command.mPostedNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (!playbackThread->postFastTrackCommand(command)) {
+        ALOGV("%s(%d): fast track command %u not posted",
+                __func__, track->id(), (unsigned)type);
+    }
+}
+
 status_t TrackBase::initCheck() const
 {
     status_t status;
@@ -1249,6 +1265,9 @@ status_t Track::start(AudioSystem::sync_event_t event __unused,
             // by the fast mixer; furthermore, the same track can be recycled, i.e. start
             // after stop.
             mObservedUnderruns = playbackThread->getFastTrackUnderruns(mFastIndex);
+            // undo a STOP posted by an earlier pause() if the fast mixer still holds the
+            // track, e.g. after pause() and stop(); otherwise the command is discarded.
+            postFastTrackCommand(playbackThread, this, FastTrackCommand::START);
         }
         status = playbackThread->addTrack_l(this);
         if (status == INVALID_OPERATION || status == PERMISSION_DENIED || status == DEAD_OBJECT) {
@@ -1381,6 +1400,10 @@ void Track::pause()
             if (isOffloadedOrDirect()) {
                 mPauseHwPending = true;
             }
+            if (isFastTrack()) {
+                // stop pulling frames at the next fast mixer cycle.
+                postFastTrackCommand(playbackThread, this, FastTrackCommand::STOP);
+            }
             playbackThread->broadcast_l();
             break;
 
@@ -40,6 +40,9 @@ void FastCaptureDumpState::dump(int fd) const
                 FastCaptureState::commandToString(mCommand), mReadSequence, mFramesRead,
                 mReadErrors, mSampleRate, mFrameCount, measuredWarmupMs, mWarmupCycles,
                 periodSec * 1e3, mSilenced ? "true" : "false");
+#ifdef FAST_THREAD_STATISTICS
+    dumpHistograms(fd, "FastCapture");
+#endif
 }
 
 }  // namespace android
@@ -129,6 +129,11 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
     mGenerations[index] = fastTrack->mGeneration;
 
+    // a STOP command only applies to the track which was in the slot when it was posted.
+    if (reason != REASON_MODIFY) {
+        mStoppedTrackMask &= ~(1 << index);
+    }
+
     // mMixer == nullptr on configuration failure (check done after generation update).
     if (mMixer == nullptr) {
         return;
@@ -190,6 +195,47 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
 }
 
+void FastMixer::processTrackCommands()
+{
+    const FastMixerState * const current = (const FastMixerState *) mCurrent;
+    FastMixerDumpState * const dumpState = (FastMixerDumpState *) mDumpState;
+    FastTrackCommand command;
+    int64_t nowNs = 0;
+
+    while (mTrackCommands.pop(&command)) {
+        const int i = command.mIndex;
+        if (i < 0 || i >= (int)FastMixerState::kMaxFastTracks
+                || !(current->mTrackMask & (1 << i))
+                || current->mFastTracks[i].mBufferProvider != command.mTrackId) {
+            // the track is not (or no longer) in this slot, the normal mixer will handle it.
+            dumpState->mTrackCommandsDiscarded++;
+            continue;
+        }
+        switch (command.mType) {
+        case FastTrackCommand::START:
+            mStoppedTrackMask &= ~(1 << i);
+            break;
+        case FastTrackCommand::STOP:
+            mStoppedTrackMask |= 1 << i;
+            if (mMixer != nullptr) {
+                mMixer->disable(i);
+            }
+            break;
+        default:
+            dumpState->mTrackCommandsDiscarded++;
+            continue;
+        }
+        if (nowNs == 0) {
+            nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
+        const int64_t latencyNs = nowNs - command.mPostedNs;
+        if (latencyNs > dumpState->mTrackCommandMaxLatencyNs) {
+            dumpState->mTrackCommandMaxLatencyNs = latencyNs;
+        }
+        dumpState->mTrackCommands++;
+    }
+}
+
 void FastMixer::onStateChange()
 {
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
@@ -353,6 +399,9 @@ void FastMixer::onWork()
     if ((command & FastMixerState::MIX) && (mMixer != nullptr) && mIsWarm) {
         ALOG_ASSERT(mMixerBuffer != nullptr);
 
+        // apply any fast track updates posted since the last cycle.
+        processTrackCommands();
+
         // AudioMixer::mState.enabledTracks is undefined if mState.hook == process__validate,
         // so we keep a side copy of enabledTracks
         bool anyEnabledTracks = false;
@@ -383,6 +432,11 @@ void FastMixer::onWork()
             fastTrack->mBufferProvider->onTimestamp(perTrackTimestamp);
 
             const int name = i;
+            if (mStoppedTrackMask & (1 << i)) {
+                // stopped by a FastTrackCommand, until restarted or the slot is reassigned.
+                mMixer->disable(name);
+                continue;
+            }
             if (fastTrack->mVolumeProvider != nullptr) {
                 const gain_minifloat_packed_t vlr = fastTrack->mVolumeProvider->getVolumeLR();
                 float vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <audio_utils/Balance.h>
 #include "FastThread.h"
+#include "FastTrackCommandQueue.h"
 #include "StateQueue.h"
 #include "FastMixerState.h"
 #include "FastMixerDumpState.h"
@@ -39,6 +40,13 @@ public:
 
             FastMixerStateQueue* sq();
 
+    // Post a fast track update directly to the fast mixer, bypassing the state queue.
+    // May be called from any thread; never blocks.
+    // Returns false if the command queue is full.
+            bool postTrackCommand(const FastTrackCommand& command) {
+                return mTrackCommands.push(command);
+            }
+
     virtual void setMasterMono(bool mono) { mMasterMono.store(mono); /* memory_order_seq_cst */ }
     virtual void setMasterBalance(float balance) { mMasterBalance.store(balance); }
     virtual float getMasterBalance() const { return mMasterBalance.load(); }
@@ -47,6 +55,7 @@ public:
     }
 private:
             FastMixerStateQueue mSQ;
+            FastTrackCommandQueue mTrackCommands;
 
     // callouts
     const FastThreadState *poll() override;
@@ -65,12 +74,17 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // drain mTrackCommands, called once per cycle before mixing
+    void processTrackCommands();
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
     FastMixerState  mPreIdle;   // copy of state before we went into idle
     int             mGenerations[FastMixerState::kMaxFastTracks]{};
                                 // last observed mFastTracks[i].mGeneration
+    unsigned        mStoppedTrackMask = 0; // bit i is set if track i was stopped by a
+                                           // FastTrackCommand::STOP and is not mixed
     NBAIO_Sink*     mOutputSink = nullptr;
     int             mOutputSinkGen = 0;
     AudioMixer*     mMixer = nullptr;
@@ -61,6 +61,8 @@ void FastMixerDumpState::dump(int fd) const
                 mSampleRate, mFrameCount, measuredWarmupMs, mWarmupCycles,
                 mixPeriodSec * 1e3, mLatencyMs);
     dprintf(fd, "  FastMixer Timestamp stats: %s\n", mTimestampVerifier.toString().c_str());
+    dprintf(fd, "  FastMixer track commands=%u discarded=%u maxLatency=%.3f ms\n",
+            mTrackCommands, mTrackCommandsDiscarded, mTrackCommandMaxLatencyNs * 1e-6);
 #ifdef FAST_THREAD_STATISTICS
     // find the interval of valid samples
     const uint32_t bounds = mBounds;
@@ -152,6 +154,7 @@ void FastMixerDumpState::dump(int fd) const
                     right.getStdDev()*1e-6);
         delete[] tail;
     }
+    dumpHistograms(fd, "FastMixer");
 #endif
     // The active track mask and track states are updated non-atomically.
     // So if we relied on isActive to decide whether to display,
@@ -73,6 +73,10 @@ struct FastMixerDumpState : FastThreadDumpState {
     uint32_t mSampleRate = 0;
     size_t   mFrameCount = 0;
     uint32_t mTrackMask = 0;      // mask of active tracks
+    uint32_t mTrackCommands = 0;  // FastTrackCommands applied
+    uint32_t mTrackCommandsDiscarded = 0; // FastTrackCommands for a slot no longer held by
+                                          // the track, or otherwise invalid
+    int64_t  mTrackCommandMaxLatencyNs = 0; // max time from posting to applying a command
     FastTrackDump   mTracks[FastMixerState::kMaxFastTracks];
 
     // For timestamp statistics.
@@ -20,6 +20,8 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
+#include <cstdlib>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <audio_utils/clock.h>
@@ -311,6 +313,14 @@ bool FastThread::threadLoop()
                     // this store #4 is not atomic with respect to stores #1, #2, #3 above, but
                     // the newest open & oldest closed halves are atomic with respect to each other
                     mDumpState->mBounds = mBounds;
+                    // the histograms are cumulative, so they do not depend on the bounds
+                    mDumpState->mCycleNsHistogram.record(monotonicNs);
+                    mDumpState->mLoadNsHistogram.record(loadNs);
+                    if (mPeriodNs > 0) {
+                        const int64_t jitterNs = (int64_t) monotonicNs - mPeriodNs;
+                        mDumpState->mJitterNsHistogram.record(
+                                (uint32_t) std::min<int64_t>(std::abs(jitterNs), UINT32_MAX));
+                    }
                     ATRACE_INT(mCycleMs, monotonicNs / 1000000);
                     ATRACE_INT(mLoadUs, loadNs / 1000);
                 }
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <memory>
+#include <stdio.h>
+
 #include <audio_utils/roundup.h>
 #include "FastThreadDumpState.h"
 
@@ -42,6 +45,32 @@ void FastThreadDumpState::increaseSamplingN(uint32_t samplingN)
 #endif
     mSamplingN = samplingN;
 }
+
+void FastThreadDumpState::dumpHistograms(int fd, const char *name) const
+{
+    const struct {
+        const char *mLabel;
+        const FastThreadHistogram *mHistogram;
+    } histograms[] = {
+        { "cycle", &mCycleNsHistogram },
+        { "load", &mLoadNsHistogram },
+        { "jitter", &mJitterNsHistogram },
+    };
+    // the snapshot is too large for the stack of a binder thread
+    const auto snapshot = std::make_unique<FastThreadHistogram::Snapshot>();
+    dprintf(fd, "  %s histograms in us (%u cycles):\n", name, mCycleNsHistogram.count());
+    for (const auto& h : histograms) {
+        h.mHistogram->snapshot(snapshot.get());
+        if (snapshot->mCount == 0) {
+            continue;
+        }
+        dprintf(fd, "    %-6s mean=%.0f p50=%.0f p90=%.0f p99=%.0f p99.9=%.0f max=%.0f\n",
+                h.mLabel, snapshot->mean() * 1e-3,
+                snapshot->percentile(50.) * 1e-3, snapshot->percentile(90.) * 1e-3,
+                snapshot->percentile(99.) * 1e-3, snapshot->percentile(99.9) * 1e-3,
+                snapshot->mMax * 1e-3);
+    }
+}
 #endif
 
 }  // namespace android
@@ -19,6 +19,7 @@
 #include <type_traits>
 
 #include "Configuration.h"
+#include "FastThreadHistogram.h"
 #include "FastThreadState.h"
 
 namespace android {
@@ -63,6 +64,17 @@ struct FastThreadDumpState {
 
     // Increase sampling window after construction, must be a power of 2 <= kSamplingN
     void    increaseSamplingN(uint32_t samplingN);
+
+    // Histograms over all warm cycles since the thread was created, unlike the sample
+    // arrays above which only cover the most recent cycles.  They are maintained by the
+    // fast thread without locks, and may be read at any time by any thread with
+    // FastThreadHistogram::snapshot(), so pollers need not copy the whole dump state.
+    FastThreadHistogram mCycleNsHistogram;  // delta monotonic (wall clock) time
+    FastThreadHistogram mLoadNsHistogram;   // delta CPU load in time
+    FastThreadHistogram mJitterNsHistogram; // absolute difference of cycle time and period
+
+    // Print a summary of the histograms, prefixed by the thread name.
+    void    dumpHistograms(int fd, const char *name) const;
 #endif
 
 };  // struct FastThreadDumpState
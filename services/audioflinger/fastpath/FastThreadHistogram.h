@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// FastThreadHistogram is a continuously maintained histogram of durations in nanoseconds,
+// used for the cycle time, CPU load and wake-up jitter of a FastThread.
+//
+// The buckets are log-linear (as in HdrHistogram): values below 2 * kSubBuckets have a bucket
+// each, and every following power of 2 is split into kSubBuckets linear buckets, so the
+// relative error of a reported value is at most 1 / kSubBuckets over the whole uint32_t range.
+//
+// There is a single writer, the fast thread, which updates the counters with relaxed
+// loads and stores only; it never locks, allocates, or performs a read-modify-write.
+// Any number of readers may call snapshot() at any time, without synchronizing with the
+// writer. A snapshot may be torn by the samples recorded while it is taken, which is
+// acceptable for statistics; the counters themselves are never corrupted.
+// The counters wrap after 2^32 samples, about 100 days of 2 ms cycles.
+class FastThreadHistogram {
+public:
+    static constexpr uint32_t kSubBucketBits = 4;
+    static constexpr uint32_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr uint32_t kBuckets = (32 - kSubBucketBits + 1) * kSubBuckets;
+
+    // A stable copy of the histogram, owned by the reader.
+    struct Snapshot {
+        uint32_t mCount = 0;    // total number of samples
+        uint32_t mMax = 0;      // largest sample
+        uint32_t mCounts[kBuckets]{};
+
+        // Returns an upper bound of the value below which the given percentage
+        // (0. to 100.) of samples fall, or 0 if there are no samples.
+        uint32_t percentile(double percent) const {
+            if (mCount == 0) {
+                return 0;
+            }
+            const double target = mCount * (percent < 0. ? 0. : percent > 100. ? 100. : percent)
+                    / 100.;
+            uint64_t cumulative = 0;
+            for (uint32_t i = 0; i < kBuckets; ++i) {
+                cumulative += mCounts[i];
+                if (cumulative > 0 && cumulative >= target) {
+                    const uint32_t upper = bucketUpperBound(i);
+                    return upper < mMax ? upper : mMax;
+                }
+            }
+            return mMax;
+        }
+
+        // Returns the approximate mean, using the midpoint of each bucket.
+        double mean() const {
+            uint64_t total = 0;
+            double sum = 0.;
+            for (uint32_t i = 0; i < kBuckets; ++i) {
+                if (mCounts[i] != 0) {
+                    total += mCounts[i];
+                    sum += mCounts[i] *
+                            ((double) bucketLowerBound(i) + (double) bucketUpperBound(i)) * 0.5;
+                }
+            }
+            return total == 0 ? 0. : sum / total;
+        }
+    };
+
+    FastThreadHistogram() = default;
+
+    // Copying takes a snapshot, so that a dump state containing histograms may be copied.
+    FastThreadHistogram(const FastThreadHistogram& other) {
+        copyFrom(other);
+    }
+    FastThreadHistogram& operator=(const FastThreadHistogram& other) {
+        if (this != &other) {
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    // Writer API, only called by the fast thread.
+    // The counters are allowed to wrap, see above.
+    __attribute__((no_sanitize("unsigned-integer-overflow")))
+    void record(uint32_t valueNs) {
+        std::atomic<uint32_t>& counter = mCounts[bucketIndex(valueNs)];
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (valueNs > mMax.load(std::memory_order_relaxed)) {
+            mMax.store(valueNs, std::memory_order_relaxed);
+        }
+        // Published last, so that a reader observing the count has usually seen the bucket.
+        mCount.store(mCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Reader API, may be called from any thread.
+    void snapshot(Snapshot* snapshot) const {
+        snapshot->mCount = mCount.load(std::memory_order_acquire);
+        snapshot->mMax = mMax.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < kBuckets; ++i) {
+            snapshot->mCounts[i] = mCounts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t count() const { return mCount.load(std::memory_order_relaxed); }
+
+    static uint32_t bucketIndex(uint32_t value) {
+        if (value < 2 * kSubBuckets) {
+            return value;
+        }
+        const uint32_t msb = 31 - __builtin_clz(value);
+        const uint32_t shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + (value >> shift) - kSubBuckets;
+    }
+
+    static uint32_t bucketLowerBound(uint32_t index) {
+        if (index < 2 * kSubBuckets) {
+            return index;
+        }
+        const uint32_t shift = index / kSubBuckets - 1;
+        return (index % kSubBuckets + kSubBuckets) << shift;
+    }
+
+    static uint32_t bucketUpperBound(uint32_t index) {
+        if (index < 2 * kSubBuckets) {
+            return index;
+        }
+        const uint32_t shift = index / kSubBuckets - 1;
+        // computed in 64 bits as the last bucket ends at UINT32_MAX
+        return (uint32_t) ((((uint64_t) (index % kSubBuckets + kSubBuckets + 1)) << shift) - 1);
+    }
+
+private:
+    void copyFrom(const FastThreadHistogram& other) {
+        for (uint32_t i = 0; i < kBuckets; ++i) {
+            mCounts[i].store(other.mCounts[i].load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        }
+        mMax.store(other.mMax.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        mCount.store(other.mCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> mCount{0};
+    std::atomic<uint32_t> mMax{0};
+    std::atomic<uint32_t> mCounts[kBuckets]{};
+};
+
+}   // namespace android
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// The StateQueue has a single mutator, the normal mixer thread, so a fast track
+// start or pause made on a binder thread is only seen by the fast mixer after
+// the next normal mixer cycle pushes a new state.
+//
+// The FastTrackCommandQueue is a side channel for such small per-track updates:
+//  - any number of threads (binder threads) may post commands concurrently.
+//  - the fast mixer is the only consumer; it drains the queue once per cycle.
+//  - posting and consuming never block, lock, or allocate; posting fails if the
+//    queue is full, in which case the change still arrives through the StateQueue.
+//  - commands address a fast track slot, and carry the identity of the track
+//    expected in that slot, so commands for a slot that has since been recycled
+//    are discarded by the fast mixer.
+// The StateQueue remains the only way to add or remove fast tracks, as
+// that requires state owned by the normal mixer.
+// Volume has no command: the fast mixer already reads each track's volume
+// from its VolumeProvider every cycle.
+
+namespace android {
+
+struct FastTrackCommand {
+    enum Type : uint32_t {
+        START,  // resume mixing a slot that was stopped by a STOP command
+        STOP,   // stop mixing the slot until START, or until the slot is reassigned
+    };
+
+    Type        mType = START;
+    int         mIndex = -1;          // fast track slot, see Track::fastIndex()
+    const void* mTrackId = nullptr;   // expected FastTrack::mBufferProvider of the slot;
+                                      // used for comparison only, never dereferenced
+    int64_t     mPostedNs = 0;        // CLOCK_MONOTONIC time of posting, for dump statistics
+};
+
+// Only POD is copied through the queue.
+static_assert(std::is_trivially_copyable_v<FastTrackCommand>);
+
+// Bounded lock-free multi-producer single-consumer ring.
+//
+// Each cell has a sequence number which tells whether the cell is free for the
+// producer claiming position pos (sequence == pos), or holds an element ready
+// for the consumer (sequence == pos + 1).  Producers claim positions with a CAS
+// on mTail; the consumer owns mHead.
+// A producer preempted between claiming and publishing a cell only delays the
+// consumer from seeing that element (and later ones); the consumer never waits.
+template <typename T, size_t N>
+class FastCommandRing final {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of 2");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    FastCommandRing() {
+        for (size_t i = 0; i < N; ++i) {
+            mCells[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Producer API, may be called concurrently from any thread.
+    // Returns false if the ring is full.
+    bool push(const T& value) {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &mCells[pos & (N - 1)];
+            const size_t sequence = cell->mSequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+                // pos has been reloaded by compare_exchange_weak.
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->mValue = value;
+        cell->mSequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer API, must only be called from a single thread.
+    // Returns false if the ring is empty.
+    bool pop(T* value) {
+        Cell* const cell = &mCells[mHead & (N - 1)];
+        const size_t sequence = cell->mSequence.load(std::memory_order_acquire);
+        if (sequence != mHead + 1) {
+            return false; // empty, or the next element is not published yet
+        }
+        *value = cell->mValue;
+        cell->mSequence.store(mHead + N, std::memory_order_release);
+        ++mHead;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> mSequence;
+        T                   mValue;
+    };
+
+    // Keep the producer and consumer positions on separate cache lines.
+    alignas(64) std::atomic<size_t> mTail{0};   // next position claimed by a producer
+    alignas(64) size_t              mHead = 0;  // next position read by the consumer
+    alignas(64) Cell                mCells[N];
+};
+
+using FastTrackCommandQueue = FastCommandRing<FastTrackCommand, 64>;
+
+}   // namespace android
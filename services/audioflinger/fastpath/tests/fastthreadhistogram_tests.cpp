@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "FastThreadHistogram.h"
+
+namespace android {
+
+TEST(FastThreadHistogram, buckets) {
+    using H = FastThreadHistogram;
+    uint32_t previousUpper = UINT32_MAX;  // so that previousUpper + 1 == 0
+    for (uint32_t i = 0; i < H::kBuckets; ++i) {
+        // buckets are contiguous and cover the whole uint32_t range
+        EXPECT_EQ(previousUpper + 1, H::bucketLowerBound(i));
+        EXPECT_EQ(i, H::bucketIndex(H::bucketLowerBound(i)));
+        EXPECT_EQ(i, H::bucketIndex(H::bucketUpperBound(i)));
+        // relative resolution is bounded by the number of sub-buckets
+        const uint32_t width = H::bucketUpperBound(i) - H::bucketLowerBound(i);
+        EXPECT_LE((uint64_t) width * H::kSubBuckets, std::max(H::bucketLowerBound(i), 1u));
+        previousUpper = H::bucketUpperBound(i);
+    }
+    EXPECT_EQ(UINT32_MAX, previousUpper);
+}
+
+TEST(FastThreadHistogram, percentiles) {
+    FastThreadHistogram histogram;
+    auto snapshot = std::make_unique<FastThreadHistogram::Snapshot>();
+    histogram.snapshot(snapshot.get());
+    EXPECT_EQ(0u, snapshot->mCount);
+    EXPECT_EQ(0u, snapshot->percentile(50.));
+
+    // 1000 cycles of ~2 ms, with 10 outliers at 8 ms
+    for (uint32_t i = 0; i < 990; ++i) {
+        histogram.record(2000000 + i);
+    }
+    for (uint32_t i = 0; i < 10; ++i) {
+        histogram.record(8000000);
+    }
+    histogram.snapshot(snapshot.get());
+    EXPECT_EQ(1000u, snapshot->mCount);
+    EXPECT_EQ(8000000u, snapshot->mMax);
+    const uint32_t p50 = snapshot->percentile(50.);
+    EXPECT_GE(p50, 2000000u);
+    EXPECT_LE(p50, 2000000u + 2000000u / FastThreadHistogram::kSubBuckets);
+    EXPECT_LT(snapshot->percentile(98.), 8000000u * 15 / 16);
+    EXPECT_EQ(8000000u, snapshot->percentile(99.5));
+    EXPECT_EQ(8000000u, snapshot->percentile(100.));
+    EXPECT_NEAR(2.06e6, snapshot->mean(), 2.06e6 / FastThreadHistogram::kSubBuckets);
+
+    // copying takes a snapshot
+    const FastThreadHistogram copy(histogram);
+    EXPECT_EQ(1000u, copy.count());
+}
+
+TEST(FastThreadHistogram, concurrentReader) {
+    constexpr uint32_t kSamples = 1000000;
+    FastThreadHistogram histogram;
+    std::thread writer([&histogram]() {
+        for (uint32_t i = 0; i < kSamples; ++i) {
+            histogram.record(i & 0xFFFFF);
+        }
+    });
+    // a reader only ever observes counts that grow, and never exceed the samples recorded
+    auto snapshot = std::make_unique<FastThreadHistogram::Snapshot>();
+    uint32_t previousCount = 0;
+    while (previousCount < kSamples) {
+        histogram.snapshot(snapshot.get());
+        EXPECT_GE(snapshot->mCount, previousCount);
+        EXPECT_LE(snapshot->mCount, kSamples);
+        previousCount = snapshot->mCount;
+    }
+    writer.join();
+    histogram.snapshot(snapshot.get());
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < FastThreadHistogram::kBuckets; ++i) {
+        total += snapshot->mCounts[i];
+    }
+    EXPECT_EQ(kSamples, total);
+}
+
+}  // namespace android
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "FastTrackCommandQueue.h"
+
+using namespace android;
+using namespace std::chrono_literals;
+
+namespace {
+
+// A typical fast mixer period: 96 frames at 48 kHz.
+constexpr auto kFastMixerPeriod = 2ms;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Simulates a fast mixer cycle loop, draining commands once per period
+// and accumulating the post-to-apply latency.
+class FastMixerSimulator {
+public:
+    explicit FastMixerSimulator(FastTrackCommandQueue& queue) : mQueue(queue),
+            mThread([this]() { threadLoop(); }) {}
+
+    ~FastMixerSimulator() {
+        mExit = true;
+        mThread.join();
+    }
+
+    // Returns the number of commands seen so far.
+    int64_t applied() const { return mApplied.load(); }
+    int64_t totalLatencyNs() const { return mTotalLatencyNs.load(); }
+
+private:
+    void threadLoop() {
+        while (!mExit) {
+            FastTrackCommand command;
+            while (mQueue.pop(&command)) {
+                mTotalLatencyNs += nowNs() - command.mPostedNs;
+                ++mApplied;
+            }
+            std::this_thread::sleep_for(kFastMixerPeriod);
+        }
+    }
+
+    FastTrackCommandQueue& mQueue;
+    std::atomic<bool> mExit{false};
+    std::atomic<int64_t> mApplied{0};
+    std::atomic<int64_t> mTotalLatencyNs{0};
+    std::thread mThread;
+};
+
+}  // namespace
+
+// Post-to-apply latency through the FastTrackCommandQueue, with a simulated fast mixer which
+// drains it every period: at most one fast mixer period.
+static void BM_FastTrackCommandLatency(benchmark::State& state) {
+    FastTrackCommandQueue queue;
+    FastMixerSimulator fastMixer(queue);
+    int64_t posted = 0;
+    for (auto _ : state) {
+        FastTrackCommand command;
+        command.mType = FastTrackCommand::START;
+        command.mPostedNs = nowNs();
+        while (!queue.push(command)) {
+            std::this_thread::yield();
+        }
+        ++posted;
+        while (fastMixer.applied() < posted) {
+            std::this_thread::yield();
+        }
+    }
+    state.counters["latency_ms"] = fastMixer.totalLatencyNs() * 1e-6 / posted;
+}
+
+// Cost of posting with several concurrent producers and a draining consumer.
+static void BM_FastTrackCommandPost(benchmark::State& state) {
+    static FastTrackCommandQueue queue;
+    static std::atomic<bool> exit;
+    static std::thread consumer;
+    if (state.thread_index() == 0) {
+        exit = false;
+        consumer = std::thread([]() {
+            FastTrackCommand command;
+            while (!exit) {
+                while (queue.pop(&command)) {}
+                std::this_thread::yield();
+            }
+        });
+    }
+    FastTrackCommand command;
+    command.mType = FastTrackCommand::STOP;
+    int64_t dropped = 0;
+    for (auto _ : state) {
+        command.mPostedNs = nowNs();
+        dropped += !queue.push(command);
+    }
+    state.counters["dropped"] = dropped;
+    if (state.thread_index() == 0) {
+        exit = true;
+        consumer.join();
+    }
+}
+
+BENCHMARK(BM_FastTrackCommandLatency)->Iterations(200)->UseRealTime();
+BENCHMARK(BM_FastTrackCommandPost)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "FastTrackCommandQueue.h"
+
+namespace android {
+
+TEST(FastTrackCommandQueue, empty) {
+    FastTrackCommandQueue queue;
+    FastTrackCommand command;
+    EXPECT_FALSE(queue.pop(&command));
+}
+
+TEST(FastTrackCommandQueue, fifo) {
+    FastCommandRing<int, 4> ring;
+    for (int round = 0; round < 3; ++round) {  // wrap around several times
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(ring.push(round * 10 + i));
+        }
+        EXPECT_FALSE(ring.push(-1));  // full
+        for (int i = 0; i < 4; ++i) {
+            int value;
+            ASSERT_TRUE(ring.pop(&value));
+            EXPECT_EQ(round * 10 + i, value);
+        }
+        int value;
+        EXPECT_FALSE(ring.pop(&value));
+    }
+}
+
+TEST(FastTrackCommandQueue, multipleProducers) {
+    constexpr int kProducers = 8;
+    constexpr int kCommandsPerProducer = 10000;
+    FastTrackCommandQueue queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kCommandsPerProducer; ) {
+                FastTrackCommand command;
+                command.mIndex = p;
+                command.mPostedNs = i;
+                if (queue.push(command)) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // commands from each producer must arrive complete and in order.
+    int64_t next[kProducers]{};
+    int received = 0;
+    while (received < kProducers * kCommandsPerProducer) {
+        FastTrackCommand command;
+        if (!queue.pop(&command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_GE(command.mIndex, 0);
+        ASSERT_LT(command.mIndex, kProducers);
+        EXPECT_EQ(next[command.mIndex], command.mPostedNs);
+        next[command.mIndex] = command.mPostedNs + 1;
+        ++received;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    FastTrackCommand command;
+    EXPECT_FALSE(queue.pop(&command));
+}
+
+}  // namespace android
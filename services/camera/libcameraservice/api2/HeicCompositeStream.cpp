@@ -30,6 +30,7 @@
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include <camera/StringUtils.h>
+#include <cutils/properties.h>
 
 #include <mediadrm/ICrypto.h>
 #include <media/MediaCodecBuffer.h>
@@ -181,6 +182,12 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
         mMainImageConsumer = new CpuConsumer(consumer, 1);
         mMainImageConsumer->setFrameAvailableListener(this);
         mMainImageConsumer->setName(String8("Camera3-HeicComposite-HevcInputYUVStream"));
+
+        int32_t tileCopyThreads = property_get_int32("camera.heic.tile_copy_threads",
+                kDefaultTileCopyThreads);
+        if (tileCopyThreads > 0) {
+            mTileCopyWorkers = std::make_unique<WorkerPool>(tileCopyThreads, "HeicTileCopy");
+        }
     }
     mMainImageSurface = new Surface(producer);
 
@@ -235,6 +242,7 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
 status_t HeicCompositeStream::deleteInternalStreams() {
     requestExit();
     auto res = join();
+    mTileCopyWorkers.reset();
     if (res != OK) {
         ALOGE("%s: Failed to join with the main processing thread: %s (%d)", __FUNCTION__,
                 strerror(-res), res);
@@ -821,15 +829,13 @@ bool HeicCompositeStream::getNextReadyInputLocked(int64_t *frameNumber /*out*/)
     for (auto& it : mPendingInputFrames) {
         // New input is considered to be available only if:
         // 1. input buffers are ready, or
-        // 2. App segment and muxer is created, or
-        // 3. A codec output tile is ready, and an output buffer is available.
+        // 2. App segment is ready to be prepared, or
+        // 3. Prepared app segment and muxer is created, or
+        // 4. A codec output tile is ready, and an output buffer is available.
         // This makes sure that muxer gets created only when an output tile is
         // generated, because right now we only handle 1 HEIC output buffer at a
         // time (max dequeued buffer count is 1).
-        bool appSegmentReady =
-                (it.second.appSegmentBuffer.data != nullptr || it.second.exifError) &&
-                !it.second.appSegmentWritten && it.second.result != nullptr &&
-                it.second.muxer != nullptr;
+        bool appSegmentReady = it.second.appSegmentPending() || it.second.appSegmentReady();
         bool codecOutputReady = !it.second.codecOutputBuffers.empty();
         bool codecInputReady = (it.second.yuvBuffer.data != nullptr) &&
                 (!it.second.codecInputBuffers.empty());
@@ -867,19 +873,16 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
     ATRACE_CALL();
     status_t res = OK;
 
-    bool appSegmentReady =
-            (inputFrame.appSegmentBuffer.data != nullptr || inputFrame.exifError) &&
-            !inputFrame.appSegmentWritten && inputFrame.result != nullptr &&
-            inputFrame.muxer != nullptr;
+    bool appSegmentPending = inputFrame.appSegmentPending();
     bool codecOutputReady = inputFrame.codecOutputBuffers.size() > 0;
     bool codecInputReady = inputFrame.yuvBuffer.data != nullptr &&
             !inputFrame.codecInputBuffers.empty();
     bool hasOutputBuffer = inputFrame.muxer != nullptr ||
             (mDequeuedOutputBufferCnt < kMaxOutputSurfaceProducerCount);
 
-    ALOGV("%s: [%" PRId64 "]: appSegmentReady %d, codecOutputReady %d, codecInputReady %d,"
+    ALOGV("%s: [%" PRId64 "]: appSegmentPending %d, codecOutputReady %d, codecInputReady %d,"
             " dequeuedOutputBuffer %d, timestamp %" PRId64, __FUNCTION__, frameNumber,
-            appSegmentReady, codecOutputReady, codecInputReady, mDequeuedOutputBufferCnt,
+            appSegmentPending, codecOutputReady, codecInputReady, mDequeuedOutputBufferCnt,
             inputFrame.timestamp);
 
     // Handle inputs for Hevc tiling
@@ -892,6 +895,17 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
         }
     }
 
+    // Prepare the JPEG APP segments while the codec is encoding the tiles.
+    if (appSegmentPending) {
+        res = prepareAppSegment(frameNumber, inputFrame);
+        if (res != OK) {
+            ALOGE("%s: Failed to prepare JPEG APP segments: %s (%d)", __FUNCTION__,
+                    strerror(-res), res);
+            return res;
+        }
+    }
+
+    bool appSegmentReady = inputFrame.appSegmentReady();
     if (!(codecOutputReady && hasOutputBuffer) && !appSegmentReady) {
         return OK;
     }
@@ -909,7 +923,7 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
     }
 
     // Write JPEG APP segments data to the muxer.
-    if (appSegmentReady) {
+    if (inputFrame.appSegmentReady()) {
         res = processAppSegment(frameNumber, inputFrame);
         if (res != OK) {
             ALOGE("%s: Failed to process JPEG APP segments: %s (%d)", __FUNCTION__,
@@ -998,7 +1012,8 @@ status_t HeicCompositeStream::startMuxerForInputFrame(int64_t frameNumber, Input
     return OK;
 }
 
-status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame &inputFrame) {
+status_t HeicCompositeStream::prepareAppSegment(int64_t frameNumber, InputFrame &inputFrame) {
+    ATRACE_CALL();
     size_t app1Size = 0;
     size_t appSegmentSize = 0;
     if (!inputFrame.exifError) {
@@ -1045,7 +1060,8 @@ status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame
     kExifApp1Marker[7] = static_cast<uint8_t>(newApp1Length & 0xFF);
     size_t appSegmentBufferSize = sizeof(kExifApp1Marker) +
             appSegmentSize - app1Size + newApp1Length;
-    uint8_t* appSegmentBuffer = new uint8_t[appSegmentBufferSize];
+    sp<ABuffer> aBuffer = new ABuffer(appSegmentBufferSize);
+    uint8_t* appSegmentBuffer = aBuffer->data();
     memcpy(appSegmentBuffer, kExifApp1Marker, sizeof(kExifApp1Marker));
     memcpy(appSegmentBuffer + sizeof(kExifApp1Marker), newApp1Segment, newApp1Length);
     if (appSegmentSize - app1Size > 0) {
@@ -1053,34 +1069,49 @@ status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame
                 inputFrame.appSegmentBuffer.data + app1Size, appSegmentSize - app1Size);
     }
 
-    sp<ABuffer> aBuffer = new ABuffer(appSegmentBuffer, appSegmentBufferSize);
-    auto res = inputFrame.muxer->writeSampleData(aBuffer, inputFrame.trackIndex,
-            inputFrame.timestamp, MediaCodec::BUFFER_FLAG_MUXER_DATA);
-    delete[] appSegmentBuffer;
+    ALOGV("%s: [%" PRId64 "]: appSegmentSize is %zu, width %d, height %d, app1Size %zu",
+          __FUNCTION__, frameNumber, appSegmentSize, inputFrame.appSegmentBuffer.width,
+          inputFrame.appSegmentBuffer.height, app1Size);
+
+    inputFrame.appSegmentData = aBuffer;
+    // Release the buffer now so any pending input app segments can be processed
+    if (inputFrame.appSegmentBuffer.data != nullptr) {
+        mAppSegmentConsumer->unlockBuffer(inputFrame.appSegmentBuffer);
+        inputFrame.appSegmentBuffer.data = nullptr;
+    }
+    inputFrame.exifError = false;
 
+    return OK;
+}
+
+status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame &inputFrame) {
+    auto res = inputFrame.muxer->writeSampleData(inputFrame.appSegmentData,
+            inputFrame.trackIndex, inputFrame.timestamp, MediaCodec::BUFFER_FLAG_MUXER_DATA);
     if (res != OK) {
         ALOGE("%s: Failed to write JPEG APP segments to muxer: %s (%d)",
                 __FUNCTION__, strerror(-res), res);
         return res;
     }
 
-    ALOGV("%s: [%" PRId64 "]: appSegmentSize is %zu, width %d, height %d, app1Size %zu",
-          __FUNCTION__, frameNumber, appSegmentSize, inputFrame.appSegmentBuffer.width,
-          inputFrame.appSegmentBuffer.height, app1Size);
+    ALOGV("%s: [%" PRId64 "]: appSegmentData size is %zu", __FUNCTION__, frameNumber,
+            inputFrame.appSegmentData->size());
 
     inputFrame.appSegmentWritten = true;
-    // Release the buffer now so any pending input app segments can be processed
-    mAppSegmentConsumer->unlockBuffer(inputFrame.appSegmentBuffer);
-    inputFrame.appSegmentBuffer.data = nullptr;
-    inputFrame.exifError = false;
+    inputFrame.appSegmentData.clear();
 
     return OK;
 }
 
 status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
-    for (auto& inputBuffer : inputFrame.codecInputBuffers) {
-        sp<MediaCodecBuffer> buffer;
-        auto res = mCodec->getInputBuffer(inputBuffer.index, &buffer);
+    ATRACE_CALL();
+    // Get all available codec input buffers first, so that the tiles can be
+    // copied in parallel.
+    std::vector<sp<MediaCodecBuffer>> buffers(inputFrame.codecInputBuffers.size());
+    std::vector<WorkerPool::Job> copyJobs;
+    copyJobs.reserve(inputFrame.codecInputBuffers.size());
+    for (size_t i = 0; i < inputFrame.codecInputBuffers.size(); i++) {
+        const CodecInputBufferInfo& inputBuffer = inputFrame.codecInputBuffers[i];
+        auto res = mCodec->getInputBuffer(inputBuffer.index, &buffers[i]);
         if (res != OK) {
             ALOGE("%s: Error getting codec input buffer: %s (%d)", __FUNCTION__,
                     strerror(-res), res);
@@ -1100,14 +1131,37 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
                 " timeUs %" PRId64, __FUNCTION__, tileX, tileY, top, left, width, height,
                 inputBuffer.timeUs);
 
-        res = copyOneYuvTile(buffer, inputFrame.yuvBuffer, top, left, width, height);
-        if (res != OK) {
-            ALOGE("%s: Failed to copy YUV tile %s (%d)", __FUNCTION__,
-                    strerror(-res), res);
-            return res;
+        sp<MediaCodecBuffer>& buffer = buffers[i];
+        copyJobs.push_back([this, &buffer, &inputFrame, top, left, width, height]() {
+            return copyOneYuvTile(buffer, inputFrame.yuvBuffer, top, left, width, height);
+        });
+    }
+
+    status_t res = OK;
+    if (mTileCopyWorkers != nullptr) {
+        res = mTileCopyWorkers->run(copyJobs);
+    } else {
+        for (auto& copyJob : copyJobs) {
+            res = copyJob();
+            if (res != OK) break;
         }
+    }
+    if (res != OK) {
+        ALOGE("%s: Failed to copy YUV tile %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+        return res;
+    }
 
-        res = mCodec->queueInputBuffer(inputBuffer.index, 0, buffer->capacity(),
+    // Queue the tiles in order, as their timestamps need to be increasing.
+    for (size_t i = 0; i < inputFrame.codecInputBuffers.size(); i++) {
+        const CodecInputBufferInfo& inputBuffer = inputFrame.codecInputBuffers[i];
+        // The previous frame may still be encoded, so apply the quality of
+        // this frame with its first tile.
+        if (inputBuffer.tileIndex == 0) {
+            Mutex::Autolock l(mMutex);
+            updateCodecQualityLocked(inputFrame.quality);
+        }
+        res = mCodec->queueInputBuffer(inputBuffer.index, 0, buffers[i]->capacity(),
                 inputBuffer.timeUs, 0, nullptr /*errorDetailMsg*/);
         if (res != OK) {
             ALOGE("%s: Failed to queueInputBuffer to Codec: %s (%d)",
@@ -1115,8 +1169,15 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
             return res;
         }
     }
-
     inputFrame.codecInputBuffers.clear();
+
+    // Once all tiles are copied, release the YUV buffer so that the next
+    // frame can be tiled while this one is encoded and muxed.
+    if (inputFrame.codecInputCounter == mGridRows * mGridCols) {
+        mMainImageConsumer->unlockBuffer(inputFrame.yuvBuffer);
+        inputFrame.yuvBuffer.data = nullptr;
+        mYuvBufferAcquired = false;
+    }
     return OK;
 }
 
@@ -1290,11 +1351,15 @@ void HeicCompositeStream::releaseInputFramesLocked() {
     // Note that when encoding is in surface mode, currently there is  no
     // way for camera service to synchronize quality setting on a per-frame
     // basis: we don't get notification when codec is ready to consume a new
-    // input frame. So we update codec quality on a best-effort basis.
+    // input frame. So we update codec quality on a best-effort basis. In grid
+    // mode the quality is applied along with the first tile of each frame
+    // instead, as later frames may already be encoding.
     if (inputFrameDone) {
         auto firstPendingFrame = mPendingInputFrames.begin();
         if (firstPendingFrame != mPendingInputFrames.end()) {
-            updateCodecQualityLocked(firstPendingFrame->second.quality);
+            if (!mUseGrid) {
+                updateCodecQualityLocked(firstPendingFrame->second.quality);
+            }
         } else {
             markTrackerIdle();
         }
@@ -24,12 +24,14 @@
 
 #include <media/hardware/VideoAPI.h>
 #include <media/MediaCodecBuffer.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/MediaCodec.h>
 #include <media/stagefright/MediaMuxer.h>
 
 #include "CompositeStream.h"
+#include "utils/WorkerPool.h"
 
 namespace android {
 namespace camera3 {
@@ -156,6 +158,8 @@ private:
         int32_t                   quality;
 
         CpuConsumer::LockedBuffer          appSegmentBuffer;
+        // APP segments with the regenerated APP1 segment, ready for muxing.
+        sp<ABuffer>                        appSegmentData;
         std::vector<CodecOutputBufferInfo> codecOutputBuffers;
         std::unique_ptr<CameraMetadata>    result;
 
@@ -183,6 +187,17 @@ private:
                        exifError(false), timestamp(-1), requestId(-1), fenceFd(-1),
                        fileFd(-1), trackIndex(-1), anb(nullptr), appSegmentWritten(false),
                        pendingOutputTiles(0), codecInputCounter(0) { }
+
+        // The APP segments can be prepared for muxing. This doesn't need
+        // the muxer, so it can be done while the tiles are being encoded.
+        bool appSegmentPending() const {
+            return (appSegmentBuffer.data != nullptr || exifError) && appSegmentData == nullptr &&
+                    !appSegmentWritten && result != nullptr;
+        }
+        // The prepared APP segments can be written to the muxer.
+        bool appSegmentReady() const {
+            return appSegmentData != nullptr && !appSegmentWritten && muxer != nullptr;
+        }
     };
 
     void compilePendingInputLocked();
@@ -194,6 +209,7 @@ private:
     status_t processInputFrame(int64_t frameNumber, InputFrame &inputFrame);
     status_t processCodecInputFrame(InputFrame &inputFrame);
     status_t startMuxerForInputFrame(int64_t frameNumber, InputFrame &inputFrame);
+    status_t prepareAppSegment(int64_t frameNumber, InputFrame &inputFrame);
     status_t processAppSegment(int64_t frameNumber, InputFrame &inputFrame);
     status_t processOneCodecOutputFrame(int64_t frameNumber, InputFrame &inputFrame);
     status_t processCompletedInputFrame(int64_t frameNumber, InputFrame &inputFrame);
@@ -280,6 +296,11 @@ private:
     // Function pointer of libyuv row copy.
     void (*mFnCopyRow)(const uint8_t* src, uint8_t* dst, int width);
 
+    // Threads copying YUV tiles in parallel with threadLoop (for HEVC YUV
+    // tiling only). Tiles are copied on threadLoop only if null.
+    std::unique_ptr<WorkerPool> mTileCopyWorkers;
+    static const int32_t kDefaultTileCopyThreads = 2;
+
     // A set of APP_SEGMENT error frame numbers
     std::set<int64_t> mExifErrorFrameNumbers;
     void flagAnExifErrorFrameNumber(int64_t frameNumber);
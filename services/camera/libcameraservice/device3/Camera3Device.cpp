@@ -656,10 +656,10 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         if (mInFlightMap.size() == 0) {
             lines += "      None\n";
         } else {
-            for (size_t i = 0; i < mInFlightMap.size(); i++) {
-                InFlightRequest r = mInFlightMap.valueAt(i);
+            for (uint32_t frameNumber : mInFlightMap.frameNumbers()) {
+                const InFlightRequest &r = *mInFlightMap.find(frameNumber);
                 lines += fmt::sprintf("      Frame %d |  Timestamp: %" PRId64 ", metadata"
-                        " arrived: %s, buffers left: %d\n", mInFlightMap.keyAt(i),
+                        " arrived: %s, buffers left: %d\n", frameNumber,
                         r.shutterTimestamp, r.haveResultMetadata ? "true" : "false",
                         r.numBuffersLeft);
             }
@@ -2917,12 +2917,10 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
     ATRACE_CALL();
     std::lock_guard<std::mutex> l(mInFlightLock);
 
-    ssize_t res;
-    res = mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
+    mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
             hasAppCallback, minExpectedDuration, maxExpectedDuration, isFixedFps, physicalCameraIds,
             isStillCapture, isZslCapture, rotateAndCropAuto, autoframingAuto, cameraIdsWithZoom,
             requestTimeNs, outputSurfaces));
-    if (res < 0) return res;
 
     if (mInFlightMap.size() == 1) {
         // Hold a separate dedicated tracker lock to prevent race with disconnect and also
@@ -2972,10 +2970,10 @@ void Camera3Device::onInflightMapFlushedLocked() {
     mExpectedInflightDuration = 0;
 }
 
-void Camera3Device::removeInFlightMapEntryLocked(int idx) {
+void Camera3Device::removeInFlightMapEntryLocked(uint32_t frameNumber) {
     ATRACE_HFR_CALL();
-    nsecs_t duration = mInFlightMap.valueAt(idx).maxExpectedDuration;
-    mInFlightMap.removeItemsAt(idx, 1);
+    nsecs_t duration = mInFlightMap.find(frameNumber)->maxExpectedDuration;
+    mInFlightMap.remove(frameNumber);
 
     onInflightEntryRemovedLocked(duration);
 }
@@ -4536,11 +4534,11 @@ void Camera3Device::RequestThread::cleanUpFailedRequests(bool sendRequestError)
           sp<Camera3Device> parent = mParent.promote();
           if (parent != NULL) {
               std::lock_guard<std::mutex> l(parent->mInFlightLock);
-              ssize_t idx = parent->mInFlightMap.indexOfKey(captureRequest->mResultExtras.frameNumber);
-              if (idx >= 0) {
+              uint32_t frameNumber = captureRequest->mResultExtras.frameNumber;
+              if (parent->mInFlightMap.find(frameNumber) != nullptr) {
                   ALOGV("%s: Remove inflight request from queue: frameNumber %" PRId64,
                         __FUNCTION__, captureRequest->mResultExtras.frameNumber);
-                  parent->removeInFlightMapEntryLocked(idx);
+                  parent->removeInFlightMapEntryLocked(frameNumber);
               }
           }
         }
@@ -1359,9 +1359,9 @@ class Camera3Device :
 
     /**** Scope for mInFlightLock ****/
 
-    // Remove the in-flight map entry of the given index from mInFlightMap.
+    // Remove the in-flight map entry of the given frame number from mInFlightMap.
     // It must only be called with mInFlightLock held.
-    void removeInFlightMapEntryLocked(int idx);
+    void removeInFlightMapEntryLocked(uint32_t frameNumber);
 
     // Remove all in-flight requests and return all buffers.
     // This is used after HAL interface is closed to cleanup any request/buffers
@@ -491,20 +491,19 @@ void sendCaptureResult(
     insertResultLocked(states, &captureResult, frameNumber);
 }
 
-void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
+void removeInFlightMapEntryLocked(CaptureOutputStates& states, uint32_t frameNumber) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
-    nsecs_t duration = inflightMap.valueAt(idx).maxExpectedDuration;
-    inflightMap.removeItemsAt(idx, 1);
+    nsecs_t duration = inflightMap.find(frameNumber)->maxExpectedDuration;
+    inflightMap.remove(frameNumber);
 
     states.inflightIntf.onInflightEntryRemovedLocked(duration);
 }
 
-void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx,
+void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, uint32_t frameNumber,
         std::vector<BufferToReturn> *returnableBuffers) {
     InFlightRequestMap& inflightMap = states.inflightMap;
-    const InFlightRequest &request = inflightMap.valueAt(idx);
-    const uint32_t frameNumber = inflightMap.keyAt(idx);
+    const InFlightRequest &request = *inflightMap.find(frameNumber);
     SessionStatsBuilder& sessionStatsBuilder = states.sessionStatsBuilder;
 
     nsecs_t sensorTimestamp = request.sensorTimestamp;
@@ -561,7 +560,7 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx,
 
         sessionStatsBuilder.incResultCounter(request.skipResultMetadata);
 
-        removeInFlightMapEntryLocked(states, idx);
+        removeInFlightMapEntryLocked(states, frameNumber);
         ALOGVV("%s: removed frame %d from InFlightMap", __FUNCTION__, frameNumber);
     }
 
@@ -597,15 +596,14 @@ const std::set<std::string>& getCameraIdsWithZoomLocked(
     }
 
     uint32_t overridingFrameNumber = frameNumberEntry.data.i32[0];
-    ssize_t idx = inflightMap.indexOfKey(overridingFrameNumber);
-    if (idx < 0) {
+    const InFlightRequest *r = inflightMap.find(overridingFrameNumber);
+    if (r == nullptr) {
         ALOGE("%s: Failed to find pending request #%d in inflight map",
                 __FUNCTION__, overridingFrameNumber);
         return cameraIdsWithZoom;
     }
 
-    const InFlightRequest &r = inflightMap.valueFor(overridingFrameNumber);
-    return r.cameraIdsWithZoom;
+    return r->cameraIdsWithZoom;
 }
 
 void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result) {
@@ -644,13 +642,13 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
     nsecs_t shutterTimestamp = 0;
     {
         std::lock_guard<std::mutex> l(states.inflightLock);
-        ssize_t idx = states.inflightMap.indexOfKey(frameNumber);
-        if (idx == NAME_NOT_FOUND) {
+        InFlightRequest *inflightRequest = states.inflightMap.find(frameNumber);
+        if (inflightRequest == nullptr) {
             SET_ERR("Unknown frame number for capture result: %d",
                     frameNumber);
             return;
         }
-        InFlightRequest &request = states.inflightMap.editValueAt(idx);
+        InFlightRequest &request = *inflightRequest;
         ALOGVV("%s: got InFlightRequest requestId = %" PRId32
                 ", frameNumber = %" PRId64 ", burstId = %" PRId32
                 ", partialResultCount = %d/%d, hasCallback = %d, num_output_buffers %d"
@@ -694,8 +692,8 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                                 // but we could still try and configure it for any future requests
                                 // that are still in flight. The assumption is that the physical
                                 // device id remains the same for the duration of the pending queue.
-                                for (size_t i = 0; i < states.inflightMap.size(); i++) {
-                                    auto &r = states.inflightMap.editValueAt(i);
+                                for (uint32_t f : states.inflightMap.frameNumbers()) {
+                                    auto &r = *states.inflightMap.find(f);
                                     if (r.requestTimeNs >= request.requestTimeNs) {
                                         r.transform = transform;
                                     }
@@ -832,7 +830,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     request.physicalMetadatas);
             }
         }
-        removeInFlightRequestIfReadyLocked(states, idx, &returnableBuffers);
+        removeInFlightRequestIfReadyLocked(states, frameNumber, &returnableBuffers);
         if (!flags::return_buffers_outside_locks()) {
             finishReturningOutputBuffers(returnableBuffers,
                 states.listener, states.sessionStatsBuilder);
@@ -1014,7 +1012,7 @@ void collectAndRemovePendingOutputBuffers(bool useHalBufManager,
 
 void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg) {
     ATRACE_CALL();
-    ssize_t idx;
+    bool found;
 
     std::vector<BufferToReturn> returnableBuffers{};
     CaptureResultExtras pendingNotificationResultExtras{};
@@ -1024,9 +1022,10 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
     {
         std::lock_guard<std::mutex> l(states.inflightLock);
         InFlightRequestMap& inflightMap = states.inflightMap;
-        idx = inflightMap.indexOfKey(msg.frame_number);
-        if (idx >= 0) {
-            InFlightRequest &r = inflightMap.editValueAt(idx);
+        InFlightRequest *inflightRequest = inflightMap.find(msg.frame_number);
+        found = inflightRequest != nullptr;
+        if (found) {
+            InFlightRequest &r = *inflightRequest;
 
             // Verify ordering of shutter notifications
             {
@@ -1109,11 +1108,11 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
                         states.listener, states.sessionStatsBuilder);
             }
 
-            removeInFlightRequestIfReadyLocked(states, idx, &returnableBuffers);
+            removeInFlightRequestIfReadyLocked(states, msg.frame_number, &returnableBuffers);
 
         }
     }
-    if (idx < 0) {
+    if (!found) {
         SET_ERR("Shutter notification for non-existent frame number %d",
                 msg.frame_number);
     }
@@ -1178,9 +1177,9 @@ void notifyError(CaptureOutputStates& states, const camera_error_msg_t &msg) {
             std::vector<BufferToReturn> returnableBuffers{};
             {
                 std::lock_guard<std::mutex> l(states.inflightLock);
-                ssize_t idx = states.inflightMap.indexOfKey(msg.frame_number);
-                if (idx >= 0) {
-                    InFlightRequest &r = states.inflightMap.editValueAt(idx);
+                InFlightRequest *inflightRequest = states.inflightMap.find(msg.frame_number);
+                if (inflightRequest != nullptr) {
+                    InFlightRequest &r = *inflightRequest;
                     r.requestStatus = msg.error_code;
                     resultExtras = r.resultExtras;
                     bool physicalDeviceResultError = false;
@@ -1212,7 +1211,8 @@ void notifyError(CaptureOutputStates& states, const camera_error_msg_t &msg) {
 
                         // Check whether the buffers returned. If they returned,
                         // remove inflight request.
-                        removeInFlightRequestIfReadyLocked(states, idx, &returnableBuffers);
+                        removeInFlightRequestIfReadyLocked(states, msg.frame_number,
+                                &returnableBuffers);
                         if (!flags::return_buffers_outside_locks()) {
                             finishReturningOutputBuffers(returnableBuffers,
                                     states.listener, states.sessionStatsBuilder);
@@ -1273,8 +1273,8 @@ void flushInflightRequests(FlushInflightReqStates& states) {
     std::vector<BufferToReturn> returnableBuffers{};
     { // First return buffers cached in inFlightMap
         std::lock_guard<std::mutex> l(states.inflightLock);
-        for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
-            const InFlightRequest &request = states.inflightMap.valueAt(idx);
+        for (uint32_t frameNumber : states.inflightMap.frameNumbers()) {
+            const InFlightRequest &request = *states.inflightMap.find(frameNumber);
             collectReturnableOutputBuffers(
                 states.useHalBufManager, states.halBufManagedStreamIds,
                 states.listener,
@@ -1290,7 +1290,7 @@ void flushInflightRequests(FlushInflightReqStates& states) {
             }
             ALOGW("%s: Frame %d |  Timestamp: %" PRId64 ", metadata"
                     " arrived: %s, buffers left: %d.\n", __FUNCTION__,
-                    states.inflightMap.keyAt(idx), request.shutterTimestamp,
+                    frameNumber, request.shutterTimestamp,
                     request.haveResultMetadata ? "true" : "false",
                     request.numBuffersLeft);
         }
@@ -126,6 +126,19 @@ status_t Camera3SharedOutputStream::notifyBufferReleased(ANativeWindowBuffer *an
     return res;
 }
 
+void Camera3SharedOutputStream::dump(int fd, const Vector<String16> &args) {
+    Camera3OutputStream::dump(fd, args);
+
+    sp<Camera3StreamSplitter> splitter;
+    {
+        Mutex::Autolock l(mLock);
+        splitter = mStreamSplitter;
+    }
+    if (splitter != nullptr) {
+        splitter->dump(fd);
+    }
+}
+
 bool Camera3SharedOutputStream::isConsumerConfigurationDeferred(size_t surface_id) const {
     Mutex::Autolock l(mLock);
     if (surface_id >= kMaxOutputs) {
@@ -55,6 +55,8 @@ public:
 
     virtual status_t notifyBufferReleased(ANativeWindowBuffer *buffer);
 
+    virtual void dump(int fd, const Vector<String16> &args);
+
     virtual bool isConsumerConfigurationDeferred(size_t surface_id) const;
 
     virtual status_t setConsumers(const std::vector<sp<Surface>>& consumers);
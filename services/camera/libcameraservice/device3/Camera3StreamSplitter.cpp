@@ -276,7 +276,7 @@ status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surfa
                 mConsumerBufferCount[surfaceId], mMaxHalBuffers);
     }
     mNotifiers[gbp] = listener;
-    mOutputSlots[gbp] = std::make_unique<OutputSlots>(totalBufferCount);
+    mOutputSlots[gbp] = std::make_unique<OutputSlots>(surfaceId, totalBufferCount);
 
     mMaxConsumerBuffers += maxConsumerBuffers;
     return NO_ERROR;
@@ -313,7 +313,7 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     //Search and decrement the ref. count of any buffers that are
     //still attached to the removed surface.
     std::vector<uint64_t> pendingBufferIds;
-    auto& outputSlots = *mOutputSlots[gbp];
+    auto& outputSlots = mOutputSlots[gbp]->mBuffers;
     for (size_t i = 0; i < outputSlots.size(); i++) {
         if (outputSlots[i] != nullptr) {
             pendingBufferIds.push_back(outputSlots[i]->getId());
@@ -377,6 +377,13 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
         SP_LOGE("%s: Invalid surface id: %zu!", __FUNCTION__, surfaceId);
     }
 
+    // Set before queueing, since the output can release the buffer before
+    // queueBuffer returns.
+    nsecs_t queueStart = systemTime();
+    if (slot != BufferItem::INVALID_BUFFER_SLOT) {
+        mOutputSlots[output]->mQueueTimes[slot] = queueStart;
+    }
+
     // In case the output BufferQueue has its own lock, if we hold splitter lock while calling
     // queueBuffer (which will try to acquire the output lock), the output could be holding its
     // own lock calling releaseBuffer (which  will try to acquire the splitter lock), running into
@@ -384,6 +391,7 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
     mMutex.unlock();
     res = output->queueBuffer(slot, queueInput, &queueOutput);
     mMutex.lock();
+    nsecs_t queueDuration = systemTime() - queueStart;
 
     SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
             __FUNCTION__, output.get(), slot, res);
@@ -392,7 +400,11 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
     if (mOutputSlots[output] == nullptr) {
         return res;
     }
+    OutputSlots& outputSlots = *mOutputSlots[output];
     if (res != OK) {
+        if (slot != BufferItem::INVALID_BUFFER_SLOT) {
+            outputSlots.mQueueTimes[slot] = 0;
+        }
         if (res != NO_INIT && res != DEAD_OBJECT) {
             SP_LOGE("Queuing buffer to output failed (%d)", res);
         }
@@ -404,6 +416,10 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
         return res;
     }
 
+    outputSlots.mQueueCount++;
+    outputSlots.mTotalQueueDuration += queueDuration;
+    outputSlots.mMaxQueueDuration = std::max(outputSlots.mMaxQueueDuration, queueDuration);
+
     // If the queued buffer replaces a pending buffer in the async
     // queue, no onBufferReleased is called by the buffer queue.
     // Proactively trigger the callback to avoid buffer loss.
@@ -414,6 +430,37 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
     return res;
 }
 
+void Camera3StreamSplitter::dump(int fd) {
+    Mutex::Autolock lock(mMutex);
+
+    std::string lines = fmt::sprintf("      Stream splitter %s: %zu buffers in flight\n",
+            mConsumerName.c_str(), mBuffers.size());
+    write(fd, lines.c_str(), lines.size());
+
+    std::vector<const OutputSlots*> outputs;
+    for (const auto& it : mOutputSlots) {
+        if (it.second != nullptr) {
+            outputs.push_back(it.second.get());
+        }
+    }
+    std::sort(outputs.begin(), outputs.end(), [](const OutputSlots* a, const OutputSlots* b) {
+        return a->mSurfaceId < b->mSurfaceId;
+    });
+    for (const OutputSlots* output : outputs) {
+        lines = fmt::sprintf("        Surface %zu: %zu buffers attached, %zu attachBuffer calls,"
+                " %zu frames queued", output->mSurfaceId, output->mSlots.size(),
+                output->mAttachCount, output->mQueueCount);
+        if (output->mQueueCount > 0) {
+            lines += fmt::sprintf(", queueBuffer avg %" PRId64 "us max %" PRId64 "us",
+                    ns2us(output->mTotalQueueDuration) / static_cast<int64_t>(output->mQueueCount),
+                    ns2us(output->mMaxQueueDuration));
+        }
+        lines += "\n";
+        write(fd, lines.c_str(), lines.size());
+        output->mReleaseLatency.dump(fd, "        Release latency histogram:");
+    }
+}
+
 std::string Camera3StreamSplitter::getUniqueConsumerName() {
     static volatile int32_t counter = 0;
     return fmt::sprintf("Camera3StreamSplitter-%d", android_atomic_inc(&counter));
@@ -479,18 +526,17 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
             continue;
         }
         auto& outputSlots = *mOutputSlots[gbp];
-        if (static_cast<size_t> (slot + 1) > outputSlots.size()) {
-            outputSlots.resize(slot + 1);
-        }
-        if (outputSlots[slot] != nullptr) {
+        if (static_cast<size_t>(slot) < outputSlots.mBuffers.size() &&
+                outputSlots.mBuffers[slot] != nullptr) {
             // If the buffer is attached to a slot which already contains a buffer,
             // the previous buffer will be removed from the output queue. Decrement
             // the reference count accordingly.
-            decrementBufRefCountLocked(outputSlots[slot]->getId(), surface_id);
+            decrementBufRefCountLocked(outputSlots.mBuffers[slot]->getId(), surface_id);
         }
         SP_LOGV("%s: Attached buffer %p to slot %d on output %p.",__FUNCTION__, gb.get(),
                 slot, gbp.get());
-        outputSlots[slot] = gb;
+        outputSlots.setBuffer(slot, gb);
+        outputSlots.mAttachCount++;
     }
 
     mBuffers[bufferId] = std::move(tracker);
@@ -541,6 +587,7 @@ void Camera3StreamSplitter::onFrameAvailable(const BufferItem& /*item*/) {
 
     // Attach and queue the buffer to each of the outputs
     BufferTracker& tracker = *(mBuffers[bufferId]);
+    tracker.setInputSlot(bufferItem.mSlot);
 
     SP_LOGV("%s: BufferTracker for buffer %" PRId64 ", number of requests %zu",
            __FUNCTION__, bufferItem.mGraphicBuffer->getId(), tracker.requestedSurfaces().size());
@@ -590,20 +637,23 @@ void Camera3StreamSplitter::decrementBufRefCountLocked(uint64_t id, size_t surfa
     mBuffers.erase(id);
 
     uint64_t bufferId = tracker_ptr->getBuffer()->getId();
-    int consumerSlot = -1;
-    uint64_t frameNumber;
-    auto inputSlot = mInputSlots.begin();
-    for (; inputSlot != mInputSlots.end(); inputSlot++) {
-        if (inputSlot->second.mGraphicBuffer->getId() == bufferId) {
-            consumerSlot = inputSlot->second.mSlot;
-            frameNumber = inputSlot->second.mFrameNumber;
-            break;
+    auto inputSlot = mInputSlots.find(tracker_ptr->getInputSlot());
+    if (inputSlot == mInputSlots.end() ||
+            inputSlot->second.mGraphicBuffer->getId() != bufferId) {
+        // The buffer is released before it was acquired from the input.
+        inputSlot = mInputSlots.begin();
+        for (; inputSlot != mInputSlots.end(); inputSlot++) {
+            if (inputSlot->second.mGraphicBuffer->getId() == bufferId) {
+                break;
+            }
         }
     }
-    if (consumerSlot == -1) {
+    if (inputSlot == mInputSlots.end()) {
         SP_LOGE("%s: Buffer missing inside input slots!", __FUNCTION__);
         return;
     }
+    int consumerSlot = inputSlot->second.mSlot;
+    uint64_t frameNumber = inputSlot->second.mFrameNumber;
 
     auto detachBuffer = mDetachedBuffers.find(bufferId);
     bool detach = (detachBuffer != mDetachedBuffers.end());
@@ -662,21 +712,13 @@ void Camera3StreamSplitter::onBufferReleasedByOutput(
         return;
     }
 
-    size_t surfaceId = 0;
-    bool found = false;
-    for (const auto& it : mOutputs) {
-        if (it.second == from) {
-            found = true;
-            surfaceId = it.first;
-            break;
-        }
-    }
-    if (!found) {
+    auto outputSlots = mOutputSlots.find(from);
+    if (outputSlots == mOutputSlots.end() || outputSlots->second == nullptr) {
         SP_LOGV("%s: output surface not registered anymore!", __FUNCTION__);
         return;
     }
 
-    returnOutputBufferLocked(fence, from, surfaceId, slot);
+    returnOutputBufferLocked(fence, from, outputSlots->second->mSurfaceId, slot);
 }
 
 void Camera3StreamSplitter::onBufferReplacedLocked(
@@ -704,8 +746,12 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
         return;
     }
 
-    auto outputSlots = *mOutputSlots[from];
-    buffer = outputSlots[slot];
+    auto& outputSlots = *mOutputSlots[from];
+    buffer = outputSlots.mBuffers[slot];
+    if (outputSlots.mQueueTimes[slot] != 0) {
+        outputSlots.mReleaseLatency.add(outputSlots.mQueueTimes[slot], systemTime());
+        outputSlots.mQueueTimes[slot] = 0;
+    }
     BufferTracker& tracker = *(mBuffers[buffer->getId()]);
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
@@ -718,7 +764,7 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
     if (detach) {
         auto res = from->detachBuffer(slot);
         if (res == NO_ERROR) {
-            outputSlots[slot] = nullptr;
+            outputSlots.clearBuffer(slot);
         } else {
             SP_LOGE("%s: detach buffer from output failed (%d)", __FUNCTION__, res);
         }
@@ -764,12 +810,9 @@ void Camera3StreamSplitter::onAbandonedLocked() {
 
 int Camera3StreamSplitter::getSlotForOutputLocked(const sp<IGraphicBufferProducer>& gbp,
         const sp<GraphicBuffer>& gb) {
-    auto& outputSlots = *mOutputSlots[gbp];
-
-    for (size_t i = 0; i < outputSlots.size(); i++) {
-        if (outputSlots[i] == gb) {
-            return (int)i;
-        }
+    int slot = mOutputSlots[gbp]->getSlot(gb->getId());
+    if (slot != BufferItem::INVALID_BUFFER_SLOT) {
+        return slot;
     }
 
     SP_LOGV("%s: Cannot find slot for gb %p on output %p", __FUNCTION__, gb.get(),
@@ -802,7 +845,7 @@ void Camera3StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who
 Camera3StreamSplitter::BufferTracker::BufferTracker(
         const sp<GraphicBuffer>& buffer, const std::vector<size_t>& requestedSurfaces)
       : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mRequestedSurfaces(requestedSurfaces),
-        mReferenceCount(requestedSurfaces.size()) {}
+        mReferenceCount(requestedSurfaces.size()), mInputSlot(BufferItem::INVALID_BUFFER_SLOT) {}
 
 void Camera3StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
     mMergedFence = Fence::merge(String8("Camera3StreamSplitter"), mMergedFence, with);
@@ -821,4 +864,31 @@ size_t Camera3StreamSplitter::BufferTracker::decrementReferenceCountLocked(size_
     return mReferenceCount;
 }
 
+Camera3StreamSplitter::OutputSlots::OutputSlots(size_t surfaceId, size_t slotCount)
+      : mSurfaceId(surfaceId), mBuffers(slotCount), mQueueTimes(slotCount),
+        mReleaseLatency(kReleaseLatencyBinSize) {}
+
+void Camera3StreamSplitter::OutputSlots::setBuffer(int slot, const sp<GraphicBuffer>& buffer) {
+    if (static_cast<size_t>(slot) >= mBuffers.size()) {
+        mBuffers.resize(slot + 1);
+        mQueueTimes.resize(slot + 1);
+    }
+    clearBuffer(slot);
+    mBuffers[slot] = buffer;
+    mSlots[buffer->getId()] = slot;
+}
+
+void Camera3StreamSplitter::OutputSlots::clearBuffer(int slot) {
+    if (mBuffers[slot] != nullptr) {
+        mSlots.erase(mBuffers[slot]->getId());
+        mBuffers[slot] = nullptr;
+    }
+    mQueueTimes[slot] = 0;
+}
+
+int Camera3StreamSplitter::OutputSlots::getSlot(uint64_t bufferId) const {
+    auto it = mSlots.find(bufferId);
+    return it != mSlots.end() ? it->second : BufferItem::INVALID_BUFFER_SLOT;
+}
+
 } // namespace android
@@ -30,6 +30,8 @@
 #include <utils/StrongPointer.h>
 #include <utils/Timers.h>
 
+#include "utils/LatencyHistogram.h"
+
 #define SP_LOGV(x, ...) ALOGV("[%s] " x, mConsumerName.c_str(), ##__VA_ARGS__)
 #define SP_LOGI(x, ...) ALOGI("[%s] " x, mConsumerName.c_str(), ##__VA_ARGS__)
 #define SP_LOGW(x, ...) ALOGW("[%s] " x, mConsumerName.c_str(), ##__VA_ARGS__)
@@ -47,6 +49,10 @@ class IGraphicBufferProducer;
 // BufferQueue, where each buffer queued to the input is available to be
 // acquired by each of the outputs, and is able to be dequeued by the input
 // again only once all of the outputs have released it.
+//
+// A buffer stays attached to an output once it has been attached, so in steady
+// state, when the camera cycles through the same set of buffers, frames are
+// only queued to and dequeued from the outputs.
 class Camera3StreamSplitter : public BnConsumerListener {
 public:
 
@@ -96,6 +102,9 @@ public:
 
     void setHalBufferManager(bool enabled);
 
+    // Dump the per-output buffer and latency counters.
+    void dump(int fd);
+
 private:
     // From IConsumerListener
     //
@@ -194,6 +203,11 @@ private:
 
         const std::vector<size_t> requestedSurfaces() const { return mRequestedSurfaces; }
 
+        // The input queue slot the buffer was acquired from, or
+        // BufferItem::INVALID_BUFFER_SLOT if it hasn't been acquired yet.
+        int getInputSlot() const { return mInputSlot; }
+        void setInputSlot(int slot) { mInputSlot = slot; }
+
     private:
 
         // Disallow copying
@@ -208,6 +222,42 @@ private:
         // which output is the buffer sent to.
         std::vector<size_t> mRequestedSurfaces;
         size_t mReferenceCount;
+        int mInputSlot;
+    };
+
+    // The buffers attached to one output, and the counters dumped for it.
+    // Attaching a buffer that is already attached to an output is a lookup in
+    // mSlots instead of a call into the output queue.
+    struct OutputSlots {
+        OutputSlots(size_t surfaceId, size_t slotCount);
+
+        // Record that the buffer is attached to the slot, replacing any
+        // buffer that was attached to it before.
+        void setBuffer(int slot, const sp<GraphicBuffer>& buffer);
+        void clearBuffer(int slot);
+
+        // Return the slot the buffer is attached to, or
+        // BufferItem::INVALID_BUFFER_SLOT.
+        int getSlot(uint64_t bufferId) const;
+
+        const size_t mSurfaceId;
+
+        // Slot -> attached buffer
+        std::vector<sp<GraphicBuffer>> mBuffers;
+
+        // Attached buffer id -> slot
+        std::unordered_map<uint64_t, int> mSlots;
+
+        // Slot -> time the buffer was queued, or 0 if it isn't queued
+        std::vector<nsecs_t> mQueueTimes;
+
+        size_t mAttachCount = 0;
+        size_t mQueueCount = 0;
+        nsecs_t mTotalQueueDuration = 0;
+        nsecs_t mMaxQueueDuration = 0;
+
+        // Time from queueing a buffer to the output until the output releases it
+        CameraLatencyHistogram mReleaseLatency;
     };
 
     // Must be accessed through RefBase
@@ -244,6 +294,8 @@ private:
     static const nsecs_t kNormalDequeueBufferTimeout    = s2ns(1);  // 1 sec
     static const nsecs_t kHalBufMgrDequeueBufferTimeout = ms2ns(1); // 1 msec
 
+    static const int32_t kReleaseLatencyBinSize = 10; // in ms
+
     Mutex mMutex;
 
     sp<IGraphicBufferProducer> mProducer;
@@ -251,7 +303,7 @@ private:
     sp<BufferItemConsumer> mBufferItemConsumer;
     sp<Surface> mSurface;
 
-    //Map graphic buffer ids -> buffer items
+    //Map input queue slots -> buffer items
     std::unordered_map<uint64_t, BufferItem> mInputSlots;
 
     //Map surface ids -> gbp outputs
@@ -277,7 +329,6 @@ private:
     std::unordered_map<sp<IGraphicBufferProducer>, sp<OutputListener>,
             GBPHash> mNotifiers;
 
-    typedef std::vector<sp<GraphicBuffer>> OutputSlots;
     std::unordered_map<sp<IGraphicBufferProducer>, std::unique_ptr<OutputSlots>,
             GBPHash> mOutputSlots;
 
@@ -280,7 +280,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -385,25 +385,31 @@ status_t DistortionMapper::mapCorrectedToRawImpl(T *coordPairs, int coordCount,
 
     if (simple) return mapCorrectedToRawImplSimple(coordPairs, coordCount, mapperInfo, clamp);
 
-    float activeCx = mapperInfo->mCx - mapperInfo->mArrayDiffX;
-    float activeCy = mapperInfo->mCy - mapperInfo->mArrayDiffY;
+    // Copy the parameters, as coordPairs may alias mapperInfo when T is float, which
+    // would force them to be reloaded for every point.
+    const float fx = mapperInfo->mFx, fy = mapperInfo->mFy;
+    const float cx = mapperInfo->mCx, cy = mapperInfo->mCy, s = mapperInfo->mS;
+    const float invFx = mapperInfo->mInvFx, invFy = mapperInfo->mInvFy;
+    const std::array<float, 5> kK = mapperInfo->mK;
+    const float maxX = mapperInfo->mArrayWidth - 1, maxY = mapperInfo->mArrayHeight - 1;
+    const float activeCx = cx - mapperInfo->mArrayDiffX;
+    const float activeCy = cy - mapperInfo->mArrayDiffY;
     for (int i = 0; i < coordCount * 2; i += 2) {
         // Move to normalized space from active array space
-        float ywi = (coordPairs[i + 1] - activeCy) * mapperInfo->mInvFy;
-        float xwi = (coordPairs[i] - activeCx - mapperInfo->mS * ywi) * mapperInfo->mInvFx;
+        float ywi = (coordPairs[i + 1] - activeCy) * invFy;
+        float xwi = (coordPairs[i] - activeCx - s * ywi) * invFx;
         // Apply distortion model to calculate raw image coordinates
-        const std::array<float, 5> &kK = mapperInfo->mK;
         float rSq = xwi * xwi + ywi * ywi;
         float Fr = 1.f + (kK[0] * rSq) + (kK[1] * rSq * rSq) + (kK[2] * rSq * rSq * rSq);
         float xc = xwi * Fr + (kK[3] * 2 * xwi * ywi) + kK[4] * (rSq + 2 * xwi * xwi);
         float yc = ywi * Fr + (kK[4] * 2 * xwi * ywi) + kK[3] * (rSq + 2 * ywi * ywi);
         // Move back to image space
-        float xr = mapperInfo->mFx * xc + mapperInfo->mS * yc + mapperInfo->mCx;
-        float yr = mapperInfo->mFy * yc + mapperInfo->mCy;
+        float xr = fx * xc + s * yc + cx;
+        float yr = fy * yc + cy;
         // Clamp to within pre-correction active array
         if (clamp) {
-            xr = std::min(mapperInfo->mArrayWidth - 1, std::max(0.f, xr));
-            yr = std::min(mapperInfo->mArrayHeight - 1, std::max(0.f, yr));
+            xr = std::min(maxX, std::max(0.f, xr));
+            yr = std::min(maxY, std::max(0.f, yr));
         }
 
         coordPairs[i] = static_cast<T>(std::round(xr));
@@ -439,25 +445,22 @@ status_t DistortionMapper::mapCorrectedRectToRaw(int32_t *rects, int rectCount,
        const DistortionMapperInfo *mapperInfo, bool clamp, bool simple) const {
     if (!mapperInfo->mValidMapping) return INVALID_OPERATION;
 
+    // Map from (l, t, width, height) to (l, t, r, b) in place, so that the
+    // corners of all rectangles are mapped in one pass
     for (int i = 0; i < rectCount * 4; i += 4) {
-        // Map from (l, t, width, height) to (l, t, r, b)
-        int32_t coords[4] = {
-            rects[i],
-            rects[i + 1],
-            rects[i] + rects[i + 2] - 1,
-            rects[i + 1] + rects[i + 3] - 1
-        };
+        rects[i + 2] = rects[i] + rects[i + 2] - 1;
+        rects[i + 3] = rects[i + 1] + rects[i + 3] - 1;
+    }
 
-        mapCorrectedToRaw(coords, 2, mapperInfo, clamp, simple);
+    status_t res = mapCorrectedToRaw(rects, rectCount * 2, mapperInfo, clamp, simple);
 
-        // Map back to (l, t, width, height)
-        rects[i] = coords[0];
-        rects[i + 1] = coords[1];
-        rects[i + 2] = coords[2] - coords[0] + 1;
-        rects[i + 3] = coords[3] - coords[1] + 1;
+    // Map back to (l, t, width, height)
+    for (int i = 0; i < rectCount * 4; i += 4) {
+        rects[i + 2] = rects[i + 2] - rects[i] + 1;
+        rects[i + 3] = rects[i + 3] - rects[i + 1] + 1;
     }
 
-    return OK;
+    return res;
 }
 
 status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
@@ -490,43 +493,134 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    buildQuadIndex(mapperInfo);
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+void DistortionMapper::buildQuadIndex(DistortionMapperInfo *mapperInfo) {
+    const std::vector<GridQuad>& grid = mapperInfo->mDistortedGrid;
+    QuadIndex& index = mapperInfo->mDistortedGridIndex;
+    index.mCellStart.clear();
+    index.mQuads.clear();
+
+    // Bounds of each quad as (left, top, right, bottom), and of the whole grid
+    std::vector<std::array<float, 4>> bounds(grid.size());
+    float left = INFINITY, top = INFINITY, right = -INFINITY, bottom = -INFINITY;
+    for (size_t q = 0; q < grid.size(); q++) {
+        const std::array<float, 8>& c = grid[q].coords;
+        if (!std::all_of(c.begin(), c.end(), [](float v) { return std::isfinite(v); })) {
+            left = NAN;
+            break;
+        }
+        bounds[q] = {
+            std::min({c[0], c[2], c[4], c[6]}) - kQuadIndexMargin,
+            std::min({c[1], c[3], c[5], c[7]}) - kQuadIndexMargin,
+            std::max({c[0], c[2], c[4], c[6]}) + kQuadIndexMargin,
+            std::max({c[1], c[3], c[5], c[7]}) + kQuadIndexMargin
+        };
+        left = std::min(left, bounds[q][0]);
+        top = std::min(top, bounds[q][1]);
+        right = std::max(right, bounds[q][2]);
+        bottom = std::max(bottom, bounds[q][3]);
+    }
+
+    index.mX = left;
+    index.mY = top;
+    index.mInvCellWidth = kQuadIndexSize / (right - left);
+    index.mInvCellHeight = kQuadIndexSize / (bottom - top);
+    if (grid.empty() || !std::isfinite(right - left) || !std::isfinite(bottom - top) ||
+            !std::isfinite(index.mInvCellWidth) || !std::isfinite(index.mInvCellHeight)) {
+        // Degenerate calibration; fall back to testing every quad
+        ALOGW("%s: Unable to index distorted grid", __FUNCTION__);
+        return;
+    }
+
+    std::vector<std::vector<uint16_t>> cells(kQuadIndexSize * kQuadIndexSize);
+    for (size_t q = 0; q < grid.size(); q++) {
+        size_t cellLeft = quadIndexCell(bounds[q][0], index.mX, index.mInvCellWidth);
+        size_t cellTop = quadIndexCell(bounds[q][1], index.mY, index.mInvCellHeight);
+        size_t cellRight = quadIndexCell(bounds[q][2], index.mX, index.mInvCellWidth);
+        size_t cellBottom = quadIndexCell(bounds[q][3], index.mY, index.mInvCellHeight);
+        for (size_t cy = cellTop; cy <= cellBottom; cy++) {
+            for (size_t cx = cellLeft; cx <= cellRight; cx++) {
+                cells[cy * kQuadIndexSize + cx].push_back(static_cast<uint16_t>(q));
+            }
+        }
+    }
+
+    index.mCellStart.reserve(cells.size() + 1);
+    for (const std::vector<uint16_t>& cell : cells) {
+        index.mCellStart.push_back(index.mQuads.size());
+        index.mQuads.insert(index.mQuads.end(), cell.begin(), cell.end());
+    }
+    index.mCellStart.push_back(index.mQuads.size());
+}
+
+size_t DistortionMapper::quadIndexCell(float coord, float origin, float invCellSize) {
+    float cell = std::floor((coord - origin) * invCellSize);
+    return static_cast<size_t>(
+            std::clamp(cell, 0.f, static_cast<float>(kQuadIndexSize - 1)));
+}
+
+bool DistortionMapper::isInQuad(float x, float y, const GridQuad& quad) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (isInQuad(x, y, quad)) return &quad;
+    }
+    return nullptr;
+}
+
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    const QuadIndex& index = mapperInfo.mDistortedGridIndex;
+    if (index.mCellStart.empty()) {
+        return findEnclosingQuad(pt, mapperInfo.mDistortedGrid);
+    }
+
+    const float x = pt[0];
+    const float y = pt[1];
+    // Points outside of the index are clamped to its edge cells, whose quads
+    // can't enclose them either.
+    size_t cell = quadIndexCell(y, index.mY, index.mInvCellHeight) * kQuadIndexSize +
+            quadIndexCell(x, index.mX, index.mInvCellWidth);
+    for (uint32_t i = index.mCellStart[cell]; i < index.mCellStart[cell + 1]; i++) {
+        const GridQuad& quad = mapperInfo.mDistortedGrid[index.mQuads[i]];
+        if (isInQuad(x, y, quad)) return &quad;
     }
     return nullptr;
 }
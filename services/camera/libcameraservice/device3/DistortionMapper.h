@@ -135,6 +135,19 @@ class DistortionMapper : public CoordinateMapper {
         std::array<float, 8> coords;
     };
 
+    // Uniform grid of cells over the distorted grid. Each cell lists, in grid
+    // order, the quads whose bounds overlap it, so that only those need to be
+    // tested for a point in the cell.
+    struct QuadIndex {
+        // top-left corner of the index, and inverse cell dimensions, in pixels
+        float mX, mY;
+        float mInvCellWidth, mInvCellHeight;
+        // mQuads[mCellStart[c]] to mQuads[mCellStart[c + 1] - 1] are the
+        // quads of cell c; empty if the index is not usable
+        std::vector<uint32_t> mCellStart;
+        std::vector<uint16_t> mQuads;
+    };
+
     struct DistortionMapperInfo {
         bool mValidMapping = false;
         bool mValidGrids = false;
@@ -155,12 +168,17 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+        QuadIndex mDistortedGridIndex;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Same as above for the distorted grid of mapperInfo, using its index
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -188,6 +206,11 @@ class DistortionMapper : public CoordinateMapper {
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
     constexpr static float kFloatFuzz = 1e-4;
+    // Number of cells in each dimension of the distorted grid index
+    constexpr static size_t kQuadIndexSize = 2 * kGridSize;
+    // Margin to expand quad bounds by in the index, in pixels, so that points
+    // on the edges of a quad are always found despite rounding
+    constexpr static float kQuadIndexMargin = 1.f;
 
     bool mMaxResolution = false;
 
@@ -209,6 +232,15 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Utility to create the index of the distorted grid
+    static void buildQuadIndex(DistortionMapperInfo *mapperInfo);
+
+    // Index cell of a coordinate along one dimension, clamped to the index
+    static size_t quadIndexCell(float coord, float origin, float invCellSize);
+
+    // Whether the point is within the quad or on its edges
+    static bool isInQuad(float x, float y, const GridQuad& quad);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA3_FRAME_NUMBER_MAP_H
+#define ANDROID_SERVERS_CAMERA3_FRAME_NUMBER_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * Map from frame number to per-frame state, with constant time add, find and
+ * remove.
+ *
+ * Frame numbers in flight are mostly consecutive, so entries are kept in a
+ * ring of buckets indexed by the low bits of the frame number. The ring grows
+ * with the number of entries, not with the range of frame numbers, so a frame
+ * that is never completed doesn't make it grow. Buckets keep their storage
+ * after entries are removed, so a steady stream of frames doesn't allocate.
+ *
+ * Not thread safe. Adding or removing entries invalidates pointers to values.
+ */
+template <typename T>
+class FrameNumberMap {
+  public:
+    FrameNumberMap() : mBuckets(kMinBuckets), mSize(0) {}
+
+    size_t size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+
+    /**
+     * Return the value of the frame number, or nullptr if there is none
+     */
+    T* find(uint32_t frameNumber) {
+        for (Entry& entry : bucketFor(frameNumber)) {
+            if (entry.frameNumber == frameNumber) return &entry.value;
+        }
+        return nullptr;
+    }
+
+    const T* find(uint32_t frameNumber) const {
+        return const_cast<FrameNumberMap*>(this)->find(frameNumber);
+    }
+
+    /**
+     * Add the value of the frame number, replacing any existing one
+     */
+    void add(uint32_t frameNumber, T value) {
+        T* existing = find(frameNumber);
+        if (existing != nullptr) {
+            *existing = std::move(value);
+            return;
+        }
+        if (mSize >= mBuckets.size()) {
+            rehash(mBuckets.size() * 2);
+        }
+        bucketFor(frameNumber).push_back(Entry{frameNumber, std::move(value)});
+        mSize++;
+    }
+
+    /**
+     * Remove the value of the frame number. Return false if there is none.
+     */
+    bool remove(uint32_t frameNumber) {
+        std::vector<Entry>& bucket = bucketFor(frameNumber);
+        for (auto it = bucket.begin(); it != bucket.end(); it++) {
+            if (it->frameNumber == frameNumber) {
+                bucket.erase(it);
+                mSize--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        for (std::vector<Entry>& bucket : mBuckets) {
+            bucket.clear();
+        }
+        mSize = 0;
+    }
+
+    /**
+     * Return the frame numbers of all entries, in increasing order. This
+     * sorts, so it's meant for the flush, error and dump paths.
+     */
+    std::vector<uint32_t> frameNumbers() const {
+        std::vector<uint32_t> frameNumbers;
+        frameNumbers.reserve(mSize);
+        for (const std::vector<Entry>& bucket : mBuckets) {
+            for (const Entry& entry : bucket) {
+                frameNumbers.push_back(entry.frameNumber);
+            }
+        }
+        std::sort(frameNumbers.begin(), frameNumbers.end());
+        return frameNumbers;
+    }
+
+  private:
+    struct Entry {
+        uint32_t frameNumber;
+        T value;
+    };
+
+    // Must be a power of two
+    static constexpr size_t kMinBuckets = 16;
+
+    std::vector<std::vector<Entry>> mBuckets;
+    size_t mSize;
+
+    std::vector<Entry>& bucketFor(uint32_t frameNumber) {
+        return mBuckets[frameNumber & (mBuckets.size() - 1)];
+    }
+
+    void rehash(size_t bucketCount) {
+        std::vector<std::vector<Entry>> buckets(bucketCount);
+        for (std::vector<Entry>& bucket : mBuckets) {
+            for (Entry& entry : bucket) {
+                buckets[entry.frameNumber & (bucketCount - 1)].push_back(std::move(entry));
+            }
+        }
+        mBuckets.swap(buckets);
+    }
+
+}; // class FrameNumberMap
+
+} // namespace camera3
+
+} // namespace android
+
+#endif
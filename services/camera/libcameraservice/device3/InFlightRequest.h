@@ -24,6 +24,7 @@
 #include <utils/Timers.h>
 
 #include "common/CameraDeviceBase.h"
+#include "device3/FrameNumberMap.h"
 
 namespace android {
 
@@ -201,7 +202,7 @@ struct InFlightRequest {
     static const nsecs_t kDefaultMinExpectedDuration = 33333333; // 33 ms
     static const nsecs_t kDefaultMaxExpectedDuration = 100000000; // 100 ms
 
-    // Default constructor needed by KeyedVector
+    // Default constructor
     InFlightRequest() :
             shutterTimestamp(0),
             sensorTimestamp(0),
@@ -255,7 +256,7 @@ struct InFlightRequest {
 };
 
 // Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+typedef FrameNumberMap<InFlightRequest> InFlightRequestMap;
 
 } // namespace camera3
 
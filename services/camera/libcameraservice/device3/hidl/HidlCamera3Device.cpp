@@ -611,13 +611,13 @@ status_t HidlCamera3Device::switchToOffline(
     {
         std::lock_guard<std::mutex> l(mInFlightLock);
         for (auto offlineReq : offlineSessionInfo.offlineRequests) {
-            int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
-            if (idx == NAME_NOT_FOUND) {
+            const InFlightRequest *inflightRequest = mInFlightMap.find(offlineReq.frameNumber);
+            if (inflightRequest == nullptr) {
                 SET_ERR("Offline request frame number %d not found!", offlineReq.frameNumber);
                 return UNKNOWN_ERROR;
             }
 
-            const auto& inflightReq = mInFlightMap.valueAt(idx);
+            const auto& inflightReq = *inflightRequest;
             // TODO: check specific stream IDs
             size_t numBuffersLeft = static_cast<size_t>(inflightReq.numBuffersLeft);
             if (numBuffersLeft != offlineReq.pendingStreams.size()) {
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3StreamSplitterTest"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include <fmt/printf.h>
+#include <gtest/gtest.h>
+#include <gui/BufferItemConsumer.h>
+#include <gui/BufferQueue.h>
+#include <gui/Surface.h>
+
+#include "../device3/Camera3StreamSplitter.h"
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kWidth = 640;
+constexpr uint32_t kHeight = 480;
+constexpr PixelFormat kFormat = PIXEL_FORMAT_RGBA_8888;
+constexpr uint64_t kUsage = GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN;
+constexpr size_t kHalMaxBuffers = 4;
+constexpr int kInputBufferCount = 16;
+constexpr size_t kWarmupFrames = 50;
+constexpr size_t kFrames = 500;
+
+} // anonymous namespace
+
+class Camera3StreamSplitterTest : public ::testing::Test {
+  protected:
+    void TearDown() override {
+        if (mInput != nullptr) {
+            native_window_api_disconnect(mInput.get(), NATIVE_WINDOW_API_CAMERA);
+        }
+        if (mSplitter != nullptr) {
+            mSplitter->disconnect();
+        }
+    }
+
+    void connect(size_t outputCount) {
+        std::unordered_map<size_t, sp<Surface>> surfaces;
+        for (size_t i = 0; i < outputCount; i++) {
+            sp<IGraphicBufferProducer> producer;
+            sp<IGraphicBufferConsumer> consumer;
+            BufferQueue::createBufferQueue(&producer, &consumer);
+            mOutputs.push_back(new BufferItemConsumer(consumer, kUsage));
+            surfaces[i] = new Surface(producer);
+            mSurfaceIds.push_back(i);
+        }
+
+        mSplitter = new Camera3StreamSplitter();
+        ASSERT_EQ(OK, mSplitter->connect(surfaces, kUsage, kUsage, kHalMaxBuffers, kWidth,
+                kHeight, kFormat, &mInput,
+                ANDROID_REQUEST_AVAILABLE_DYNAMIC_RANGE_PROFILES_MAP_STANDARD));
+
+        ANativeWindow* anw = mInput.get();
+        ASSERT_EQ(OK, native_window_api_connect(anw, NATIVE_WINDOW_API_CAMERA));
+        ASSERT_EQ(OK, native_window_set_usage(anw, kUsage));
+        ASSERT_EQ(OK, native_window_set_buffers_dimensions(anw, kWidth, kHeight));
+        ASSERT_EQ(OK, native_window_set_buffers_format(anw, kFormat));
+        ASSERT_EQ(OK, native_window_set_buffer_count(anw, kInputBufferCount));
+    }
+
+    // Pass one frame the way Camera3SharedOutputStream does, and have every
+    // output consume it.
+    void runFrame() {
+        ANativeWindow* anw = mInput.get();
+        ANativeWindowBuffer* anb = nullptr;
+        int fenceFd = -1;
+        ASSERT_EQ(OK, anw->dequeueBuffer(anw, &anb, &fenceFd));
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        ASSERT_EQ(OK, mSplitter->attachBufferToOutputs(anb, mSurfaceIds));
+        ASSERT_EQ(OK, anw->queueBuffer(anw, anb, /*fenceFd*/ -1));
+        ASSERT_EQ(OK, mSplitter->getOnFrameAvailableResult());
+
+        for (auto& output : mOutputs) {
+            BufferItem item;
+            ASSERT_EQ(OK, output->acquireBuffer(&item, /*presentWhen*/ 0));
+            // Returns the buffer to the splitter, and to the input once all
+            // outputs have released it.
+            ASSERT_EQ(OK, output->releaseBuffer(item));
+        }
+    }
+
+    // Return the time per frame in steady state
+    std::chrono::duration<double, std::micro> runFrames() {
+        for (size_t i = 0; i < kWarmupFrames && !HasFatalFailure(); i++) {
+            runFrame();
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kFrames && !HasFatalFailure(); i++) {
+            runFrame();
+        }
+        return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                std::chrono::steady_clock::now() - start) / kFrames;
+    }
+
+    // Counters of one output, as dumped by the splitter
+    struct OutputStats {
+        size_t surfaceId;
+        size_t attached;
+        size_t attachCalls;
+        size_t queued;
+    };
+
+    std::vector<OutputStats> parseOutputStats(const std::string& dump) {
+        std::vector<OutputStats> stats;
+        std::istringstream lines(dump);
+        std::string line;
+        while (std::getline(lines, line)) {
+            OutputStats output;
+            if (sscanf(line.c_str(), " Surface %zu: %zu buffers attached, %zu attachBuffer calls,"
+                    " %zu frames queued", &output.surfaceId, &output.attached,
+                    &output.attachCalls, &output.queued) == 4) {
+                stats.push_back(output);
+            }
+        }
+        return stats;
+    }
+
+    // Each input buffer is attached to each output once, no matter how many
+    // frames go through it.
+    void expectSteadyState(size_t outputCount, size_t frames) {
+        std::string dump = dumpSplitter();
+        std::vector<OutputStats> stats = parseOutputStats(dump);
+        EXPECT_EQ(outputCount, stats.size()) << dump;
+        for (const OutputStats& output : stats) {
+            EXPECT_EQ(frames, output.queued) << "surface " << output.surfaceId;
+            EXPECT_LE(output.attached, static_cast<size_t>(kInputBufferCount))
+                    << "surface " << output.surfaceId;
+            EXPECT_EQ(output.attached, output.attachCalls) << "surface " << output.surfaceId;
+        }
+    }
+
+    std::string dumpSplitter() {
+        int fd = memfd_create("Camera3StreamSplitterTest", 0);
+        EXPECT_GE(fd, 0);
+        mSplitter->dump(fd);
+        std::string out(lseek(fd, 0, SEEK_CUR), '\0');
+        EXPECT_EQ(static_cast<ssize_t>(out.size()), pread(fd, out.data(), out.size(), 0));
+        close(fd);
+        return out;
+    }
+
+    std::vector<sp<BufferItemConsumer>> mOutputs;
+    std::vector<size_t> mSurfaceIds;
+    sp<Camera3StreamSplitter> mSplitter;
+    sp<Surface> mInput;
+};
+
+TEST_F(Camera3StreamSplitterTest, SteadyStateDoesNotAttach) {
+    connect(3);
+    for (size_t i = 0; i < kWarmupFrames + kFrames; i++) {
+        runFrame();
+        if (HasFatalFailure()) return;
+    }
+
+    expectSteadyState(3, kWarmupFrames + kFrames);
+    std::string dump = dumpSplitter();
+    EXPECT_NE(std::string::npos, dump.find("Release latency histogram: (" +
+            std::to_string(kWarmupFrames + kFrames) + ") samples")) << dump;
+}
+
+TEST_F(Camera3StreamSplitterTest, PerOutputCostDoesNotGrow) {
+    const size_t outputCounts[] = {2, 4};
+    for (size_t i = 0; i < 2; i++) {
+        TearDown();
+        mOutputs.clear();
+        mSurfaceIds.clear();
+        mInput.clear();
+        mSplitter.clear();
+        connect(outputCounts[i]);
+        if (HasFatalFailure()) return;
+
+        auto perFrame = runFrames();
+        if (HasFatalFailure()) return;
+        // For reference only; timings are too noisy on devices to assert on.
+        RecordProperty(fmt::sprintf("PerFrameUs%zuOutputs", outputCounts[i]),
+                fmt::sprintf("%f", perFrame.count()));
+
+        // Per frame, the splitter queues the buffer once to each output and
+        // attaches nothing, whatever the number of outputs.
+        expectSteadyState(outputCounts[i], kWarmupFrames + kFrames);
+    }
+}
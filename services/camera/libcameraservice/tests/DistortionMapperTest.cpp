@@ -348,6 +348,80 @@ TEST(DistortionMapperTest, LargeTransform) {
     RandomTransformTest(this, testActiveArray, m, /*clamp*/false, /*simple*/false);
 }
 
+// The index of the distorted grid must find the same quad as testing all of them,
+// including for points outside of the grid
+TEST(DistortionMapperTest, QuadIndexMatchesLinearSearch) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+    float distortion[] = {0.06875723, -0.13922249, 0.02818312, -0.00032781, -0.00025431};
+    float intrinsics[] = {1812.50000000, 1812.50000000, 1645.59533691, 1229.23229980, 0.00000000};
+    int32_t activeArray[] = {0, 8, 3278, 2450};
+    int32_t preCorrectionActiveArray[] = {0, 0, 3280, 2464};
+
+    DistortionMapper big, small;
+    setupTestMapper(&big, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    setupTestMapper(&small, distortion, intrinsics, activeArray, preCorrectionActiveArray);
+
+    for (DistortionMapper *m : {&big, &small}) {
+        DistortionMapperInfo *mapperInfo = m->getMapperInfo();
+        // Build the grids
+        int32_t coords[2] = {
+            static_cast<int32_t>(mapperInfo->mArrayWidth / 2),
+            static_cast<int32_t>(mapperInfo->mArrayHeight / 2)
+        };
+        ASSERT_EQ(OK, m->mapRawToCorrected(coords, 1, mapperInfo, /*clamp*/false,
+                /*simple*/false));
+        ASSERT_FALSE(mapperInfo->mDistortedGridIndex.mCellStart.empty());
+
+        int32_t width = static_cast<int32_t>(mapperInfo->mArrayWidth);
+        int32_t height = static_cast<int32_t>(mapperInfo->mArrayHeight);
+        for (int32_t y = -height / 4; y < height * 5 / 4; y += 13) {
+            for (int32_t x = -width / 4; x < width * 5 / 4; x += 13) {
+                int32_t pt[2] = {x, y};
+                ASSERT_EQ(DistortionMapper::findEnclosingQuad(pt, mapperInfo->mDistortedGrid),
+                        DistortionMapper::findEnclosingQuad(pt, *mapperInfo))
+                        << "(" << x << ", " << y << ")";
+            }
+        }
+    }
+}
+
+// Rectangles are mapped in one batch; make sure that matches mapping their corners
+TEST(DistortionMapperTest, RectTransform) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+
+    std::default_random_engine gen(1234);
+    std::uniform_int_distribution<int> x_dist(0, testActiveArray[2] / 2);
+    std::uniform_int_distribution<int> y_dist(0, testActiveArray[3] / 2);
+
+    for (bool simple : {false, true}) {
+        std::vector<int32_t> rects;
+        for (int i = 0; i < 100; i++) {
+            rects.insert(rects.end(), {x_dist(gen), y_dist(gen), x_dist(gen) + 1, y_dist(gen) + 1});
+        }
+        auto mappedRects = rects;
+        ASSERT_EQ(OK, m.mapCorrectedRectToRaw(mappedRects.data(), mappedRects.size() / 4,
+                mapperInfo, /*clamp*/true, simple));
+
+        for (size_t i = 0; i < rects.size(); i += 4) {
+            int32_t corners[4] = {rects[i], rects[i + 1],
+                    rects[i] + rects[i + 2] - 1, rects[i + 1] + rects[i + 3] - 1};
+            ASSERT_EQ(OK, m.mapCorrectedToRaw(corners, 2, mapperInfo, /*clamp*/true, simple));
+            EXPECT_EQ(corners[0], mappedRects[i]);
+            EXPECT_EQ(corners[1], mappedRects[i + 1]);
+            EXPECT_EQ(corners[2] - corners[0] + 1, mappedRects[i + 2]);
+            EXPECT_EQ(corners[3] - corners[1] + 1, mappedRects[i + 3]);
+        }
+    }
+}
+
 // Compare against values calculated by OpenCV
 // undistortPoints() method, which is the same as mapRawToCorrected
 // Ignore clamping
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "FrameNumberMapTest"
+
+#include <map>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../device3/FrameNumberMap.h"
+
+using namespace android::camera3;
+
+TEST(FrameNumberMapTest, AddFindRemove) {
+    FrameNumberMap<std::string> map;
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(nullptr, map.find(0));
+    EXPECT_FALSE(map.remove(0));
+
+    map.add(5, "five");
+    map.add(3, "three");
+    ASSERT_EQ(2u, map.size());
+    ASSERT_NE(nullptr, map.find(5));
+    EXPECT_EQ("five", *map.find(5));
+    EXPECT_EQ("three", *map.find(3));
+    EXPECT_EQ(nullptr, map.find(4));
+
+    // Adding an existing frame number replaces the value
+    map.add(5, "FIVE");
+    EXPECT_EQ(2u, map.size());
+    EXPECT_EQ("FIVE", *map.find(5));
+
+    *map.find(3) = "THREE";
+    EXPECT_EQ("THREE", *map.find(3));
+
+    EXPECT_TRUE(map.remove(5));
+    EXPECT_FALSE(map.remove(5));
+    EXPECT_EQ(nullptr, map.find(5));
+    EXPECT_EQ(1u, map.size());
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(nullptr, map.find(3));
+}
+
+TEST(FrameNumberMapTest, FrameNumbersAreOrdered) {
+    FrameNumberMap<int> map;
+    // Colliding in the initial buckets, and across the uint32_t range
+    std::vector<uint32_t> frameNumbers = {UINT32_MAX, 48, 0, 16, 1, 32, 100000, 17};
+    for (uint32_t f : frameNumbers) {
+        map.add(f, static_cast<int>(f));
+    }
+    std::sort(frameNumbers.begin(), frameNumbers.end());
+    EXPECT_EQ(frameNumbers, map.frameNumbers());
+    for (uint32_t f : frameNumbers) {
+        ASSERT_NE(nullptr, map.find(f));
+        EXPECT_EQ(static_cast<int>(f), *map.find(f));
+    }
+}
+
+// Simulate in-flight traffic, with one frame that is never completed, and
+// compare against std::map
+TEST(FrameNumberMapTest, MatchesStdMap) {
+    FrameNumberMap<uint64_t> map;
+    std::map<uint32_t, uint64_t> expected;
+    std::default_random_engine gen(1234);
+    std::uniform_int_distribution<uint32_t> depth(1, 40);
+
+    map.add(0, 0);
+    expected[0] = 0;
+    for (uint32_t f = 1; f < 20000; f++) {
+        map.add(f, f * 3);
+        expected[f] = f * 3;
+        // Complete a random earlier frame
+        uint32_t done = f - std::min(f - 1, depth(gen));
+        EXPECT_EQ(expected.erase(done) == 1, map.remove(done)) << done;
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+    std::vector<uint32_t> frameNumbers = map.frameNumbers();
+    ASSERT_EQ(expected.size(), frameNumbers.size());
+    auto it = expected.begin();
+    for (uint32_t f : frameNumbers) {
+        EXPECT_EQ(it->first, f);
+        ASSERT_NE(nullptr, map.find(f));
+        EXPECT_EQ(it->second, *map.find(f));
+        it++;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Simulates the in-flight map traffic of a high speed session: each frame is
+// registered, then looked up for its shutter, partial results and buffers,
+// and removed once complete, with a number of frames in flight. Compares
+// FrameNumberMap with the KeyedVector it replaced.
+
+#include <set>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <utils/KeyedVector.h>
+
+#include "../device3/FrameNumberMap.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+// Stand-in for InFlightRequest, with containers to copy or move
+struct Request {
+    int64_t shutterTimestamp = 0;
+    int numBuffersLeft = 0;
+    int partialResultCount = 0;
+    std::set<std::string> cameraIdsWithZoom;
+    std::set<std::set<std::string>> physicalCameraIds;
+    uint8_t other[256] = {};
+};
+
+constexpr int kNumPartialResults = 2;
+constexpr int kNumBuffers = 2;
+
+Request makeRequest() {
+    Request r;
+    r.numBuffersLeft = kNumBuffers;
+    r.cameraIdsWithZoom = {"0"};
+    r.physicalCameraIds = {{"2", "3"}};
+    return r;
+}
+
+struct KeyedVectorAdapter {
+    KeyedVector<uint32_t, Request> map;
+
+    void add(uint32_t f, Request r) { map.add(f, r); }
+    Request* find(uint32_t f) {
+        ssize_t idx = map.indexOfKey(f);
+        return idx < 0 ? nullptr : &map.editValueAt(idx);
+    }
+    void remove(uint32_t f) { map.removeItem(f); }
+};
+
+struct FrameNumberMapAdapter {
+    FrameNumberMap<Request> map;
+
+    void add(uint32_t f, Request r) { map.add(f, std::move(r)); }
+    Request* find(uint32_t f) { return map.find(f); }
+    void remove(uint32_t f) { map.remove(f); }
+};
+
+// Results for a frame arrive once |depth| newer frames have been registered;
+// buffers of even frames are returned before their shutter.
+template <typename Map>
+void BM_InFlightMap(benchmark::State& state) {
+    const uint32_t depth = state.range(0);
+    Map map;
+    uint32_t frameNumber = 0;
+    for (uint32_t i = 0; i < depth; i++) {
+        map.add(frameNumber++, makeRequest());
+    }
+
+    for (auto _ : state) {
+        map.add(frameNumber, makeRequest());
+        uint32_t done = frameNumber - depth;
+        frameNumber++;
+
+        if (done % 2 == 0) {
+            map.find(done)->numBuffersLeft--;
+        }
+        map.find(done)->shutterTimestamp = done;
+        for (int p = 1; p <= kNumPartialResults; p++) {
+            map.find(done)->partialResultCount = p;
+        }
+        Request* r = map.find(done);
+        while (r->numBuffersLeft > 0) {
+            r->numBuffersLeft--;
+            r = map.find(done);
+        }
+        map.remove(done);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+// range(0): frames in flight
+BENCHMARK_TEMPLATE(BM_InFlightMap, KeyedVectorAdapter)
+        ->ArgName("depth")->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK_TEMPLATE(BM_InFlightMap, FrameNumberMapAdapter)
+        ->ArgName("depth")->Arg(8)->Arg(32)->Arg(128);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "TagMonitorTest"
+
+#include <chrono>
+
+#include <fmt/printf.h>
+#include <gtest/gtest.h>
+
+#include "../utils/TagMonitor.h"
+
+using namespace android;
+
+namespace {
+
+const std::unordered_map<std::string, CameraMetadata> kNoPhysicalMetadata;
+
+std::vector<std::string> getEvents(TagMonitor& monitor) {
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    return events;
+}
+
+bool contains(const std::string& str, const std::string& substr) {
+    return str.find(substr) != std::string::npos;
+}
+
+} // anonymous namespace
+
+TEST(TagMonitorTest, RecordsOnlyChanges) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.control.aeMode, android.control.aeExposureCompensation");
+
+    CameraMetadata request;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    int32_t exposureCompensation = 0;
+    request.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    request.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, &exposureCompensation, 1);
+    for (int64_t frameNumber = 0; frameNumber < 10; frameNumber++) {
+        monitor.monitorMetadata(TagMonitor::REQUEST, frameNumber, /*timestamp*/ 1, request,
+                kNoPhysicalMetadata);
+    }
+    std::vector<std::string> events = getEvents(monitor);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_TRUE(contains(events[0], "f0:")) << events[0];
+    EXPECT_TRUE(contains(events[0], "aeExposureCompensation")) << events[0];
+    EXPECT_TRUE(contains(events[1], "aeMode")) << events[1];
+
+    exposureCompensation = 2;
+    request.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, &exposureCompensation, 1);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 10, /*timestamp*/ 1, request,
+            kNoPhysicalMetadata);
+    request.erase(ANDROID_CONTROL_AE_MODE);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 11, /*timestamp*/ 1, request,
+            kNoPhysicalMetadata);
+    // Results are tracked separately from requests
+    monitor.monitorMetadata(TagMonitor::RESULT, 11, /*timestamp*/ 1, request,
+            kNoPhysicalMetadata);
+
+    events = getEvents(monitor);
+    ASSERT_EQ(5u, events.size());
+    EXPECT_TRUE(contains(events[0], "f11:")) << events[0];
+    EXPECT_TRUE(contains(events[0], "RES:")) << events[0];
+    EXPECT_TRUE(contains(events[0], "[2 ]")) << events[0];
+    EXPECT_TRUE(contains(events[1], "f11:")) << events[1];
+    EXPECT_TRUE(contains(events[1], "aeMode:  (Removed)")) << events[1];
+    EXPECT_TRUE(contains(events[2], "f10:")) << events[2];
+    EXPECT_TRUE(contains(events[2], "[2 ]")) << events[2];
+}
+
+TEST(TagMonitorTest, PhysicalCameras) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.control.aeExposureCompensation");
+
+    CameraMetadata request;
+    int32_t exposureCompensation = 0;
+    request.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, &exposureCompensation, 1);
+    std::unordered_map<std::string, CameraMetadata> physicalMetadata;
+    physicalMetadata["2"] = request;
+    monitor.monitorMetadata(TagMonitor::RESULT, 0, /*timestamp*/ 1, request, physicalMetadata);
+
+    exposureCompensation = 1;
+    physicalMetadata["2"].update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION,
+            &exposureCompensation, 1);
+    physicalMetadata["3"] = request;
+    monitor.monitorMetadata(TagMonitor::RESULT, 1, /*timestamp*/ 1, request, physicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, /*timestamp*/ 1, request, physicalMetadata);
+
+    std::vector<std::string> events = getEvents(monitor);
+    ASSERT_EQ(4u, events.size());
+    // The physical cameras of a frame are in no particular order
+    size_t camera3Event = contains(events[0], "f1:1ns: 3") ? 0 : 1;
+    EXPECT_TRUE(contains(events[camera3Event], "f1:1ns: 3")) << events[camera3Event];
+    EXPECT_TRUE(contains(events[camera3Event], "[0 ]")) << events[camera3Event];
+    EXPECT_TRUE(contains(events[1 - camera3Event], "f1:1ns: 2")) << events[1 - camera3Event];
+    EXPECT_TRUE(contains(events[1 - camera3Event], "[1 ]")) << events[1 - camera3Event];
+}
+
+TEST(TagMonitorTest, KeepsLatestEvents) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.control.aeRegions");
+
+    CameraMetadata request;
+    for (int32_t frameNumber = 0; frameNumber < 150; frameNumber++) {
+        // Values larger than the preallocated space in every other frame
+        std::vector<int32_t> regions((frameNumber % 2 == 0 ? 1 : 4) * 5, frameNumber);
+        request.update(ANDROID_CONTROL_AE_REGIONS, regions.data(), regions.size());
+        monitor.monitorMetadata(TagMonitor::REQUEST, frameNumber, /*timestamp*/ 1, request,
+                kNoPhysicalMetadata);
+    }
+
+    std::vector<std::string> events = getEvents(monitor);
+    ASSERT_EQ(100u, events.size());
+    EXPECT_TRUE(contains(events[0], "f149:")) << events[0];
+    EXPECT_TRUE(contains(events[0], "[149 149 149 149 149 149 149 149 ]")) << events[0];
+    EXPECT_TRUE(contains(events[1], "f148:")) << events[1];
+    EXPECT_TRUE(contains(events[1], "[148 148 148 148 148 ]")) << events[1];
+    EXPECT_TRUE(contains(events[99], "f50:")) << events[99];
+
+    monitor.disableMonitoring();
+    EXPECT_EQ(100u, getEvents(monitor).size());
+}
+
+TEST(TagMonitorTest, SteadyStateCost) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("3a");
+
+    CameraMetadata request;
+    uint8_t modes[] = {ANDROID_CONTROL_MODE_AUTO};
+    request.update(ANDROID_CONTROL_MODE, modes, 1);
+    request.update(ANDROID_CONTROL_AE_MODE, modes, 1);
+    request.update(ANDROID_CONTROL_AF_MODE, modes, 1);
+    request.update(ANDROID_CONTROL_AWB_MODE, modes, 1);
+    int32_t regions[] = {0, 0, 1000, 1000, 1};
+    request.update(ANDROID_CONTROL_AE_REGIONS, regions, 5);
+    request.update(ANDROID_CONTROL_AF_REGIONS, regions, 5);
+    request.update(ANDROID_CONTROL_AWB_REGIONS, regions, 5);
+    int32_t fpsRange[] = {30, 30};
+    request.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    std::unordered_map<std::string, CameraMetadata> physicalMetadata;
+    physicalMetadata["2"] = request;
+
+    const int64_t kFrames = 10000;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t frameNumber = 0; frameNumber < kFrames; frameNumber++) {
+        monitor.monitorMetadata(TagMonitor::REQUEST, frameNumber, /*timestamp*/ 1, request,
+                physicalMetadata);
+        monitor.monitorMetadata(TagMonitor::RESULT, frameNumber, /*timestamp*/ 1, request,
+                physicalMetadata);
+    }
+    auto perFrame = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+            std::chrono::steady_clock::now() - start) / kFrames;
+    RecordProperty("MonitorDurationPerFrameUs", fmt::sprintf("%f", perFrame.count()));
+
+    // The initial value of each tag, for the logical and the physical camera
+    EXPECT_EQ(2u * 2u * 8u, getEvents(monitor).size());
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A WorkerPool microbenchmark: runs one job per 512x512 tile of a 12MP planar
+// YUV frame, each copying its tile into an NV12 buffer, serially and on
+// WorkerPools of various sizes. It shows the speedup and dispatch overhead of
+// the pool for work shaped like HeicCompositeStream's tile copies. It does not
+// run HeicCompositeStream::copyOneYuvTile(), which also handles other layouts
+// and copies into codec buffers; the copy here is a simplified stand-in.
+
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../utils/WorkerPool.h"
+
+using namespace android;
+
+static constexpr size_t kWidth = 4032;
+static constexpr size_t kHeight = 3024;
+static constexpr size_t kGridSize = 512;
+
+struct YuvFrame {
+    YuvFrame() : y(kWidth * kHeight, 0x40), cb(kWidth * kHeight / 4, 0x80),
+            cr(kWidth * kHeight / 4, 0x90) {}
+    std::vector<uint8_t> y, cb, cr;
+};
+
+// Stand-in for the tile copy: copies one tile of |src| to the NV12 |dst|,
+// a row at a time for the luma plane and interleaving the planar chroma.
+static status_t copyTile(const YuvFrame& src, uint8_t* dst, size_t top, size_t left,
+        size_t width, size_t height) {
+    for (size_t row = 0; row < height; row++) {
+        memcpy(dst + row * kGridSize, src.y.data() + (top + row) * kWidth + left, width);
+    }
+    dst += kGridSize * kGridSize;
+    for (size_t row = 0; row < height / 2; row++) {
+        size_t srcOffset = (top / 2 + row) * (kWidth / 2) + left / 2;
+        uint8_t* dstRow = dst + row * kGridSize;
+        for (size_t col = 0; col < width / 2; col++) {
+            dstRow[col * 2] = src.cb[srcOffset + col];
+            dstRow[col * 2 + 1] = src.cr[srcOffset + col];
+        }
+    }
+    return OK;
+}
+
+// range(0): number of WorkerPool threads, or -1 to copy on the calling thread
+static void BM_WorkerPoolTileCopy(benchmark::State& state) {
+    const YuvFrame frame;
+    const size_t gridCols = (kWidth + kGridSize - 1) / kGridSize;
+    const size_t gridRows = (kHeight + kGridSize - 1) / kGridSize;
+    std::vector<std::vector<uint8_t>> tiles(gridRows * gridCols,
+            std::vector<uint8_t>(kGridSize * kGridSize * 3 / 2));
+
+    std::vector<WorkerPool::Job> jobs;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        size_t tileX = i % gridCols;
+        size_t tileY = i / gridCols;
+        size_t width = (tileX == gridCols - 1) ? kWidth - tileX * kGridSize : kGridSize;
+        size_t height = (tileY == gridRows - 1) ? kHeight - tileY * kGridSize : kGridSize;
+        uint8_t* dst = tiles[i].data();
+        jobs.push_back([&frame, dst, tileX, tileY, width, height]() {
+            return copyTile(frame, dst, tileY * kGridSize, tileX * kGridSize, width, height);
+        });
+    }
+
+    std::unique_ptr<WorkerPool> pool;
+    if (state.range(0) >= 0) {
+        pool = std::make_unique<WorkerPool>(state.range(0), "TileCopy");
+    }
+    for (auto _ : state) {
+        if (pool != nullptr) {
+            pool->run(jobs);
+        } else {
+            for (auto& job : jobs) {
+                job();
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kWidth * kHeight * 3 / 2);
+}
+
+BENCHMARK(BM_WorkerPoolTileCopy)
+        ->ArgName("threads")
+        ->Arg(-1)->DenseRange(0, 4)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "WorkerPoolTest"
+
+#include <atomic>
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "../utils/WorkerPool.h"
+
+using namespace android;
+
+TEST(WorkerPoolTest, RunsAllJobs) {
+    WorkerPool pool(3, "WorkerPoolTest");
+    ASSERT_EQ(3u, pool.numThreads());
+
+    for (size_t batch = 0; batch < 50; batch++) {
+        std::vector<int> results(batch, 0);
+        std::vector<WorkerPool::Job> jobs;
+        for (size_t i = 0; i < batch; i++) {
+            jobs.push_back([&results, i]() {
+                results[i] = static_cast<int>(i) + 1;
+                return OK;
+            });
+        }
+        ASSERT_EQ(OK, pool.run(jobs));
+        for (size_t i = 0; i < batch; i++) {
+            EXPECT_EQ(static_cast<int>(i) + 1, results[i]) << "batch " << batch << " job " << i;
+        }
+    }
+}
+
+TEST(WorkerPoolTest, ReturnsError) {
+    WorkerPool pool(2, "WorkerPoolTest");
+    std::atomic<int> count = 0;
+    std::vector<WorkerPool::Job> jobs;
+    for (int i = 0; i < 8; i++) {
+        jobs.push_back([&count, i]() {
+            count++;
+            return (i == 5) ? BAD_VALUE : OK;
+        });
+    }
+    EXPECT_EQ(BAD_VALUE, pool.run(jobs));
+    // The remaining jobs still run.
+    EXPECT_EQ(8, count);
+
+    // The error does not carry over to the next batch.
+    EXPECT_EQ(OK, pool.run({ []() { return OK; } }));
+}
+
+TEST(WorkerPoolTest, RunsJobsInParallel) {
+    WorkerPool pool(3, "WorkerPoolTest");
+    // Each job waits for all others to start, which only completes if all of
+    // them run at the same time on the pool and the calling thread.
+    const int kNumJobs = 4;
+    std::atomic<int> started = 0;
+    std::atomic<bool> timedOut = false;
+    std::vector<WorkerPool::Job> jobs(kNumJobs, [&]() {
+        started++;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (started < kNumJobs) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                timedOut = true;
+                return TIMED_OUT;
+            }
+            std::this_thread::yield();
+        }
+        return OK;
+    });
+    EXPECT_EQ(OK, pool.run(jobs));
+    EXPECT_FALSE(timedOut);
+}
+
+TEST(WorkerPoolTest, NoThreads) {
+    WorkerPool pool(0, "WorkerPoolTest");
+    int count = 0;
+    std::vector<WorkerPool::Job> jobs(4, [&count]() {
+        count++;
+        return OK;
+    });
+    EXPECT_EQ(OK, pool.run(jobs));
+    EXPECT_EQ(4, count);
+}
@@ -18,6 +18,7 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -34,7 +35,6 @@ namespace android {
 
 TagMonitor::TagMonitor():
         mMonitoringEnabled(false),
-        mMonitoringEvents(kMaxMonitorEvents),
         mVendorTagId(CAMERA_METADATA_INVALID_VENDOR_ID)
 {}
 
@@ -43,9 +43,11 @@ TagMonitor::TagMonitor(const TagMonitor& other):
         mMonitoredTagList(other.mMonitoredTagList),
         mLastMonitoredRequestValues(other.mLastMonitoredRequestValues),
         mLastMonitoredResultValues(other.mLastMonitoredResultValues),
-        mLastMonitoredPhysicalRequestKeys(other.mLastMonitoredPhysicalRequestKeys),
-        mLastMonitoredPhysicalResultKeys(other.mLastMonitoredPhysicalResultKeys),
+        mLastInputStreamId(other.mLastInputStreamId),
+        mLastStreamIds(other.mLastStreamIds),
         mMonitoringEvents(other.mMonitoringEvents),
+        mNextEvent(other.mNextEvent),
+        mEventCount(other.mEventCount),
         mVendorTagId(other.mVendorTagId) {}
 
 const std::string TagMonitor::kMonitorOption("-m");
@@ -103,17 +105,28 @@ void TagMonitor::parseTagsToMonitor(std::string tagNames) {
     }
 
     if (gotTag) {
-        // Got at least one new tag
+        // Got at least one new tag. The last values are laid out by the tag
+        // list, so start over.
+        clearLastValuesLocked();
+        if (mMonitoringEvents.empty()) {
+            mMonitoringEvents.resize(kMaxMonitorEvents);
+            for (MonitorEvent& event : mMonitoringEvents) {
+                event.newData.reserve(kPreallocatedValueSize);
+            }
+        }
         mMonitoringEnabled = true;
     }
 }
 
 void TagMonitor::disableMonitoring() {
+    std::lock_guard<std::mutex> lock(mMonitorMutex);
     mMonitoringEnabled = false;
+    clearLastValuesLocked();
+}
+
+void TagMonitor::clearLastValuesLocked() {
     mLastMonitoredRequestValues.clear();
     mLastMonitoredResultValues.clear();
-    mLastMonitoredPhysicalRequestKeys.clear();
-    mLastMonitoredPhysicalResultKeys.clear();
     mLastStreamIds.clear();
     mLastInputStreamId = -1;
 }
@@ -130,109 +143,135 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
     if (timestamp == 0) {
         timestamp = systemTime(SYSTEM_TIME_BOOTTIME);
     }
-    std::unordered_set<int32_t> outputStreamIds;
-    for (size_t i = 0; i < numOutputBuffers; i++) {
-        const camera3::camera_stream_buffer_t *src = outputBuffers + i;
-        int32_t streamId = camera3::Camera3Stream::cast(src->stream)->getId();
-        outputStreamIds.emplace(streamId);
-    }
-    std::string emptyId;
-    for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata,
-                outputStreamIds, inputStreamId);
-
-        for (auto& m : physicalMetadata) {
-            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second,
-                    outputStreamIds, inputStreamId);
-        }
-    }
-}
-
-void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
-        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata,
-        const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId) {
-
-    CameraMetadata &lastValues = (source == REQUEST) ?
-            (cameraId.empty() ? mLastMonitoredRequestValues :
-                    mLastMonitoredPhysicalRequestKeys[cameraId]) :
-            (cameraId.empty() ? mLastMonitoredResultValues :
-                    mLastMonitoredPhysicalResultKeys[cameraId]);
-
-    camera_metadata_ro_entry entry = metadata.find(tag);
-    if (lastValues.isEmpty()) {
-        lastValues = CameraMetadata(mMonitoredTagList.size());
-        const camera_metadata_t *metaBuffer =
-                lastValues.getAndLock();
-        set_camera_metadata_vendor_id(
-                const_cast<camera_metadata_t *> (metaBuffer), mVendorTagId);
-        lastValues.unlock(metaBuffer);
-    }
-
-    camera_metadata_entry lastEntry = lastValues.find(tag);
+    std::vector<TagValues>& lastValues = (source == REQUEST) ?
+            mLastMonitoredRequestValues : mLastMonitoredResultValues;
 
     // Monitor when the stream ids change, this helps visually see what
     // monitored metadata values are for capture requests with different
     // stream ids.
+    std::string emptyId;
     if (source == REQUEST) {
         if (inputStreamId != mLastInputStreamId) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, std::unordered_set<int>(), inputStreamId);
+            addEventLocked(MonitorEvent::INPUT_STREAM_CHANGED, source, frameNumber, timestamp,
+                    emptyId).inputStreamId = inputStreamId;
             mLastInputStreamId = inputStreamId;
         }
 
-        if (outputStreamIds != mLastStreamIds) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, outputStreamIds, -1);
-            mLastStreamIds = outputStreamIds;
+        mStreamIds.clear();
+        for (size_t i = 0; i < numOutputBuffers; i++) {
+            const camera3::camera_stream_buffer_t *src = outputBuffers + i;
+            mStreamIds.push_back(camera3::Camera3Stream::cast(src->stream)->getId());
+        }
+        std::sort(mStreamIds.begin(), mStreamIds.end());
+        mStreamIds.erase(std::unique(mStreamIds.begin(), mStreamIds.end()), mStreamIds.end());
+        if (mStreamIds != mLastStreamIds) {
+            addEventLocked(MonitorEvent::OUTPUT_STREAMS_CHANGED, source, frameNumber, timestamp,
+                    emptyId).outputStreamIds = mStreamIds;
+            mLastStreamIds = mStreamIds;
+        }
+    }
+
+    // Look up the values of all cameras first, since adding the values of a
+    // camera can move the others.
+    mMetadataToMonitor.clear();
+    mMetadataToMonitor.emplace_back(getTagValuesLocked(lastValues, emptyId), &metadata);
+    for (auto& m : physicalMetadata) {
+        mMetadataToMonitor.emplace_back(getTagValuesLocked(lastValues, m.first), &m.second);
+    }
+    for (size_t i = 0; i < mMonitoredTagList.size(); i++) {
+        for (const auto& [valuesIndex, cameraMetadata] : mMetadataToMonitor) {
+            monitorSingleMetadata(source, frameNumber, timestamp, lastValues[valuesIndex], i,
+                    *cameraMetadata);
         }
     }
+}
+
+size_t TagMonitor::getTagValuesLocked(std::vector<TagValues>& allValues,
+        const std::string& cameraId) {
+    for (size_t i = 0; i < allValues.size(); i++) {
+        if (allValues[i].cameraId == cameraId) {
+            return i;
+        }
+    }
+
+    TagValues& values = allValues.emplace_back();
+    values.cameraId = cameraId;
+    values.slots.resize(mMonitoredTagList.size());
+    values.data.resize(mMonitoredTagList.size() * kPreallocatedValueSize);
+    for (size_t i = 0; i < mMonitoredTagList.size(); i++) {
+        TagValues::Slot& slot = values.slots[i];
+        slot.offset = i * kPreallocatedValueSize;
+        slot.capacity = kPreallocatedValueSize;
+        slot.count = 0;
+        slot.type = get_local_camera_metadata_tag_type_vendor_id(mMonitoredTagList[i],
+                mVendorTagId);
+        slot.present = false;
+    }
+    return allValues.size() - 1;
+}
+
+void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
+        TagValues& lastValues, size_t tagIndex, const CameraMetadata& metadata) {
+    uint32_t tag = mMonitoredTagList[tagIndex];
+    TagValues::Slot& lastEntry = lastValues.slots[tagIndex];
+
+    camera_metadata_ro_entry entry = metadata.find(tag);
     if (entry.count > 0) {
-        bool isDifferent = false;
-        if (lastEntry.count > 0) {
-            // Have a last value, compare to see if changed
-            if (lastEntry.type == entry.type &&
-                    lastEntry.count == entry.count) {
-                // Same type and count, compare values
-                size_t bytesPerValue = camera_metadata_type_size[lastEntry.type];
-                size_t entryBytes = bytesPerValue * lastEntry.count;
-                int cmp = memcmp(entry.data.u8, lastEntry.data.u8, entryBytes);
-                if (cmp != 0) {
-                    isDifferent = true;
-                }
-            } else {
-                // Count or type has changed
-                isDifferent = true;
-            }
-        } else {
-            // No last entry, so always consider to be different
-            isDifferent = true;
+        size_t entryBytes = camera_metadata_type_size[entry.type] * entry.count;
+        if (lastEntry.present && lastEntry.type == entry.type &&
+                lastEntry.count == entry.count &&
+                memcmp(entry.data.u8, lastValues.data.data() + lastEntry.offset,
+                        entryBytes) == 0) {
+            return;
         }
 
-        if (isDifferent) {
-            ALOGV("%s: Tag %s changed", __FUNCTION__,
-                  get_local_camera_metadata_tag_name_vendor_id(
-                          tag, mVendorTagId));
-            lastValues.update(entry);
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                      std::unordered_set<int>(), -1);
+        ALOGV("%s: Tag %s changed", __FUNCTION__,
+              get_local_camera_metadata_tag_name_vendor_id(
+                      tag, mVendorTagId));
+        if (entryBytes > lastEntry.capacity) {
+            // Move the value to the end; the old space is left unused.
+            lastEntry.offset = lastValues.data.size();
+            lastEntry.capacity = entryBytes;
+            lastValues.data.resize(lastEntry.offset + entryBytes);
         }
-    } else if (lastEntry.count > 0) {
+        memcpy(lastValues.data.data() + lastEntry.offset, entry.data.u8, entryBytes);
+        lastEntry.type = entry.type;
+        lastEntry.count = entry.count;
+        lastEntry.present = true;
+
+        MonitorEvent& event = addEventLocked(MonitorEvent::TAG_CHANGED, source, frameNumber,
+                timestamp, lastValues.cameraId);
+        event.tag = tag;
+        event.type = entry.type;
+        event.newData.assign(entry.data.u8, entry.data.u8 + entryBytes);
+    } else if (lastEntry.present) {
         // Value has been removed
         ALOGV("%s: Tag %s removed", __FUNCTION__,
               get_local_camera_metadata_tag_name_vendor_id(
                       tag, mVendorTagId));
-        lastValues.erase(tag);
-        entry.tag = tag;
-        entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
-                mVendorTagId);
-        entry.count = 0;
-        mLastInputStreamId = inputStreamId;
-        mLastStreamIds = outputStreamIds;
-        mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                  std::unordered_set<int>(), -1);
+        lastEntry.present = false;
+        MonitorEvent& event = addEventLocked(MonitorEvent::TAG_CHANGED, source, frameNumber,
+                timestamp, lastValues.cameraId);
+        event.tag = tag;
+        event.type = get_local_camera_metadata_tag_type_vendor_id(tag, mVendorTagId);
+        event.newData.clear();
     }
 }
 
+TagMonitor::MonitorEvent& TagMonitor::addEventLocked(MonitorEvent::Kind kind, eventSource source,
+        int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId) {
+    MonitorEvent& event = mMonitoringEvents[mNextEvent];
+    mNextEvent = (mNextEvent + 1) % mMonitoringEvents.size();
+    mEventCount = std::min(mEventCount + 1, mMonitoringEvents.size());
+
+    event.kind = kind;
+    event.source = source;
+    event.frameNumber = frameNumber;
+    event.timestamp = timestamp;
+    event.cameraId = cameraId;
+    return event;
+}
+
 void TagMonitor::dumpMonitoredMetadata(int fd) {
     std::lock_guard<std::mutex> lock(mMonitorMutex);
 
@@ -249,7 +288,7 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
         dprintf(fd, "     Tag monitoring disabled (enable with -m <name1,..,nameN>)\n");
     }
 
-    if (mMonitoringEvents.size() == 0) { return; }
+    if (mEventCount == 0) { return; }
 
     dprintf(fd, "     Monitored tag event log:\n");
 
@@ -266,9 +305,11 @@ void TagMonitor::getLatestMonitoredTagEvents(std::vector<std::string> &out) {
 }
 
 void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &vec) {
-    if (mMonitoringEvents.size() == 0) { return; }
-
-    for (const auto& event : mMonitoringEvents) {
+    // Most recent first
+    for (size_t i = 1; i <= mEventCount; i++) {
+        const MonitorEvent& event =
+                mMonitoringEvents[(mNextEvent + mMonitoringEvents.size() - i) %
+                        mMonitoringEvents.size()];
         int indentation = (event.source == REQUEST) ? 15 : 30;
         std::string eventString = fmt::sprintf("f%d:%" PRId64 "ns:%*s%*s",
                 event.frameNumber, event.timestamp,
@@ -276,7 +317,7 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
                 indentation,
                 event.source == REQUEST ? "REQ:" : "RES:");
 
-        if (!event.outputStreamIds.empty()) {
+        if (event.kind == MonitorEvent::OUTPUT_STREAMS_CHANGED) {
             eventString += " output stream ids:";
             for (const auto& id : event.outputStreamIds) {
                 eventString += fmt::sprintf(" %d", id);
@@ -286,7 +327,7 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
             continue;
         }
 
-        if (event.inputStreamId != -1) {
+        if (event.kind == MonitorEvent::INPUT_STREAM_CHANGED) {
             eventString += fmt::sprintf(" input stream id: %d\n", event.inputStreamId);
             vec.emplace_back(eventString);
             continue;
@@ -387,22 +428,4 @@ std::string TagMonitor::getEventDataString(const uint8_t* data_ptr, uint32_t tag
     return std::move(returnStr.str());
 }
 
-template<typename T>
-TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-        const T &value, const std::string& cameraId,
-        const std::unordered_set<int32_t> &outputStreamIds,
-        int32_t inputStreamId) :
-        source(src),
-        frameNumber(frameNumber),
-        timestamp(timestamp),
-        cameraId(cameraId),
-        tag(value.tag),
-        type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
-        outputStreamIds(outputStreamIds),
-        inputStreamId(inputStreamId) {}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
-}
-
 } // namespace android
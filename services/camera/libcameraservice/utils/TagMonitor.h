@@ -26,7 +26,6 @@
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
 
-#include <media/RingBuffer.h>
 #include <system/camera_metadata.h>
 #include <system/camera_vendor_tags.h>
 #include <camera/CameraMetadata.h>
@@ -37,7 +36,11 @@ namespace android {
 /**
  * A monitor for camera metadata values.
  * Tracks changes to specified metadata values over time, keeping a circular
- * buffer log that can be dumped at will. */
+ * buffer log that can be dumped at will.
+ *
+ * Only the values of the monitored tags are kept, and the event log is
+ * preallocated when monitoring is enabled, so monitoring a request or result
+ * whose values didn't change doesn't allocate. */
 class TagMonitor {
   public:
 
@@ -88,56 +91,95 @@ class TagMonitor {
     static std::string getEventDataString(const uint8_t* data_ptr, uint32_t tag, int type,
             int count, int indentation);
 
-    void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
-            nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata, const std::unordered_set<int32_t> &outputStreamIds,
-            int32_t inputStreamId);
-
-    std::atomic<bool> mMonitoringEnabled;
-    std::mutex mMonitorMutex;
-
-    // Current tags to monitor and record changes to
-    std::vector<uint32_t> mMonitoredTagList;
-
-    // Latest-seen values of tracked tags
-    CameraMetadata mLastMonitoredRequestValues;
-    CameraMetadata mLastMonitoredResultValues;
-
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalRequestKeys;
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalResultKeys;
+    /**
+     * Latest-seen values of the monitored tags of one camera, for either
+     * requests or results. The values are kept back to back in one buffer,
+     * with a slot per entry of mMonitoredTagList.
+     */
+    struct TagValues {
+        struct Slot {
+            size_t offset;
+            size_t capacity;
+            size_t count;
+            uint8_t type;
+            bool present;
+        };
 
-    int32_t mLastInputStreamId = -1;
-    std::unordered_set<int32_t> mLastStreamIds;
+        std::string cameraId;
+        std::vector<Slot> slots;
+        std::vector<uint8_t> data;
+    };
 
     /**
      * A monitoring event
-     * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
+     * Stores a new metadata field value and the timestamp at which it changed,
+     * or the new stream ids of the requests. The events are kept in a ring, and
+     * their storage is reused when they are overwritten.
      */
     struct MonitorEvent {
-        template<typename T>
-        MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-                const T &newValue, const std::string& cameraId,
-                const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId);
-        ~MonitorEvent();
+        enum Kind {
+            TAG_CHANGED,
+            OUTPUT_STREAMS_CHANGED,
+            INPUT_STREAM_CHANGED
+        };
 
+        Kind kind;
         eventSource source;
         uint32_t frameNumber;
         nsecs_t timestamp;
         std::string cameraId;
+        // For TAG_CHANGED; newData is empty if the tag was removed
         uint32_t tag;
         uint8_t type;
         std::vector<uint8_t> newData;
-        // NOTE: We want to print changes to outputStreamIds and inputStreamId in their own lines.
-        // So any MonitorEvent where these fields are not the default value will have garbage
-        // values for all fields other than source, frameNumber, timestamp, and cameraId.
-        std::unordered_set<int32_t> outputStreamIds;
-        int32_t inputStreamId = -1;
+        // For OUTPUT_STREAMS_CHANGED, sorted
+        std::vector<int32_t> outputStreamIds;
+        // For INPUT_STREAM_CHANGED
+        int32_t inputStreamId;
     };
 
-    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
-    static const int kMaxMonitorEvents = 100;
-    RingBuffer<MonitorEvent> mMonitoringEvents;
+    // Return the index of the values of the camera in allValues, adding them if
+    // the camera wasn't seen before.
+    size_t getTagValuesLocked(std::vector<TagValues>& allValues, const std::string& cameraId);
+
+    void monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
+            TagValues& lastValues, size_t tagIndex, const CameraMetadata& metadata);
+
+    // Return the next event in the ring to fill in, overwriting the oldest one
+    // once the ring is full.
+    MonitorEvent& addEventLocked(MonitorEvent::Kind kind, eventSource source,
+            int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId);
+
+    void clearLastValuesLocked();
+
+    std::atomic<bool> mMonitoringEnabled;
+    std::mutex mMonitorMutex;
+
+    // Current tags to monitor and record changes to
+    std::vector<uint32_t> mMonitoredTagList;
+
+    // Latest-seen values of tracked tags, per camera
+    std::vector<TagValues> mLastMonitoredRequestValues;
+    std::vector<TagValues> mLastMonitoredResultValues;
+
+    // Scratch space for monitorMetadata: indices of the per camera values, and
+    // the metadata to compare them to.
+    std::vector<std::pair<size_t, const CameraMetadata*>> mMetadataToMonitor;
+    std::vector<int32_t> mStreamIds;
+
+    int32_t mLastInputStreamId = -1;
+    std::vector<int32_t> mLastStreamIds;
+
+    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes.
+    // Allocated when monitoring is first enabled.
+    static const size_t kMaxMonitorEvents = 100;
+    std::vector<MonitorEvent> mMonitoringEvents;
+    size_t mNextEvent = 0;
+    size_t mEventCount = 0;
+
+    // Bytes reserved for each tag value and event, enough for all of the 3A
+    // tags without regions larger than one rectangle.
+    static const size_t kPreallocatedValueSize = 32;
 
     // 3A fields to use with the "3a" option
     static const char *k3aTags;
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-WorkerPool"
+#include <pthread.h>
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "WorkerPool.h"
+
+namespace android {
+
+WorkerPool::WorkerPool(size_t numThreads, const std::string& name) :
+        mName(name),
+        mJobs(nullptr),
+        mNextJob(0),
+        mRunningJobs(0),
+        mResult(OK),
+        mExiting(false) {
+    mThreads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        mThreads.emplace_back(&WorkerPool::threadLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        mExiting = true;
+    }
+    mBatchCondition.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+status_t WorkerPool::run(const std::vector<Job>& jobs) {
+    std::unique_lock<std::mutex> l(mLock);
+    mJobs = &jobs;
+    mNextJob = 0;
+    mResult = OK;
+    if (jobs.size() > 1) {
+        mBatchCondition.notify_all();
+    }
+    runJobsLocked(l);
+    mDoneCondition.wait(l, [this] { return mRunningJobs == 0; });
+    mJobs = nullptr;
+    return mResult;
+}
+
+void WorkerPool::threadLoop(size_t index) {
+    // Thread names are limited to 15 characters.
+    std::string threadName = (mName + std::to_string(index)).substr(0, 15);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+
+    std::unique_lock<std::mutex> l(mLock);
+    while (true) {
+        mBatchCondition.wait(l, [this] {
+            return mExiting || (mJobs != nullptr && mNextJob < mJobs->size());
+        });
+        if (mExiting) {
+            return;
+        }
+        runJobsLocked(l);
+    }
+}
+
+void WorkerPool::runJobsLocked(std::unique_lock<std::mutex>& lock) {
+    while (mJobs != nullptr && mNextJob < mJobs->size()) {
+        const Job& job = (*mJobs)[mNextJob++];
+        mRunningJobs++;
+        lock.unlock();
+        status_t res = job();
+        lock.lock();
+        if (res != OK && mResult == OK) {
+            ALOGE("%s: %s job failed: %s (%d)", __FUNCTION__, mName.c_str(),
+                    strerror(-res), res);
+            mResult = res;
+        }
+        if (--mRunningJobs == 0 && mNextJob >= mJobs->size()) {
+            mDoneCondition.notify_all();
+        }
+    }
+}
+
+}; // namespace android
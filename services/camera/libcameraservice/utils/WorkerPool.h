@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_WORKER_POOL_H_
+#define ANDROID_SERVERS_CAMERA_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <utils/Errors.h>
+
+namespace android {
+
+// A fixed set of threads that run batches of independent jobs, such as
+// copying the tiles of an image. Batches are run one at a time; the thread
+// that submits a batch runs jobs too, and waits for the whole batch.
+class WorkerPool {
+public:
+    typedef std::function<status_t()> Job;
+
+    WorkerPool(size_t numThreads, const std::string& name);
+    ~WorkerPool();
+
+    // Run all |jobs|, and return the first error returned by a job, or OK.
+    // All jobs are run even if one of them fails.
+    status_t run(const std::vector<Job>& jobs);
+
+    size_t numThreads() const { return mThreads.size(); }
+
+private:
+    void threadLoop(size_t index);
+    // Run jobs of the current batch until none are left. Called with mLock held.
+    void runJobsLocked(std::unique_lock<std::mutex>& lock);
+
+    const std::string mName;
+    std::mutex mLock;
+    std::condition_variable mBatchCondition;
+    std::condition_variable mDoneCondition;
+    const std::vector<Job>* mJobs;
+    size_t mNextJob;
+    size_t mRunningJobs;
+    status_t mResult;
+    bool mExiting;
+    std::vector<std::thread> mThreads;
+}; // class WorkerPool
+
+}; // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_WORKER_POOL_H_
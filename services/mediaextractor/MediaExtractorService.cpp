@@ -18,9 +18,11 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <cutils/properties.h>
 #include <utils/Vector.h>
 
 #include <datasource/DataSourceFactory.h>
+#include <datasource/ReadAheadSource.h>
 #include <media/DataSource.h>
 #include <media/stagefright/InterfaceUtils.h>
 #include <media/stagefright/MediaExtractorFactory.h>
@@ -29,6 +31,12 @@
 
 namespace android {
 
+// The read-ahead of the sources of local files, which are read quickly: each
+// extractor keeps at most 256 KiB of blocks, read up to 64 KiB at a time.
+static const size_t kReadAheadBlockSize = 16 * 1024;
+static const size_t kReadAheadMaxReadAheadBlocks = 4;
+static const size_t kReadAheadMaxCachedBlocks = 16;
+
 MediaExtractorService::MediaExtractorService() {
     MediaExtractorFactory::LoadExtractors();
 }
@@ -44,6 +52,16 @@ MediaExtractorService::~MediaExtractorService() {
     ALOGV("@@@ MediaExtractorService::makeExtractor for %s", mime ? mime->c_str() : nullptr);
 
     sp<DataSource> localSource = CreateDataSourceFromIDataSource(remoteSource);
+    // Every read of the remote source is a binder transaction, so coalesce
+    // the small reads of the extractors into fewer, larger ones. Network
+    // sources are already read ahead and cached by the client.
+    if (localSource != nullptr
+            && (localSource->flags() & (DataSourceBase::kIsHTTPBasedSource
+                    | DataSourceBase::kIsCachingDataSource)) == 0
+            && property_get_bool("media.stagefright.extractor.readahead", true)) {
+        localSource = new ReadAheadSource(localSource, kReadAheadBlockSize,
+                kReadAheadMaxReadAheadBlocks, kReadAheadMaxCachedBlocks);
+    }
 
     MediaBuffer::useSharedMemory();
     sp<IMediaExtractor> extractor = MediaExtractorFactory::CreateFromService(